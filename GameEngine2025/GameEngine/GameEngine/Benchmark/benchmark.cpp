@@ -0,0 +1,151 @@
+#include "benchmark.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+
+static void printUsage()
+{
+    std::cout << "Usage: GameEngine --bench <suite> [options]" << std::endl;
+    std::cout << "  ecs [entityCount]         archetype chunks vs. per-object heap layout" << std::endl;
+    std::cout << "  transform [objectCount]   SIMD model/MVP kernels vs. glm (validation + throughput)" << std::endl;
+    std::cout << "  loaders [iterations]      OBJ/BMP parsing and scene construction, GPU upload stubbed" << std::endl;
+    std::cout << "  collision [iterations]    mesh BVH builds, raycasts and capsule queries on scene 1" << std::endl;
+    std::cout << "  physics [maxBodies]       rigid-body step time for 1k/10k/100k falling asteroids" << std::endl;
+    std::cout << "  particles [count]         SoA particle update and instance writes vs. a scalar AoS loop" << std::endl;
+    std::cout << "  pacing [fps]              capped frame pacing holds the period, also after an overrun" << std::endl;
+    std::cout << "  scene [options]           headless flythrough with per-frame CPU/GPU times" << std::endl;
+    std::cout << "      --scene N               scene to load (1)" << std::endl;
+    std::cout << "      --frames N              measured frames (600), --warmup N (30)" << std::endl;
+    std::cout << "      --size WxH              framebuffer size (1280x720)" << std::endl;
+    std::cout << "      --context API           native | egl | osmesa" << std::endl;
+    std::cout << "      --path file             camera path (Resources/CameraPaths/sceneN.path)" << std::endl;
+    std::cout << "      --out file              JSON results (scene_benchmark.json)" << std::endl;
+    std::cout << "      --baseline file         compare against earlier results" << std::endl;
+    std::cout << "      --tolerance percent     allowed slowdown before failing (10)" << std::endl;
+    std::cout << "      --shadow-cascades N     sun shadow cascades, 0 for none (3)" << std::endl;
+    std::cout << "      --shadow-resolution N   shadow map size per cascade (2048)" << std::endl;
+    std::cout << "      --impostor-distance d   where rocks and walls become impostors, 1e9 for never (300)" << std::endl;
+    std::cout << "      --frame-budget ms       GPU time for the resolution governor to hold (off)" << std::endl;
+    std::cout << "      --render-stats file     append render stats every second, as the game's option does" << std::endl;
+    std::cout << "      --max-allocating-frames N  fail when more measured frames allocate (off)" << std::endl;
+    std::cout << "      --max-streaming-p99 ms  fail when frames that load or remove a world cell are slower (off)" << std::endl;
+}
+
+static bool parseSceneOptions(int argc, char** argv, SceneBenchmarkOptions& options)
+{
+    for (int i = 3; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value)
+        {
+            std::cout << "Missing value for " << arg << std::endl;
+            return false;
+        }
+
+        if (strcmp(arg, "--scene") == 0) options.sceneId = atoi(value);
+        else if (strcmp(arg, "--frames") == 0) options.frames = atoi(value);
+        else if (strcmp(arg, "--warmup") == 0) options.warmupFrames = atoi(value);
+        else if (strcmp(arg, "--context") == 0) options.contextApi = value;
+        else if (strcmp(arg, "--path") == 0) options.cameraPath = value;
+        else if (strcmp(arg, "--out") == 0) options.outputPath = value;
+        else if (strcmp(arg, "--baseline") == 0) options.baselinePath = value;
+        else if (strcmp(arg, "--tolerance") == 0) options.tolerancePercent = (float)atof(value);
+        else if (strcmp(arg, "--shadow-cascades") == 0) options.shadowCascades = atoi(value);
+        else if (strcmp(arg, "--shadow-resolution") == 0) options.shadowResolution = atoi(value);
+        else if (strcmp(arg, "--impostor-distance") == 0) options.impostorDistance = (float)atof(value);
+        else if (strcmp(arg, "--frame-budget") == 0) options.frameBudgetMs = (float)atof(value);
+        else if (strcmp(arg, "--render-stats") == 0) options.renderStatsPath = value;
+        else if (strcmp(arg, "--max-allocating-frames") == 0) options.maxAllocatingFrames = atoi(value);
+        else if (strcmp(arg, "--max-streaming-p99") == 0) options.maxStreamingP99Ms = (float)atof(value);
+        else if (strcmp(arg, "--size") == 0)
+        {
+            if (sscanf(value, "%dx%d", &options.width, &options.height) != 2)
+            {
+                std::cout << "Expected --size WIDTHxHEIGHT, got " << value << std::endl;
+                return false;
+            }
+        }
+        else
+        {
+            std::cout << "Unknown scene benchmark option " << arg << std::endl;
+            return false;
+        }
+        i++;
+    }
+
+    if (options.frames < 2 || options.width <= 0 || options.height <= 0 || options.warmupFrames < 0)
+    {
+        std::cout << "Invalid scene benchmark options" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool runBenchmarkFromCommandLine(int argc, char** argv, int& exitCode)
+{
+    exitCode = 0;
+    if (argc < 2 || strcmp(argv[1], "--bench") != 0)
+        return false;
+
+    if (argc < 3)
+    {
+        printUsage();
+        exitCode = 1;
+        return true;
+    }
+
+    const char* suite = argv[2];
+    if (strcmp(suite, "ecs") == 0)
+    {
+        int entityCount = argc > 3 ? atoi(argv[3]) : 100000;
+        runEcsBenchmark(entityCount > 0 ? entityCount : 100000);
+    }
+    else if (strcmp(suite, "transform") == 0)
+    {
+        int objectCount = argc > 3 ? atoi(argv[3]) : 100000;
+        runTransformBenchmark(objectCount > 0 ? objectCount : 100000);
+    }
+    else if (strcmp(suite, "loaders") == 0)
+    {
+        int iterations = argc > 3 ? atoi(argv[3]) : 5;
+        runLoaderBenchmark(iterations > 0 ? iterations : 5);
+    }
+    else if (strcmp(suite, "collision") == 0)
+    {
+        int iterations = argc > 3 ? atoi(argv[3]) : 5;
+        runCollisionBenchmark(iterations > 0 ? iterations : 5);
+    }
+    else if (strcmp(suite, "physics") == 0)
+    {
+        int maxBodies = argc > 3 ? atoi(argv[3]) : 100000;
+        runPhysicsBenchmark(maxBodies > 0 ? maxBodies : 100000);
+    }
+    else if (strcmp(suite, "particles") == 0)
+    {
+        int count = argc > 3 ? atoi(argv[3]) : 1000000;
+        runParticleBenchmark(count > 0 ? count : 1000000);
+    }
+    else if (strcmp(suite, "pacing") == 0)
+    {
+        float fps = argc > 3 ? (float)atof(argv[3]) : 60.0f;
+        exitCode = runPacingBenchmark(fps > 0.0f ? fps : 60.0f);
+    }
+    else if (strcmp(suite, "scene") == 0)
+    {
+        SceneBenchmarkOptions options;
+        if (parseSceneOptions(argc, argv, options))
+            exitCode = runSceneBenchmark(options);
+        else
+            exitCode = 1;
+    }
+    else
+    {
+        std::cout << "Unknown benchmark suite '" << suite << "'" << std::endl;
+        printUsage();
+        exitCode = 1;
+    }
+
+    return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// Command line benchmarks, run instead of the game:
+//   GameEngine.exe --bench ecs [entityCount]
+//   GameEngine.exe --bench transform [objectCount]
+//   GameEngine.exe --bench loaders [iterations]
+//   GameEngine.exe --bench collision [iterations]
+//   GameEngine.exe --bench physics [maxBodies]
+//   GameEngine.exe --bench particles [count]
+//   GameEngine.exe --bench pacing [fps]
+//   GameEngine.exe --bench scene [--scene N] [--baseline file.json] ...
+// Returns true when the arguments selected a benchmark (which has then run);
+// exitCode is non-zero when it failed or regressed against its baseline.
+bool runBenchmarkFromCommandLine(int argc, char** argv, int& exitCode);
+
+// Headless scene flythrough, see sceneBenchmark.cpp
+struct SceneBenchmarkOptions
+{
+    int sceneId = 1;
+    int frames = 600;           // measured frames, spread evenly over the camera path
+    int warmupFrames = 30;
+    int width = 1280;
+    int height = 720;
+    std::string contextApi = "native";
+    std::string cameraPath;     // empty: Resources/CameraPaths/scene<N>.path
+    std::string outputPath = "scene_benchmark.json";
+    std::string baselinePath;   // empty: no comparison
+    float tolerancePercent = 10.0f;
+    int shadowCascades = -1;    // -1: the renderer's defaults
+    int shadowResolution = -1;
+    float impostorDistance = -1.0f;     // -1: the renderer's default; 0 puts every rock and wall on a card
+    float frameBudgetMs = 0.0f;    // > 0: dynamic resolution holds this GPU time
+    std::string renderStatsPath;    // non-empty: RenderStats appends its summary there every second
+    int maxAllocatingFrames = -1;   // >= 0: fail when more measured frames allocated
+    float maxStreamingP99Ms = 0.0f; // > 0: fail when frames that load or remove a cell take longer at p99
+};
+
+// Individual suites
+void runEcsBenchmark(int entityCount);
+void runTransformBenchmark(int objectCount);
+void runLoaderBenchmark(int iterations);
+void runCollisionBenchmark(int iterations);
+void runPhysicsBenchmark(int maxBodies);
+void runParticleBenchmark(int count);
+int runPacingBenchmark(float targetFps);
+int runSceneBenchmark(const SceneBenchmarkOptions& options);
+
+// Runs fn `iterations` times and returns the median wall time in milliseconds
+template<typename Fn>
+double measureMedianMs(int iterations, Fn fn)
+{
+    std::vector<double> samples;
+    samples.reserve(iterations);
+
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        fn();
+        auto end = std::chrono::high_resolution_clock::now();
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
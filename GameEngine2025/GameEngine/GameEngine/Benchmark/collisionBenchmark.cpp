@@ -0,0 +1,241 @@
+#include "benchmark.h"
+#include "../Collision/collisionWorld.h"
+#include "../Collision/triangleBvh.h"
+#include "../Graphics/gpuUpload.h"
+#include "../Model Loading/meshCache.h"
+#include "../Model Loading/meshLoaderObj.h"
+#include "../ResourceManager/resourceManager.h"
+#include "../SceneManager/sceneManager.h"
+#include <gtc/matrix_transform.hpp>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+// Build cost of the per-mesh BVHs and query cost against scene 1, with GPU
+// uploads stubbed. Raycasts are checked against a brute-force test of every
+// triangle in the scene.
+
+static const char* COLLISION_MODELS[][2] =
+{
+    { "spaceship", "Resources/Models/Imperial_Steniel_obj.obj" },
+    { "cave_wall_set", "Resources/Models/CaveWalls2_Set.obj" },
+    { "cave_wall4_set", "Resources/Models/CaveWalls4_Set.obj" },
+    { "rock04_set", "Resources/Models/Rock04_Set.obj" },
+    { "asteroid", "Resources/Models/Asteroid_1.obj" },
+    { "alien", "Resources/Models/body.obj" }
+};
+
+static const int RAY_COUNT = 20000;
+static const int VALIDATED_RAYS = 500;
+static const int MOVE_COUNT = 5000;
+static const float RAY_LENGTH = 300.0f;
+
+static float randomRange(float lo, float hi)
+{
+    return lo + (hi - lo) * ((float)rand() / RAND_MAX);
+}
+
+// Every solid triangle of the scene in world space, for the reference raycast
+struct WorldTriangle
+{
+    glm::vec3 a, b, c;
+};
+
+static void collectTriangles(EntityWorld& world, std::vector<WorldTriangle>& triangles)
+{
+    ResourceManager& rm = ResourceManager::getInstance();
+    const ComponentMask nonSolid = componentBit(TAG_PORTAL_MARKER) | componentBit(COMPONENT_PREVIOUS_POSITION);
+    world.forEachChunk(RENDERABLE_COMPONENTS, nonSolid, [&](ArchetypeChunk& chunk)
+    {
+        for (uint32_t i = 0; i < chunk.count; i++)
+        {
+            const TriangleBvh* bvh = rm.getCollisionMesh(chunk.column<COMPONENT_MESH>()[i]);
+            if (!bvh)
+                continue;
+
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), chunk.column<COMPONENT_POSITION>()[i]) *
+                glm::mat4_cast(chunk.column<COMPONENT_ROTATION>()[i]) *
+                glm::scale(glm::mat4(1.0f), chunk.column<COMPONENT_SCALE>()[i]);
+            bvh->forEachTriangle(glm::vec3(-FLT_MAX), glm::vec3(FLT_MAX), [&](const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+            {
+                WorldTriangle triangle = { glm::vec3(model * glm::vec4(a, 1.0f)), glm::vec3(model * glm::vec4(b, 1.0f)),
+                    glm::vec3(model * glm::vec4(c, 1.0f)) };
+                triangles.push_back(triangle);
+            });
+        }
+    });
+}
+
+static float bruteForceRaycast(const std::vector<WorldTriangle>& triangles, const glm::vec3& origin, const glm::vec3& direction)
+{
+    float best = RAY_LENGTH;
+    for (const WorldTriangle& triangle : triangles)
+    {
+        glm::vec3 edge1 = triangle.b - triangle.a;
+        glm::vec3 edge2 = triangle.c - triangle.a;
+        glm::vec3 pvec = glm::cross(direction, edge2);
+        float det = glm::dot(edge1, pvec);
+        if (det == 0.0f)
+            continue;
+        float inverseDet = 1.0f / det;
+        glm::vec3 tvec = origin - triangle.a;
+        float u = glm::dot(tvec, pvec) * inverseDet;
+        glm::vec3 qvec = glm::cross(tvec, edge1);
+        float v = glm::dot(direction, qvec) * inverseDet;
+        float t = glm::dot(edge2, qvec) * inverseDet;
+        if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t < best)
+            best = t;
+    }
+    return best;
+}
+
+void runCollisionBenchmark(int iterations)
+{
+    std::cout << "Collision benchmark: " << iterations << " iterations, GPU upload stubbed" << std::endl;
+    setGpuUploadEnabled(false);
+
+    // ===== PER-MESH BVH =====
+    std::cout << "TriangleBvh::build" << std::endl;
+    MeshLoaderObj loader;
+    for (const auto& model : COLLISION_MODELS)
+    {
+        std::vector<Vertex> vertices;
+        std::vector<int> indices;
+        if (!readMeshCache(model[1], vertices, indices) && !loader.parseObj(model[1], vertices, indices))
+        {
+            printf("  %-20s missing (%s)\n", model[0], model[1]);
+            continue;
+        }
+
+        TriangleBvh bvh;
+        double buildMs = measureMedianMs(iterations, [&]() { bvh.build(vertices, indices); });
+        writeTriangleBvhCache(model[1], bvh);
+        TriangleBvh cached;
+        double readMs = measureMedianMs(iterations, [&]() { readTriangleBvhCache(model[1], cached); });
+
+        printf("  %-20s %8u tris %7u nodes %8.1f KB   build %8.3f ms (%5.1f M tris/s)   cache read %6.3f ms\n",
+            model[0], bvh.getTriangleCount(), bvh.getNodeCount(), bvh.getMemoryBytes() / 1024.0,
+            buildMs, bvh.getTriangleCount() / (buildMs * 1.0e3), readMs);
+    }
+
+    // ===== SCENE QUERIES =====
+    SceneManager sceneManager;
+    {
+        std::streambuf* previous = std::cout.rdbuf(nullptr);
+        sceneManager.initializeResources();
+        sceneManager.loadScene(1);
+        std::cout.rdbuf(previous);
+    }
+    std::cout.clear();
+
+    const CollisionWorld& collision = sceneManager.getCollisionWorld();
+    std::vector<WorldTriangle> triangles;
+    collectTriangles(sceneManager.getWorld(), triangles);
+
+    std::cout << "CollisionWorld (scene 1: " << collision.getInstanceCount() << " solid instances, "
+        << triangles.size() << " triangles)" << std::endl;
+
+    CollisionWorld rebuilt;
+    double buildMs = measureMedianMs(iterations, [&]()
+    {
+        rebuilt.build(sceneManager.getWorld(), componentBit(TAG_PORTAL_MARKER) | componentBit(COMPONENT_PREVIOUS_POSITION));
+    });
+    printf("  %-24s %10.3f ms\n", "build (top level)", buildMs);
+
+    // Rays from around head height towards random points on the geometry, so
+    // most of them hit something after a realistic amount of traversal
+    srand(1234);
+    std::vector<glm::vec3> origins(RAY_COUNT), directions(RAY_COUNT);
+    for (int i = 0; i < RAY_COUNT; i++)
+    {
+        const WorldTriangle& target = triangles[(size_t)randomRange(0.0f, (float)(triangles.size() - 1))];
+        glm::vec3 point = (target.a + target.b + target.c) / 3.0f;
+        origins[i] = glm::vec3(point.x + randomRange(-60.0f, 60.0f), randomRange(-8.3f, 10.0f), point.z + randomRange(-60.0f, 60.0f));
+        directions[i] = glm::normalize(point - origins[i]);
+    }
+
+    int hits = 0;
+    double rayMs = measureMedianMs(iterations, [&]()
+    {
+        hits = 0;
+        for (int i = 0; i < RAY_COUNT; i++)
+        {
+            RaycastHit hit;
+            if (collision.raycast(origins[i], directions[i], RAY_LENGTH, hit))
+                hits++;
+        }
+    });
+    printf("  %-24s %10.1f ns/ray   %5.1f%% hit\n", "raycast", rayMs * 1.0e6 / RAY_COUNT, 100.0 * hits / RAY_COUNT);
+
+    int mismatches = 0;
+    double bruteMs = measureMedianMs(1, [&]()
+    {
+        for (int i = 0; i < VALIDATED_RAYS; i++)
+        {
+            RaycastHit hit;
+            float expected = bruteForceRaycast(triangles, origins[i], directions[i]);
+            float actual = collision.raycast(origins[i], directions[i], RAY_LENGTH, hit) ? hit.distance : RAY_LENGTH;
+            if (fabs(expected - actual) > 1.0e-3f * (1.0f + expected))
+                mismatches++;
+        }
+    });
+    printf("  %-24s %10.1f ns/ray   %d of %d rays disagree\n", "brute force (reference)",
+        bruteMs * 1.0e6 / VALIDATED_RAYS, mismatches, VALIDATED_RAYS);
+
+    // Player-sized capsules next to the geometry, each taking one tick's step
+    std::vector<Capsule> bodies(MOVE_COUNT);
+    std::vector<glm::vec3> steps(MOVE_COUNT);
+    for (int i = 0; i < MOVE_COUNT; i++)
+    {
+        glm::vec3 eye = origins[i];
+        RaycastHit hit;
+        if (collision.raycast(origins[i], directions[i], RAY_LENGTH, hit))
+            eye = hit.point + hit.normal * randomRange(0.0f, 2.0f);
+        bodies[i].a = eye - glm::vec3(0.0f, 1.3f, 0.0f);
+        bodies[i].b = eye;
+        bodies[i].radius = 0.4f;
+        steps[i] = glm::normalize(glm::vec3(randomRange(-1.0f, 1.0f), 0.0f, randomRange(-1.0f, 1.0f))) * 0.5f;
+    }
+
+    int contacts = 0;
+    double overlapMs = measureMedianMs(iterations, [&]()
+    {
+        contacts = 0;
+        for (int i = 0; i < MOVE_COUNT; i++)
+        {
+            ShapeHit hit;
+            if (collision.overlapCapsule(bodies[i], hit))
+                contacts++;
+        }
+    });
+    printf("  %-24s %10.1f ns/query %5.1f%% touching\n", "overlapCapsule", overlapMs * 1.0e6 / MOVE_COUNT, 100.0 * contacts / MOVE_COUNT);
+
+    int blocked = 0;
+    double sweepMs = measureMedianMs(iterations, [&]()
+    {
+        blocked = 0;
+        for (int i = 0; i < MOVE_COUNT; i++)
+        {
+            ShapeHit hit;
+            if (collision.sweepCapsule(bodies[i], steps[i] * 10.0f, hit))
+                blocked++;
+        }
+    });
+    printf("  %-24s %10.1f ns/query %5.1f%% blocked (5 m sweeps)\n", "sweepCapsule", sweepMs * 1.0e6 / MOVE_COUNT, 100.0 * blocked / MOVE_COUNT);
+
+    double moveMs = measureMedianMs(iterations, [&]()
+    {
+        for (int i = 0; i < MOVE_COUNT; i++)
+            collision.moveCapsule(bodies[i], steps[i]);
+    });
+    printf("  %-24s %10.1f ns/move\n", "moveCapsule", moveMs * 1.0e6 / MOVE_COUNT);
+
+    // What the game does per simulation tick: up to two moves and one pick
+    printf("  %-24s %10.1f us\n", "per tick (2 moves, 1 ray)",
+        (2.0 * moveMs / MOVE_COUNT + rayMs / RAY_COUNT) * 1.0e3);
+
+    sceneManager.clearScene();
+    ResourceManager::getInstance().cleanup();
+}
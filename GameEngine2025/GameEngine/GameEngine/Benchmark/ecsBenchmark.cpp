@@ -0,0 +1,114 @@
+#include "benchmark.h"
+#include "../ECS/entityWorld.h"
+#include "../ECS/transformSystem.h"
+#include "../GameObject/gameObject.h"
+#include <memory>
+#include <cstdio>
+#include <iostream>
+
+// Compares the archetype chunk storage against the old scene layout
+// (one heap-allocated GameObject per prop reached through a unique_ptr).
+
+static const int ITERATIONS = 15;
+
+static void report(const char* name, double oldMs, double ecsMs, int count, double ecsBytesPerEntity)
+{
+    double gbPerSecond = (ecsBytesPerEntity * count) / (ecsMs * 1.0e6);
+    printf("  %-28s old %8.3f ms   ecs %8.3f ms   x%5.2f   ecs %6.2f GB/s   %6.2f ns/entity\n",
+        name, oldMs, ecsMs, oldMs / ecsMs, gbPerSecond, ecsMs * 1.0e6 / count);
+}
+
+void runEcsBenchmark(int entityCount)
+{
+    std::cout << "ECS benchmark: " << entityCount << " entities, median of " << ITERATIONS << " runs" << std::endl;
+
+    // ===== OLD LAYOUT =====
+    std::vector<std::unique_ptr<GameObject>> objects;
+    objects.reserve(entityCount);
+    for (int i = 0; i < entityCount; i++)
+    {
+        glm::vec3 pos((float)(i % 1000), 0.0f, (float)(i / 1000));
+        objects.push_back(std::make_unique<GameObject>(MeshHandle(), pos, glm::vec3(0.0f, (float)(i % 360), 0.0f), glm::vec3(1.0f)));
+    }
+
+    // ===== ARCHETYPE LAYOUT =====
+    EntityWorld world;
+    for (int i = 0; i < entityCount; i++)
+    {
+        Entity e = world.createEntity(RENDERABLE_COMPONENTS | componentBit(TAG_ROCK));
+        world.get<COMPONENT_POSITION>(e) = glm::vec3((float)(i % 1000), 0.0f, (float)(i / 1000));
+        world.get<COMPONENT_ROTATION>(e) = eulerToQuat(glm::vec3(0.0f, (float)(i % 360), 0.0f));
+    }
+    updateModelMatrices(world);
+
+    const ComponentMask rocks = componentBit(TAG_ROCK);
+    glm::quat spin = glm::angleAxis(glm::radians(0.4f), glm::vec3(0.0f, 1.0f, 0.0f));
+    volatile float sink = 0.0f;
+
+    // Read-only sweep over positions (proximity tests, culling)
+    double oldSweep = measureMedianMs(ITERATIONS, [&]()
+    {
+        glm::vec3 sum(0.0f);
+        for (auto& object : objects)
+            sum += object->getPosition();
+        sink = sum.x + sum.y + sum.z;
+    });
+    double ecsSweep = measureMedianMs(ITERATIONS, [&]()
+    {
+        glm::vec3 sum(0.0f);
+        world.forEachChunk(rocks | componentBit(COMPONENT_POSITION), [&](const ArchetypeChunk& chunk)
+        {
+            const glm::vec3* positions = chunk.column<COMPONENT_POSITION>();
+            for (uint32_t i = 0; i < chunk.count; i++)
+                sum += positions[i];
+        });
+        sink = sum.x + sum.y + sum.z;
+    });
+    report("position sweep", oldSweep, ecsSweep, entityCount, sizeof(glm::vec3));
+
+    // Read cached world matrices (what the render loop does)
+    double oldMatrices = measureMedianMs(ITERATIONS, [&]()
+    {
+        float sum = 0.0f;
+        for (auto& object : objects)
+            sum += object->getModelMatrix()[3][0];
+        sink = sum;
+    });
+    double ecsMatrices = measureMedianMs(ITERATIONS, [&]()
+    {
+        float sum = 0.0f;
+        world.forEachChunk(rocks | componentBit(COMPONENT_MODEL_MATRIX), [&](const ArchetypeChunk& chunk)
+        {
+            const glm::mat4* models = chunk.column<COMPONENT_MODEL_MATRIX>();
+            for (uint32_t i = 0; i < chunk.count; i++)
+                sum += models[i][3][0];
+        });
+        sink = sum;
+    });
+    report("model matrix read", oldMatrices, ecsMatrices, entityCount, sizeof(glm::mat4));
+
+    // Animate every object and rebuild its matrix (portal-style update)
+    double oldAnimate = measureMedianMs(ITERATIONS, [&]()
+    {
+        for (auto& object : objects)
+        {
+            object->setRotation(spin * object->getOrientation());
+            object->getModelMatrix();
+        }
+    });
+    double ecsAnimate = measureMedianMs(ITERATIONS, [&]()
+    {
+        world.forEachChunk(rocks | componentBit(COMPONENT_ROTATION), [&](ArchetypeChunk& chunk)
+        {
+            glm::quat* rotations = chunk.column<COMPONENT_ROTATION>();
+            for (uint32_t i = 0; i < chunk.count; i++)
+                rotations[i] = glm::normalize(spin * rotations[i]);
+            chunk.transformsDirty = true;
+        });
+        updateModelMatrices(world);
+    });
+    report("animate + rebuild matrix", oldAnimate, ecsAnimate, entityCount,
+        sizeof(glm::vec3) * 2 + sizeof(glm::quat) * 2 + sizeof(glm::mat4));
+
+    (void)sink;
+}
@@ -0,0 +1,398 @@
+#include "benchmark.h"
+#include "../Core/allocationTracker.h"
+#include "../Graphics/gpuUpload.h"
+#include "../Model Loading/meshLoaderObj.h"
+#include "../Model Loading/texture.h"
+#include "../ResourceManager/resourceManager.h"
+#include "../SceneManager/sceneManager.h"
+#include "../SceneManager/sceneFile.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <streambuf>
+#include <thread>
+
+// CPU cost of the asset loaders and scene construction with GPU uploads
+// stubbed out, so it runs on build machines without a GL context. Reports
+// median time, throughput and heap allocations per call.
+
+struct AssetFile
+{
+    const char* name;
+    const char* path;
+};
+
+// The assets SceneManager::initializeResources loads
+static const AssetFile MODELS[] =
+{
+    { "spaceship", "Resources/Models/Imperial_Steniel_obj.obj" },
+    { "cave_wall_a", "Resources/Models/CaveWalls2_A.obj" },
+    { "cave_wall_b", "Resources/Models/CaveWalls2_B.obj" },
+    { "cave_wall_c", "Resources/Models/CaveWalls2_C.obj" },
+    { "cave_wall_set", "Resources/Models/CaveWalls2_Set.obj" },
+    { "asteroid", "Resources/Models/Asteroid_1.obj" },
+    { "cave_wall4_set", "Resources/Models/CaveWalls4_Set.obj" },
+    { "rock04_a", "Resources/Models/Rock04_A.obj" },
+    { "rock04_b", "Resources/Models/Rock04_B.obj" },
+    { "rock04_c", "Resources/Models/Rock04_C.obj" },
+    { "rock04_d", "Resources/Models/Rock04_D.obj" },
+    { "rock04_e", "Resources/Models/Rock04_E.obj" },
+    { "rock04_set", "Resources/Models/Rock04_Set.obj" },
+    { "alien", "Resources/Models/body.obj" },
+    { "bag", "Resources/Models/bakery paper bag.obj" }
+};
+
+static const AssetFile TEXTURES[] =
+{
+    { "mars", "Resources/Textures/mars.bmp" },
+    { "base_color", "Resources/Textures/Texture_1K/Base_BaseColor.bmp" },
+    { "base_normal", "Resources/Textures/Texture_1K/Base_Normal.bmp" },
+    { "cave_wall_diffuse", "Resources/Textures/CaveWalls2_Base_Diffuse.bmp" },
+    { "asteroid_diffuse", "Resources/Textures/Asteroid_1_Diffuse_1K.bmp" },
+    { "cave_wall4_diffuse", "Resources/Textures/CaveWalls4_Base_Diffuse.bmp" },
+    { "alien_body", "Resources/Textures/body_Base_Color.bmp" },
+    { "alien_eye", "Resources/Textures/eye_Base_Color.bmp" },
+    { "bag_diffuse", "Resources/Textures/tex_bakery_paper_bag.bmp" }
+};
+
+// Swallows std::cout while the loaders log, so console I/O stays out of the timings
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+};
+
+class ScopedSilence
+{
+public:
+    ScopedSilence() : previous(std::cout.rdbuf(&sink)) {}
+    ~ScopedSilence() { std::cout.rdbuf(previous); }
+
+private:
+    NullBuffer sink;
+    std::streambuf* previous;
+};
+
+struct LoaderSample
+{
+    double medianMs;
+    AllocationStats allocations;    // of a single call
+};
+
+// Times fn over `iterations` runs; reset() runs untimed before each one
+template<typename Reset, typename Fn>
+static LoaderSample measureLoader(int iterations, Reset reset, Fn fn)
+{
+    std::vector<double> samples;
+    LoaderSample sample = {};
+
+    for (int i = 0; i < iterations; i++)
+    {
+        reset();
+
+        AllocationStats before = getAllocationStats();
+        auto start = std::chrono::high_resolution_clock::now();
+        {
+            ScopedSilence silence;
+            fn();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        sample.allocations = getAllocationStats() - before;
+
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    sample.medianMs = samples[samples.size() / 2];
+    return sample;
+}
+
+static long long fileSize(const char* path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file ? (long long)file.tellg() : -1;
+}
+
+static void printSample(const char* label, const LoaderSample& sample, long long bytes, const char* detail)
+{
+    printf("  %-32s %9.3f ms", label, sample.medianMs);
+    if (bytes > 0)
+        printf("  %8.1f MB/s", bytes / (sample.medianMs * 1.0e3));
+    else
+        printf("  %13s", "");
+    printf("  %8llu allocs %10.1f KB  %s\n", sample.allocations.count, sample.allocations.bytes / 1024.0, detail);
+}
+
+static void noReset()
+{
+}
+
+// Scatters `count` rocks and walls over a square kilometre, in the text scene format
+static bool writeSyntheticScene(const char* path, int count)
+{
+    std::ofstream file(path);
+    if (!file)
+        return false;
+
+    const char* meshes[] = { "rock04_a", "rock04_b", "rock04_c", "cave_wall_a", "cave_wall_b" };
+    const char* tags[] = { "rock", "rock", "rock", "cave_wall", "cave_wall" };
+
+    file << "name Synthetic placements\n";
+    srand(1234);
+    for (int i = 0; i < count; i++)
+    {
+        int kind = rand() % 5;
+        file << "object " << meshes[kind] << " " << tags[kind] << " "
+            << (rand() % 1000 - 500) << " -8 " << (rand() % 1000 - 500) << " 0 " << (rand() % 360) << " 0 "
+            << (1.0f + (rand() % 200) / 100.0f) << (i % 100 == 0 ? " enhanced animated\n" : "\n");
+    }
+    file << "trigger 0 -8 0 25 1 Synthetic trigger\n";
+    return true;
+}
+
+void runLoaderBenchmark(int iterations)
+{
+    std::cout << "Loader benchmark: " << iterations << " iterations per asset, GPU upload stubbed" << std::endl;
+    if (!isAllocationTrackingEnabled())
+        std::cout << "  (allocation tracking is compiled out; counts read 0)" << std::endl;
+
+    setGpuUploadEnabled(false);
+    ResourceManager& rm = ResourceManager::getInstance();
+    rm.cleanup();
+
+    char detail[128];
+
+    // ===== OBJ MODELS =====
+    std::cout << "MeshLoaderObj::loadObj" << std::endl;
+    MeshLoaderObj loader;
+    for (const AssetFile& model : MODELS)
+    {
+        long long bytes = fileSize(model.path);
+        if (bytes < 0)
+        {
+            printf("  %-32s missing (%s)\n", model.name, model.path);
+            continue;
+        }
+
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
+        LoaderSample sample = measureLoader(iterations, noReset, [&]()
+        {
+            Mesh mesh = loader.loadObj(model.path);
+            vertexCount = mesh.vertices.size();
+            indexCount = mesh.indices.size();
+        });
+
+        snprintf(detail, sizeof(detail), "%zu vertices, %zu indices", vertexCount, indexCount);
+        printSample(model.name, sample, bytes, detail);
+    }
+
+    // ===== BMP TEXTURES =====
+    std::cout << "decodeBMP" << std::endl;
+    for (const AssetFile& texture : TEXTURES)
+    {
+        long long bytes = fileSize(texture.path);
+        if (bytes < 0)
+        {
+            printf("  %-32s missing (%s)\n", texture.name, texture.path);
+            continue;
+        }
+
+        unsigned int width = 0, height = 0;
+        LoaderSample sample = measureLoader(iterations, noReset, [&]()
+        {
+            ImageData image;
+            if (decodeBMP(texture.path, image))
+            {
+                width = image.width;
+                height = image.height;
+            }
+        });
+
+        snprintf(detail, sizeof(detail), "%ux%u", width, height);
+        printSample(texture.name, sample, bytes, detail);
+    }
+
+    // ===== PROCEDURAL MESHES =====
+    std::cout << "ResourceManager procedural meshes" << std::endl;
+    {
+        auto reset = [&]() { rm.cleanup(); };
+
+        LoaderSample stars = measureLoader(iterations, reset, [&]() { rm.createStarField("stars", 500, 2000.0f); });
+        printSample("createStarField(500)", stars, 0, "");
+
+        LoaderSample ground = measureLoader(iterations, reset, [&]() { rm.createGround("ground", 200.0f, "mars"); });
+        printSample("createGround(200)", ground, 0, "21x21 grid");
+    }
+
+    // ===== ASSET LOOKUPS =====
+    std::cout << "ResourceManager lookups" << std::endl;
+    {
+        rm.cleanup();
+
+        // Registration only, so nothing is loaded
+        const int NAME_COUNT = 512;
+        const int LOOKUPS = 1000000;
+        std::vector<std::string> names;
+        std::vector<MeshHandle> handles;
+        std::map<std::string, Mesh*> oldIndex;
+        for (int i = 0; i < NAME_COUNT; i++)
+        {
+            names.push_back(i == 0 ? std::string("asteroid") : "mesh_" + std::to_string(i));
+            handles.push_back(rm.registerMesh(names.back(), "", std::vector<TextureBinding>()));
+            oldIndex[names.back()] = rm.getMesh(handles.back());
+        }
+
+        volatile uintptr_t sink = 0;
+        auto report = [&](const char* label, const LoaderSample& sample)
+        {
+            snprintf(detail, sizeof(detail), "%.1f ns/lookup", sample.medianMs * 1.0e6 / LOOKUPS);
+            printSample(label, sample, 0, detail);
+        };
+
+        report("std::map<std::string> find", measureLoader(iterations, noReset, [&]()
+        {
+            for (int i = 0; i < LOOKUPS; i++)
+                sink = sink + (uintptr_t)oldIndex.find(names[i % NAME_COUNT])->second;
+        }));
+        report("findMesh(std::string)", measureLoader(iterations, noReset, [&]()
+        {
+            for (int i = 0; i < LOOKUPS; i++)
+                sink = sink + rm.findMesh(names[i % NAME_COUNT]).value;
+        }));
+        report("findMesh(ASSET_NAME)", measureLoader(iterations, noReset, [&]()
+        {
+            for (int i = 0; i < LOOKUPS; i++)
+                sink = sink + rm.findMesh(ASSET_NAME("asteroid")).value;
+        }));
+        report("getMesh(MeshHandle)", measureLoader(iterations, noReset, [&]()
+        {
+            for (int i = 0; i < LOOKUPS; i++)
+                sink = sink + (uintptr_t)rm.getMesh(handles[i % NAME_COUNT]);
+        }));
+    }
+
+    // ===== SCENE CONSTRUCTION =====
+    std::cout << "SceneManager" << std::endl;
+    {
+        SceneManager sceneManager;
+        rm.cleanup();
+
+        // Registration only; the loads happen in the first loadScene of each scene
+        LoaderSample init = measureLoader(1, noReset, [&]() { sceneManager.initializeResources(); });
+        printSample("initializeResources", init, 0, "register only");
+
+        for (int sceneId = 1; sceneId <= 2; sceneId++)
+        {
+            LoaderSample scene = measureLoader(iterations, noReset, [&]() { sceneManager.loadScene(sceneId); });
+            snprintf(detail, sizeof(detail), "%u entities", sceneManager.getWorld().getEntityCount());
+            char label[64];
+            snprintf(label, sizeof(label), "loadScene(%d)", sceneId);
+            printSample(label, scene, 0, detail);
+        }
+
+        // The N-key path once the player has been near the portal for a while
+        LoaderSample swap = measureLoader(iterations, [&]()
+        {
+            ScopedSilence silence;
+            sceneManager.loadScene(2);
+            sceneManager.startPrefetch(1);
+            while (!sceneManager.isPrefetchReady(1))
+                std::this_thread::yield();
+        }, [&]() { sceneManager.loadScene(1); });
+        printSample("loadScene(1) from prefetch", swap, 0, "swap only");
+
+        // With no budget, switching scenes evicts everything the previous one used
+        rm.setMemoryBudget(0, 0);
+        LoaderSample reload = measureLoader(iterations, [&]()
+        {
+            ScopedSilence silence;
+            sceneManager.loadScene(2);
+        }, [&]() { sceneManager.loadScene(1); });
+        ResourceMemoryStats memory = rm.getMemoryStats();
+        snprintf(detail, sizeof(detail), "%u meshes from .meshcache, %u evictions so far", memory.residentMeshes, memory.evictions);
+        printSample("loadScene(1) after eviction", reload, 0, detail);
+
+        // Same, but the prefetch also started the mesh loads: the swap no
+        // longer waits for them, and they finish over the following frames
+        const double UPLOAD_BUDGET_MS = 2.0;
+        auto drainUploads = [&]()
+        {
+            while (rm.getPendingLoadCount() > 0)
+                rm.processUploads(UPLOAD_BUDGET_MS);
+        };
+        auto prefetchAfterEviction = [&]()
+        {
+            ScopedSilence silence;
+            drainUploads();
+            sceneManager.loadScene(2);
+            sceneManager.startPrefetch(1);
+            while (!sceneManager.isPrefetchReady(1))
+                std::this_thread::yield();
+        };
+        LoaderSample asyncSwap = measureLoader(iterations, prefetchAfterEviction, [&]() { sceneManager.loadScene(1); });
+        printSample("prefetch swap after eviction", asyncSwap, 0, "meshes still loading");
+
+        unsigned int frames = 0;
+        LoaderSample streaming = measureLoader(iterations, [&]()
+        {
+            prefetchAfterEviction();
+            ScopedSilence silence;
+            sceneManager.loadScene(1);
+            frames = 0;
+        }, [&]()
+        {
+            while (rm.getPendingLoadCount() > 0)
+            {
+                if (rm.processUploads(UPLOAD_BUDGET_MS) > 0)
+                    frames++;
+                else
+                    std::this_thread::yield();
+            }
+        });
+        snprintf(detail, sizeof(detail), "wall time, %u frames with uploads", frames);
+        printSample("  async loads until resident", streaming, 0, detail);
+        rm.setMemoryBudget(512 * 1024 * 1024, 512 * 1024 * 1024);
+    }
+
+    // ===== SCENE FILES =====
+    std::cout << "Scene files" << std::endl;
+    {
+        const int PLACEMENTS = 50000;
+        const char* textPath = "loader_benchmark.scene";
+        const char* binaryPath = "loader_benchmark.scenebin";
+
+        if (writeSyntheticScene(textPath, PLACEMENTS))
+        {
+            std::vector<unsigned char> bytes;
+            LoaderSample compile = measureLoader(iterations, noReset, [&]() { compileSceneText(textPath, bytes); });
+            snprintf(detail, sizeof(detail), "%d placements (offline step)", PLACEMENTS);
+            printSample("compileSceneText", compile, fileSize(textPath), detail);
+
+            {
+                ScopedSilence silence;
+                compileSceneFile(textPath, binaryPath);
+            }
+
+            uint32_t entityCount = 0;
+            SceneContents scene;
+            LoaderSample instantiate = measureLoader(iterations, [&]() { scene.world.clear(); scene.triggerZones.clear(); }, [&]()
+            {
+                SceneFile file;
+                if (file.open(binaryPath))
+                    SceneManager::instantiateScene(file, scene);
+                entityCount = scene.world.getEntityCount();
+            });
+            snprintf(detail, sizeof(detail), "%u entities", entityCount);
+            printSample("map + instantiateScene", instantiate, fileSize(binaryPath), detail);
+        }
+
+        std::remove(textPath);
+        std::remove(binaryPath);
+    }
+
+    rm.cleanup();
+    setGpuUploadEnabled(true);
+}
@@ -0,0 +1,91 @@
+#include "benchmark.h"
+#include "../Graphics/framePacer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+
+// Checks the capped-mode schedule of FramePacer without a window: frames do
+// no work but sleep for a chosen share of the period, and the time from one
+// endFrame to the next is what the loop would see. After a frame that ran
+// over, the next one must get a whole period again instead of the remainder
+// of a schedule that has already passed.
+
+static const int WARMUP_FRAMES = 10;
+static const int STEADY_FRAMES = 30;
+
+// Overruns to recover from, in periods of frame work
+static const double OVERRUNS[] = { 1.1, 1.5, 2.5 };
+
+// Late wake-ups are made up by the next frame, so single light frames may
+// be short; the mean must hold the period. Sleeps never wake up early, so
+// the frame after an overrun has no reason to be short at all.
+static const double MEAN_TOLERANCE = 0.05;
+static const double SHORT_FRAME = 0.9;
+
+typedef std::chrono::steady_clock Clock;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static void work(double ms)
+{
+    std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(ms));
+}
+
+int runPacingBenchmark(float targetFps)
+{
+    FramePacer pacer;
+    pacer.setMode(PACING_CAPPED);
+    pacer.setTargetFps(targetFps);
+    double periodMs = 1000.0 / pacer.getTargetFps();
+
+    std::cout << "Capped frame pacing at " << pacer.getTargetFps() << " fps (" << periodMs << " ms period)" << std::endl;
+
+    for (int i = 0; i < WARMUP_FRAMES; i++)
+        pacer.endFrame();
+
+    // Light frames are held to the period
+    double shortest = 1.0e9;
+    double sum = 0.0;
+    Clock::time_point last = Clock::now();
+    for (int i = 0; i < STEADY_FRAMES; i++)
+    {
+        work(periodMs * 0.25);
+        pacer.endFrame();
+        double frameMs = millisecondsSince(last);
+        last = Clock::now();
+        shortest = std::min(shortest, frameMs);
+        sum += frameMs;
+    }
+    double meanMs = sum / STEADY_FRAMES;
+    bool passed = std::fabs(meanMs - periodMs) <= periodMs * MEAN_TOLERANCE;
+    printf("  steady      %d frames, %.3f ms mean, %.3f ms shortest  %s\n", STEADY_FRAMES,
+        meanMs, shortest, passed ? "ok" : "OFF THE PERIOD");
+
+    // One heavy frame, then light ones again
+    for (double overrun : OVERRUNS)
+    {
+        work(periodMs * 0.25);
+        pacer.endFrame();
+
+        work(periodMs * overrun);
+        pacer.endFrame();
+
+        Clock::time_point start = Clock::now();
+        pacer.endFrame();
+        double nextMs = millisecondsSince(start);
+
+        bool recovered = nextMs >= periodMs * SHORT_FRAME;
+        passed = passed && recovered;
+        printf("  overrun %.1fx  next frame %.3f ms  %s\n", overrun, nextMs, recovered ? "ok" : "CATCH-UP BURST");
+    }
+
+    if (!passed)
+        std::cout << "FRAME PACING FAILED" << std::endl;
+    return passed ? 0 : 1;
+}
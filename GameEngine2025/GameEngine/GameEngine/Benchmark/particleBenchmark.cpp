@@ -0,0 +1,172 @@
+#include "benchmark.h"
+#include "../Core/frameArena.h"
+#include "../Particles/particleSystem.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+// Compares the SoA particle kernels against the straightforward layout (one
+// struct per particle, updated and killed in a scalar loop) on an emitter
+// kept full: every frame about 1/180 of the particles expire and respawn.
+
+static const float FRAME_SECONDS = 1.0f / 60.0f;
+static const int WARMUP_FRAMES = 240;   // past the first lifetimes, so deaths are spread out
+static const int MEASURED_FRAMES = 30;
+
+static ParticleEmitterDesc benchmarkEmitter(uint32_t count)
+{
+    ParticleEmitterDesc desc;
+    desc.positionSpread = glm::vec3(50.0f, 2.0f, 50.0f);
+    desc.velocity = glm::vec3(0.5f, 0.2f, 0.0f);
+    desc.velocitySpread = glm::vec3(0.5f);
+    desc.acceleration = glm::vec3(0.0f, -0.1f, 0.0f);
+    desc.drag = 0.2f;
+    desc.minLifetime = 2.0f;
+    desc.maxLifetime = 4.0f;
+    desc.startSize = 0.2f;
+    desc.endSize = 0.6f;
+    desc.startColor = glm::vec4(0.8f, 0.5f, 0.3f, 0.6f);
+    desc.endColor = glm::vec4(0.6f, 0.4f, 0.3f, 0.0f);
+    desc.maxParticles = count;
+    // Enough to refill even the first generation, which all expires within
+    // maxLifetime - minLifetime; the emitter stays full
+    desc.rate = count / desc.minLifetime;
+    return desc;
+}
+
+// ===== SCALAR REFERENCE =====
+
+struct ScalarParticle
+{
+    glm::vec3 position;
+    glm::vec3 velocity;
+    float age;
+    float lifetime;
+};
+
+struct ScalarEmitter
+{
+    ParticleEmitterDesc desc;
+    std::vector<ScalarParticle> particles;
+    float emitDebt = 0.0f;
+    uint32_t seed = 1;
+
+    float random(float lo, float hi)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * ((seed >> 8) * (1.0f / 16777216.0f));
+    }
+
+    void emit(uint32_t amount)
+    {
+        for (uint32_t i = 0; i < amount && particles.size() < desc.maxParticles; i++)
+        {
+            ScalarParticle particle;
+            particle.position = desc.position + glm::vec3(random(-1.0f, 1.0f), random(-1.0f, 1.0f),
+                random(-1.0f, 1.0f)) * desc.positionSpread;
+            particle.velocity = desc.velocity + glm::vec3(random(-1.0f, 1.0f), random(-1.0f, 1.0f),
+                random(-1.0f, 1.0f)) * desc.velocitySpread;
+            particle.age = 0.0f;
+            particle.lifetime = random(desc.minLifetime, desc.maxLifetime);
+            particles.push_back(particle);
+        }
+    }
+
+    void update(float dt)
+    {
+        float damping = std::max(1.0f - desc.drag * dt, 0.0f);
+        for (size_t i = 0; i < particles.size();)
+        {
+            ScalarParticle& particle = particles[i];
+            particle.velocity = particle.velocity * damping + desc.acceleration * dt;
+            particle.position += particle.velocity * dt;
+            particle.age += dt;
+            if (particle.age >= particle.lifetime)
+            {
+                particle = particles.back();
+                particles.pop_back();
+                continue;
+            }
+            i++;
+        }
+
+        emitDebt += desc.rate * dt;
+        uint32_t spawned = (uint32_t)emitDebt;
+        emitDebt -= (float)spawned;
+        emit(spawned);
+    }
+
+    void writeInstances(glm::vec4* centers, uint32_t* colors) const
+    {
+        for (size_t i = 0; i < particles.size(); i++)
+        {
+            const ScalarParticle& particle = particles[i];
+            float t = std::min(particle.age / particle.lifetime, 1.0f);
+            centers[i] = glm::vec4(particle.position, desc.startSize + (desc.endSize - desc.startSize) * t);
+            glm::vec4 color = (desc.startColor + (desc.endColor - desc.startColor) * t) * 255.0f;
+            colors[i] = (uint32_t)(color.x + 0.5f) | ((uint32_t)(color.y + 0.5f) << 8) |
+                ((uint32_t)(color.z + 0.5f) << 16) | ((uint32_t)(color.w + 0.5f) << 24);
+        }
+    }
+};
+
+static void report(const char* name, double scalarMs, double soaMs, uint32_t count)
+{
+    printf("  %-24s scalar %8.3f ms   soa %8.3f ms   x%5.2f   %6.2f ns/particle\n",
+        name, scalarMs, soaMs, scalarMs / soaMs, soaMs * 1.0e6 / count);
+}
+
+void runParticleBenchmark(int count)
+{
+    ThreadPool& pool = ThreadPool::getShared();
+    std::cout << "Particle benchmark: " << count << " particles, " << pool.getThreadCount()
+        << " worker threads + caller, median of " << MEASURED_FRAMES << " frames" << std::endl;
+
+    ParticleEmitterDesc desc = benchmarkEmitter((uint32_t)count);
+    ScalarEmitter scalar;
+    scalar.desc = desc;
+    scalar.particles.reserve(count);
+    scalar.emit(count);
+    ParticleEmitter emitter(desc);
+    emitter.emit(count);
+
+    for (int i = 0; i < WARMUP_FRAMES; i++)
+    {
+        scalar.update(FRAME_SECONDS);
+        emitter.update(FRAME_SECONDS, pool);
+    }
+
+    double scalarUpdate = measureMedianMs(MEASURED_FRAMES, [&]() { scalar.update(FRAME_SECONDS); });
+    double soaUpdate = measureMedianMs(MEASURED_FRAMES, [&]() { emitter.update(FRAME_SECONDS, pool); });
+    report("emit + update + kill", scalarUpdate, soaUpdate, emitter.getCount());
+
+    std::vector<glm::vec4> centers(std::max((uint32_t)scalar.particles.size(), emitter.getInstanceCapacity()) + 4);
+    std::vector<uint32_t> colors(centers.size());
+    ParticleInstances instances = { centers.data(), colors.data() };
+    glm::vec3 cameraPos(0.0f, 2.0f, -60.0f);
+    glm::vec3 viewDirection(0.0f, 0.0f, 1.0f);
+
+    double scalarWrite = measureMedianMs(MEASURED_FRAMES, [&]() { scalar.writeInstances(centers.data(), colors.data()); });
+    double soaWrite = measureMedianMs(MEASURED_FRAMES, [&]()
+    {
+        emitter.writeInstances(instances, cameraPos, viewDirection, pool);
+    });
+    report("instance write", scalarWrite, soaWrite, emitter.getCount());
+
+    // Sorting is opt-in; show what it costs at this count
+    ParticleEmitterDesc sortedDesc = desc;
+    sortedDesc.sorted = true;
+    ParticleEmitter sorted(sortedDesc);
+    sorted.emit(count);
+    sorted.update(FRAME_SECONDS, pool);
+    double sortedWrite = measureMedianMs(5, [&]()
+    {
+        sorted.writeInstances(instances, cameraPos, viewDirection, pool);
+        FrameArena::getInstance().reset();
+    });
+    printf("  %-24s                       soa %8.3f ms              %6.2f ns/particle\n",
+        "sorted instance write", sortedWrite, sortedWrite * 1.0e6 / sorted.getCount());
+
+    printf("  live: scalar %zu, soa %u; per frame total scalar %.3f ms, soa %.3f ms\n",
+        scalar.particles.size(), emitter.getCount(), scalarUpdate + scalarWrite, soaUpdate + soaWrite);
+}
@@ -0,0 +1,162 @@
+#include "benchmark.h"
+#include "../Model Loading/meshCache.h"
+#include "../Model Loading/meshLoaderObj.h"
+#include "../Physics/physicsWorld.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// Step cost of the rigid-body module on asteroid showers of growing size.
+// Bodies start in a loose block above the ground, fall, collide and pile up;
+// the measured steps are taken while the lower layers are landing.
+
+static const float STEP_SECONDS = 1.0f / 60.0f;
+static const int WARMUP_STEPS = 90;
+static const int MEASURED_STEPS = 30;
+static const int DETERMINISM_STEPS = 120;
+
+static const int SHOWER_LAYERS = 10;
+static const float SHOWER_SPACING = 3.0f;
+
+// Own generator so every run, whatever else used rand(), builds the same shower
+struct ShowerRandom
+{
+    uint32_t state = 12345u;
+
+    float next(float lo, float hi)
+    {
+        state = state * 1664525u + 1013904223u;
+        return lo + (hi - lo) * ((state >> 8) * (1.0f / 16777216.0f));
+    }
+};
+
+// Asteroid hull with unit bounding radius; a coarse sphere of points when the model is missing
+static void buildAsteroidHull(ConvexHull& hull)
+{
+    std::vector<Vertex> vertices;
+    std::vector<int> indices;
+    MeshLoaderObj loader;
+    const char* path = "Resources/Models/Asteroid_1.obj";
+
+    std::vector<glm::vec3> points;
+    if (readMeshCache(path, vertices, indices) || loader.parseObj(path, vertices, indices))
+    {
+        for (const Vertex& vertex : vertices)
+            points.push_back(vertex.pos);
+    }
+    else
+    {
+        for (int i = 0; i < 64; i++)
+        {
+            float y = 1.0f - 2.0f * (i + 0.5f) / 64.0f;
+            float ring = std::sqrt(1.0f - y * y);
+            points.push_back(glm::vec3(ring * std::cos(2.4f * i), y, ring * std::sin(2.4f * i)));
+        }
+    }
+
+    buildConvexHull(points.data(), (uint32_t)points.size(), 32, hull);
+    float normalize = hull.boundingRadius > 0.0f ? 1.0f / hull.boundingRadius : 1.0f;
+    for (glm::vec3& point : hull.points)
+        point *= normalize;
+    hull.boundingRadius = 1.0f;
+}
+
+// Every fourth body is a sphere, the rest asteroid hulls of varying size
+static void buildShower(PhysicsWorld& physics, uint32_t count, uint32_t hullShape, uint32_t sphereShape)
+{
+    ShowerRandom random;
+    uint32_t perSide = (uint32_t)std::ceil(std::sqrt(count / (float)SHOWER_LAYERS));
+    float half = perSide * SHOWER_SPACING * 0.5f;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t layer = i / (perSide * perSide);
+        uint32_t x = i % perSide;
+        uint32_t z = (i / perSide) % perSide;
+
+        RigidBodyDesc body;
+        body.position = glm::vec3(x * SHOWER_SPACING - half + random.next(-0.5f, 0.5f),
+            4.0f + layer * SHOWER_SPACING + random.next(-0.5f, 0.5f),
+            z * SHOWER_SPACING - half + random.next(-0.5f, 0.5f));
+        body.orientation = glm::normalize(glm::quat(random.next(-1.0f, 1.0f), random.next(-1.0f, 1.0f),
+            random.next(-1.0f, 1.0f), random.next(-1.0f, 1.0f)));
+        body.linearVelocity = glm::vec3(random.next(-1.0f, 1.0f), random.next(-4.0f, 0.0f), random.next(-1.0f, 1.0f));
+        body.angularVelocity = glm::vec3(random.next(-2.0f, 2.0f), random.next(-2.0f, 2.0f), random.next(-2.0f, 2.0f));
+        body.scale = random.next(0.6f, 1.2f);
+        body.mass = body.scale * body.scale * body.scale;
+        body.shape = (i % 4 == 3) ? sphereShape : hullShape;
+        physics.addBody(body);
+    }
+}
+
+static void setUpShower(PhysicsWorld& physics, const ConvexHull& hull, uint32_t count)
+{
+    uint32_t hullShape = physics.addHullShape(hull, 0.05f);
+    uint32_t sphereShape = physics.addSphereShape(1.0f);
+    physics.setGroundHeight(0.0f);
+    buildShower(physics, count, hullShape, sphereShape);
+}
+
+void runPhysicsBenchmark(int maxBodies)
+{
+    std::cout << "Physics benchmark: " << ThreadPool::getShared().getThreadCount() << " worker threads + caller, "
+        << WARMUP_STEPS << " warm-up steps, median of " << MEASURED_STEPS << " steps at " << 1.0f / STEP_SECONDS << " Hz" << std::endl;
+
+    ConvexHull hull;
+    buildAsteroidHull(hull);
+    std::cout << "  asteroid hull: " << hull.points.size() << " points" << std::endl;
+
+    const uint32_t SIZES[] = { 1000, 10000, 100000 };
+    for (uint32_t count : SIZES)
+    {
+        if (count > (uint32_t)maxBodies)
+            break;
+
+        PhysicsWorld physics;
+        setUpShower(physics, hull, count);
+        for (int i = 0; i < WARMUP_STEPS; i++)
+            physics.step(STEP_SECONDS);
+
+        // Per phase: the mean over the measured steps
+        PhysicsStepTimings sum;
+        double stepMs = measureMedianMs(MEASURED_STEPS, [&]()
+        {
+            physics.step(STEP_SECONDS);
+            const PhysicsStepTimings& last = physics.getLastTimings();
+            sum.bounds += last.bounds;
+            sum.broadphase += last.broadphase;
+            sum.narrowphase += last.narrowphase;
+            sum.solve += last.solve;
+            sum.integrate += last.integrate;
+        });
+
+        printf("  %6u bodies  step %8.3f ms  (%5.1f%% of a tick)  %7u pairs  %7u contacts\n",
+            count, stepMs, stepMs * 100.0 / (STEP_SECONDS * 1000.0), physics.getPairCount(), physics.getContactCount());
+        printf("                 bounds %.3f  broadphase %.3f  narrowphase %.3f  solve %.3f  integrate %.3f ms\n",
+            sum.bounds / MEASURED_STEPS, sum.broadphase / MEASURED_STEPS, sum.narrowphase / MEASURED_STEPS,
+            sum.solve / MEASURED_STEPS, sum.integrate / MEASURED_STEPS);
+    }
+
+    // Same shower on the shared pool and on a pool of a different size: the
+    // blocks, and so the results, must not depend on the thread count
+    PhysicsWorld shared;
+    ThreadPool otherPool(3);
+    PhysicsWorld other(otherPool);
+    setUpShower(shared, hull, 1000);
+    setUpShower(other, hull, 1000);
+    for (int i = 0; i < DETERMINISM_STEPS; i++)
+    {
+        shared.step(STEP_SECONDS);
+        other.step(STEP_SECONDS);
+    }
+
+    bool identical = true;
+    for (uint32_t i = 0; i < shared.getBodyCount() && identical; i++)
+    {
+        identical = memcmp(&shared.getPosition(i), &other.getPosition(i), sizeof(glm::vec3)) == 0 &&
+            memcmp(&shared.getOrientation(i), &other.getOrientation(i), sizeof(glm::quat)) == 0;
+    }
+    printf("  determinism: 1000 bodies, %d steps on %u and 3 worker threads: %s\n", DETERMINISM_STEPS,
+        ThreadPool::getShared().getThreadCount(), identical ? "identical" : "DIFFERENT");
+}
@@ -0,0 +1,498 @@
+#include "benchmark.h"
+#include "../Graphics/offscreenContext.h"
+#include "../Camera/camera.h"
+#include "../Camera/cameraPath.h"
+#include "../Core/frameAllocationCheck.h"
+#include "../Core/frameArena.h"
+#include "../Core/frameGovernor.h"
+#include "../Graphics/gpuFrameTimer.h"
+#include "../Graphics/glStateCache.h"
+#include "../Graphics/renderStats.h"
+#include "../Graphics/scaledRenderTarget.h"
+#include "../SceneManager/sceneManager.h"
+#include "../ResourceManager/resourceManager.h"
+#include "../Shaders/shader.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Renders a scene offscreen while the camera follows a recorded path and
+// reports per-frame CPU and GPU times. Every run samples the path at the same
+// points, so results from different builds or machines are comparable.
+
+static const float SIMULATION_STEP = 1.0f / 60.0f;
+
+// Same per-frame upload budgets as the game loop
+static const double ASSET_UPLOAD_BUDGET_MS = 2.0;
+static const size_t TEXTURE_STREAMING_BYTES = 8 * 1024 * 1024;
+
+// GPU timings are read this many frames after they were issued
+static const int QUERY_LATENCY = 4;
+
+struct FrameStats
+{
+    double mean, p50, p90, p95, p99, max;
+};
+
+static FrameStats computeStats(std::vector<double> samples)
+{
+    FrameStats stats = {};
+    if (samples.empty())
+        return stats;
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double s : samples)
+        sum += s;
+
+    // Nearest-rank percentiles
+    auto percentile = [&](double p)
+    {
+        size_t rank = (size_t)ceil(p / 100.0 * samples.size());
+        return samples[rank > 0 ? rank - 1 : 0];
+    };
+
+    stats.mean = sum / samples.size();
+    stats.p50 = percentile(50.0);
+    stats.p90 = percentile(90.0);
+    stats.p95 = percentile(95.0);
+    stats.p99 = percentile(99.0);
+    stats.max = samples.back();
+    return stats;
+}
+
+static void writeStats(std::ofstream& out, const char* name, const FrameStats& stats)
+{
+    out << "\"" << name << "\":{\"mean\":" << stats.mean << ",\"p50\":" << stats.p50
+        << ",\"p90\":" << stats.p90 << ",\"p95\":" << stats.p95 << ",\"p99\":" << stats.p99
+        << ",\"max\":" << stats.max << "}";
+}
+
+// Reads summary.<series>.<key> from a results file written by this benchmark
+static bool readSummaryValue(const std::string& json, const char* series, const char* key, double& value)
+{
+    size_t summary = json.find("\"summary\"");
+    if (summary == std::string::npos)
+        return false;
+
+    size_t block = json.find(std::string("\"") + series + "\"", summary);
+    if (block == std::string::npos)
+        return false;
+    size_t blockEnd = json.find('}', block);
+
+    size_t field = json.find(std::string("\"") + key + "\":", block);
+    if (field == std::string::npos || field > blockEnd)
+        return false;
+
+    value = atof(json.c_str() + field + strlen(key) + 3);
+    return true;
+}
+
+// Prints the comparison and returns false when any tracked metric regressed
+static bool compareWithBaseline(const SceneBenchmarkOptions& options, const FrameStats& cpu,
+    const FrameStats& gpu, bool hasGpu)
+{
+    std::ifstream file(options.baselinePath.c_str());
+    if (!file)
+    {
+        std::cout << "Warning: baseline '" << options.baselinePath << "' not found, nothing compared" << std::endl;
+        return true;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string json = buffer.str();
+
+    struct Metric { const char* series; const char* key; double current; };
+    const Metric metrics[] =
+    {
+        { "cpuMs", "p50", cpu.p50 }, { "cpuMs", "p95", cpu.p95 }, { "cpuMs", "p99", cpu.p99 },
+        { "gpuMs", "p50", gpu.p50 }, { "gpuMs", "p95", gpu.p95 }, { "gpuMs", "p99", gpu.p99 }
+    };
+
+    bool passed = true;
+    float limit = 1.0f + options.tolerancePercent / 100.0f;
+    std::cout << "Baseline " << options.baselinePath << " (tolerance " << options.tolerancePercent << "%)" << std::endl;
+    for (const Metric& metric : metrics)
+    {
+        bool isGpu = metric.series[0] == 'g';
+        double baseline = 0.0;
+        if ((isGpu && !hasGpu) || !readSummaryValue(json, metric.series, metric.key, baseline) || baseline <= 0.0)
+            continue;
+
+        double ratio = metric.current / baseline;
+        bool regressed = ratio > limit;
+        passed = passed && !regressed;
+        printf("  %-6s %-4s %9.3f ms  baseline %9.3f ms  %+7.1f%%  %s\n", metric.series, metric.key,
+            metric.current, baseline, (ratio - 1.0) * 100.0, regressed ? "REGRESSED" : "ok");
+    }
+    return passed;
+}
+
+// Slow orbit around the scene origin, used when no recorded path exists
+static void buildDefaultPath(CameraPath& path)
+{
+    const int KEYS = 9;
+    for (int i = 0; i < KEYS; i++)
+    {
+        float angle = glm::radians(360.0f * i / (KEYS - 1));
+        glm::vec3 position(sin(angle) * 120.0f, 5.0f, cos(angle) * 120.0f - 50.0f);
+        // Face the origin: yaw 0 looks along +x, -90 along -z
+        float yaw = glm::degrees(atan2(-50.0f - position.z, -position.x));
+        path.addKeyframe(i * 2.5f, position, yaw, -5.0f);
+    }
+}
+
+int runSceneBenchmark(const SceneBenchmarkOptions& options)
+{
+    OffscreenContextApi api;
+    if (!OffscreenContext::parseApiName(options.contextApi.c_str(), api))
+    {
+        std::cout << "Unknown context API '" << options.contextApi << "' (native, egl, osmesa)" << std::endl;
+        return 1;
+    }
+
+    OffscreenContext context;
+    if (!context.create(options.width, options.height, api))
+        return 1;
+
+    std::string pathFile = options.cameraPath;
+    if (pathFile.empty())
+        pathFile = "Resources/CameraPaths/scene" + std::to_string(options.sceneId) + ".path";
+
+    CameraPath path;
+    if (!path.load(pathFile))
+    {
+        std::cout << "Using the built-in orbit path" << std::endl;
+        buildDefaultPath(path);
+    }
+
+    bool hasGpuTimers = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    std::vector<double> cpuTimes, gpuTimes;
+    std::vector<double> streamingTimes;     // cpu ms of the frames that loaded or removed a cell
+    std::vector<double> streamingStepTimes; // of updateWorldStreaming in those frames
+    unsigned long long allocatingFrames = 0;
+    std::string renderer = (const char*)glGetString(GL_RENDERER);
+
+    {
+        glClearColor(0.02f, 0.05f, 0.15f, 1.0f);
+        GlStateCache& state = GlStateCache::getInstance();
+        state.setEnabled(GL_DEPTH_TEST, true);
+
+        Shader shader("Shaders/vertex_shader.glsl", "Shaders/fragment_shader.glsl");
+        Shader sunShader("Shaders/sun_vertex_shader.glsl", "Shaders/sun_fragment_shader.glsl");
+        Shader particleShader("Shaders/particle_vertex_shader.glsl", "Shaders/particle_fragment_shader.glsl");
+        Shader shadowShader("Shaders/shadow_vertex_shader.glsl", "Shaders/shadow_fragment_shader.glsl");
+        Shader impostorShader("Shaders/impostor_vertex_shader.glsl", "Shaders/impostor_fragment_shader.glsl");
+        Shader impostorBakeShader("Shaders/vertex_shader.glsl", "Shaders/impostor_bake_fragment_shader.glsl");
+
+        SceneManager sceneManager;
+        sceneManager.initializeResources();
+        sceneManager.loadScene(options.sceneId);
+
+        CascadedShadowMap& shadows = sceneManager.getShadows();
+        if (options.shadowCascades >= 0)
+            shadows.setCascadeCount(options.shadowCascades);
+        if (options.shadowResolution > 0)
+            shadows.setResolution(options.shadowResolution);
+        if (options.impostorDistance >= 0.0f)
+            sceneManager.setImpostorDistance(options.impostorDistance);
+
+        // Same dynamic resolution as the game loop when a budget is given
+        FrameGovernorSettings governorSettings;
+        governorSettings.targetMs = options.frameBudgetMs;
+        FrameGovernor governor(governorSettings);
+        GpuFrameTimer gpuTimer;
+        ScaledRenderTarget sceneTarget;
+        governor.setEnabled(options.frameBudgetMs > 0.0f && gpuTimer.isSupported());
+
+        Camera camera;
+        glm::mat4 projection = glm::perspective(90.0f, options.width * 1.0f / options.height, 0.1f, 10000.0f);
+
+        GLuint queries[QUERY_LATENCY] = {};
+        if (hasGpuTimers)
+            glGenQueries(QUERY_LATENCY, queries);
+        int queriesIssued = 0;
+
+        auto collectQuery = [&](int index)
+        {
+            GLuint64 elapsedNs = 0;
+            glGetQueryObjectui64v(queries[index % QUERY_LATENCY], GL_QUERY_RESULT, &elapsedNs);
+            if (index >= options.warmupFrames)
+                gpuTimes.push_back(elapsedNs / 1.0e6);
+        };
+
+        GlStateStats stateTotals;
+        RenderCounters renderTotals;
+        FrameAllocationCheck allocationCheck(options.warmupFrames);
+        allocationCheck.setWarnings(false);
+        int totalFrames = options.warmupFrames + options.frames;
+        float simulationTime = 0.0f;
+        cpuTimes.reserve(options.frames);
+        gpuTimes.reserve(options.frames);
+        streamingTimes.reserve(options.frames);
+        streamingStepTimes.reserve(options.frames);
+        // Dumps happen inside frames, so the heap check covers them as well
+        if (!options.renderStatsPath.empty())
+            RenderStats::getInstance().startDump(options.renderStatsPath);
+
+        std::cout << "Rendering " << options.frames << " frames (+" << options.warmupFrames << " warm-up) at "
+            << options.width << "x" << options.height << " along " << path.getDuration() << " s of camera path" << std::endl;
+
+        unsigned long long impostorInstances = 0;
+        for (int frame = 0; frame < totalFrames; frame++)
+        {
+            int measured = frame - options.warmupFrames;
+            float pathTime = measured <= 0 ? 0.0f : path.getDuration() * measured / (options.frames - 1);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            // Closes the previous frame's state counts
+            state.beginFrame();
+            RenderStats::getInstance().beginFrame();
+            if (measured > 0)
+            {
+                stateTotals.add(state.getLastFrameStats());
+                renderTotals.add(RenderStats::getInstance().getLastFrame());
+            }
+
+            if (hasGpuTimers)
+            {
+                // The slot is reused QUERY_LATENCY frames later; its result is long done by then
+                if (queriesIssued >= QUERY_LATENCY)
+                    collectQuery(queriesIssued - QUERY_LATENCY);
+                glBeginQuery(GL_TIME_ELAPSED, queries[queriesIssued % QUERY_LATENCY]);
+            }
+
+            // One simulation tick per frame keeps animation deterministic
+            sceneManager.beginSimulationTick();
+            sceneManager.updatePortalAnimation(simulationTime, SIMULATION_STEP);
+            simulationTime += SIMULATION_STEP;
+
+            path.apply(camera, pathTime);
+            camera.storePreviousState();
+            sceneManager.updateBagFollowCamera(camera, 1.0f);
+            sceneManager.interpolateTransforms(1.0f);
+            sceneManager.updateParticles(SIMULATION_STEP, camera.getCameraPosition());
+
+            context.bind();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            gpuTimer.beginFrame();
+            float renderScale = governor.getState().renderScale;
+            bool scaled = renderScale < 1.0f;
+            if (scaled)
+            {
+                sceneTarget.bind((int)(options.width * renderScale + 0.5f), (int)(options.height * renderScale + 0.5f));
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            }
+
+            glm::mat4 view = camera.getViewMatrix();
+            const WorldPartitionStats& streaming = sceneManager.getWorldPartition().getStats();
+            unsigned long long cellChanges = streaming.cellLoads + streaming.cellUnloads;
+            auto streamingStart = std::chrono::high_resolution_clock::now();
+            sceneManager.updateWorldStreaming(camera.getCameraPosition(), SIMULATION_STEP);
+            double streamingMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - streamingStart).count();
+            bool streamingFrame = streaming.cellLoads + streaming.cellUnloads != cellChanges;
+            ResourceManager::getInstance().processUploads(ASSET_UPLOAD_BUDGET_MS);
+            sceneManager.renderShadows(projection, view, shadowShader);
+            sceneManager.renderStars(projection, view, sunShader);
+            sceneManager.renderGround(projection, view, camera.getCameraPosition(), shader);
+            sceneManager.render(projection, view, camera.getCameraPosition(), shader);
+            sceneManager.renderImpostors(projection, view, camera.getCameraPosition(), impostorShader, impostorBakeShader);
+            if (measured >= 0)
+                impostorInstances += sceneManager.getImpostors().getInstancesLastFrame();
+            sceneManager.renderParticles(projection, view, camera.getCameraPosition(), particleShader);
+            ResourceManager::getInstance().updateTextureStreaming(TEXTURE_STREAMING_BYTES);
+
+            if (scaled)
+                sceneTarget.resolve(context.getFramebuffer(), options.width, options.height);
+            gpuTimer.endFrame();
+            double frameGpuMs;
+            while (gpuTimer.readResult(frameGpuMs))
+                governor.addGpuFrameTime(frameGpuMs);
+            if (governor.update())
+            {
+                const FrameGovernorState& quality = governor.getState();
+                sceneManager.setDrawDistance(quality.drawDistance);
+                sceneManager.setTextureLodBias(quality.lodBias);
+                printf("  frame %4d: %s at %.2f ms GPU, scale %.2f, LOD bias %.1f, draw distance %.0f\n",
+                    frame, FrameGovernor::getActionName(quality.lastAction), quality.averageGpuMs,
+                    quality.renderScale, quality.lodBias, quality.drawDistance);
+            }
+
+            if (hasGpuTimers)
+            {
+                glEndQuery(GL_TIME_ELAPSED);
+                queriesIssued++;
+            }
+
+            // Stands in for the buffer swap: submit without waiting
+            glFlush();
+            FrameArena::getInstance().reset();
+            allocationCheck.endFrame();
+
+            auto end = std::chrono::high_resolution_clock::now();
+            if (measured >= 0)
+            {
+                cpuTimes.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+                if (streamingFrame)
+                {
+                    streamingTimes.push_back(cpuTimes.back());
+                    streamingStepTimes.push_back(streamingMs);
+                }
+            }
+        }
+
+        glFinish();
+        RenderStats::getInstance().stopDump();
+        if (hasGpuTimers)
+        {
+            for (int i = queriesIssued > QUERY_LATENCY ? queriesIssued - QUERY_LATENCY : 0; i < queriesIssued; i++)
+                collectQuery(i);
+            glDeleteQueries(QUERY_LATENCY, queries);
+        }
+
+        // Texture streaming follows the path; GPU memory is what the last frames needed
+        ResourceMemoryStats memory = ResourceManager::getInstance().getMemoryStats();
+        printf("  assets  %.1f MB GPU at the end, %u texture mips streamed in, %u dropped\n",
+            memory.gpuBytes / (1024.0 * 1024.0), memory.streamedMips, memory.droppedMips);
+        state.beginFrame();
+        RenderStats::getInstance().beginFrame();
+        if (options.frames > 0)
+        {
+            stateTotals.add(state.getLastFrameStats());
+            renderTotals.add(RenderStats::getInstance().getLastFrame());
+            double frames = options.frames;
+            printf("  draws   %.1f per frame, %.0f triangles, %.1f uploads of %.1f KB, %.1f culled\n",
+                renderTotals.drawCalls / frames, renderTotals.triangles / frames, renderTotals.uploads / frames,
+                renderTotals.uploadBytes / frames / 1024.0, renderTotals.culled / frames);
+            printf("  state   %.1f GL state calls per frame, %.1f redundant ones skipped",
+                stateTotals.getTotalIssued() / (double)options.frames, stateTotals.getTotalSkipped() / (double)options.frames);
+            for (int i = 0; i < STATE_CATEGORY_COUNT; i++)
+                printf("%s%s %.1f", i ? ", " : " (", GlStateCache::getCategoryName((GlStateCategory)i),
+                    stateTotals.skipped[i] / (double)options.frames);
+            printf(")\n");
+        }
+        if (isAllocationTrackingEnabled())
+        {
+            const AllocationStats& flagged = allocationCheck.getFlaggedTotal();
+            allocatingFrames = allocationCheck.getFlaggedFrames();
+            printf("  heap    %llu of %d frames allocated after warm-up, %.1f allocations (%.1f KB) per frame, frame arena peak %.1f KB\n",
+                allocationCheck.getFlaggedFrames(), options.frames, flagged.count / (double)std::max(options.frames, 1),
+                flagged.bytes / 1024.0 / std::max(options.frames, 1), FrameArena::getInstance().getPeak() / 1024.0);
+        }
+        const WorldPartition& partition = sceneManager.getWorldPartition();
+        if (partition.isOpen())
+        {
+            const WorldPartitionStats& world = partition.getStats();
+            printf("  world   %u of %u cells loaded at the end, %u entities, %llu cell loads, %llu unloads\n",
+                world.loadedCells, world.activeCells, world.entities, world.cellLoads, world.cellUnloads);
+        }
+        const ImpostorRenderer& impostors = sceneManager.getImpostors();
+        if (impostors.getAtlasCount() > 0)
+            printf("  impostors %.1f per frame, %u atlases in %.1f MB GPU\n",
+                impostorInstances / (double)std::max(options.frames, 1), impostors.getAtlasCount(),
+                impostors.getGpuBytes() / (1024.0 * 1024.0));
+        printf("  shadows %d cascades at %d, cached cascades redrawn %u times\n",
+            shadows.getCascadeCount(), shadows.getResolution(), shadows.getStaticRedrawsTotal());
+
+        // GL objects must go while the context is still current
+        sceneManager.clearScene();
+        ResourceManager::getInstance().cleanup();
+    }
+
+    FrameStats cpu = computeStats(cpuTimes);
+    FrameStats gpu = computeStats(gpuTimes);
+    FrameStats streaming = computeStats(streamingTimes);
+    FrameStats streamingStep = computeStats(streamingStepTimes);
+
+    printf("  cpu ms  mean %7.3f  p50 %7.3f  p90 %7.3f  p95 %7.3f  p99 %7.3f  max %7.3f\n",
+        cpu.mean, cpu.p50, cpu.p90, cpu.p95, cpu.p99, cpu.max);
+    if (hasGpuTimers)
+    {
+        printf("  gpu ms  mean %7.3f  p50 %7.3f  p90 %7.3f  p95 %7.3f  p99 %7.3f  max %7.3f\n",
+            gpu.mean, gpu.p50, gpu.p90, gpu.p95, gpu.p99, gpu.max);
+    }
+    else
+    {
+        std::cout << "  gpu ms  unavailable (no timer query support)" << std::endl;
+    }
+    if (!streamingTimes.empty())
+    {
+        printf("  cell changes, cpu ms  mean %7.3f  p50 %7.3f  p99 %7.3f  max %7.3f  (%zu frames)\n",
+            streaming.mean, streaming.p50, streaming.p99, streaming.max, streamingTimes.size());
+        printf("    of which streaming  mean %7.3f  p50 %7.3f  p99 %7.3f  max %7.3f\n",
+            streamingStep.mean, streamingStep.p50, streamingStep.p99, streamingStep.max);
+    }
+
+    std::ofstream out(options.outputPath.c_str());
+    if (out)
+    {
+        out.setf(std::ios::fixed);
+        out.precision(4);
+        out << "{\"benchmark\":\"scene\",\"scene\":" << options.sceneId
+            << ",\"frames\":" << options.frames << ",\"width\":" << options.width << ",\"height\":" << options.height
+            << ",\"context\":\"" << options.contextApi << "\",\"renderer\":\"";
+        for (char c : renderer)
+            out << (c == '"' || c == '\\' ? ' ' : c);
+        out << "\",\"cameraPath\":\"" << pathFile << "\",\n\"summary\":{";
+        writeStats(out, "cpuMs", cpu);
+        if (hasGpuTimers)
+        {
+            out << ",";
+            writeStats(out, "gpuMs", gpu);
+        }
+        if (!streamingTimes.empty())
+        {
+            out << ",";
+            writeStats(out, "streamingCpuMs", streaming);
+            out << ",";
+            writeStats(out, "streamingStepMs", streamingStep);
+        }
+        out << "},\n\"perFrame\":[";
+        for (size_t i = 0; i < cpuTimes.size(); i++)
+        {
+            out << (i ? ",\n" : "\n") << "{\"cpuMs\":" << cpuTimes[i];
+            if (i < gpuTimes.size())
+                out << ",\"gpuMs\":" << gpuTimes[i];
+            out << "}";
+        }
+        out << "\n]}\n";
+        std::cout << "Results written to " << options.outputPath << std::endl;
+    }
+    else
+    {
+        std::cout << "Warning: could not write " << options.outputPath << std::endl;
+    }
+
+    if (options.maxAllocatingFrames >= 0)
+    {
+        if (!isAllocationTrackingEnabled())
+        {
+            std::cout << "Warning: allocation tracking is off, allocating frames not checked" << std::endl;
+        }
+        else if (allocatingFrames > (unsigned long long)options.maxAllocatingFrames)
+        {
+            std::cout << "HEAP ALLOCATIONS in " << allocatingFrames << " measured frames, at most "
+                << options.maxAllocatingFrames << " allowed" << std::endl;
+            return 1;
+        }
+    }
+
+    if (options.maxStreamingP99Ms > 0.0f && streaming.p99 > options.maxStreamingP99Ms)
+    {
+        printf("CELL CHANGES TOO SLOW: p99 %.3f ms, at most %.3f ms allowed\n", streaming.p99, options.maxStreamingP99Ms);
+        return 1;
+    }
+
+    if (!options.baselinePath.empty() && !compareWithBaseline(options, cpu, gpu, hasGpuTimers))
+    {
+        std::cout << "PERFORMANCE REGRESSION against baseline" << std::endl;
+        return 1;
+    }
+    return 0;
+}
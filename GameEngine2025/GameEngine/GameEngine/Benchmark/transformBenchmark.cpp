@@ -0,0 +1,123 @@
+#include "benchmark.h"
+#include "../Math/transformKernel.h"
+#include <gtc/matrix_transform.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+// Validates every compiled transform kernel against glm and measures throughput.
+
+static const float TOLERANCE = 1.0e-4f;
+static const int ITERATIONS = 21;
+
+static float randomRange(float lo, float hi)
+{
+    return lo + (hi - lo) * ((float)rand() / RAND_MAX);
+}
+
+// Largest difference relative to the magnitude of the reference entry
+static float maxRelativeError(const std::vector<glm::mat4>& expected, const std::vector<glm::mat4>& actual)
+{
+    float worst = 0.0f;
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            for (int r = 0; r < 4; r++)
+            {
+                float e = expected[i][c][r];
+                float diff = fabs(e - actual[i][c][r]) / (fabs(e) > 1.0f ? fabs(e) : 1.0f);
+                if (diff > worst)
+                    worst = diff;
+            }
+        }
+    }
+    return worst;
+}
+
+void runTransformBenchmark(int count)
+{
+    std::cout << "Transform kernel benchmark: " << count << " objects, best path '"
+        << getTransformKernelName(getBestTransformKernelPath()) << "'" << std::endl;
+
+    srand(1234);
+    std::vector<glm::vec3> positions(count), scales(count);
+    std::vector<glm::quat> rotations(count);
+    for (int i = 0; i < count; i++)
+    {
+        positions[i] = glm::vec3(randomRange(-500.0f, 500.0f), randomRange(-20.0f, 50.0f), randomRange(-500.0f, 500.0f));
+        scales[i] = glm::vec3(randomRange(0.1f, 5.0f), randomRange(0.1f, 5.0f), randomRange(0.1f, 5.0f));
+        rotations[i] = glm::normalize(glm::quat(randomRange(-1.0f, 1.0f), randomRange(-1.0f, 1.0f),
+            randomRange(-1.0f, 1.0f), randomRange(-1.0f, 1.0f)));
+    }
+
+    glm::mat4 projection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 10000.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(10.0f, 5.0f, 30.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 viewProjection = projection * view;
+
+    // ===== GLM REFERENCE =====
+    std::vector<glm::mat4> expectedModels(count), expectedMvps(count);
+    double glmMs = measureMedianMs(ITERATIONS, [&]()
+    {
+        for (int i = 0; i < count; i++)
+        {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), positions[i]);
+            model = model * glm::mat4_cast(rotations[i]);
+            model = glm::scale(model, scales[i]);
+            expectedModels[i] = model;
+            expectedMvps[i] = viewProjection * model;
+        }
+    });
+    printf("  %-8s %9.3f ms   %8.2f M matrices/s (model + mvp)\n", "glm", glmMs, count / (glmMs * 1.0e3));
+
+    std::vector<glm::mat4> models(count), mvps(count);
+    TransformKernelPath original = getTransformKernelPath();
+    bool allPassed = true;
+
+    for (int path = KERNEL_SCALAR; path <= getBestTransformKernelPath(); path++)
+    {
+        setTransformKernelPath((TransformKernelPath)path);
+
+        double ms = measureMedianMs(ITERATIONS, [&]()
+        {
+            batchTransform(positions.data(), rotations.data(), scales.data(), viewProjection,
+                models.data(), mvps.data(), count);
+        });
+
+        float modelError = maxRelativeError(expectedModels, models);
+        float mvpError = maxRelativeError(expectedMvps, mvps);
+
+        // A short odd-sized batch exercises the SIMD tail handling
+        int tail = count < 13 ? count : 13;
+        std::vector<glm::mat4> tailModels(tail), tailMvps(tail);
+        batchTransform(positions.data(), rotations.data(), scales.data(), viewProjection,
+            tailModels.data(), tailMvps.data(), tail);
+        modelError = std::max(modelError, maxRelativeError(
+            std::vector<glm::mat4>(expectedModels.begin(), expectedModels.begin() + tail), tailModels));
+        mvpError = std::max(mvpError, maxRelativeError(
+            std::vector<glm::mat4>(expectedMvps.begin(), expectedMvps.begin() + tail), tailMvps));
+        bool passed = modelError <= TOLERANCE && mvpError <= TOLERANCE;
+        allPassed = allPassed && passed;
+
+        printf("  %-8s %9.3f ms   %8.2f M matrices/s   x%5.2f vs glm   max err model %.2e mvp %.2e  %s\n",
+            getTransformKernelName((TransformKernelPath)path), ms, count / (ms * 1.0e3), glmMs / ms,
+            modelError, mvpError, passed ? "PASS" : "FAIL");
+
+        // MVP only, from cached model matrices
+        std::vector<glm::mat4> cachedMvps(count);
+        double multiplyMs = measureMedianMs(ITERATIONS, [&]()
+        {
+            batchMultiply(viewProjection, expectedModels.data(), cachedMvps.data(), count);
+        });
+        float multiplyError = maxRelativeError(expectedMvps, cachedMvps);
+        allPassed = allPassed && multiplyError <= TOLERANCE;
+
+        printf("  %-8s %9.3f ms   %8.2f M matrices/s   mvp from cached model, max err %.2e  %s\n",
+            "", multiplyMs, count / (multiplyMs * 1.0e3), multiplyError,
+            multiplyError <= TOLERANCE ? "PASS" : "FAIL");
+    }
+
+    setTransformKernelPath(original);
+    std::cout << (allPassed ? "All kernels match glm" : "KERNEL MISMATCH against glm") << std::endl;
+}
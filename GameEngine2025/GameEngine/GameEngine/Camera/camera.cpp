@@ -1,4 +1,7 @@
 #include "camera.h"
+#include "../Collision/collisionWorld.h"
+
+static const float BODY_RADIUS = 0.4f;
 
 Camera::Camera()
 {
@@ -11,9 +14,11 @@ Camera::Camera()
 
     groundHeight = -10.0f; // same as your ground Y
     eyeHeight = 1.7f;      // FPS-style eye height
+    collisionWorld = nullptr;
 
     updateCameraVectors();
     clampToGround();
+    previousPosition = cameraPosition;
 }
 
 Camera::Camera(glm::vec3 position)
@@ -27,9 +32,11 @@ Camera::Camera(glm::vec3 position)
 
     groundHeight = -10.0f;
     eyeHeight = 1.7f;
+    collisionWorld = nullptr;
 
     updateCameraVectors();
     clampToGround();
+    previousPosition = cameraPosition;
 }
 
 Camera::Camera(glm::vec3 position, glm::vec3 direction, glm::vec3 up)
@@ -44,9 +51,11 @@ Camera::Camera(glm::vec3 position, glm::vec3 direction, glm::vec3 up)
 
     groundHeight = -10.0f;
     eyeHeight = 1.7f;
+    collisionWorld = nullptr;
 
     cameraRight = glm::normalize(glm::cross(cameraViewDirection, cameraUp));
     clampToGround();
+    previousPosition = cameraPosition;
 }
 
 Camera::~Camera() {}
@@ -72,6 +81,24 @@ void Camera::clampToGround()
         cameraPosition.y = groundHeight + eyeHeight;
 }
 
+// Every movement goes through here; the body slides along what it bumps into
+void Camera::move(const glm::vec3& delta)
+{
+    if (collisionWorld)
+    {
+        Capsule body;
+        body.a = cameraPosition - glm::vec3(0.0f, eyeHeight - BODY_RADIUS, 0.0f);
+        body.b = cameraPosition;
+        body.radius = BODY_RADIUS;
+        cameraPosition += collisionWorld->moveCapsule(body, delta);
+    }
+    else
+    {
+        cameraPosition += delta;
+    }
+    clampToGround();
+}
+
 // ================= MOVEMENT =================
 
 // Forward/backward (GROUND ONLY)
@@ -81,8 +108,7 @@ void Camera::keyboardMoveFront(float speed)
     forward.y = 0.0f;
     forward = glm::normalize(forward);
 
-    cameraPosition += forward * speed;
-    clampToGround();
+    move(forward * speed);
 }
 
 void Camera::keyboardMoveBack(float speed)
@@ -91,8 +117,7 @@ void Camera::keyboardMoveBack(float speed)
     forward.y = 0.0f;
     forward = glm::normalize(forward);
 
-    cameraPosition -= forward * speed;
-    clampToGround();
+    move(-forward * speed);
 }
 
 // Strafing (GROUND ONLY)
@@ -102,8 +127,7 @@ void Camera::keyboardMoveLeft(float speed)
     right.y = 0.0f;
     right = glm::normalize(right);
 
-    cameraPosition -= right * speed;
-    clampToGround();
+    move(-right * speed);
 }
 
 void Camera::keyboardMoveRight(float speed)
@@ -112,20 +136,18 @@ void Camera::keyboardMoveRight(float speed)
     right.y = 0.0f;
     right = glm::normalize(right);
 
-    cameraPosition += right * speed;
-    clampToGround();
+    move(right * speed);
 }
 
 // Vertical movement (explicit)
 void Camera::keyboardMoveUp(float speed)
 {
-    cameraPosition.y += speed;
+    move(glm::vec3(0.0f, speed, 0.0f));
 }
 
 void Camera::keyboardMoveDown(float speed)
 {
-    cameraPosition.y -= speed;
-    clampToGround();
+    move(glm::vec3(0.0f, -speed, 0.0f));
 }
 
 // ================= MOUSE =================
@@ -144,6 +166,15 @@ void Camera::processMouseMovement(float xoffset, float yoffset)
     updateCameraVectors();
 }
 
+void Camera::setPose(const glm::vec3& position, float newYaw, float newPitch)
+{
+    cameraPosition = position;
+    yaw = newYaw;
+    pitch = glm::clamp(newPitch, -89.0f, 89.0f);
+
+    updateCameraVectors();
+}
+
 // ================= GETTERS =================
 
 glm::mat4 Camera::getViewMatrix()
@@ -156,6 +187,24 @@ glm::vec3 Camera::getCameraPosition()
     return cameraPosition;
 }
 
+// ================= INTERPOLATION =================
+
+void Camera::storePreviousState()
+{
+    previousPosition = cameraPosition;
+}
+
+glm::vec3 Camera::getInterpolatedPosition(float alpha)
+{
+    return glm::mix(previousPosition, cameraPosition, alpha);
+}
+
+glm::mat4 Camera::getViewMatrix(float alpha)
+{
+    glm::vec3 position = getInterpolatedPosition(alpha);
+    return glm::lookAt(position, position + cameraViewDirection, cameraUp);
+}
+
 glm::vec3 Camera::getCameraViewDirection()
 {
     return cameraViewDirection;
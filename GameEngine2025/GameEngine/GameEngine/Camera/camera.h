@@ -6,10 +6,13 @@
 #include <gtc\type_ptr.hpp>
 #include "..\Graphics\window.h"
 
+class CollisionWorld;
+
 class Camera
 {
 private:
     glm::vec3 cameraPosition;
+    glm::vec3 previousPosition; // position at the previous simulation tick
     glm::vec3 cameraViewDirection;
     glm::vec3 cameraUp;
     glm::vec3 cameraRight;
@@ -22,8 +25,12 @@ private:
     float groundHeight;
     float eyeHeight;
 
+    // Scene geometry the body collides with; null walks through everything
+    const CollisionWorld* collisionWorld;
+
     void updateCameraVectors();
     void clampToGround();
+    void move(const glm::vec3& delta);
 
 public:
     Camera();
@@ -33,6 +40,12 @@ public:
 
     glm::mat4 getViewMatrix();
     glm::vec3 getCameraPosition();
+
+    // Fixed-timestep support: movement happens in simulation ticks, rendering
+    // blends between the previous and the current tick position
+    void storePreviousState();
+    glm::vec3 getInterpolatedPosition(float alpha);
+    glm::mat4 getViewMatrix(float alpha);
     glm::vec3 getCameraViewDirection();
     glm::vec3 getCameraUp();
 
@@ -46,6 +59,14 @@ public:
     void keyboardMoveUp(float cameraSpeed);
     void keyboardMoveDown(float cameraSpeed);
 
+    // Collision: the body is a capsule from the feet to the eye
+    void setCollisionWorld(const CollisionWorld* world) { collisionWorld = world; }
+
     // Mouse look
     void processMouseMovement(float xoffset, float yoffset);
+
+    // Scripted placement (camera paths); angles in degrees, same convention as mouse look
+    void setPose(const glm::vec3& position, float yaw, float pitch);
+    float getYaw() const { return yaw; }
+    float getPitch() const { return pitch; }
 };
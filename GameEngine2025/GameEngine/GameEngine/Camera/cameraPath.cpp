@@ -0,0 +1,150 @@
+#include "cameraPath.h"
+#include "camera.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static float catmullRom(float p0, float p1, float p2, float p3, float t)
+{
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return 0.5f * ((2.0f * p1) + (-p0 + p2) * t +
+        (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+        (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+}
+
+static glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+{
+    return glm::vec3(catmullRom(p0.x, p1.x, p2.x, p3.x, t),
+        catmullRom(p0.y, p1.y, p2.y, p3.y, t),
+        catmullRom(p0.z, p1.z, p2.z, p3.z, t));
+}
+
+// Moves `angle` by whole turns so it lies within 180 degrees of `reference`
+static float unwrapDegrees(float angle, float reference)
+{
+    while (angle - reference > 180.0f) angle -= 360.0f;
+    while (angle - reference < -180.0f) angle += 360.0f;
+    return angle;
+}
+
+bool CameraPath::load(const std::string& path)
+{
+    std::ifstream file(path.c_str());
+    if (!file)
+    {
+        std::cout << "Warning: camera path '" << path << "' not found" << std::endl;
+        return false;
+    }
+
+    keyframes.clear();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream fields(line);
+        CameraKeyframe key;
+        if (!(fields >> key.time))
+            continue;   // blank line
+
+        if (!(fields >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch))
+        {
+            std::cout << "Warning: malformed keyframe at " << path << ":" << lineNumber << std::endl;
+            continue;
+        }
+        addKeyframe(key.time, key.position, key.yaw, key.pitch);
+    }
+
+    std::cout << "Loaded camera path " << path << " (" << keyframes.size() << " keyframes, "
+        << getDuration() << " s)" << std::endl;
+    return !keyframes.empty();
+}
+
+bool CameraPath::save(const std::string& path) const
+{
+    std::ofstream file(path.c_str());
+    if (!file)
+    {
+        std::cout << "Warning: could not write camera path '" << path << "'" << std::endl;
+        return false;
+    }
+
+    file << "# time x y z yaw pitch\n";
+    for (const CameraKeyframe& key : keyframes)
+    {
+        file << key.time << " " << key.position.x << " " << key.position.y << " " << key.position.z
+            << " " << key.yaw << " " << key.pitch << "\n";
+    }
+
+    std::cout << "Saved camera path " << path << " (" << keyframes.size() << " keyframes)" << std::endl;
+    return true;
+}
+
+void CameraPath::addKeyframe(float time, const glm::vec3& position, float yaw, float pitch)
+{
+    if (!keyframes.empty() && time <= keyframes.back().time)
+    {
+        std::cout << "Warning: camera keyframe at " << time << " s is out of order, skipped" << std::endl;
+        return;
+    }
+
+    // Store yaw continuously so interpolation takes the short way round
+    if (!keyframes.empty())
+        yaw = unwrapDegrees(yaw, keyframes.back().yaw);
+
+    CameraKeyframe key = { time, position, yaw, pitch };
+    keyframes.push_back(key);
+}
+
+bool CameraPath::sample(float time, glm::vec3& position, float& yaw, float& pitch) const
+{
+    if (keyframes.empty())
+        return false;
+
+    if (time <= keyframes.front().time || keyframes.size() == 1)
+    {
+        position = keyframes.front().position;
+        yaw = keyframes.front().yaw;
+        pitch = keyframes.front().pitch;
+        return true;
+    }
+    if (time >= keyframes.back().time)
+    {
+        position = keyframes.back().position;
+        yaw = keyframes.back().yaw;
+        pitch = keyframes.back().pitch;
+        return true;
+    }
+
+    size_t segment = 0;
+    while (segment + 2 < keyframes.size() && keyframes[segment + 1].time <= time)
+        segment++;
+
+    // End points are repeated so the curve passes through the first and last keys
+    const CameraKeyframe& k0 = keyframes[segment > 0 ? segment - 1 : 0];
+    const CameraKeyframe& k1 = keyframes[segment];
+    const CameraKeyframe& k2 = keyframes[segment + 1];
+    const CameraKeyframe& k3 = keyframes[segment + 2 < keyframes.size() ? segment + 2 : segment + 1];
+
+    float t = (time - k1.time) / (k2.time - k1.time);
+    position = catmullRom(k0.position, k1.position, k2.position, k3.position, t);
+    yaw = catmullRom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, t);
+    pitch = catmullRom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, t);
+    return true;
+}
+
+bool CameraPath::apply(Camera& camera, float time) const
+{
+    glm::vec3 position;
+    float yaw, pitch;
+    if (!sample(time, position, yaw, pitch))
+        return false;
+
+    camera.setPose(position, yaw, pitch);
+    return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glm.hpp>
+
+class Camera;
+
+struct CameraKeyframe
+{
+    float time;         // seconds from the start of the path
+    glm::vec3 position;
+    float yaw;          // degrees, Camera convention
+    float pitch;
+};
+
+// Timed camera keyframes played back as a Catmull-Rom spline, so recorded
+// flights are smooth and repeatable. Used by the scene benchmark and recorded
+// in game with F8.
+//
+// File format, one keyframe per line ('#' starts a comment):
+//   time x y z yaw pitch
+class CameraPath
+{
+public:
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    void clear() { keyframes.clear(); }
+    // Keyframes must be added in increasing time order
+    void addKeyframe(float time, const glm::vec3& position, float yaw, float pitch);
+
+    size_t getKeyframeCount() const { return keyframes.size(); }
+    float getDuration() const { return keyframes.empty() ? 0.0f : keyframes.back().time; }
+
+    // Pose at time t (clamped to the path); false when the path is empty
+    bool sample(float time, glm::vec3& position, float& yaw, float& pitch) const;
+    bool apply(Camera& camera, float time) const;
+
+private:
+    std::vector<CameraKeyframe> keyframes;
+};
@@ -0,0 +1,174 @@
+#include "bvh.h"
+#include <algorithm>
+#include <cfloat>
+
+// Split candidates per axis; 16 bins are within a few percent of a full sweep
+static const int BIN_COUNT = 16;
+
+// Past this depth the builder stops trying SAH splits and halves the range,
+// which bounds the depth even for degenerate input
+static const uint32_t MEDIAN_SPLIT_DEPTH = BVH_MAX_DEPTH / 2;
+
+struct BvhBounds
+{
+    glm::vec3 min;
+    glm::vec3 max;
+
+    BvhBounds() : min(FLT_MAX), max(-FLT_MAX) {}
+
+    void grow(const glm::vec3& pointMin, const glm::vec3& pointMax)
+    {
+        min = glm::min(min, pointMin);
+        max = glm::max(max, pointMax);
+    }
+
+    void grow(const BvhBounds& other) { grow(other.min, other.max); }
+
+    float halfArea() const
+    {
+        glm::vec3 size = max - min;
+        return size.x < 0.0f ? 0.0f : size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+};
+
+struct BuildTask
+{
+    uint32_t node;
+    uint32_t begin;
+    uint32_t end;
+    uint32_t depth;
+};
+
+void buildBvh(const glm::vec3* itemMin, const glm::vec3* itemMax, uint32_t count, uint32_t maxLeafSize,
+    std::vector<BvhNode>& nodes, std::vector<uint32_t>& order)
+{
+    nodes.clear();
+    order.resize(count);
+    if (count == 0)
+        return;
+
+    std::vector<glm::vec3> centroids(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        order[i] = i;
+        centroids[i] = (itemMin[i] + itemMax[i]) * 0.5f;
+    }
+
+    // A binary tree with single-item leaves has 2n - 1 nodes; the pair layout adds one
+    nodes.reserve(count * 2);
+    nodes.resize(1);
+
+    std::vector<BuildTask> tasks;
+    tasks.push_back({ 0, 0, count, 0 });
+
+    while (!tasks.empty())
+    {
+        BuildTask task = tasks.back();
+        tasks.pop_back();
+
+        BvhBounds bounds, centroidBounds;
+        for (uint32_t i = task.begin; i < task.end; i++)
+        {
+            bounds.grow(itemMin[order[i]], itemMax[order[i]]);
+            centroidBounds.grow(centroids[order[i]], centroids[order[i]]);
+        }
+
+        uint32_t itemCount = task.end - task.begin;
+        BvhNode& node = nodes[task.node];
+        node.boundsMin = bounds.min;
+        node.boundsMax = bounds.max;
+
+        // Best bin boundary over the three axes
+        int bestAxis = -1;
+        int bestSplit = 0;
+        float bestCost = FLT_MAX;
+        glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+
+        if (itemCount > maxLeafSize && task.depth < MEDIAN_SPLIT_DEPTH)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (extent[axis] <= 0.0f)
+                    continue;
+
+                BvhBounds bins[BIN_COUNT];
+                uint32_t binCounts[BIN_COUNT] = {};
+                float binScale = BIN_COUNT / extent[axis];
+                for (uint32_t i = task.begin; i < task.end; i++)
+                {
+                    uint32_t item = order[i];
+                    int bin = std::min(BIN_COUNT - 1, (int)((centroids[item][axis] - centroidBounds.min[axis]) * binScale));
+                    binCounts[bin]++;
+                    bins[bin].grow(itemMin[item], itemMax[item]);
+                }
+
+                // Sweep from the right to get every right-hand side's cost
+                float rightArea[BIN_COUNT];
+                uint32_t rightCount[BIN_COUNT];
+                BvhBounds right;
+                uint32_t rightItems = 0;
+                for (int bin = BIN_COUNT - 1; bin > 0; bin--)
+                {
+                    right.grow(bins[bin]);
+                    rightItems += binCounts[bin];
+                    rightArea[bin] = right.halfArea();
+                    rightCount[bin] = rightItems;
+                }
+
+                BvhBounds left;
+                uint32_t leftItems = 0;
+                for (int split = 1; split < BIN_COUNT; split++)
+                {
+                    left.grow(bins[split - 1]);
+                    leftItems += binCounts[split - 1];
+                    if (leftItems == 0 || rightCount[split] == 0)
+                        continue;
+
+                    float cost = left.halfArea() * leftItems + rightArea[split] * rightCount[split];
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = split;
+                    }
+                }
+            }
+        }
+
+        if (itemCount <= maxLeafSize)
+        {
+            node.first = task.begin;
+            node.count = itemCount;
+            continue;
+        }
+
+        uint32_t middle;
+        if (bestAxis >= 0)
+        {
+            float binScale = BIN_COUNT / extent[bestAxis];
+            float origin = centroidBounds.min[bestAxis];
+            uint32_t* split = std::partition(&order[0] + task.begin, &order[0] + task.end, [&](uint32_t item)
+            {
+                return std::min(BIN_COUNT - 1, (int)((centroids[item][bestAxis] - origin) * binScale)) < bestSplit;
+            });
+            middle = (uint32_t)(split - &order[0]);
+        }
+        else
+        {
+            // Coincident centroids or the depth limit: halve along the widest axis
+            int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+            middle = task.begin + itemCount / 2;
+            std::nth_element(&order[0] + task.begin, &order[0] + middle, &order[0] + task.end, [&](uint32_t a, uint32_t b)
+            {
+                return centroids[a][axis] < centroids[b][axis];
+            });
+        }
+
+        uint32_t leftChild = (uint32_t)nodes.size();
+        node.first = leftChild;
+        node.count = 0;
+        nodes.resize(nodes.size() + 2);
+        tasks.push_back({ leftChild, task.begin, middle, task.depth + 1 });
+        tasks.push_back({ leftChild + 1, middle, task.end, task.depth + 1 });
+    }
+}
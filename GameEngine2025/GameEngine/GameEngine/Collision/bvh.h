@@ -0,0 +1,77 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <xmmintrin.h>
+#include <glm.hpp>
+
+// Node of a bounding volume hierarchy, 32 bytes so two share a cache line.
+// Children of an interior node are stored next to each other at `first`;
+// a leaf covers `count` consecutive items starting at `first`.
+struct BvhNode
+{
+    glm::vec3 boundsMin;
+    uint32_t first;
+    glm::vec3 boundsMax;
+    uint32_t count;     // 0 for interior nodes
+
+    bool isLeaf() const { return count != 0; }
+};
+
+static_assert(sizeof(BvhNode) == 32, "BvhNode must stay 32 bytes");
+
+// Binned surface area heuristic build over item bounding boxes. `order`
+// receives the item indices in leaf order; no leaf holds more than
+// maxLeafSize items. Node 0 is the root; an empty input gives no nodes.
+void buildBvh(const glm::vec3* itemMin, const glm::vec3* itemMax, uint32_t count, uint32_t maxLeafSize,
+    std::vector<BvhNode>& nodes, std::vector<uint32_t>& order);
+
+// Deepest traversal stack any query needs; the builder never exceeds it
+const int BVH_MAX_DEPTH = 64;
+
+// A ray prepared for repeated slab tests
+struct BvhRay
+{
+    __m128 origin;
+    __m128 inverseDirection;
+
+    BvhRay(const glm::vec3& rayOrigin, const glm::vec3& direction)
+    {
+        // Axis-parallel rays would divide by zero; a tiny component keeps the slabs finite
+        const float TINY = 1.0e-20f;
+        float dx = fabsf(direction.x) > TINY ? direction.x : TINY;
+        float dy = fabsf(direction.y) > TINY ? direction.y : TINY;
+        float dz = fabsf(direction.z) > TINY ? direction.z : TINY;
+        origin = _mm_setr_ps(rayOrigin.x, rayOrigin.y, rayOrigin.z, 0.0f);
+        inverseDirection = _mm_setr_ps(1.0f / dx, 1.0f / dy, 1.0f / dz, 0.0f);
+    }
+};
+
+// Slab test of all three axes at once. Returns the entry distance, or a
+// negative value when the ray misses the box before maxDistance.
+inline float intersectRayBox(const BvhRay& ray, const BvhNode& node, float maxDistance)
+{
+    // The loads pull in the first/count words as a fourth lane; only x, y, z are used
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.boundsMin.x), ray.origin), ray.inverseDirection);
+    __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.boundsMax.x), ray.origin), ray.inverseDirection);
+    __m128 nearT = _mm_min_ps(t1, t2);
+    __m128 farT = _mm_max_ps(t1, t2);
+
+    __m128 nearMax = _mm_max_ss(_mm_max_ss(nearT, _mm_shuffle_ps(nearT, nearT, _MM_SHUFFLE(1, 1, 1, 1))),
+        _mm_shuffle_ps(nearT, nearT, _MM_SHUFFLE(2, 2, 2, 2)));
+    __m128 farMin = _mm_min_ss(_mm_min_ss(farT, _mm_shuffle_ps(farT, farT, _MM_SHUFFLE(1, 1, 1, 1))),
+        _mm_shuffle_ps(farT, farT, _MM_SHUFFLE(2, 2, 2, 2)));
+
+    float entry = _mm_cvtss_f32(nearMax);
+    float exit = _mm_cvtss_f32(farMin);
+    if (exit < entry || exit < 0.0f || entry > maxDistance)
+        return -1.0f;
+    return entry > 0.0f ? entry : 0.0f;
+}
+
+inline bool boxesOverlap(const glm::vec3& minA, const glm::vec3& maxA, const glm::vec3& minB, const glm::vec3& maxB)
+{
+    return minA.x <= maxB.x && maxA.x >= minB.x &&
+        minA.y <= maxB.y && maxA.y >= minB.y &&
+        minA.z <= maxB.z && maxA.z >= minB.z;
+}
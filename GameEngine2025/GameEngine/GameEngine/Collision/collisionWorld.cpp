@@ -0,0 +1,610 @@
+#include "collisionWorld.h"
+#include "triangleBvh.h"
+#include "../ResourceManager/resourceManager.h"
+#include <algorithm>
+#include <cfloat>
+#include <gtc/matrix_transform.hpp>
+
+// Distance kept between a moved capsule and the surfaces it touches, so the
+// next sweep does not start in contact
+static const float SKIN = 0.01f;
+
+// Sweeps stop this close to a surface
+static const float CONTACT_TOLERANCE = 0.005f;
+
+static const int MAX_ADVANCE_STEPS = 16;
+static const int MAX_DEPENETRATION_STEPS = 4;
+static const int MAX_SLIDES = 4;
+
+// ==================== GEOMETRY ====================
+
+static glm::vec3 transformPoint(const glm::mat4& matrix, const glm::vec3& point)
+{
+    return glm::vec3(matrix * glm::vec4(point, 1.0f));
+}
+
+// World box around a transformed local box
+static void transformBounds(const glm::mat4& matrix, const glm::vec3& localMin, const glm::vec3& localMax,
+    glm::vec3& boundsMin, glm::vec3& boundsMax)
+{
+    boundsMin = glm::vec3(FLT_MAX);
+    boundsMax = glm::vec3(-FLT_MAX);
+    for (int corner = 0; corner < 8; corner++)
+    {
+        glm::vec3 point((corner & 1) ? localMax.x : localMin.x, (corner & 2) ? localMax.y : localMin.y,
+            (corner & 4) ? localMax.z : localMin.z);
+        point = transformPoint(matrix, point);
+        boundsMin = glm::min(boundsMin, point);
+        boundsMax = glm::max(boundsMax, point);
+    }
+}
+
+// Closest point to p on triangle abc (Ericson, Real-Time Collision Detection 5.1.5)
+static glm::vec3 closestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    glm::vec3 ab = b - a;
+    glm::vec3 ac = c - a;
+    glm::vec3 ap = p - a;
+    float d1 = glm::dot(ab, ap);
+    float d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return a;
+
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp);
+    float d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return b;
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + ab * (d1 / (d1 - d3));
+
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp);
+    float d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return c;
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + ac * (d2 / (d2 - d6));
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    float denominator = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+// Closest points of segments p1q1 and p2q2; returns their squared distance (Ericson 5.1.9)
+static float closestSegmentSegment(const glm::vec3& p1, const glm::vec3& q1, const glm::vec3& p2, const glm::vec3& q2,
+    glm::vec3& c1, glm::vec3& c2)
+{
+    const float EPSILON = 1.0e-12f;
+    glm::vec3 d1 = q1 - p1;
+    glm::vec3 d2 = q2 - p2;
+    glm::vec3 r = p1 - p2;
+    float a = glm::dot(d1, d1);
+    float e = glm::dot(d2, d2);
+    float f = glm::dot(d2, r);
+    float s = 0.0f;
+    float t = 0.0f;
+
+    if (a <= EPSILON && e <= EPSILON)
+    {
+        // Both are points
+    }
+    else if (a <= EPSILON)
+    {
+        t = glm::clamp(f / e, 0.0f, 1.0f);
+    }
+    else
+    {
+        float c = glm::dot(d1, r);
+        if (e <= EPSILON)
+        {
+            s = glm::clamp(-c / a, 0.0f, 1.0f);
+        }
+        else
+        {
+            float b = glm::dot(d1, d2);
+            float denominator = a * e - b * b;
+            s = denominator != 0.0f ? glm::clamp((b * f - c * e) / denominator, 0.0f, 1.0f) : 0.0f;
+            t = (b * s + f) / e;
+            if (t < 0.0f)
+            {
+                t = 0.0f;
+                s = glm::clamp(-c / a, 0.0f, 1.0f);
+            }
+            else if (t > 1.0f)
+            {
+                t = 1.0f;
+                s = glm::clamp((b - c) / a, 0.0f, 1.0f);
+            }
+        }
+    }
+
+    c1 = p1 + d1 * s;
+    c2 = p2 + d2 * t;
+    return glm::dot(c1 - c2, c1 - c2);
+}
+
+// Closest points of segment pq and triangle abc; returns their squared distance
+static float closestSegmentTriangle(const glm::vec3& p, const glm::vec3& q,
+    const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, glm::vec3& onSegment, glm::vec3& onTriangle)
+{
+    // A segment through the triangle touches it
+    glm::vec3 direction = q - p;
+    glm::vec3 edge1 = b - a;
+    glm::vec3 edge2 = c - a;
+    glm::vec3 pvec = glm::cross(direction, edge2);
+    float det = glm::dot(edge1, pvec);
+    if (det != 0.0f)
+    {
+        float inverseDet = 1.0f / det;
+        glm::vec3 tvec = p - a;
+        float u = glm::dot(tvec, pvec) * inverseDet;
+        glm::vec3 qvec = glm::cross(tvec, edge1);
+        float v = glm::dot(direction, qvec) * inverseDet;
+        float t = glm::dot(edge2, qvec) * inverseDet;
+        if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t <= 1.0f)
+        {
+            onSegment = onTriangle = p + direction * t;
+            return 0.0f;
+        }
+    }
+
+    // Otherwise the closest pair involves an end of the segment or an edge of the triangle
+    onSegment = p;
+    onTriangle = closestPointOnTriangle(p, a, b, c);
+    float best = glm::dot(onTriangle - p, onTriangle - p);
+
+    glm::vec3 candidate = closestPointOnTriangle(q, a, b, c);
+    float distance = glm::dot(candidate - q, candidate - q);
+    if (distance < best)
+    {
+        best = distance;
+        onSegment = q;
+        onTriangle = candidate;
+    }
+
+    const glm::vec3* corners[4] = { &a, &b, &c, &a };
+    for (int edge = 0; edge < 3; edge++)
+    {
+        glm::vec3 segmentPoint, edgePoint;
+        distance = closestSegmentSegment(p, q, *corners[edge], *corners[edge + 1], segmentPoint, edgePoint);
+        if (distance < best)
+        {
+            best = distance;
+            onSegment = segmentPoint;
+            onTriangle = edgePoint;
+        }
+    }
+    return best;
+}
+
+// The triangle lies in its plane, so a segment whose ends stay further than
+// `margin` from the plane, on one side, over the whole motion never comes
+// within margin of it
+static bool segmentBeyondPlane(const glm::vec3& p, const glm::vec3& q, const glm::vec3& delta,
+    const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, float margin)
+{
+    glm::vec3 normal = glm::cross(b - a, c - a);
+    float length = glm::length(normal);
+    if (length <= 0.0f)
+        return true;    // no area; its edges belong to the neighbours too
+
+    normal /= length;
+    float distanceP = glm::dot(p - a, normal);
+    float distanceQ = glm::dot(q - a, normal);
+    float along = glm::dot(delta, normal);
+    float nearest = std::min(distanceP, distanceQ) + std::min(along, 0.0f);
+    float furthest = std::max(distanceP, distanceQ) + std::max(along, 0.0f);
+    return nearest > margin || furthest < -margin;
+}
+
+// Unit vector from the triangle towards the capsule. Falls back to the face
+// normal when the segment touches the triangle and no direction is defined.
+static glm::vec3 separatingNormal(const Capsule& capsule, const glm::vec3& onSegment, const glm::vec3& onTriangle,
+    float distance, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    if (distance > 1.0e-6f)
+        return (onSegment - onTriangle) / distance;
+
+    glm::vec3 normal = glm::cross(b - a, c - a);
+    float length = glm::length(normal);
+    if (length <= 0.0f)
+        return glm::vec3(0.0f, 1.0f, 0.0f);
+    normal /= length;
+
+    glm::vec3 middle = (capsule.a + capsule.b) * 0.5f;
+    return glm::dot(middle - a, normal) < 0.0f ? -normal : normal;
+}
+
+// ==================== BUILD ====================
+
+// From the transform columns: cached model matrices are only rebuilt when
+// the scene is rendered
+CollisionWorld::Instance CollisionWorld::makeInstance(Entity entity, MeshHandle mesh, const TriangleBvh& bvh,
+    const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    Instance instance;
+    instance.entity = entity;
+    instance.mesh = mesh;
+    instance.model = glm::translate(glm::mat4(1.0f), position) * glm::mat4_cast(rotation) *
+        glm::scale(glm::mat4(1.0f), scale);
+    instance.inverse = glm::inverse(instance.model);
+    transformBounds(instance.model, bvh.getBoundsMin(), bvh.getBoundsMax(), instance.boundsMin, instance.boundsMax);
+    return instance;
+}
+
+void CollisionWorld::buildTree(Tree& tree)
+{
+    std::vector<Instance>& instances = tree.instances;
+    std::vector<glm::vec3> boundsMin(instances.size()), boundsMax(instances.size());
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        boundsMin[i] = instances[i].boundsMin;
+        boundsMax[i] = instances[i].boundsMax;
+    }
+
+    std::vector<uint32_t> order;
+    buildBvh(boundsMin.data(), boundsMax.data(), (uint32_t)instances.size(), 2, tree.nodes, order);
+
+    std::vector<Instance> ordered(instances.size());
+    for (size_t i = 0; i < order.size(); i++)
+        ordered[i] = instances[order[i]];
+    instances.swap(ordered);
+}
+
+void CollisionWorld::build(EntityWorld& world, ComponentMask excluded)
+{
+    base.instances.clear();
+    base.nodes.clear();
+    pendingCount = 0;
+    ResourceManager& rm = ResourceManager::getInstance();
+
+    world.forEachChunk(RENDERABLE_COMPONENTS, excluded, [&](ArchetypeChunk& chunk)
+    {
+        const Entity* entities = chunk.entities;
+        const glm::vec3* positions = chunk.column<COMPONENT_POSITION>();
+        const glm::quat* rotations = chunk.column<COMPONENT_ROTATION>();
+        const glm::vec3* scales = chunk.column<COMPONENT_SCALE>();
+        const MeshHandle* meshes = chunk.column<COMPONENT_MESH>();
+
+        for (uint32_t i = 0; i < chunk.count; i++)
+        {
+            const TriangleBvh* bvh = rm.getCollisionMesh(meshes[i]);
+            if (!bvh)
+            {
+                if (meshes[i].isValid())
+                    pendingCount++;
+                continue;
+            }
+            base.instances.push_back(makeInstance(entities[i], meshes[i], *bvh, positions[i], rotations[i], scales[i]));
+        }
+    });
+
+    buildTree(base);
+}
+
+void CollisionWorld::addGroup(uint32_t id, const EntityWorld& world, const Entity* entities, uint32_t count,
+    ComponentMask excluded)
+{
+    removeGroup(id);
+    ResourceManager& rm = ResourceManager::getInstance();
+
+    Tree group;
+    group.id = id;
+    group.instances.reserve(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        ComponentMask signature = world.getSignature(entities[i]);
+        if ((signature & RENDERABLE_COMPONENTS) != RENDERABLE_COMPONENTS || (signature & excluded))
+            continue;
+
+        MeshHandle mesh = world.read<COMPONENT_MESH>(entities[i]);
+        const TriangleBvh* bvh = rm.getCollisionMesh(mesh);
+        if (bvh)
+            group.instances.push_back(makeInstance(entities[i], mesh, *bvh, world.read<COMPONENT_POSITION>(entities[i]),
+                world.read<COMPONENT_ROTATION>(entities[i]), world.read<COMPONENT_SCALE>(entities[i])));
+    }
+
+    if (group.instances.empty())
+        return;
+    buildTree(group);
+    groups.push_back(std::move(group));
+}
+
+void CollisionWorld::removeGroup(uint32_t id)
+{
+    for (size_t i = 0; i < groups.size(); i++)
+    {
+        if (groups[i].id == id)
+        {
+            groups[i] = std::move(groups.back());
+            groups.pop_back();
+            return;
+        }
+    }
+}
+
+void CollisionWorld::clear()
+{
+    base.instances.clear();
+    base.nodes.clear();
+    groups.clear();
+    pendingCount = 0;
+}
+
+uint32_t CollisionWorld::getInstanceCount() const
+{
+    size_t count = base.instances.size();
+    for (const Tree& group : groups)
+        count += group.instances.size();
+    return (uint32_t)count;
+}
+
+// ==================== QUERIES ====================
+
+template<typename Fn>
+void CollisionWorld::forEachTriangle(const glm::vec3& boxMin, const glm::vec3& boxMax, Fn fn) const
+{
+    forEachTriangle(base, boxMin, boxMax, fn);
+    for (const Tree& group : groups)
+        forEachTriangle(group, boxMin, boxMax, fn);
+}
+
+template<typename Fn>
+void CollisionWorld::forEachTriangle(const Tree& tree, const glm::vec3& boxMin, const glm::vec3& boxMax, Fn fn) const
+{
+    const std::vector<BvhNode>& nodes = tree.nodes;
+    const std::vector<Instance>& instances = tree.instances;
+    if (nodes.empty())
+        return;
+
+    ResourceManager& rm = ResourceManager::getInstance();
+    uint32_t stack[BVH_MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const BvhNode& node = nodes[stack[--stackSize]];
+        if (!boxesOverlap(node.boundsMin, node.boundsMax, boxMin, boxMax))
+            continue;
+
+        if (!node.isLeaf())
+        {
+            stack[stackSize++] = node.first;
+            stack[stackSize++] = node.first + 1;
+            continue;
+        }
+
+        for (uint32_t i = node.first; i < node.first + node.count; i++)
+        {
+            const Instance& instance = instances[i];
+            const TriangleBvh* bvh = rm.getCollisionMesh(instance.mesh);
+            if (!bvh || !boxesOverlap(instance.boundsMin, instance.boundsMax, boxMin, boxMax))
+                continue;
+
+            glm::vec3 localMin, localMax;
+            transformBounds(instance.inverse, boxMin, boxMax, localMin, localMax);
+            bvh->forEachTriangle(localMin, localMax, [&](const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+            {
+                // The local box is looser than the query under rotation; cut it back per triangle
+                glm::vec3 worldA = transformPoint(instance.model, a);
+                glm::vec3 worldB = transformPoint(instance.model, b);
+                glm::vec3 worldC = transformPoint(instance.model, c);
+                if (boxesOverlap(glm::min(worldA, glm::min(worldB, worldC)), glm::max(worldA, glm::max(worldB, worldC)), boxMin, boxMax))
+                    fn(instance, worldA, worldB, worldC);
+            });
+        }
+    }
+}
+
+bool CollisionWorld::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RaycastHit& hit) const
+{
+    float best = maxDistance;
+    const Instance* bestInstance = nullptr;
+    glm::vec3 bestNormal;
+    raycast(base, origin, direction, best, bestInstance, bestNormal);
+    for (const Tree& group : groups)
+        raycast(group, origin, direction, best, bestInstance, bestNormal);
+
+    if (!bestInstance)
+        return false;
+
+    hit.entity = bestInstance->entity;
+    hit.distance = best;
+    hit.point = origin + direction * best;
+    hit.normal = glm::normalize(bestNormal);
+    return true;
+}
+
+// Narrows best to the closest hit in the tree
+bool CollisionWorld::raycast(const Tree& tree, const glm::vec3& origin, const glm::vec3& direction, float& best,
+    const Instance*& bestInstance, glm::vec3& bestNormal) const
+{
+    const std::vector<BvhNode>& nodes = tree.nodes;
+    const std::vector<Instance>& instances = tree.instances;
+    if (nodes.empty())
+        return false;
+
+    ResourceManager& rm = ResourceManager::getInstance();
+    BvhRay ray(origin, direction);
+    bool found = false;
+
+    uint32_t stack[BVH_MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const BvhNode& node = nodes[stack[--stackSize]];
+        if (intersectRayBox(ray, node, best) < 0.0f)
+            continue;
+
+        if (!node.isLeaf())
+        {
+            stack[stackSize++] = node.first;
+            stack[stackSize++] = node.first + 1;
+            continue;
+        }
+
+        for (uint32_t i = node.first; i < node.first + node.count; i++)
+        {
+            const Instance& instance = instances[i];
+            const TriangleBvh* bvh = rm.getCollisionMesh(instance.mesh);
+            if (!bvh)
+                continue;
+
+            // The model-space direction keeps its scale, so distances stay in world units
+            glm::vec3 localOrigin = transformPoint(instance.inverse, origin);
+            glm::vec3 localDirection = glm::mat3(instance.inverse) * direction;
+            TriangleBvh::RayHit localHit;
+            if (bvh->raycast(localOrigin, localDirection, best, localHit))
+            {
+                best = localHit.distance;
+                bestInstance = &instance;
+                bestNormal = glm::transpose(glm::mat3(instance.inverse)) * localHit.normal;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+// Deepest penetration so far in hit.depth; true when this triangle goes deeper
+static bool overlapTriangle(const Capsule& capsule, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c,
+    Entity entity, ShapeHit& hit)
+{
+    if (segmentBeyondPlane(capsule.a, capsule.b, glm::vec3(0.0f), a, b, c, capsule.radius))
+        return false;
+
+    glm::vec3 onSegment, onTriangle;
+    float distanceSquared = closestSegmentTriangle(capsule.a, capsule.b, a, b, c, onSegment, onTriangle);
+    if (distanceSquared >= capsule.radius * capsule.radius)
+        return false;
+
+    float distance = std::sqrt(distanceSquared);
+    float depth = capsule.radius - distance;
+    if (depth <= hit.depth)
+        return false;
+
+    hit.entity = entity;
+    hit.time = 0.0f;
+    hit.depth = depth;
+    hit.normal = separatingNormal(capsule, onSegment, onTriangle, distance, a, b, c);
+    return true;
+}
+
+// Earliest contact so far in hit.time; true when this triangle is reached sooner
+static bool sweepTriangle(const Capsule& capsule, const glm::vec3& delta, const glm::vec3& a, const glm::vec3& b,
+    const glm::vec3& c, Entity entity, ShapeHit& hit)
+{
+    if (segmentBeyondPlane(capsule.a, capsule.b, delta, a, b, c, capsule.radius + CONTACT_TOLERANCE))
+        return false;
+
+    // Conservative advancement: the gap can shrink no faster than the motion
+    // along the closest-point direction, so stepping by gap / approach never
+    // passes through the triangle
+    float time = 0.0f;
+    for (int step = 0; step < MAX_ADVANCE_STEPS; step++)
+    {
+        glm::vec3 offset = delta * time;
+        Capsule moved = { capsule.a + offset, capsule.b + offset, capsule.radius };
+        glm::vec3 onSegment, onTriangle;
+        float distance = std::sqrt(closestSegmentTriangle(moved.a, moved.b, a, b, c, onSegment, onTriangle));
+        glm::vec3 normal = separatingNormal(moved, onSegment, onTriangle, distance, a, b, c);
+
+        // Moving away or along the surface: the gap only grows from here
+        float approach = -glm::dot(delta, normal);
+        if (approach <= 1.0e-7f)
+            return false;
+
+        float gap = distance - capsule.radius;
+        if (gap <= CONTACT_TOLERANCE || step == MAX_ADVANCE_STEPS - 1)
+        {
+            if (time >= hit.time)
+                return false;
+            hit.entity = entity;
+            hit.time = time;
+            hit.depth = gap < 0.0f ? -gap : 0.0f;
+            hit.normal = normal;
+            return true;
+        }
+
+        time += (gap - CONTACT_TOLERANCE * 0.5f) / approach;
+        if (time >= hit.time)
+            return false;
+    }
+    return false;
+}
+
+bool CollisionWorld::overlapCapsule(const Capsule& capsule, ShapeHit& hit) const
+{
+    glm::vec3 boxMin = glm::min(capsule.a, capsule.b) - glm::vec3(capsule.radius);
+    glm::vec3 boxMax = glm::max(capsule.a, capsule.b) + glm::vec3(capsule.radius);
+
+    bool found = false;
+    hit.depth = 0.0f;
+    forEachTriangle(boxMin, boxMax, [&](const Instance& instance, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+    {
+        found |= overlapTriangle(capsule, a, b, c, instance.entity, hit);
+    });
+    return found;
+}
+
+bool CollisionWorld::sweepCapsule(const Capsule& capsule, const glm::vec3& delta, ShapeHit& hit) const
+{
+    glm::vec3 startMin = glm::min(capsule.a, capsule.b);
+    glm::vec3 startMax = glm::max(capsule.a, capsule.b);
+    glm::vec3 boxMin = glm::min(startMin, startMin + delta) - glm::vec3(capsule.radius + CONTACT_TOLERANCE);
+    glm::vec3 boxMax = glm::max(startMax, startMax + delta) + glm::vec3(capsule.radius + CONTACT_TOLERANCE);
+
+    bool found = false;
+    hit.time = 1.0f;
+    forEachTriangle(boxMin, boxMax, [&](const Instance& instance, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+    {
+        found |= sweepTriangle(capsule, delta, a, b, c, instance.entity, hit);
+    });
+    return found;
+}
+
+glm::vec3 CollisionWorld::moveCapsule(const Capsule& capsule, const glm::vec3& delta) const
+{
+    Capsule current = capsule;
+
+    for (int step = 0; step < MAX_DEPENETRATION_STEPS; step++)
+    {
+        ShapeHit hit;
+        if (!overlapCapsule(current, hit))
+            break;
+        glm::vec3 push = hit.normal * (hit.depth + SKIN);
+        current.a += push;
+        current.b += push;
+    }
+
+    glm::vec3 remaining = delta;
+    for (int slide = 0; slide < MAX_SLIDES && glm::dot(remaining, remaining) > 1.0e-10f; slide++)
+    {
+        ShapeHit hit;
+        if (!sweepCapsule(current, remaining, hit))
+        {
+            current.a += remaining;
+            current.b += remaining;
+            break;
+        }
+
+        glm::vec3 advance = remaining * hit.time;
+        current.a += advance;
+        current.b += advance;
+
+        // Keep the part of the rest that runs along the surface
+        remaining -= advance;
+        remaining -= hit.normal * glm::dot(remaining, hit.normal);
+    }
+
+    return current.a - capsule.a;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "bvh.h"
+#include "../ECS/entityWorld.h"
+
+class TriangleBvh;
+
+// Line segment swept by a sphere; a sphere is a capsule with a == b
+struct Capsule
+{
+    glm::vec3 a;
+    glm::vec3 b;
+    float radius;
+};
+
+struct RaycastHit
+{
+    Entity entity;
+    float distance;
+    glm::vec3 point;
+    glm::vec3 normal;       // unit length, facing the ray
+};
+
+struct ShapeHit
+{
+    Entity entity;
+    float time;             // fraction of the sweep; 0 for overlaps
+    float depth;            // penetration of an overlap
+    glm::vec3 normal;       // unit length, pushing the shape out of the surface
+};
+
+// Solid geometry of a scene for the gameplay queries: a top-level BVH over the
+// world bounds of every solid entity, each pointing at its mesh's TriangleBvh.
+// Rays are tested in model space; capsules against world-space copies of the
+// nearby triangles, so non-uniform scales stay exact.
+//
+// Meshes that are not resident yet are left out and counted as pending; the
+// owner rebuilds once they have loaded.
+//
+// Streamed cells come and go as groups with a tree of their own, so a cell
+// change costs a tree over that cell's entities instead of a whole rebuild.
+class CollisionWorld
+{
+public:
+    // Collects every entity with a mesh and none of `excluded` (e.g. moving ones
+    // or streamed ones); groups are kept
+    void build(EntityWorld& world, ComponentMask excluded);
+    void clear();
+
+    // The solid ones of `entities` as group `id`, replacing any group with that
+    // id. Their meshes must have settled: ones that failed stay out for good.
+    void addGroup(uint32_t id, const EntityWorld& world, const Entity* entities, uint32_t count, ComponentMask excluded);
+    void removeGroup(uint32_t id);
+
+    uint32_t getInstanceCount() const;
+    uint32_t getPendingCount() const { return pendingCount; }
+
+    // Closest hit within maxDistance; direction must be unit length
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RaycastHit& hit) const;
+
+    // Deepest penetration of the capsule into the geometry
+    bool overlapCapsule(const Capsule& capsule, ShapeHit& hit) const;
+
+    // First contact of the capsule moved by delta (conservative advancement per triangle)
+    bool sweepCapsule(const Capsule& capsule, const glm::vec3& delta, ShapeHit& hit) const;
+
+    // Collide and slide: the displacement the capsule can actually make towards
+    // delta, after pushing it out of anything it starts inside
+    glm::vec3 moveCapsule(const Capsule& capsule, const glm::vec3& delta) const;
+
+private:
+    struct Instance
+    {
+        Entity entity;
+        MeshHandle mesh;
+        glm::mat4 model;
+        glm::mat4 inverse;
+        glm::vec3 boundsMin;    // world space
+        glm::vec3 boundsMax;
+    };
+
+    struct Tree
+    {
+        uint32_t id = 0;
+        std::vector<Instance> instances;    // in leaf order
+        std::vector<BvhNode> nodes;         // leaf `first` indexes instances
+    };
+
+    Tree base;
+    std::vector<Tree> groups;
+    uint32_t pendingCount = 0;              // of the base tree
+
+    static Instance makeInstance(Entity entity, MeshHandle mesh, const TriangleBvh& bvh, const glm::vec3& position,
+        const glm::quat& rotation, const glm::vec3& scale);
+    static void buildTree(Tree& tree);
+
+    // Calls fn(instance, a, b, c) with world-space triangles near the box
+    template<typename Fn>
+    void forEachTriangle(const glm::vec3& boxMin, const glm::vec3& boxMax, Fn fn) const;
+    template<typename Fn>
+    void forEachTriangle(const Tree& tree, const glm::vec3& boxMin, const glm::vec3& boxMax, Fn fn) const;
+    bool raycast(const Tree& tree, const glm::vec3& origin, const glm::vec3& direction, float& best,
+        const Instance*& bestInstance, glm::vec3& bestNormal) const;
+};
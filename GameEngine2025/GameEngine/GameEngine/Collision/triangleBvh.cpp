@@ -0,0 +1,272 @@
+#include "triangleBvh.h"
+#include "../Core/mappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+void TriangleBvh::build(const std::vector<Vertex>& vertices, const std::vector<int>& indices)
+{
+    clear();
+
+    uint32_t count = (uint32_t)(indices.size() / 3);
+    std::vector<glm::vec3> triangleMin(count), triangleMax(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const glm::vec3& a = vertices[indices[i * 3]].pos;
+        const glm::vec3& b = vertices[indices[i * 3 + 1]].pos;
+        const glm::vec3& c = vertices[indices[i * 3 + 2]].pos;
+        triangleMin[i] = glm::min(a, glm::min(b, c));
+        triangleMax[i] = glm::max(a, glm::max(b, c));
+    }
+
+    std::vector<uint32_t> order;
+    buildBvh(triangleMin.data(), triangleMax.data(), count, LEAF_SIZE, nodes, order);
+    triangleCount = count;
+
+    // Pack each leaf's triangles into one block; the leaf then points at the block
+    blocks.reserve(nodes.size() / 2 + 1);
+    for (BvhNode& node : nodes)
+    {
+        if (!node.isLeaf())
+            continue;
+
+        TriangleBlock block;
+        memset(&block, 0, sizeof(block));
+        for (uint32_t lane = 0; lane < node.count; lane++)
+        {
+            uint32_t triangle = order[node.first + lane];
+            const glm::vec3& a = vertices[indices[triangle * 3]].pos;
+            glm::vec3 edge1 = vertices[indices[triangle * 3 + 1]].pos - a;
+            glm::vec3 edge2 = vertices[indices[triangle * 3 + 2]].pos - a;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                block.v0[axis][lane] = a[axis];
+                block.edge1[axis][lane] = edge1[axis];
+                block.edge2[axis][lane] = edge2[axis];
+            }
+            block.triangle[lane] = triangle;
+        }
+
+        node.first = (uint32_t)blocks.size();
+        blocks.push_back(block);
+    }
+
+    // The builder reserves for single-item leaves; give the slack back
+    std::vector<BvhNode>(nodes).swap(nodes);
+}
+
+void TriangleBvh::clear()
+{
+    std::vector<BvhNode>().swap(nodes);
+    std::vector<TriangleBlock>().swap(blocks);
+    triangleCount = 0;
+}
+
+void TriangleBvh::swap(TriangleBvh& other)
+{
+    nodes.swap(other.nodes);
+    blocks.swap(other.blocks);
+    std::swap(triangleCount, other.triangleCount);
+}
+
+size_t TriangleBvh::getMemoryBytes() const
+{
+    return nodes.capacity() * sizeof(BvhNode) + blocks.capacity() * sizeof(TriangleBlock);
+}
+
+bool TriangleBvh::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const
+{
+    if (nodes.empty())
+        return false;
+
+    BvhRay ray(origin, direction);
+    if (intersectRayBox(ray, nodes[0], maxDistance) < 0.0f)
+        return false;
+
+    const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+    const __m128 dx = _mm_set1_ps(direction.x), dy = _mm_set1_ps(direction.y), dz = _mm_set1_ps(direction.z);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    float best = maxDistance;
+    const TriangleBlock* bestBlock = nullptr;
+    int bestLane = 0;
+
+    // Far children wait on the stack with their entry distance, so ones the
+    // closest hit so far already rules out are dropped without a box test
+    uint32_t stack[BVH_MAX_DEPTH];
+    float stackEntry[BVH_MAX_DEPTH];
+    int stackSize = 0;
+    uint32_t current = 0;
+
+    for (;;)
+    {
+        const BvhNode& node = nodes[current];
+        if (node.isLeaf())
+        {
+            // Moeller-Trumbore on all four triangles at once
+            const TriangleBlock& block = blocks[node.first];
+            __m128 e1x = _mm_loadu_ps(block.edge1[0]), e1y = _mm_loadu_ps(block.edge1[1]), e1z = _mm_loadu_ps(block.edge1[2]);
+            __m128 e2x = _mm_loadu_ps(block.edge2[0]), e2y = _mm_loadu_ps(block.edge2[1]), e2z = _mm_loadu_ps(block.edge2[2]);
+
+            __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+            __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+            __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+            __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+            __m128 inverseDet = _mm_div_ps(one, det);
+
+            __m128 tx = _mm_sub_ps(ox, _mm_loadu_ps(block.v0[0]));
+            __m128 ty = _mm_sub_ps(oy, _mm_loadu_ps(block.v0[1]));
+            __m128 tz = _mm_sub_ps(oz, _mm_loadu_ps(block.v0[2]));
+            __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), inverseDet);
+
+            __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+            __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+            __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+            __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverseDet);
+            __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverseDet);
+
+            // Degenerate (padding) lanes have det == 0 and fail here, or through NaNs below
+            __m128 mask = _mm_cmpneq_ps(det, zero);
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+            mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(t, zero));
+            mask = _mm_and_ps(mask, _mm_cmplt_ps(t, _mm_set1_ps(best)));
+
+            int hits = _mm_movemask_ps(mask);
+            if (hits)
+            {
+                float distances[4];
+                _mm_storeu_ps(distances, t);
+                for (int lane = 0; lane < 4; lane++)
+                {
+                    if ((hits & (1 << lane)) && distances[lane] < best)
+                    {
+                        best = distances[lane];
+                        bestBlock = &block;
+                        bestLane = lane;
+                    }
+                }
+            }
+        }
+        else
+        {
+            float left = intersectRayBox(ray, nodes[node.first], best);
+            float right = intersectRayBox(ray, nodes[node.first + 1], best);
+            if (left >= 0.0f && right >= 0.0f)
+            {
+                bool leftFirst = left <= right;
+                stack[stackSize] = leftFirst ? node.first + 1 : node.first;
+                stackEntry[stackSize++] = leftFirst ? right : left;
+                current = leftFirst ? node.first : node.first + 1;
+                continue;
+            }
+            if (left >= 0.0f || right >= 0.0f)
+            {
+                current = left >= 0.0f ? node.first : node.first + 1;
+                continue;
+            }
+        }
+
+        // Next pending subtree that can still beat the best hit
+        while (stackSize > 0 && stackEntry[stackSize - 1] > best)
+            stackSize--;
+        if (stackSize == 0)
+            break;
+        current = stack[--stackSize];
+    }
+
+    if (!bestBlock)
+        return false;
+
+    glm::vec3 edge1(bestBlock->edge1[0][bestLane], bestBlock->edge1[1][bestLane], bestBlock->edge1[2][bestLane]);
+    glm::vec3 edge2(bestBlock->edge2[0][bestLane], bestBlock->edge2[1][bestLane], bestBlock->edge2[2][bestLane]);
+    glm::vec3 normal = glm::cross(edge1, edge2);
+    hit.distance = best;
+    hit.normal = glm::dot(normal, direction) > 0.0f ? -normal : normal;
+    hit.triangle = bestBlock->triangle[bestLane];
+    return true;
+}
+
+// ==================== CACHE ====================
+
+static const uint32_t BVH_CACHE_MAGIC = 0x48564243;    // "CBVH"
+static const uint32_t BVH_CACHE_VERSION = 1;
+
+struct BvhCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nodeSize;      // record sizes when written; guard against layout changes
+    uint32_t blockSize;
+    uint32_t nodeCount;
+    uint32_t blockCount;
+    uint32_t triangleCount;
+};
+
+static std::string bvhCachePath(const std::string& modelPath)
+{
+    return modelPath + ".bvhcache";
+}
+
+bool readTriangleBvhCache(const std::string& modelPath, TriangleBvh& bvh)
+{
+    std::string path = bvhCachePath(modelPath);
+    long long cacheTime = getFileModificationTime(path);
+    if (cacheTime < 0 || cacheTime < getFileModificationTime(modelPath))
+        return false;
+
+    MappedFile file;
+    if (!file.open(path) || file.getSize() < sizeof(BvhCacheHeader))
+        return false;
+
+    BvhCacheHeader header;
+    memcpy(&header, file.getData(), sizeof(header));
+    if (header.magic != BVH_CACHE_MAGIC || header.version != BVH_CACHE_VERSION ||
+        header.nodeSize != sizeof(BvhNode) || header.blockSize != sizeof(TriangleBvh::TriangleBlock) ||
+        file.getSize() != sizeof(header) + (unsigned long long)header.nodeCount * sizeof(BvhNode) +
+        (unsigned long long)header.blockCount * sizeof(TriangleBvh::TriangleBlock))
+    {
+        std::cout << "Warning: ignoring outdated collision cache " << path << std::endl;
+        return false;
+    }
+
+    const unsigned char* data = file.getData() + sizeof(header);
+    bvh.clear();
+    bvh.nodes.resize(header.nodeCount);
+    bvh.blocks.resize(header.blockCount);
+    bvh.triangleCount = header.triangleCount;
+    if (header.nodeCount)
+        memcpy(&bvh.nodes[0], data, header.nodeCount * sizeof(BvhNode));
+    if (header.blockCount)
+        memcpy(&bvh.blocks[0], data + header.nodeCount * sizeof(BvhNode), header.blockCount * sizeof(TriangleBvh::TriangleBlock));
+    return true;
+}
+
+bool writeTriangleBvhCache(const std::string& modelPath, const TriangleBvh& bvh)
+{
+    std::string path = bvhCachePath(modelPath);
+    std::ofstream out(path.c_str(), std::ios::binary);
+    if (!out)
+        return false;
+
+    BvhCacheHeader header = { BVH_CACHE_MAGIC, BVH_CACHE_VERSION, (uint32_t)sizeof(BvhNode),
+        (uint32_t)sizeof(TriangleBvh::TriangleBlock), (uint32_t)bvh.nodes.size(), (uint32_t)bvh.blocks.size(),
+        bvh.triangleCount };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!bvh.nodes.empty())
+        out.write(reinterpret_cast<const char*>(&bvh.nodes[0]), bvh.nodes.size() * sizeof(BvhNode));
+    if (!bvh.blocks.empty())
+        out.write(reinterpret_cast<const char*>(&bvh.blocks[0]), bvh.blocks.size() * sizeof(TriangleBvh::TriangleBlock));
+
+    if (!out)
+    {
+        // A half-written cache would only be rejected later; drop it now
+        out.close();
+        std::remove(path.c_str());
+        return false;
+    }
+    return true;
+}
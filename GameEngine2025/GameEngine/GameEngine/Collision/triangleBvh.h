@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "bvh.h"
+#include "../Model Loading/mesh.h"
+
+// Triangle BVH over one mesh, in model space. Built once when the mesh is
+// loaded (or read back from <model>.bvhcache) and shared by every instance.
+//
+// Leaves hold up to four triangles packed as one SSE block, so a ray tests a
+// whole leaf in a single pass. Triangles are stored as a corner and two edges,
+// which is what both the ray test and the shape queries want.
+class TriangleBvh
+{
+public:
+    static const uint32_t LEAF_SIZE = 4;
+
+    struct RayHit
+    {
+        float distance;     // in units of the ray direction's length
+        glm::vec3 normal;   // unnormalized geometric normal, facing the ray
+        uint32_t triangle;  // index into the mesh's triangle list
+    };
+
+    // Replaces the hierarchy with one over the indexed triangles
+    void build(const std::vector<Vertex>& vertices, const std::vector<int>& indices);
+    void clear();
+    void swap(TriangleBvh& other);
+
+    bool isEmpty() const { return nodes.empty(); }
+    uint32_t getTriangleCount() const { return triangleCount; }
+    uint32_t getNodeCount() const { return (uint32_t)nodes.size(); }
+    size_t getMemoryBytes() const;
+    const glm::vec3& getBoundsMin() const { return nodes[0].boundsMin; }
+    const glm::vec3& getBoundsMax() const { return nodes[0].boundsMax; }
+
+    // Closest triangle the ray hits before maxDistance, from either side
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const;
+
+    // Calls fn(a, b, c) for every triangle whose leaf overlaps the box
+    template<typename Fn>
+    void forEachTriangle(const glm::vec3& boxMin, const glm::vec3& boxMax, Fn fn) const
+    {
+        if (nodes.empty())
+            return;
+
+        uint32_t stack[BVH_MAX_DEPTH];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0)
+        {
+            const BvhNode& node = nodes[stack[--stackSize]];
+            if (!boxesOverlap(node.boundsMin, node.boundsMax, boxMin, boxMax))
+                continue;
+
+            if (!node.isLeaf())
+            {
+                stack[stackSize++] = node.first;
+                stack[stackSize++] = node.first + 1;
+                continue;
+            }
+
+            const TriangleBlock& block = blocks[node.first];
+            for (uint32_t i = 0; i < node.count; i++)
+            {
+                glm::vec3 a(block.v0[0][i], block.v0[1][i], block.v0[2][i]);
+                glm::vec3 b = a + glm::vec3(block.edge1[0][i], block.edge1[1][i], block.edge1[2][i]);
+                glm::vec3 c = a + glm::vec3(block.edge2[0][i], block.edge2[1][i], block.edge2[2][i]);
+                fn(a, b, c);
+            }
+        }
+    }
+
+private:
+    // Four triangles in SoA form: [axis][lane]. Unused lanes are degenerate
+    struct TriangleBlock
+    {
+        float v0[3][4];
+        float edge1[3][4];
+        float edge2[3][4];
+        uint32_t triangle[4];
+    };
+
+    std::vector<BvhNode> nodes;         // leaf `first` indexes blocks
+    std::vector<TriangleBlock> blocks;
+    uint32_t triangleCount = 0;
+
+    friend bool readTriangleBvhCache(const std::string& modelPath, TriangleBvh& bvh);
+    friend bool writeTriangleBvhCache(const std::string& modelPath, const TriangleBvh& bvh);
+};
+
+// Built hierarchies dumped next to their source model (<model>.bvhcache),
+// the same way as the mesh cache. A cache older than its model is ignored.
+bool readTriangleBvhCache(const std::string& modelPath, TriangleBvh& bvh);
+bool writeTriangleBvhCache(const std::string& modelPath, const TriangleBvh& bvh);
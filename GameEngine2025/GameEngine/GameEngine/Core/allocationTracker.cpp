@@ -0,0 +1,153 @@
+#include "allocationTracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if ENABLE_ALLOCATION_TRACKING
+
+// Relaxed atomics: the counters are statistics, not synchronization
+static std::atomic<unsigned long long> allocationCount(0);
+static std::atomic<unsigned long long> allocationBytes(0);
+
+// Plain thread-locals: constant-initialized, so usable from operator new
+// before anything else on the thread has run
+static thread_local AllocationStats threadAllocations = { 0, 0 };
+static thread_local AllocationStats threadExpectedAllocations = { 0, 0 };
+static thread_local int expectedScopeDepth = 0;
+
+static void* trackedAllocate(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    threadAllocations.count++;
+    threadAllocations.bytes += size;
+    if (expectedScopeDepth > 0)
+    {
+        threadExpectedAllocations.count++;
+        threadExpectedAllocations.bytes += size;
+    }
+    return malloc(size ? size : 1);
+}
+
+void* operator new(size_t size)
+{
+    void* memory = trackedAllocate(size);
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](size_t size)
+{
+    void* memory = trackedAllocate(size);
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return trackedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return trackedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    free(memory);
+}
+
+AllocationStats getAllocationStats()
+{
+    AllocationStats stats = { allocationCount.load(std::memory_order_relaxed),
+        allocationBytes.load(std::memory_order_relaxed) };
+    return stats;
+}
+
+bool isAllocationTrackingEnabled()
+{
+    return true;
+}
+
+AllocationStats getThreadAllocationStats()
+{
+    return threadAllocations;
+}
+
+AllocationStats getThreadExpectedAllocationStats()
+{
+    return threadExpectedAllocations;
+}
+
+ExpectedAllocationScope::ExpectedAllocationScope()
+{
+    expectedScopeDepth++;
+}
+
+ExpectedAllocationScope::~ExpectedAllocationScope()
+{
+    expectedScopeDepth--;
+}
+
+#else
+
+AllocationStats getAllocationStats()
+{
+    AllocationStats stats = { 0, 0 };
+    return stats;
+}
+
+bool isAllocationTrackingEnabled()
+{
+    return false;
+}
+
+AllocationStats getThreadAllocationStats()
+{
+    AllocationStats stats = { 0, 0 };
+    return stats;
+}
+
+AllocationStats getThreadExpectedAllocationStats()
+{
+    AllocationStats stats = { 0, 0 };
+    return stats;
+}
+
+ExpectedAllocationScope::ExpectedAllocationScope()
+{
+}
+
+ExpectedAllocationScope::~ExpectedAllocationScope()
+{
+}
+
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+
+// Counts every heap allocation made through operator new (the replacement
+// lives in allocationTracker.cpp). Totals only ever grow, so callers measure
+// a section by taking a snapshot before and after it:
+//
+//   AllocationStats before = getAllocationStats();
+//   loadSomething();
+//   AllocationStats used = getAllocationStats() - before;
+//
+// Set ENABLE_ALLOCATION_TRACKING=0 in the preprocessor definitions to keep the
+// default allocator; the counters then stay at zero.
+#ifndef ENABLE_ALLOCATION_TRACKING
+#define ENABLE_ALLOCATION_TRACKING 1
+#endif
+
+struct AllocationStats
+{
+    unsigned long long count;   // calls to operator new / new[]
+    unsigned long long bytes;   // bytes requested by those calls
+};
+
+inline AllocationStats operator-(const AllocationStats& a, const AllocationStats& b)
+{
+    AllocationStats result = { a.count - b.count, a.bytes - b.bytes };
+    return result;
+}
+
+AllocationStats getAllocationStats();
+bool isAllocationTrackingEnabled();
+
+// The same counts for the calling thread only, so a frame on the render
+// thread can be measured while loader threads allocate. Allocations made
+// inside an ExpectedAllocationScope are counted in both totals.
+AllocationStats getThreadAllocationStats();
+AllocationStats getThreadExpectedAllocationStats();
+
+// Marks the allocations of a block as expected, e.g. streaming in an asset;
+// frame checks subtract them. Scopes nest.
+class ExpectedAllocationScope
+{
+public:
+    ExpectedAllocationScope();
+    ~ExpectedAllocationScope();
+
+    ExpectedAllocationScope(const ExpectedAllocationScope&) = delete;
+    ExpectedAllocationScope& operator=(const ExpectedAllocationScope&) = delete;
+};
@@ -0,0 +1,58 @@
+#include "fixedTimestep.h"
+#include <cmath>
+
+FixedTimestep::FixedTimestep(float ticksPerSecond)
+    : tickSeconds(1.0f / 60.0f),
+    maxFrameSeconds(0.25f),
+    maxTicksPerFrame(8),
+    ticksThisFrame(0),
+    accumulator(0.0),
+    simulationTime(0.0),
+    tickCount(0),
+    droppedTicks(0)
+{
+    setTickRate(ticksPerSecond);
+}
+
+void FixedTimestep::setTickRate(float ticksPerSecond)
+{
+    if (ticksPerSecond < 1.0f)
+        ticksPerSecond = 1.0f;
+
+    // Keep the interpolation position when the rate changes mid-run
+    float alpha = getAlpha();
+    tickSeconds = 1.0f / ticksPerSecond;
+    accumulator = alpha * tickSeconds;
+}
+
+void FixedTimestep::addFrameTime(float frameSeconds)
+{
+    if (frameSeconds < 0.0f)
+        frameSeconds = 0.0f;
+    if (frameSeconds > maxFrameSeconds)
+        frameSeconds = maxFrameSeconds;
+
+    accumulator += frameSeconds;
+    ticksThisFrame = 0;
+}
+
+bool FixedTimestep::step()
+{
+    if (accumulator < tickSeconds)
+        return false;
+
+    if (ticksThisFrame >= maxTicksPerFrame)
+    {
+        // Too far behind: drop whole ticks instead of spiralling, keep the fraction
+        double backlog = floor(accumulator / tickSeconds);
+        droppedTicks += (unsigned long long)backlog;
+        accumulator -= backlog * tickSeconds;
+        return false;
+    }
+
+    accumulator -= tickSeconds;
+    simulationTime += tickSeconds;
+    tickCount++;
+    ticksThisFrame++;
+    return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// Fixed-rate simulation clock. Real frame time is accumulated and consumed in
+// whole ticks of 1 / tickRate seconds, so gameplay runs at the same speed and
+// produces the same results whatever the render frame rate. The remainder is
+// exposed as an interpolation factor for rendering between the last two ticks.
+//
+//   simulation.addFrameTime(deltaTime);
+//   while (simulation.step()) { ...update with getTickSeconds()... }
+//   render(simulation.getAlpha());
+class FixedTimestep
+{
+public:
+    FixedTimestep(float ticksPerSecond);
+
+    void setTickRate(float ticksPerSecond);
+    float getTickRate() const { return 1.0f / tickSeconds; }
+    float getTickSeconds() const { return tickSeconds; }
+
+    // Frame times above this are clamped (debugger breaks, window drags)
+    void setMaxFrameTime(float seconds) { maxFrameSeconds = seconds; }
+    // Ticks run per frame before the remaining backlog is dropped
+    void setMaxTicksPerFrame(int ticks) { maxTicksPerFrame = ticks; }
+
+    void addFrameTime(float frameSeconds);
+    bool step();
+
+    // How far the render time is between the previous and the current tick, in [0, 1)
+    float getAlpha() const { return (float)(accumulator / tickSeconds); }
+
+    double getSimulationTime() const { return simulationTime; }
+    unsigned long long getTickCount() const { return tickCount; }
+    unsigned long long getDroppedTicks() const { return droppedTicks; }
+
+private:
+    float tickSeconds;
+    float maxFrameSeconds;
+    int maxTicksPerFrame;
+    int ticksThisFrame;
+
+    double accumulator;
+    double simulationTime;
+    unsigned long long tickCount;
+    unsigned long long droppedTicks;
+};
@@ -0,0 +1,56 @@
+#include "frameAllocationCheck.h"
+#include <iostream>
+
+FrameAllocationCheck::FrameAllocationCheck(int warmupFrames)
+    : warmupFrames(warmupFrames), framesToSettle(warmupFrames), warningsLeft(MAX_WARNINGS),
+      frames(0), flaggedFrames(0)
+{
+#ifdef _DEBUG
+    warnings = true;
+#else
+    warnings = false;
+#endif
+    frameStart = unexpectedAllocations();
+    lastFrame.count = lastFrame.bytes = 0;
+    flaggedTotal.count = flaggedTotal.bytes = 0;
+}
+
+AllocationStats FrameAllocationCheck::unexpectedAllocations()
+{
+    return getThreadAllocationStats() - getThreadExpectedAllocationStats();
+}
+
+void FrameAllocationCheck::endFrame()
+{
+    AllocationStats now = unexpectedAllocations();
+    lastFrame = now - frameStart;
+    frameStart = now;
+    frames++;
+
+    if (framesToSettle > 0)
+    {
+        framesToSettle--;
+        return;
+    }
+    if (lastFrame.count == 0)
+        return;
+
+    flaggedFrames++;
+    flaggedTotal.count += lastFrame.count;
+    flaggedTotal.bytes += lastFrame.bytes;
+    if (warnings && warningsLeft > 0)
+    {
+        warningsLeft--;
+        // The message itself allocates; measure the next frame from after it
+        std::cout << "Warning: frame " << frames << " made " << lastFrame.count << " heap allocations ("
+            << lastFrame.bytes << " bytes)" << (warningsLeft == 0 ? ", further frames are only counted" : "")
+            << std::endl;
+        frameStart = unexpectedAllocations();
+    }
+}
+
+void FrameAllocationCheck::restartWarmup()
+{
+    framesToSettle = warmupFrames;
+    warningsLeft = MAX_WARNINGS;
+}
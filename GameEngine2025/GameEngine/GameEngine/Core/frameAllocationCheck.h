@@ -0,0 +1,47 @@
+#pragma once
+#include "allocationTracker.h"
+
+// Holds the render loop to zero heap allocations per frame. Counts what the
+// calling thread allocates between endFrame() calls, leaving out anything
+// inside an ExpectedAllocationScope (asset uploads, streaming, scene loads),
+// and flags every frame after the warm-up that allocated anyway. Per-frame
+// scratch memory belongs in FrameArena instead.
+//
+// Relies on the operator new replacement in allocationTracker.cpp; with
+// ENABLE_ALLOCATION_TRACKING=0 no frame is ever flagged.
+class FrameAllocationCheck
+{
+public:
+    static const int DEFAULT_WARMUP_FRAMES = 120;
+    static const int MAX_WARNINGS = 10;     // per warm-up; later frames are only counted
+
+    explicit FrameAllocationCheck(int warmupFrames = DEFAULT_WARMUP_FRAMES);
+
+    // Once per frame on the render thread, always at the same point
+    void endFrame();
+
+    // After something that legitimately grows buffers for a while, e.g. a
+    // scene change: frames are not flagged until the warm-up has passed again
+    void restartWarmup();
+
+    void setWarnings(bool enabled) { warnings = enabled; }
+
+    const AllocationStats& getLastFrame() const { return lastFrame; }
+    unsigned long long getFrames() const { return frames; }
+    unsigned long long getFlaggedFrames() const { return flaggedFrames; }
+    const AllocationStats& getFlaggedTotal() const { return flaggedTotal; }
+
+private:
+    int warmupFrames;
+    int framesToSettle;
+    bool warnings;
+    int warningsLeft;
+
+    AllocationStats frameStart;
+    AllocationStats lastFrame;
+    AllocationStats flaggedTotal;
+    unsigned long long frames;
+    unsigned long long flaggedFrames;
+
+    static AllocationStats unexpectedAllocations();
+};
@@ -0,0 +1,53 @@
+#include "frameArena.h"
+#include <algorithm>
+#include <cstdint>
+
+FrameArena& FrameArena::getInstance()
+{
+    static FrameArena instance;
+    return instance;
+}
+
+FrameArena::FrameArena(size_t capacity)
+    : block(new unsigned char[capacity]), capacity(capacity), current(block.get()), currentSize(capacity),
+      currentUsed(0), frameBytes(0), peakBytes(0)
+{
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment)
+{
+    uintptr_t base = (uintptr_t)current;
+    size_t offset = ((base + currentUsed + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+    if (offset + bytes > currentSize)
+    {
+        // Keeps this frame going; reset() folds it into the main block
+        size_t size = std::max(capacity, bytes + alignment);
+        overflow.emplace_back(new unsigned char[size]);
+        current = overflow.back().get();
+        currentSize = size;
+        currentUsed = 0;
+        base = (uintptr_t)current;
+        offset = ((base + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+    }
+
+    frameBytes += offset - currentUsed + bytes;
+    currentUsed = offset + bytes;
+    return current + offset;
+}
+
+void FrameArena::reset()
+{
+    peakBytes = std::max(peakBytes, frameBytes);
+    if (!overflow.empty())
+    {
+        // Alignment padding depends on the addresses, hence the headroom
+        capacity = peakBytes + peakBytes / 4;
+        overflow.clear();
+        block.reset(new unsigned char[capacity]);
+    }
+
+    current = block.get();
+    currentSize = capacity;
+    currentUsed = 0;
+    frameBytes = 0;
+}
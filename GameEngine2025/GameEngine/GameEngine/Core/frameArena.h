@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for data that only lives until the end of the frame:
+// allocating moves a pointer, reset() at the frame boundary frees it all.
+// A frame that outgrows the block continues in extra blocks from the heap,
+// and the next reset() swaps them for one block big enough for that frame,
+// so once the peak has been seen a frame never touches the heap.
+//
+//   glm::mat4* mvps = FrameArena::getInstance().allocateArray<glm::mat4>(count);
+//   ...
+//   FrameArena::getInstance().reset();   // end of frame
+//
+// Nothing is destroyed on reset, so only trivially destructible types go in.
+// Not thread-safe: the shared instance belongs to the render thread.
+class FrameArena
+{
+public:
+    static const size_t DEFAULT_CAPACITY = 256 * 1024;
+    static const size_t ARRAY_ALIGNMENT = 16;   // arrays may be read with SIMD loads
+
+    static FrameArena& getInstance();
+
+    explicit FrameArena(size_t capacity = DEFAULT_CAPACITY);
+
+    // alignment must be a power of two
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    // Uninitialized storage for count values of T
+    template<typename T>
+    T* allocateArray(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+        size_t alignment = alignof(T) > ARRAY_ALIGNMENT ? alignof(T) : ARRAY_ALIGNMENT;
+        return static_cast<T*>(allocate(count * sizeof(T), alignment));
+    }
+
+    void reset();
+
+    size_t getUsed() const { return frameBytes; }       // this frame, padding included
+    size_t getCapacity() const { return capacity; }
+    size_t getPeak() const { return peakBytes; }        // largest frame so far
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+private:
+    std::unique_ptr<unsigned char[]> block;
+    size_t capacity;
+
+    // Block being filled: the main one, or the last overflow block
+    unsigned char* current;
+    size_t currentSize;
+    size_t currentUsed;
+    std::vector<std::unique_ptr<unsigned char[]>> overflow;
+
+    size_t frameBytes;
+    size_t peakBytes;
+};
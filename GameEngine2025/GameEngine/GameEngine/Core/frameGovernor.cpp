@@ -0,0 +1,146 @@
+#include "frameGovernor.h"
+#include <algorithm>
+#include <cmath>
+
+FrameGovernor::FrameGovernor(const FrameGovernorSettings& settings)
+    : enabled(true), windowSum(0.0), windowCount(0), windowsUnderBudget(0), framesToSkip(0)
+{
+    setSettings(settings);
+    state.renderScale = this->settings.maxRenderScale;
+    state.drawDistance = this->settings.maxDrawDistance;
+}
+
+void FrameGovernor::setSettings(const FrameGovernorSettings& newSettings)
+{
+    settings = newSettings;
+    settings.minRenderScale = std::max(settings.minRenderScale, settings.scaleStep);
+    settings.maxRenderScale = std::max(settings.maxRenderScale, settings.minRenderScale);
+    settings.windowFrames = std::max(settings.windowFrames, 1);
+
+    state.renderScale = std::min(std::max(state.renderScale, settings.minRenderScale), settings.maxRenderScale);
+    state.lodBias = std::min(state.lodBias, settings.maxLodBias);
+    state.drawDistance = std::min(std::max(state.drawDistance, settings.minDrawDistance), settings.maxDrawDistance);
+}
+
+void FrameGovernor::setEnabled(bool enable)
+{
+    enabled = enable;
+    windowSum = 0.0;
+    windowCount = 0;
+    windowsUnderBudget = 0;
+    if (!enabled)
+    {
+        // Full quality while nobody governs
+        state.renderScale = settings.maxRenderScale;
+        state.lodBias = 0.0f;
+        state.drawDistance = settings.maxDrawDistance;
+        state.lastAction = GOVERNOR_HOLD;
+    }
+}
+
+void FrameGovernor::addGpuFrameTime(double gpuMs)
+{
+    if (!enabled)
+        return;
+    if (framesToSkip > 0)
+    {
+        framesToSkip--;
+        return;
+    }
+    windowSum += gpuMs;
+    windowCount++;
+}
+
+float FrameGovernor::quantizeScale(float scale) const
+{
+    float steps = std::floor(scale / settings.scaleStep + 1.0e-3f);
+    return std::min(std::max(steps * settings.scaleStep, settings.minRenderScale), settings.maxRenderScale);
+}
+
+void FrameGovernor::change(FrameGovernorAction action)
+{
+    state.lastAction = action;
+    state.changes++;
+    windowsUnderBudget = 0;
+    framesToSkip = settings.settleFrames;
+}
+
+bool FrameGovernor::update()
+{
+    if (!enabled || windowCount < settings.windowFrames)
+        return false;
+
+    float average = (float)(windowSum / windowCount);
+    windowSum = 0.0;
+    windowCount = 0;
+    state.averageGpuMs = average;
+    state.windows++;
+
+    bool detailReduced = state.lodBias > 0.0f || state.drawDistance < settings.maxDrawDistance;
+
+    if (average > settings.targetMs * settings.overBudget)
+    {
+        windowsUnderBudget = 0;
+        if (state.renderScale > settings.minRenderScale)
+        {
+            // Most of the cost follows the pixel count, i.e. the scale squared;
+            // always at least one step down
+            float wanted = state.renderScale * std::sqrt(settings.targetMs / average);
+            state.renderScale = quantizeScale(std::min(wanted, state.renderScale - settings.scaleStep));
+            change(GOVERNOR_LOWER_SCALE);
+            return true;
+        }
+        if (settings.adjustDetail &&
+            (state.lodBias < settings.maxLodBias || state.drawDistance > settings.minDrawDistance))
+        {
+            state.lodBias = std::min(state.lodBias + settings.lodBiasStep, settings.maxLodBias);
+            state.drawDistance = std::max(state.drawDistance * settings.drawDistanceStep, settings.minDrawDistance);
+            change(GOVERNOR_LOWER_DETAIL);
+            return true;
+        }
+        return false;
+    }
+
+    // Inside the band: hold
+    if (average >= settings.targetMs * settings.underBudget)
+    {
+        windowsUnderBudget = 0;
+        return false;
+    }
+    if (++windowsUnderBudget < settings.raiseWindows)
+        return false;
+
+    // Detail was the last thing given up, so it comes back first
+    if (detailReduced)
+    {
+        state.lodBias = std::max(state.lodBias - settings.lodBiasStep, 0.0f);
+        state.drawDistance = std::min(state.drawDistance / settings.drawDistanceStep, settings.maxDrawDistance);
+        change(GOVERNOR_RAISE_DETAIL);
+        return true;
+    }
+
+    if (state.renderScale < settings.maxRenderScale)
+    {
+        float next = quantizeScale(state.renderScale + settings.scaleStep);
+        float ratio = next / state.renderScale;
+        if (average * ratio * ratio <= settings.targetMs)
+        {
+            state.renderScale = next;
+            change(GOVERNOR_RAISE_SCALE);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* FrameGovernor::getActionName(FrameGovernorAction action)
+{
+    switch (action)
+    {
+    case GOVERNOR_LOWER_SCALE: return "lower render scale";
+    case GOVERNOR_RAISE_SCALE: return "raise render scale";
+    case GOVERNOR_LOWER_DETAIL: return "lower detail";
+    case GOVERNOR_RAISE_DETAIL: return "raise detail";
+    default: return "hold";
+    }
+}
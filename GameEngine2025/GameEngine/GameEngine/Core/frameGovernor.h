@@ -0,0 +1,90 @@
+#pragma once
+
+struct FrameGovernorSettings
+{
+    float targetMs = 1000.0f / 60.0f;   // GPU time per frame to hold
+    float minRenderScale = 0.5f;        // of the window size, per axis
+    float maxRenderScale = 1.0f;
+    float scaleStep = 0.05f;            // render scales are multiples of this
+
+    // Hysteresis: quality drops above targetMs * overBudget and only comes
+    // back below targetMs * underBudget, for raiseWindows windows in a row,
+    // and when the predicted cost of the next step still fits the target
+    float overBudget = 1.05f;
+    float underBudget = 0.8f;
+    int raiseWindows = 2;
+    int windowFrames = 15;              // GPU frame times averaged per decision
+    int settleFrames = 4;               // dropped after a change; measured before it took effect
+
+    // Once the render scale is at its minimum: coarser textures, in mip
+    // levels, and a shorter draw distance. Restored before the scale rises.
+    bool adjustDetail = true;
+    float lodBiasStep = 0.5f;
+    float maxLodBias = 2.0f;
+    float drawDistanceStep = 0.75f;     // factor per step
+    float maxDrawDistance = 10000.0f;
+    float minDrawDistance = 300.0f;
+};
+
+enum FrameGovernorAction
+{
+    GOVERNOR_HOLD = 0,
+    GOVERNOR_LOWER_SCALE,
+    GOVERNOR_RAISE_SCALE,
+    GOVERNOR_LOWER_DETAIL,
+    GOVERNOR_RAISE_DETAIL
+};
+
+// What the governor currently asks the renderer for, and why
+struct FrameGovernorState
+{
+    float renderScale = 1.0f;
+    float lodBias = 0.0f;
+    float drawDistance = 10000.0f;
+    float averageGpuMs = 0.0f;      // of the window behind the last decision
+    FrameGovernorAction lastAction = GOVERNOR_HOLD;
+    unsigned int changes = 0;       // decisions that changed something, since startup
+    unsigned int windows = 0;       // decision windows completed
+};
+
+// Keeps GPU frame time near a target by trading render resolution, and
+// optionally texture detail and draw distance, against it. Frame times are
+// averaged over a window; a full window is one decision. Every change
+// discards the samples taken before it, so each decision sees only frames
+// rendered with the previous one. The caller measures the frames (see
+// GpuFrameTimer) and applies the state.
+//
+//   governor.addGpuFrameTime(ms);
+//   if (governor.update()) ...apply governor.getState()...
+class FrameGovernor
+{
+public:
+    explicit FrameGovernor(const FrameGovernorSettings& settings = FrameGovernorSettings());
+
+    void setSettings(const FrameGovernorSettings& settings);
+    const FrameGovernorSettings& getSettings() const { return settings; }
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled; }
+
+    void addGpuFrameTime(double gpuMs);
+
+    // Takes a decision once a window is full; true when the state changed
+    bool update();
+
+    const FrameGovernorState& getState() const { return state; }
+    static const char* getActionName(FrameGovernorAction action);
+
+private:
+    FrameGovernorSettings settings;
+    FrameGovernorState state;
+    bool enabled;
+
+    double windowSum;
+    int windowCount;
+    int windowsUnderBudget;
+    int framesToSkip;
+
+    float quantizeScale(float scale) const;
+    void change(FrameGovernorAction action);
+};
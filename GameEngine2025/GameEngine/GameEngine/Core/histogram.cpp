@@ -0,0 +1,89 @@
+#include "histogram.h"
+#include <algorithm>
+#include <cmath>
+
+static const int HALF_BUCKETS = Histogram::SUB_BUCKETS / 2;
+
+Histogram::Histogram()
+    : counts(BUCKET_COUNT, 0), count(0), maxValue(0.0)
+{
+}
+
+int Histogram::bucketOf(uint64_t ticks)
+{
+    if (ticks < (uint64_t)SUB_BUCKETS)
+        return (int)ticks;
+
+    // Keep the top SUB_BUCKET_BITS bits; the shift is the power of two
+    int highestBit = 63;
+    while (!(ticks >> highestBit))
+        highestBit--;
+    int shift = highestBit - (SUB_BUCKET_BITS - 1);
+    if (shift > MAX_SHIFT)
+        return BUCKET_COUNT - 1;
+
+    int sub = (int)(ticks >> shift);      // in [HALF_BUCKETS, SUB_BUCKETS)
+    return SUB_BUCKETS + (shift - 1) * HALF_BUCKETS + (sub - HALF_BUCKETS);
+}
+
+uint64_t Histogram::bucketTop(int bucket)
+{
+    if (bucket < SUB_BUCKETS)
+        return (uint64_t)bucket;
+
+    int step = bucket - SUB_BUCKETS;
+    int shift = step / HALF_BUCKETS + 1;
+    uint64_t sub = (uint64_t)(step % HALF_BUCKETS + HALF_BUCKETS);
+    return ((sub + 1) << shift) - 1;
+}
+
+void Histogram::record(double value)
+{
+    value = std::max(value, 0.0);
+    counts[bucketOf((uint64_t)std::llround(value * TICKS_PER_UNIT))]++;
+    count++;
+    maxValue = std::max(maxValue, value);
+}
+
+void Histogram::add(const Histogram& other)
+{
+    for (int i = 0; i < BUCKET_COUNT; i++)
+        counts[i] += other.counts[i];
+    count += other.count;
+    maxValue = std::max(maxValue, other.maxValue);
+}
+
+void Histogram::reset()
+{
+    std::fill(counts.begin(), counts.end(), 0);
+    count = 0;
+    maxValue = 0.0;
+}
+
+double Histogram::getPercentile(double percentile) const
+{
+    if (count == 0)
+        return 0.0;
+
+    uint64_t rank = (uint64_t)std::ceil(std::min(std::max(percentile, 0.0), 100.0) / 100.0 * count);
+    rank = std::max(rank, (uint64_t)1);
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+            return std::min((double)bucketTop(i) / TICKS_PER_UNIT, maxValue);
+    }
+    return maxValue;
+}
+
+HistogramSummary Histogram::getSummary() const
+{
+    HistogramSummary summary;
+    summary.count = count;
+    summary.p50 = getPercentile(50.0);
+    summary.p95 = getPercentile(95.0);
+    summary.p99 = getPercentile(99.0);
+    summary.max = maxValue;
+    return summary;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+struct HistogramSummary
+{
+    uint64_t count = 0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+// Distribution of non-negative values in fixed memory, laid out like
+// HdrHistogram: below SUB_BUCKETS ticks every value has its own bucket,
+// above it each power of two is split into SUB_BUCKETS / 2 linear steps.
+// Every value is therefore kept to within 1/64 (1.6%) of itself whatever
+// its magnitude, recording is O(1) and histograms of the same kind merge
+// by adding counts. Values are stored in ticks of 1/TICKS_PER_UNIT, so
+// millisecond timings keep microsecond resolution, up to over two hours.
+class Histogram
+{
+public:
+    static const int SUB_BUCKET_BITS = 7;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_SHIFT = 26;
+    static const int BUCKET_COUNT = SUB_BUCKETS + MAX_SHIFT * (SUB_BUCKETS / 2);
+    static const int TICKS_PER_UNIT = 1000;
+
+    Histogram();
+
+    void record(double value);
+    void add(const Histogram& other);
+    void reset();
+
+    uint64_t getCount() const { return count; }
+    double getMax() const { return maxValue; }
+
+    // Value at or below which `percentile` percent of the recorded values
+    // lie, reported as the top of its bucket (never above the maximum)
+    double getPercentile(double percentile) const;
+    HistogramSummary getSummary() const;
+
+private:
+    std::vector<uint32_t> counts;
+    uint64_t count;
+    double maxValue;
+
+    static int bucketOf(uint64_t ticks);
+    static uint64_t bucketTop(int bucket);
+};
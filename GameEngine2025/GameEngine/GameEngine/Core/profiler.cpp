@@ -0,0 +1,302 @@
+#include "profiler.h"
+#include <glfw3.h>
+#include <fstream>
+#include <iostream>
+
+// Frames to keep polling for outstanding GPU results after a capture ends
+static const int MAX_WRITE_WAIT_FRAMES = 16;
+
+bool Profiler::capturing = false;
+
+Profiler& Profiler::getInstance()
+{
+    static Profiler instance;
+    return instance;
+}
+
+Profiler::Profiler()
+    : gpuTimersSupported(false),
+    gpuOffsetUs(0.0),
+    gpuResolved(0),
+    frameIndex(0),
+    framesRemaining(0),
+    frameStartUs(0.0),
+    frameOpen(false),
+    writePending(false),
+    writeWaitFrames(0)
+{
+}
+
+Profiler::~Profiler()
+{
+    // The GL context is gone by the time statics are destroyed, so query
+    // objects are left to the driver
+}
+
+double Profiler::nowUs() const
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - captureStart).count();
+}
+
+void Profiler::beginCapture(int frames, const std::string& path)
+{
+    if (capturing || writePending)
+    {
+        std::cout << "Warning: a profiler capture is already in progress" << std::endl;
+        return;
+    }
+
+    events.clear();
+    openCpuEvents.clear();
+    counters.clear();
+    gpuEvents.clear();
+    openGpuEvents.clear();
+    gpuResolved = 0;
+
+    captureStart = std::chrono::steady_clock::now();
+    frameIndex = 0;
+    framesRemaining = frames;
+    frameStartUs = 0.0;
+    frameOpen = true;
+    outputPath = path;
+    writeWaitFrames = 0;
+
+    // Timer queries need a current context; without one (benchmarks) only CPU
+    // markers are recorded
+    gpuTimersSupported = glfwGetCurrentContext() != nullptr && (GLEW_VERSION_3_3 || GLEW_ARB_timer_query);
+    if (gpuTimersSupported)
+    {
+        // Aligns GPU timestamps to the CPU timeline. The value is taken when
+        // the query reaches the GPU, so GPU events can appear slightly late.
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        gpuOffsetUs = nowUs() - gpuNow / 1000.0;
+    }
+
+    capturing = true;
+    std::cout << "Profiler capture started";
+    if (frames > 0)
+        std::cout << " (" << frames << " frames)";
+    std::cout << (gpuTimersSupported ? "" : ", GPU timers unavailable") << std::endl;
+}
+
+void Profiler::endCapture()
+{
+    if (!capturing)
+        return;
+
+    if (frameOpen)
+    {
+        Event frame = { "Frame", frameStartUs, nowUs() - frameStartUs, frameIndex, TRACK_CPU };
+        events.push_back(frame);
+        frameOpen = false;
+    }
+
+    capturing = false;
+    writePending = true;
+    resolveGpuEvents();
+    if (gpuResolved == gpuEvents.size())
+        finishCapture();
+}
+
+void Profiler::beginFrame()
+{
+    if (capturing)
+    {
+        double now = nowUs();
+        if (frameOpen)
+        {
+            Event frame = { "Frame", frameStartUs, now - frameStartUs, frameIndex, TRACK_CPU };
+            events.push_back(frame);
+            frameOpen = false;
+        }
+
+        if (framesRemaining > 0 && --framesRemaining == 0)
+        {
+            endCapture();
+            return;
+        }
+
+        resolveGpuEvents();
+        frameIndex++;
+        frameStartUs = now;
+        frameOpen = true;
+        return;
+    }
+
+    if (writePending)
+    {
+        resolveGpuEvents();
+        if (gpuResolved == gpuEvents.size() || ++writeWaitFrames > MAX_WRITE_WAIT_FRAMES)
+            finishCapture();
+    }
+}
+
+void Profiler::finishCapture()
+{
+    if (gpuResolved != gpuEvents.size())
+    {
+        std::cout << "Warning: " << gpuEvents.size() - gpuResolved
+            << " GPU profiler events never completed and were dropped" << std::endl;
+    }
+
+    writeChromeTrace(outputPath);
+    writePending = false;
+}
+
+// ===== CPU EVENTS =====
+
+void Profiler::beginCpuEvent(const char* name)
+{
+    Event event = { name, nowUs(), 0.0, frameIndex, TRACK_CPU };
+    openCpuEvents.push_back(events.size());
+    events.push_back(event);
+}
+
+void Profiler::endCpuEvent()
+{
+    // Scopes opened during a capture still close after it ends
+    if (openCpuEvents.empty())
+        return;
+
+    Event& event = events[openCpuEvents.back()];
+    event.durationUs = nowUs() - event.startUs;
+    openCpuEvents.pop_back();
+}
+
+void Profiler::addCounter(const char* name, double value)
+{
+    if (!capturing)
+        return;
+    Counter counter = { name, nowUs(), value };
+    counters.push_back(counter);
+}
+
+// ===== GPU EVENTS =====
+
+GLuint Profiler::acquireQuery()
+{
+    if (freeQueries.empty())
+    {
+        GLuint queries[16];
+        glGenQueries(16, queries);
+        freeQueries.insert(freeQueries.end(), queries, queries + 16);
+    }
+
+    GLuint query = freeQueries.back();
+    freeQueries.pop_back();
+    return query;
+}
+
+void Profiler::beginGpuEvent(const char* name)
+{
+    if (!gpuTimersSupported)
+        return;
+
+    GpuEvent event = { name, acquireQuery(), 0, frameIndex, false };
+    glQueryCounter(event.beginQuery, GL_TIMESTAMP);
+    openGpuEvents.push_back(gpuEvents.size());
+    gpuEvents.push_back(event);
+}
+
+void Profiler::endGpuEvent()
+{
+    if (!gpuTimersSupported || openGpuEvents.empty())
+        return;
+
+    GpuEvent& event = gpuEvents[openGpuEvents.back()];
+    event.endQuery = acquireQuery();
+    glQueryCounter(event.endQuery, GL_TIMESTAMP);
+    event.closed = true;
+    openGpuEvents.pop_back();
+}
+
+void Profiler::resolveGpuEvents()
+{
+    // Queries complete in submission order, so stop at the first one pending
+    while (gpuResolved < gpuEvents.size())
+    {
+        GpuEvent& pending = gpuEvents[gpuResolved];
+        if (!pending.closed)
+            break;
+
+        GLint available = 0;
+        glGetQueryObjectiv(pending.endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+
+        GLuint64 beginNs = 0, endNs = 0;
+        glGetQueryObjectui64v(pending.beginQuery, GL_QUERY_RESULT, &beginNs);
+        glGetQueryObjectui64v(pending.endQuery, GL_QUERY_RESULT, &endNs);
+
+        Event event = { pending.name, beginNs / 1000.0 + gpuOffsetUs, (endNs - beginNs) / 1000.0,
+            pending.frame, TRACK_GPU };
+        events.push_back(event);
+
+        freeQueries.push_back(pending.beginQuery);
+        freeQueries.push_back(pending.endQuery);
+        gpuResolved++;
+    }
+
+    // Compact once nothing refers to the resolved prefix
+    if (gpuResolved == gpuEvents.size() && openGpuEvents.empty())
+    {
+        gpuEvents.clear();
+        gpuResolved = 0;
+    }
+}
+
+// ===== EXPORT =====
+
+static void writeJsonString(std::ofstream& out, const char* text)
+{
+    out << '"';
+    for (const char* c = text; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            out << '\\';
+        out << *c;
+    }
+    out << '"';
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) const
+{
+    std::ofstream out(path.c_str());
+    if (!out)
+    {
+        std::cout << "Warning: could not write profiler trace to " << path << std::endl;
+        return false;
+    }
+
+    // Trace Event Format: "X" complete events in microseconds, one thread
+    // lane per track, and "C" samples for counters. Opens in chrome://tracing,
+    // Perfetto and Speedscope.
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GameEngine\"}},\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << TRACK_CPU << ",\"args\":{\"name\":\"CPU\"}},\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << TRACK_GPU << ",\"args\":{\"name\":\"GPU\"}}";
+
+    out.setf(std::ios::fixed);
+    out.precision(3);
+    for (const Event& event : events)
+    {
+        out << ",\n{\"name\":";
+        writeJsonString(out, event.name);
+        out << ",\"cat\":\"" << (event.track == TRACK_GPU ? "gpu" : "cpu") << "\",\"ph\":\"X\""
+            << ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs
+            << ",\"pid\":1,\"tid\":" << event.track
+            << ",\"args\":{\"frame\":" << event.frame << "}}";
+    }
+    for (const Counter& counter : counters)
+    {
+        out << ",\n{\"name\":";
+        writeJsonString(out, counter.name);
+        out << ",\"ph\":\"C\",\"ts\":" << counter.timeUs << ",\"pid\":1"
+            << ",\"args\":{\"value\":" << counter.value << "}}";
+    }
+    out << "\n]}\n";
+
+    std::cout << "Profiler trace written to " << path << " (" << events.size() << " events)" << std::endl;
+    return true;
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include <glew.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Set ENABLE_PROFILER=0 in the preprocessor definitions to compile every
+// PROFILE_* marker out of the build.
+#ifndef ENABLE_PROFILER
+#define ENABLE_PROFILER 1
+#endif
+
+// Hierarchical frame profiler. CPU scopes are timed on the main thread with
+// the steady clock; GPU scopes issue GL_TIMESTAMP queries at their begin and
+// end (timestamps nest, GL_TIME_ELAPSED queries do not) which are read back a
+// few frames later, once the driver reports them available, so the CPU never
+// waits on the GPU. Outside a capture every marker costs one branch.
+//
+//   Profiler::getInstance().beginCapture(120);
+//   { PROFILE_SCOPE("render"); PROFILE_GPU_SCOPE("render"); ... }
+//   Profiler::getInstance().beginFrame();   // once per frame
+//
+// Marker names must be string literals; only the pointer is stored.
+class Profiler
+{
+public:
+    static Profiler& getInstance();
+
+    // Records until endCapture(), or for the given number of frames when > 0.
+    // The trace is written to outputPath once all GPU results are back.
+    void beginCapture(int frames = 0, const std::string& outputPath = "profile_trace.json");
+    void endCapture();
+
+    static bool isCapturing() { return capturing; }
+    bool isWritePending() const { return writePending; }
+
+    // Frame boundary: closes the previous frame event, resolves finished GPU
+    // queries and ends a frame-limited capture
+    void beginFrame();
+
+    void beginCpuEvent(const char* name);
+    void endCpuEvent();
+    void beginGpuEvent(const char* name);
+    void endGpuEvent();
+
+    // Sample of a value that is plotted over time as its own trace track
+    void addCounter(const char* name, double value);
+
+    bool writeChromeTrace(const std::string& path) const;
+
+private:
+    Profiler();
+    ~Profiler();
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    enum Track
+    {
+        TRACK_CPU = 1,
+        TRACK_GPU = 2
+    };
+
+    struct Event
+    {
+        const char* name;
+        double startUs;
+        double durationUs;
+        int frame;
+        Track track;
+    };
+
+    struct Counter
+    {
+        const char* name;
+        double timeUs;
+        double value;
+    };
+
+    struct GpuEvent
+    {
+        const char* name;
+        GLuint beginQuery;
+        GLuint endQuery;
+        int frame;
+        bool closed;
+    };
+
+    double nowUs() const;
+    GLuint acquireQuery();
+    void resolveGpuEvents();
+    void finishCapture();
+
+    static bool capturing;
+
+    std::chrono::steady_clock::time_point captureStart;
+    std::vector<Event> events;
+    std::vector<size_t> openCpuEvents;
+    std::vector<Counter> counters;
+
+    bool gpuTimersSupported;
+    double gpuOffsetUs;     // CPU capture time minus GPU timestamp, in microseconds
+    std::vector<GpuEvent> gpuEvents;    // in issue order, resolved from the front
+    std::vector<size_t> openGpuEvents;
+    size_t gpuResolved;
+    std::vector<GLuint> freeQueries;
+
+    int frameIndex;
+    int framesRemaining;
+    double frameStartUs;
+    bool frameOpen;
+
+    bool writePending;
+    int writeWaitFrames;
+    std::string outputPath;
+};
+
+#if ENABLE_PROFILER
+
+class ProfileScope
+{
+public:
+    ProfileScope(const char* name) : active(Profiler::isCapturing())
+    {
+        if (active)
+            Profiler::getInstance().beginCpuEvent(name);
+    }
+    ~ProfileScope()
+    {
+        if (active)
+            Profiler::getInstance().endCpuEvent();
+    }
+
+private:
+    bool active;
+};
+
+class GpuProfileScope
+{
+public:
+    GpuProfileScope(const char* name) : active(Profiler::isCapturing())
+    {
+        if (active)
+            Profiler::getInstance().beginGpuEvent(name);
+    }
+    ~GpuProfileScope()
+    {
+        if (active)
+            Profiler::getInstance().endGpuEvent();
+    }
+
+private:
+    bool active;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+#define PROFILE_COUNTER(name, value) do { if (Profiler::isCapturing()) Profiler::getInstance().addCounter(name, value); } while (0)
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_GPU_SCOPE(name)
+#define PROFILE_COUNTER(name, value)
+
+#endif
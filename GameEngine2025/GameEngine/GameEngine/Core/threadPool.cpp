@@ -0,0 +1,157 @@
+#include "threadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+    : stopping(false)
+{
+    if (threadCount == 0)
+        threadCount = 1;
+
+    // Only nested or concurrent loops need more than one entry
+    loops.reserve(16);
+
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    // Queued tasks still run so nobody waits on a future that never completes
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::getShared()
+{
+    unsigned int cores = std::thread::hardware_concurrency();
+    static ThreadPool instance(cores > 1 ? cores - 1 : 1);
+    return instance;
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> task)
+{
+    std::packaged_task<void()> packaged(std::move(task));
+    std::future<void> result = packaged.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(packaged));
+    }
+    wake.notify_one();
+    return result;
+}
+
+// Lives on the stack of the parallelFor caller, which waits for every helper
+// that joined to leave before returning. Helper counts are guarded by the
+// pool mutex; blocks are claimed without it.
+struct ParallelForState
+{
+    ParallelForState(BlockFunction fn, uint32_t count, uint32_t grain, uint32_t blockCount, unsigned int maxHelpers)
+        : fn(fn), count(count), grain(grain), blockCount(blockCount), nextBlock(0),
+          maxHelpers(maxHelpers), helpersJoined(0), helpersInside(0)
+    {
+    }
+
+    BlockFunction fn;
+    uint32_t count;
+    uint32_t grain;
+    uint32_t blockCount;
+    std::atomic<uint32_t> nextBlock;
+
+    unsigned int maxHelpers;
+    unsigned int helpersJoined;
+    unsigned int helpersInside;
+
+    void runBlocks()
+    {
+        for (;;)
+        {
+            uint32_t block = nextBlock.fetch_add(1);
+            if (block >= blockCount)
+                return;
+
+            uint32_t begin = block * grain;
+            fn(begin, std::min(begin + grain, count));
+        }
+    }
+};
+
+void ThreadPool::parallelFor(uint32_t count, uint32_t grain, BlockFunction fn)
+{
+    if (count == 0)
+        return;
+    if (grain == 0)
+        grain = 1;
+
+    uint32_t blockCount = (count + grain - 1) / grain;
+    if (blockCount == 1)
+    {
+        fn(0, count);
+        return;
+    }
+
+    unsigned int helpers = std::min((unsigned int)workers.size(), blockCount - 1);
+    ParallelForState state(fn, count, grain, blockCount, helpers);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        loops.push_back(&state);
+    }
+    wake.notify_all();
+
+    state.runBlocks();
+
+    // No block is left to claim; helpers that joined may still be finishing
+    // theirs, and a worker busy elsewhere must not join after this returns
+    std::unique_lock<std::mutex> lock(mutex);
+    std::vector<ParallelForState*>::iterator it = std::find(loops.begin(), loops.end(), &state);
+    if (it != loops.end())
+        loops.erase(it);
+    helpersLeft.wait(lock, [&]() { return state.helpersInside == 0; });
+}
+
+void ThreadPool::workerLoop()
+{
+    for (;;)
+    {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || !tasks.empty() || !loops.empty(); });
+
+            // Loops first: their callers are waiting, and each block is short
+            if (!loops.empty())
+            {
+                ParallelForState* loop = loops.back();
+                loop->helpersInside++;
+                if (++loop->helpersJoined == loop->maxHelpers)
+                    loops.pop_back();
+
+                lock.unlock();
+                loop->runBlocks();
+                lock.lock();
+
+                if (--loop->helpersInside == 0)
+                    helpersLeft.notify_all();
+                continue;
+            }
+
+            if (tasks.empty())
+                return;
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Non-owning reference to a parallelFor body. Unlike std::function it never
+// copies the callable, so passing a capturing lambda does not allocate; the
+// callable must outlive the call, which a temporary lambda argument does.
+class BlockFunction
+{
+public:
+    template<typename Fn>
+    BlockFunction(const Fn& fn)
+        : target(&fn), invoke(&call<Fn>)
+    {
+    }
+
+    void operator()(uint32_t begin, uint32_t end) const { invoke(target, begin, end); }
+
+private:
+    const void* target;
+    void (*invoke)(const void*, uint32_t, uint32_t);
+
+    template<typename Fn>
+    static void call(const void* fn, uint32_t begin, uint32_t end)
+    {
+        (*static_cast<const Fn*>(fn))(begin, end);
+    }
+};
+
+struct ParallelForState;
+
+// Fixed set of worker threads consuming a FIFO task queue. Work submitted
+// here must not touch GL; results that need the context are handed back to
+// the main thread by the caller.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned int threadCount);
+    ~ThreadPool();
+
+    // Engine-wide pool sized to the machine, leaving one core to the main thread
+    static ThreadPool& getShared();
+
+    std::future<void> submit(std::function<void()> task);
+
+    // Calls fn(begin, end) for consecutive blocks of `grain` items covering
+    // [0, count), on the workers and the calling thread. The caller claims
+    // blocks as well, so a pool busy with long tasks (asset loads) costs
+    // parallelism but never stalls it. Blocks depend only on count and grain,
+    // not on the thread count, so per-block results merged in block order are
+    // deterministic. Makes no heap allocation, so it can run every frame.
+    void parallelFor(uint32_t count, uint32_t grain, BlockFunction fn);
+
+    unsigned int getThreadCount() const { return (unsigned int)workers.size(); }
+
+private:
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::packaged_task<void()>> tasks;
+
+    // Running parallelFor loops still taking helpers. Workers serve these
+    // before tasks; each loop lives on its caller's stack.
+    std::vector<ParallelForState*> loops;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable helpersLeft;
+    bool stopping;
+};
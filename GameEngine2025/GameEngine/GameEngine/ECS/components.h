@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+#include "../ResourceManager/assetHandle.h"
+
+// Every component kind the entity world knows about. Data components own a
+// column inside each archetype chunk; tags are zero-size and only take part
+// in the archetype signature, so queries on them skip whole chunks.
+enum ComponentType
+{
+    COMPONENT_POSITION = 0,
+    COMPONENT_ROTATION,
+    COMPONENT_SCALE,
+    COMPONENT_MODEL_MATRIX,
+    COMPONENT_MESH,
+    COMPONENT_RENDER_FLAGS,
+
+    // Transform at the previous simulation tick, for render interpolation
+    COMPONENT_PREVIOUS_POSITION,
+    COMPONENT_PREVIOUS_ROTATION,
+    COMPONENT_PREVIOUS_SCALE,
+
+    // Index of the entity's body in the PhysicsWorld that moves it
+    COMPONENT_RIGID_BODY,
+
+    COMPONENT_DATA_COUNT,
+
+    TAG_SPACESHIP = 16,
+    TAG_ALIEN,
+    TAG_CAVE_WALL,
+    TAG_ROCK,
+    TAG_ASTEROID,
+    TAG_PORTAL_MARKER,
+
+    // Owned by a cell of a WorldPartition, which tracks it by cell
+    TAG_STREAMED
+};
+
+typedef uint32_t ComponentMask;
+
+inline ComponentMask componentBit(ComponentType type)
+{
+    return 1u << type;
+}
+
+// Signature shared by everything the scene renders
+const ComponentMask RENDERABLE_COMPONENTS =
+    (1u << COMPONENT_POSITION) | (1u << COMPONENT_ROTATION) | (1u << COMPONENT_SCALE) |
+    (1u << COMPONENT_MODEL_MATRIX) | (1u << COMPONENT_MESH) | (1u << COMPONENT_RENDER_FLAGS);
+
+// Added to entities that move during simulation ticks; their model matrix is
+// rebuilt every frame from the previous and current tick transforms
+const ComponentMask INTERPOLATED_COMPONENTS =
+    (1u << COMPONENT_PREVIOUS_POSITION) | (1u << COMPONENT_PREVIOUS_ROTATION) | (1u << COMPONENT_PREVIOUS_SCALE);
+
+// RenderFlags bits
+const uint32_t RENDER_VISIBLE = 1u << 0;
+const uint32_t RENDER_ENHANCED_LIGHTING = 1u << 1;
+
+// Maps a component id to the type stored in its column
+template<ComponentType C> struct ComponentTraits;
+
+template<> struct ComponentTraits<COMPONENT_POSITION> { typedef glm::vec3 Type; };
+template<> struct ComponentTraits<COMPONENT_ROTATION> { typedef glm::quat Type; };
+template<> struct ComponentTraits<COMPONENT_SCALE> { typedef glm::vec3 Type; };
+template<> struct ComponentTraits<COMPONENT_MODEL_MATRIX> { typedef glm::mat4 Type; };
+template<> struct ComponentTraits<COMPONENT_MESH> { typedef MeshHandle Type; };
+template<> struct ComponentTraits<COMPONENT_RENDER_FLAGS> { typedef uint32_t Type; };
+template<> struct ComponentTraits<COMPONENT_PREVIOUS_POSITION> { typedef glm::vec3 Type; };
+template<> struct ComponentTraits<COMPONENT_PREVIOUS_ROTATION> { typedef glm::quat Type; };
+template<> struct ComponentTraits<COMPONENT_PREVIOUS_SCALE> { typedef glm::vec3 Type; };
+template<> struct ComponentTraits<COMPONENT_RIGID_BODY> { typedef uint32_t Type; };
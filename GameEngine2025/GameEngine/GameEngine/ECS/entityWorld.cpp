@@ -0,0 +1,254 @@
+#include "entityWorld.h"
+#include <cstring>
+#include <utility>
+#include <iostream>
+
+static const size_t componentSizes[COMPONENT_DATA_COUNT] =
+{
+    sizeof(glm::vec3),  // COMPONENT_POSITION
+    sizeof(glm::quat),  // COMPONENT_ROTATION
+    sizeof(glm::vec3),  // COMPONENT_SCALE
+    sizeof(glm::mat4),  // COMPONENT_MODEL_MATRIX
+    sizeof(MeshHandle), // COMPONENT_MESH
+    sizeof(uint32_t),   // COMPONENT_RENDER_FLAGS
+    sizeof(glm::vec3),  // COMPONENT_PREVIOUS_POSITION
+    sizeof(glm::quat),  // COMPONENT_PREVIOUS_ROTATION
+    sizeof(glm::vec3),  // COMPONENT_PREVIOUS_SCALE
+    sizeof(uint32_t)    // COMPONENT_RIGID_BODY
+};
+
+// Columns start on a cache line so linear sweeps never straddle two arrays
+static const size_t COLUMN_ALIGNMENT = 64;
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+EntityWorld::EntityWorld()
+    : entityCount(0)
+{
+}
+
+EntityWorld::~EntityWorld()
+{
+}
+
+uint32_t EntityWorld::findOrCreateArchetype(ComponentMask signature)
+{
+    for (uint32_t i = 0; i < archetypes.size(); i++)
+    {
+        if (archetypes[i]->signature == signature)
+            return i;
+    }
+
+    std::unique_ptr<Archetype> archetype = std::make_unique<Archetype>();
+    archetype->signature = signature;
+
+    size_t stride = sizeof(Entity);
+    for (int c = 0; c < COMPONENT_DATA_COUNT; c++)
+    {
+        if (signature & (1u << c))
+            stride += componentSizes[c];
+    }
+
+    // Fit as many rows as the chunk budget allows, leaving room for column padding
+    size_t usable = CHUNK_BYTES - COLUMN_ALIGNMENT * (COMPONENT_DATA_COUNT + 1);
+    archetype->chunkCapacity = (uint32_t)(usable / stride);
+    if (archetype->chunkCapacity == 0)
+        archetype->chunkCapacity = 1;
+
+    size_t offset = 0;
+    for (int c = 0; c < COMPONENT_DATA_COUNT; c++)
+    {
+        archetype->columnOffsets[c] = 0;
+        if (signature & (1u << c))
+        {
+            archetype->columnOffsets[c] = offset;
+            offset = alignUp(offset + componentSizes[c] * archetype->chunkCapacity, COLUMN_ALIGNMENT);
+        }
+    }
+    archetype->entitiesOffset = offset;
+    archetype->chunkBytes = offset + sizeof(Entity) * archetype->chunkCapacity;
+
+    archetypes.push_back(std::move(archetype));
+    return (uint32_t)(archetypes.size() - 1);
+}
+
+ArchetypeChunk* EntityWorld::allocateChunk(Archetype& archetype)
+{
+    std::unique_ptr<ArchetypeChunk> chunk = std::make_unique<ArchetypeChunk>();
+    chunk->data.reset(new unsigned char[archetype.chunkBytes + COLUMN_ALIGNMENT]);
+
+    // Align the column block itself; offsets are relative to the aligned base
+    size_t misalignment = (size_t)chunk->data.get() & (COLUMN_ALIGNMENT - 1);
+    size_t base = misalignment ? COLUMN_ALIGNMENT - misalignment : 0;
+    for (int c = 0; c < COMPONENT_DATA_COUNT; c++)
+    {
+        chunk->columnOffsets[c] = base + archetype.columnOffsets[c];
+    }
+    chunk->entities = reinterpret_cast<Entity*>(chunk->data.get() + base + archetype.entitiesOffset);
+    chunk->count = 0;
+    chunk->capacity = archetype.chunkCapacity;
+    chunk->transformsDirty = false;
+
+    archetype.chunks.push_back(std::move(chunk));
+    return archetype.chunks.back().get();
+}
+
+Entity EntityWorld::createEntity(ComponentMask signature)
+{
+    uint32_t archetypeIndex = findOrCreateArchetype(signature);
+    Archetype& archetype = *archetypes[archetypeIndex];
+
+    // Entities are kept packed, so only the last chunk can have free rows
+    ArchetypeChunk* chunk = nullptr;
+    uint32_t chunkIndex = 0;
+    if (!archetype.chunks.empty() && archetype.chunks.back()->count < archetype.chunkCapacity)
+    {
+        chunkIndex = (uint32_t)(archetype.chunks.size() - 1);
+        chunk = archetype.chunks.back().get();
+    }
+    else
+    {
+        chunk = allocateChunk(archetype);
+        chunkIndex = (uint32_t)(archetype.chunks.size() - 1);
+    }
+
+    Entity entity;
+    if (!freeIndices.empty())
+    {
+        entity.index = freeIndices.back();
+        freeIndices.pop_back();
+    }
+    else
+    {
+        entity.index = (uint32_t)records.size();
+        EntityRecord record = {};
+        records.push_back(record);
+    }
+
+    EntityRecord& record = records[entity.index];
+    record.archetype = archetypeIndex;
+    record.chunk = chunkIndex;
+    record.row = chunk->count++;
+    record.alive = true;
+    entity.generation = record.generation;
+
+    chunk->entities[record.row] = entity;
+
+    // Default component values
+    uint32_t row = record.row;
+    if (signature & componentBit(COMPONENT_POSITION))
+        chunk->column<COMPONENT_POSITION>()[row] = glm::vec3(0.0f);
+    if (signature & componentBit(COMPONENT_ROTATION))
+        chunk->column<COMPONENT_ROTATION>()[row] = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    if (signature & componentBit(COMPONENT_SCALE))
+        chunk->column<COMPONENT_SCALE>()[row] = glm::vec3(1.0f);
+    if (signature & componentBit(COMPONENT_MODEL_MATRIX))
+        chunk->column<COMPONENT_MODEL_MATRIX>()[row] = glm::mat4(1.0f);
+    if (signature & componentBit(COMPONENT_MESH))
+        chunk->column<COMPONENT_MESH>()[row] = MeshHandle();
+    if (signature & componentBit(COMPONENT_RENDER_FLAGS))
+        chunk->column<COMPONENT_RENDER_FLAGS>()[row] = RENDER_VISIBLE;
+    if (signature & componentBit(COMPONENT_PREVIOUS_POSITION))
+        chunk->column<COMPONENT_PREVIOUS_POSITION>()[row] = glm::vec3(0.0f);
+    if (signature & componentBit(COMPONENT_PREVIOUS_ROTATION))
+        chunk->column<COMPONENT_PREVIOUS_ROTATION>()[row] = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    if (signature & componentBit(COMPONENT_PREVIOUS_SCALE))
+        chunk->column<COMPONENT_PREVIOUS_SCALE>()[row] = glm::vec3(1.0f);
+    if (signature & componentBit(COMPONENT_RIGID_BODY))
+        chunk->column<COMPONENT_RIGID_BODY>()[row] = 0xFFFFFFFFu;
+
+    chunk->transformsDirty = true;
+    entityCount++;
+    return entity;
+}
+
+void EntityWorld::destroyEntity(Entity entity)
+{
+    if (!isAlive(entity))
+    {
+        std::cout << "Warning: destroying a dead entity " << entity.index << std::endl;
+        return;
+    }
+
+    EntityRecord& record = records[entity.index];
+    Archetype& archetype = *archetypes[record.archetype];
+    ArchetypeChunk* chunk = archetype.chunks[record.chunk].get();
+    ArchetypeChunk* lastChunk = archetype.chunks.back().get();
+    uint32_t lastRow = lastChunk->count - 1;
+
+    // Fill the hole with the archetype's last entity to keep every chunk packed
+    if (chunk != lastChunk || record.row != lastRow)
+    {
+        for (int c = 0; c < COMPONENT_DATA_COUNT; c++)
+        {
+            if (!(archetype.signature & (1u << c)))
+                continue;
+
+            size_t size = componentSizes[c];
+            memcpy(chunk->data.get() + chunk->columnOffsets[c] + size * record.row,
+                lastChunk->data.get() + lastChunk->columnOffsets[c] + size * lastRow,
+                size);
+        }
+
+        Entity moved = lastChunk->entities[lastRow];
+        chunk->entities[record.row] = moved;
+        records[moved.index].chunk = record.chunk;
+        records[moved.index].row = record.row;
+        chunk->transformsDirty = true;
+    }
+
+    lastChunk->count--;
+    if (lastChunk->count == 0)
+        archetype.chunks.pop_back();
+
+    record.alive = false;
+    record.generation++;
+    freeIndices.push_back(entity.index);
+    entityCount--;
+}
+
+bool EntityWorld::isAlive(Entity entity) const
+{
+    return entity.index < records.size() &&
+        records[entity.index].alive &&
+        records[entity.index].generation == entity.generation;
+}
+
+ComponentMask EntityWorld::getSignature(Entity entity) const
+{
+    if (!isAlive(entity))
+        return 0;
+    return archetypes[records[entity.index].archetype]->signature;
+}
+
+void EntityWorld::clear()
+{
+    // Archetypes stay registered; their chunks are released
+    for (auto& archetype : archetypes)
+    {
+        archetype->chunks.clear();
+    }
+
+    for (uint32_t i = 0; i < records.size(); i++)
+    {
+        if (records[i].alive)
+        {
+            records[i].alive = false;
+            records[i].generation++;
+            freeIndices.push_back(i);
+        }
+    }
+
+    entityCount = 0;
+}
+
+void EntityWorld::swap(EntityWorld& other)
+{
+    archetypes.swap(other.archetypes);
+    records.swap(other.records);
+    freeIndices.swap(other.freeIndices);
+    std::swap(entityCount, other.entityCount);
+}
@@ -0,0 +1,156 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "components.h"
+
+struct Entity
+{
+    uint32_t index;
+    uint32_t generation;
+
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+const Entity INVALID_ENTITY = { 0xFFFFFFFFu, 0 };
+
+// Fixed-size block holding up to `capacity` entities of one archetype.
+// Each data component lives in its own contiguous column (SoA), so systems
+// walk plain arrays instead of chasing per-object heap pointers.
+struct ArchetypeChunk
+{
+    std::unique_ptr<unsigned char[]> data;
+    Entity* entities;
+    uint32_t count;
+    uint32_t capacity;
+    size_t columnOffsets[COMPONENT_DATA_COUNT];
+
+    // Set whenever a transform column is written; cleared by the transform system
+    bool transformsDirty;
+
+    template<ComponentType C>
+    typename ComponentTraits<C>::Type* column()
+    {
+        return reinterpret_cast<typename ComponentTraits<C>::Type*>(data.get() + columnOffsets[C]);
+    }
+
+    template<ComponentType C>
+    const typename ComponentTraits<C>::Type* column() const
+    {
+        return reinterpret_cast<const typename ComponentTraits<C>::Type*>(data.get() + columnOffsets[C]);
+    }
+};
+
+struct Archetype
+{
+    ComponentMask signature;
+    uint32_t chunkCapacity;
+    size_t columnOffsets[COMPONENT_DATA_COUNT];
+    size_t entitiesOffset;
+    size_t chunkBytes;
+    std::vector<std::unique_ptr<ArchetypeChunk>> chunks;
+};
+
+class EntityWorld
+{
+public:
+    // Target size of a chunk allocation; small enough to stay cache friendly
+    static const size_t CHUNK_BYTES = 16 * 1024;
+
+    EntityWorld();
+    ~EntityWorld();
+
+    EntityWorld(const EntityWorld&) = delete;
+    EntityWorld& operator=(const EntityWorld&) = delete;
+
+    Entity createEntity(ComponentMask signature);
+    void destroyEntity(Entity entity);
+    bool isAlive(Entity entity) const;
+    void clear();
+
+    // Exchanges the whole contents with another world in O(1), e.g. to swap in
+    // a scene that was built on a worker thread. Entity handles follow their data.
+    void swap(EntityWorld& other);
+
+    uint32_t getEntityCount() const { return entityCount; }
+    ComponentMask getSignature(Entity entity) const;
+
+    // Direct component access for a single entity (setup code, gameplay queries).
+    // Writable access to a transform column flags the chunk for matrix rebuild.
+    template<ComponentType C>
+    typename ComponentTraits<C>::Type& get(Entity entity)
+    {
+        const EntityRecord& record = records[entity.index];
+        ArchetypeChunk* chunk = archetypes[record.archetype]->chunks[record.chunk].get();
+        if (C <= COMPONENT_SCALE)
+            chunk->transformsDirty = true;
+        return chunk->column<C>()[record.row];
+    }
+
+    template<ComponentType C>
+    const typename ComponentTraits<C>::Type& read(Entity entity) const
+    {
+        const EntityRecord& record = records[entity.index];
+        const ArchetypeChunk* chunk = archetypes[record.archetype]->chunks[record.chunk].get();
+        return chunk->column<C>()[record.row];
+    }
+
+    // Calls fn(ArchetypeChunk&) for every non-empty chunk whose archetype has all
+    // of `required` and none of `excluded`
+    template<typename Fn>
+    void forEachChunk(ComponentMask required, ComponentMask excluded, Fn fn)
+    {
+        for (auto& archetype : archetypes)
+        {
+            if ((archetype->signature & required) != required || (archetype->signature & excluded) != 0)
+                continue;
+
+            for (auto& chunk : archetype->chunks)
+            {
+                if (chunk->count > 0)
+                    fn(*chunk);
+            }
+        }
+    }
+
+    template<typename Fn>
+    void forEachChunk(ComponentMask required, Fn fn)
+    {
+        forEachChunk(required, 0, fn);
+    }
+
+    template<typename Fn>
+    void forEachChunk(ComponentMask required, Fn fn) const
+    {
+        for (const auto& archetype : archetypes)
+        {
+            if ((archetype->signature & required) != required)
+                continue;
+
+            for (const auto& chunk : archetype->chunks)
+            {
+                if (chunk->count > 0)
+                    fn(static_cast<const ArchetypeChunk&>(*chunk));
+            }
+        }
+    }
+
+private:
+    struct EntityRecord
+    {
+        uint32_t archetype;
+        uint32_t chunk;
+        uint32_t row;
+        uint32_t generation;
+        bool alive;
+    };
+
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::vector<EntityRecord> records;
+    std::vector<uint32_t> freeIndices;
+    uint32_t entityCount;
+
+    uint32_t findOrCreateArchetype(ComponentMask signature);
+    ArchetypeChunk* allocateChunk(Archetype& archetype);
+};
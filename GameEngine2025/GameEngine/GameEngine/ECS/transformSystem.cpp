@@ -0,0 +1,92 @@
+#include "transformSystem.h"
+#include "../Math/transformKernel.h"
+#include <cstring>
+
+// Interpolated transforms are staged on the stack in batches of this size
+static const uint32_t INTERPOLATION_BATCH = 64;
+
+static const ComponentMask TRANSFORM_COMPONENTS = componentBit(COMPONENT_POSITION) | componentBit(COMPONENT_ROTATION) |
+    componentBit(COMPONENT_SCALE) | componentBit(COMPONENT_MODEL_MATRIX);
+
+unsigned int updateModelMatrices(EntityWorld& world)
+{
+    unsigned int updated = 0;
+
+    world.forEachChunk(TRANSFORM_COMPONENTS, INTERPOLATED_COMPONENTS, [&updated](ArchetypeChunk& chunk)
+    {
+        if (!chunk.transformsDirty)
+            return;
+
+        // The columns are already the packed SoA arrays the batch kernel expects
+        batchTransform(chunk.column<COMPONENT_POSITION>(), chunk.column<COMPONENT_ROTATION>(),
+            chunk.column<COMPONENT_SCALE>(), glm::mat4(1.0f), chunk.column<COMPONENT_MODEL_MATRIX>(),
+            nullptr, chunk.count);
+
+        chunk.transformsDirty = false;
+        updated += chunk.count;
+    });
+
+    return updated;
+}
+
+void storePreviousTransforms(EntityWorld& world)
+{
+    world.forEachChunk(TRANSFORM_COMPONENTS | INTERPOLATED_COMPONENTS, [](ArchetypeChunk& chunk)
+    {
+        memcpy(chunk.column<COMPONENT_PREVIOUS_POSITION>(), chunk.column<COMPONENT_POSITION>(), chunk.count * sizeof(glm::vec3));
+        memcpy(chunk.column<COMPONENT_PREVIOUS_ROTATION>(), chunk.column<COMPONENT_ROTATION>(), chunk.count * sizeof(glm::quat));
+        memcpy(chunk.column<COMPONENT_PREVIOUS_SCALE>(), chunk.column<COMPONENT_SCALE>(), chunk.count * sizeof(glm::vec3));
+    });
+}
+
+// Normalized lerp along the shorter arc; close enough to slerp for one tick of motion
+static glm::quat nlerp(const glm::quat& a, const glm::quat& b, float t)
+{
+    float sign = (a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w) < 0.0f ? -1.0f : 1.0f;
+    glm::quat q(a.w + (sign * b.w - a.w) * t,
+        a.x + (sign * b.x - a.x) * t,
+        a.y + (sign * b.y - a.y) * t,
+        a.z + (sign * b.z - a.z) * t);
+    return glm::normalize(q);
+}
+
+unsigned int interpolateModelMatrices(EntityWorld& world, float alpha)
+{
+    unsigned int updated = 0;
+
+    world.forEachChunk(TRANSFORM_COMPONENTS | INTERPOLATED_COMPONENTS, [&](ArchetypeChunk& chunk)
+    {
+        const glm::vec3* positions = chunk.column<COMPONENT_POSITION>();
+        const glm::quat* rotations = chunk.column<COMPONENT_ROTATION>();
+        const glm::vec3* scales = chunk.column<COMPONENT_SCALE>();
+        const glm::vec3* previousPositions = chunk.column<COMPONENT_PREVIOUS_POSITION>();
+        const glm::quat* previousRotations = chunk.column<COMPONENT_PREVIOUS_ROTATION>();
+        const glm::vec3* previousScales = chunk.column<COMPONENT_PREVIOUS_SCALE>();
+        glm::mat4* models = chunk.column<COMPONENT_MODEL_MATRIX>();
+
+        glm::vec3 renderPositions[INTERPOLATION_BATCH];
+        glm::quat renderRotations[INTERPOLATION_BATCH];
+        glm::vec3 renderScales[INTERPOLATION_BATCH];
+
+        for (uint32_t start = 0; start < chunk.count; start += INTERPOLATION_BATCH)
+        {
+            uint32_t count = chunk.count - start < INTERPOLATION_BATCH ? chunk.count - start : INTERPOLATION_BATCH;
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                uint32_t row = start + i;
+                renderPositions[i] = glm::mix(previousPositions[row], positions[row], alpha);
+                renderRotations[i] = nlerp(previousRotations[row], rotations[row], alpha);
+                renderScales[i] = glm::mix(previousScales[row], scales[row], alpha);
+            }
+
+            batchTransform(renderPositions, renderRotations, renderScales, glm::mat4(1.0f),
+                models + start, nullptr, count);
+        }
+
+        chunk.transformsDirty = false;
+        updated += chunk.count;
+    });
+
+    return updated;
+}
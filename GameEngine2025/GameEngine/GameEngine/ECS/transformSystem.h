@@ -0,0 +1,15 @@
+#pragma once
+#include "entityWorld.h"
+
+// Rebuilds the model matrix column of every chunk whose transforms changed.
+// Interpolated chunks are skipped; they are handled by interpolateModelMatrices.
+// Returns the number of matrices written.
+unsigned int updateModelMatrices(EntityWorld& world);
+
+// Copies the current transforms of interpolated entities into their previous-tick
+// columns. Call at the start of every simulation tick.
+void storePreviousTransforms(EntityWorld& world);
+
+// Builds the model matrices of interpolated entities from the previous and current
+// tick transforms; alpha is FixedTimestep::getAlpha(). Returns the matrices written.
+unsigned int interpolateModelMatrices(EntityWorld& world, float alpha);
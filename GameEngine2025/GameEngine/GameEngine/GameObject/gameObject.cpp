@@ -1,62 +1,182 @@
 #include "gameObject.h"
+#include "../ResourceManager/resourceManager.h"
+#include <algorithm>
 
-GameObject::GameObject(Mesh* mesh)
+unsigned int GameObject::matrixUpdateCount = 0;
+
+glm::quat eulerToQuat(const glm::vec3& degrees)
+{
+    glm::quat qy = glm::angleAxis(glm::radians(degrees.y), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::quat qx = glm::angleAxis(glm::radians(degrees.x), glm::vec3(1.0f, 0.0f, 0.0f));
+    glm::quat qz = glm::angleAxis(glm::radians(degrees.z), glm::vec3(0.0f, 0.0f, 1.0f));
+    return qy * qx * qz;
+}
+
+// Inverse of eulerToQuat, so getRotation() stays meaningful for quaternion-driven objects
+static glm::vec3 quatToEuler(const glm::quat& q)
+{
+    glm::mat3 m = glm::mat3_cast(q);
+    float sinX = -m[2][1];
+
+    if (sinX >= 0.9999f || sinX <= -0.9999f)
+    {
+        // Gimbal lock: fold the roll into the yaw
+        return glm::vec3(glm::degrees(asin(glm::clamp(sinX, -1.0f, 1.0f))),
+            glm::degrees(atan2(-m[0][2], m[0][0])),
+            0.0f);
+    }
+
+    return glm::vec3(glm::degrees(asin(sinX)),
+        glm::degrees(atan2(m[2][0], m[2][2])),
+        glm::degrees(atan2(m[0][1], m[1][1])));
+}
+
+GameObject::GameObject(MeshHandle mesh)
     : mesh(mesh),
+    parent(nullptr),
     position(0.0f, 0.0f, 0.0f),
     rotation(0.0f, 0.0f, 0.0f),
-    scale(1.0f, 1.0f, 1.0f)
+    orientation(1.0f, 0.0f, 0.0f, 0.0f),
+    scale(1.0f, 1.0f, 1.0f),
+    modelMatrix(1.0f),
+    dirty(true)
 {
+    // Keeps the mesh from being evicted while this object may draw it
+    if (mesh.isValid())
+        ResourceManager::getInstance().acquireMesh(mesh);
 }
 
-GameObject::GameObject(Mesh* mesh, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale)
+GameObject::GameObject(MeshHandle mesh, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale)
     : mesh(mesh),
+    parent(nullptr),
     position(position),
     rotation(rotation),
-    scale(scale)
+    orientation(eulerToQuat(rotation)),
+    scale(scale),
+    modelMatrix(1.0f),
+    dirty(true)
 {
+    // Keeps the mesh from being evicted while this object may draw it
+    if (mesh.isValid())
+        ResourceManager::getInstance().acquireMesh(mesh);
+}
+
+GameObject::~GameObject()
+{
+    if (mesh.isValid())
+        ResourceManager::getInstance().releaseMesh(mesh);
+
+    setParent(nullptr);
+
+    // Orphaned children become roots and keep their local transform
+    for (GameObject* child : children)
+    {
+        child->parent = nullptr;
+        child->markDirty();
+    }
 }
 
 void GameObject::setPosition(const glm::vec3& pos)
 {
     position = pos;
+    markDirty();
 }
 
 void GameObject::setRotation(const glm::vec3& rot)
 {
     rotation = rot;
+    orientation = eulerToQuat(rot);
+    markDirty();
+}
+
+void GameObject::setRotation(const glm::quat& rot)
+{
+    orientation = glm::normalize(rot);
+    rotation = quatToEuler(orientation);
+    markDirty();
 }
 
 void GameObject::setScale(const glm::vec3& scaleVec)
 {
     scale = scaleVec;
+    markDirty();
 }
 
 void GameObject::setScale(float uniformScale)
 {
-    scale = glm::vec3(uniformScale, uniformScale, uniformScale);
+    setScale(glm::vec3(uniformScale, uniformScale, uniformScale));
 }
 
-glm::mat4 GameObject::getModelMatrix() const
+void GameObject::setParent(GameObject* newParent)
 {
-    glm::mat4 model = glm::mat4(1.0f);
+    if (newParent == parent || newParent == this)
+        return;
 
+    if (parent)
+    {
+        std::vector<GameObject*>& siblings = parent->children;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+    }
+
+    parent = newParent;
+
+    if (parent)
+    {
+        parent->children.push_back(this);
+    }
+
+    markDirty();
+}
+
+// Flags this subtree for recomputation. A dirty object always has dirty descendants,
+// so the walk can stop at the first child that is already flagged.
+void GameObject::markDirty()
+{
+    if (dirty)
+        return;
+
+    dirty = true;
+    for (GameObject* child : children)
+    {
+        child->markDirty();
+    }
+}
+
+void GameObject::updateModelMatrix() const
+{
     // Apply transformations: Translate -> Rotate -> Scale
-    model = glm::translate(model, position);
+    glm::mat4 local = glm::translate(glm::mat4(1.0f), position);
+    local = local * glm::mat4_cast(orientation);
+    local = glm::scale(local, scale);
 
-    // Apply rotations in Y-X-Z order (common for game objects)
-    model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-    model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+    if (parent)
+        modelMatrix = parent->getModelMatrix() * local;
+    else
+        modelMatrix = local;
 
-    model = glm::scale(model, scale);
+    dirty = false;
+    matrixUpdateCount++;
+}
 
-    return model;
+const glm::mat4& GameObject::getModelMatrix() const
+{
+    if (dirty)
+    {
+        updateModelMatrix();
+    }
+    return modelMatrix;
+}
+
+glm::vec3 GameObject::getWorldPosition() const
+{
+    return glm::vec3(getModelMatrix()[3]);
 }
 
 void GameObject::draw(Shader& shader)
 {
-    if (mesh)
+    Mesh* resolved = ResourceManager::getInstance().getMesh(mesh);
+    if (resolved)
     {
-        mesh->draw(shader);
+        resolved->draw(shader);
     }
-}
\ No newline at end of file
+}
@@ -1,33 +1,67 @@
 #pragma once
+#include <vector>
 #include <glm.hpp>
 #include <gtc/matrix_transform.hpp>
+#include <gtc/quaternion.hpp>
 #include "../Model Loading/mesh.h"
+#include "../ResourceManager/assetHandle.h"
+
+// Builds an orientation from Euler angles in degrees, applied in Y-X-Z order
+glm::quat eulerToQuat(const glm::vec3& degrees);
 
 class GameObject
 {
 public:
-    GameObject(Mesh* mesh);
-    GameObject(Mesh* mesh, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale);
+    GameObject(MeshHandle mesh);
+    GameObject(MeshHandle mesh, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale);
+    ~GameObject();
+
+    GameObject(const GameObject&) = delete;
+    GameObject& operator=(const GameObject&) = delete;
 
+    // Local transform (relative to the parent, or to the world for root objects)
     void setPosition(const glm::vec3& pos);
     void setRotation(const glm::vec3& rot); // Euler angles in degrees
+    void setRotation(const glm::quat& orientation);
     void setScale(const glm::vec3& scale);
     void setScale(float uniformScale);
 
     glm::vec3 getPosition() const { return position; }
     glm::vec3 getRotation() const { return rotation; }
+    glm::quat getOrientation() const { return orientation; }
     glm::vec3 getScale() const { return scale; }
 
-    glm::mat4 getModelMatrix() const;
+    // Hierarchy - the local transform is kept when re-parenting
+    void setParent(GameObject* newParent);
+    GameObject* getParent() const { return parent; }
+    const std::vector<GameObject*>& getChildren() const { return children; }
+
+    // World matrix, cached and only rebuilt when this object or an ancestor moved
+    const glm::mat4& getModelMatrix() const;
+    glm::vec3 getWorldPosition() const;
 
     void draw(Shader& shader);
-    Mesh* getMesh() { return mesh; }
+    MeshHandle getMesh() const { return mesh; }
+
+    // Number of world matrices rebuilt since the last reset (used for per-frame stats)
+    static unsigned int getMatrixUpdateCount() { return matrixUpdateCount; }
+    static void resetMatrixUpdateCount() { matrixUpdateCount = 0; }
 
 private:
-    Mesh* mesh;
+    MeshHandle mesh;
+    GameObject* parent;
+    std::vector<GameObject*> children;
+
     glm::vec3 position;
     glm::vec3 rotation; // Euler angles (x, y, z) in degrees
+    glm::quat orientation;
     glm::vec3 scale;
 
+    mutable glm::mat4 modelMatrix;
+    mutable bool dirty;
+
+    static unsigned int matrixUpdateCount;
+
+    void markDirty();
     void updateModelMatrix() const;
-};
\ No newline at end of file
+};
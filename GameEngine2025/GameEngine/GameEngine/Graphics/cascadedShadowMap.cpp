@@ -0,0 +1,424 @@
+#include "cascadedShadowMap.h"
+#include "gpuUpload.h"
+#include "glStateCache.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <gtc/matrix_transform.hpp>
+
+// Casters this far towards the light from a cascade still shade it
+static const float CASTER_REACH = 300.0f;
+
+// Cached cascades cover this multiple of their reach around the camera, so
+// the camera can move a quarter of it before they are drawn again
+static const float CACHE_MARGIN = 1.25f;
+
+// Split placement: 0 spaces the cascades evenly, 1 logarithmically
+static const float SPLIT_BLEND = 0.8f;
+
+// Depth bias of the caster pass, scaled by slope and in depth buffer units
+static const float SLOPE_BIAS = 2.0f;
+static const float CONSTANT_BIAS = 4.0f;
+
+CascadedShadowMap::CascadedShadowMap()
+    : cascadeCount(3),
+    resolution(2048),
+    maxDistance(500.0f),
+    lightDirection(0.0f, -1.0f, 0.0f),
+    liveTexture(0),
+    cacheTexture(0),
+    drawFramebuffer(0),
+    readFramebuffer(0),
+    allocatedCascades(0),
+    allocatedResolution(0),
+    ready(false),
+    rendered(false),
+    staticRedrawsLastFrame(0),
+    staticRedrawsTotal(0)
+{
+    for (int i = 0; i < MAX_CASCADES; i++)
+    {
+        cascades[i] = ShadowCascade();
+        cascades[i].radius = 0.0f;
+        cascades[i].cached = false;
+        cascades[i].staticDirty = true;
+        sliceRadius[i] = 0.0f;
+        liveHasMoving[i] = false;
+        liveStale[i] = true;
+    }
+}
+
+CascadedShadowMap::~CascadedShadowMap()
+{
+    release();
+}
+
+void CascadedShadowMap::setCascadeCount(int count)
+{
+    cascadeCount = std::max(0, std::min(count, (int)MAX_CASCADES));
+}
+
+void CascadedShadowMap::setResolution(int size)
+{
+    if (size < 64)
+    {
+        std::cout << "Warning: shadow map resolution " << size << " is too small, using 64" << std::endl;
+        size = 64;
+    }
+    resolution = size;
+}
+
+void CascadedShadowMap::setMaxDistance(float distance)
+{
+    maxDistance = std::max(distance, 1.0f);
+}
+
+void CascadedShadowMap::setLightDirection(const glm::vec3& direction)
+{
+    if (glm::dot(direction, direction) <= 0.0f)
+        return;
+
+    glm::vec3 normalized = glm::normalize(direction);
+    if (glm::dot(normalized, lightDirection) < 0.99999f)
+    {
+        lightDirection = normalized;
+        invalidateStatic();
+    }
+}
+
+void CascadedShadowMap::invalidateStatic()
+{
+    for (int i = 0; i < MAX_CASCADES; i++)
+        cascades[i].staticDirty = true;
+}
+
+void CascadedShadowMap::invalidateStatic(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    if (boundsMin.x > boundsMax.x)
+        return;
+
+    // Light-space box around the world box
+    glm::vec3 localMin(FLT_MAX), localMax(-FLT_MAX);
+    for (int corner = 0; corner < 8; corner++)
+    {
+        glm::vec3 point((corner & 1) ? boundsMax.x : boundsMin.x, (corner & 2) ? boundsMax.y : boundsMin.y,
+            (corner & 4) ? boundsMax.z : boundsMin.z);
+        point = glm::vec3(lightView * glm::vec4(point, 1.0f));
+        localMin = glm::min(localMin, point);
+        localMax = glm::max(localMax, point);
+    }
+
+    // Cascades that are not cached refit, and redraw, on the next update anyway
+    for (int i = 0; i < MAX_CASCADES; i++)
+    {
+        ShadowCascade& cascade = cascades[i];
+        if (!cascade.cached ||
+            (localMax.x >= cascade.center.x - cascade.radius && localMin.x <= cascade.center.x + cascade.radius &&
+            localMax.y >= cascade.center.y - cascade.radius && localMin.y <= cascade.center.y + cascade.radius &&
+            -localMin.z >= cascade.nearDistance && -localMax.z <= cascade.farDistance))
+            cascade.staticDirty = true;
+    }
+}
+
+void CascadedShadowMap::release()
+{
+    GlStateCache& state = GlStateCache::getInstance();
+    if (liveTexture)
+    {
+        glDeleteTextures(1, &liveTexture);
+        state.forgetTexture(liveTexture);
+    }
+    if (cacheTexture)
+    {
+        glDeleteTextures(1, &cacheTexture);
+        state.forgetTexture(cacheTexture);
+    }
+    if (drawFramebuffer)
+        glDeleteFramebuffers(1, &drawFramebuffer);
+    if (readFramebuffer)
+        glDeleteFramebuffers(1, &readFramebuffer);
+    liveTexture = cacheTexture = drawFramebuffer = readFramebuffer = 0;
+    allocatedCascades = allocatedResolution = 0;
+    ready = rendered = false;
+}
+
+static GLuint createDepthArray(int resolution, int layers, bool comparison)
+{
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    GlStateCache::getInstance().bindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, resolution, resolution, layers, 0,
+        GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+
+    // Linear filtering of a comparison gives 2x2 PCF per tap for free
+    GLint filter = comparison ? GL_LINEAR : GL_NEAREST;
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (comparison)
+    {
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    }
+    return texture;
+}
+
+void CascadedShadowMap::allocate()
+{
+    release();
+
+    GLint previousDraw = 0, previousRead = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDraw);
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+
+    liveTexture = createDepthArray(resolution, cascadeCount, true);
+    if (cascadeCount > 1)
+        cacheTexture = createDepthArray(resolution, cascadeCount - 1, false);
+
+    // Depth only: no colour buffer to draw to or read from. Bound to both
+    // targets while set up, since glDrawBuffer and glReadBuffer each apply
+    // to their own binding.
+    glGenFramebuffers(1, &drawFramebuffer);
+    glGenFramebuffers(1, &readFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, drawFramebuffer);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, liveTexture, 0, 0);
+    ready = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, readFramebuffer);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDraw);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+
+    if (!ready)
+    {
+        std::cout << "Warning: shadow map framebuffer is incomplete, shadows disabled" << std::endl;
+        release();
+        // Not retried until the settings change
+        allocatedCascades = cascadeCount;
+        allocatedResolution = resolution;
+        return;
+    }
+
+    allocatedCascades = cascadeCount;
+    allocatedResolution = resolution;
+    for (int i = 0; i < MAX_CASCADES; i++)
+    {
+        cascades[i].staticDirty = true;
+        sliceRadius[i] = 0.0f;
+        liveHasMoving[i] = false;
+        liveStale[i] = true;
+    }
+}
+
+void CascadedShadowMap::fitCascade(int cascade, const glm::vec3& lightSpaceCenter, float radius)
+{
+    ShadowCascade& fitted = cascades[cascade];
+
+    // Whole texel steps, so a cascade that follows the camera does not shimmer
+    float texel = 2.0f * radius / resolution;
+    fitted.center = glm::vec3(std::floor(lightSpaceCenter.x / texel) * texel,
+        std::floor(lightSpaceCenter.y / texel) * texel, lightSpaceCenter.z);
+    fitted.radius = radius;
+    fitted.texelSize = texel;
+
+    // The light looks down -z; casters up to CASTER_REACH before the slice count
+    fitted.nearDistance = -fitted.center.z - radius - CASTER_REACH;
+    fitted.farDistance = -fitted.center.z + radius;
+    fitted.viewProjection = glm::ortho(fitted.center.x - radius, fitted.center.x + radius,
+        fitted.center.y - radius, fitted.center.y + radius, fitted.nearDistance, fitted.farDistance) * lightView;
+}
+
+bool CascadedShadowMap::update(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix)
+{
+    rendered = false;
+    if (cascadeCount == 0 || !isGpuUploadEnabled())
+    {
+        if (allocatedCascades)
+            release();
+        return false;
+    }
+
+    if (allocatedCascades != cascadeCount || allocatedResolution != resolution)
+        allocate();
+    if (!ready)
+        return false;
+
+    glm::vec3 up = std::fabs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    lightView = glm::lookAt(glm::vec3(0.0f), lightDirection, up);
+
+    // Clip planes of the perspective projection
+    float nearPlane = projectionMatrix[3][2] / (projectionMatrix[2][2] - 1.0f);
+    float farPlane = projectionMatrix[3][2] / (projectionMatrix[2][2] + 1.0f);
+    float shadowFar = std::min(maxDistance, farPlane);
+    float logNear = std::max(nearPlane, 1.0f);
+
+    // Frustum corner rays, near plane to far plane
+    glm::mat4 inverseViewProjection = glm::inverse(projectionMatrix * viewMatrix);
+    glm::vec3 nearCorners[4], farCorners[4];
+    for (int i = 0; i < 4; i++)
+    {
+        glm::vec4 nearCorner = inverseViewProjection * glm::vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, -1.0f, 1.0f);
+        glm::vec4 farCorner = inverseViewProjection * glm::vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, 1.0f, 1.0f);
+        nearCorners[i] = glm::vec3(nearCorner) / nearCorner.w;
+        farCorners[i] = glm::vec3(farCorner) / farCorner.w;
+    }
+    glm::vec3 cameraPos = glm::vec3(glm::inverse(viewMatrix)[3]);
+    glm::vec3 cameraLightSpace = glm::vec3(lightView * glm::vec4(cameraPos, 1.0f));
+
+    float splitNear = nearPlane;
+    for (int i = 0; i < cascadeCount; i++)
+    {
+        float ratio = (i + 1) / (float)cascadeCount;
+        float splitFar = i + 1 == cascadeCount ? shadowFar :
+            SPLIT_BLEND * logNear * std::pow(shadowFar / logNear, ratio) +
+            (1.0f - SPLIT_BLEND) * (nearPlane + (shadowFar - nearPlane) * ratio);
+        ShadowCascade& cascade = cascades[i];
+
+        if (i == 0)
+        {
+            // Bounding sphere of the slice; its size does not change as the
+            // camera turns, so neither does the texel size
+            glm::vec3 corners[8];
+            glm::vec3 center(0.0f);
+            for (int c = 0; c < 4; c++)
+            {
+                glm::vec3 ray = farCorners[c] - nearCorners[c];
+                corners[c] = nearCorners[c] + ray * ((splitNear - nearPlane) / (farPlane - nearPlane));
+                corners[c + 4] = nearCorners[c] + ray * ((splitFar - nearPlane) / (farPlane - nearPlane));
+                center += corners[c] + corners[c + 4];
+            }
+            center /= 8.0f;
+
+            float radius = 0.0f;
+            for (const glm::vec3& corner : corners)
+                radius = std::max(radius, glm::length(corner - center));
+            radius = std::ceil(radius * 16.0f) / 16.0f;
+
+            cascade.cached = false;
+            sliceRadius[i] = radius;
+            fitCascade(i, glm::vec3(lightView * glm::vec4(center, 1.0f)), radius);
+        }
+        else
+        {
+            // Everything within splitFar of the camera, whichever way it looks
+            glm::vec3 offset = glm::abs(cameraLightSpace - cascade.center);
+            float slack = cascade.radius - splitFar;
+            if (!cascade.cached || sliceRadius[i] != splitFar ||
+                offset.x > slack || offset.y > slack || offset.z > slack)
+            {
+                cascade.cached = true;
+                sliceRadius[i] = splitFar;
+                fitCascade(i, cameraLightSpace, splitFar * CACHE_MARGIN);
+                cascade.staticDirty = true;
+            }
+        }
+        splitNear = splitFar;
+    }
+    return true;
+}
+
+bool CascadedShadowMap::overlaps(int cascade, const glm::vec3& position, float radius) const
+{
+    const ShadowCascade& bounds = cascades[cascade];
+    glm::vec3 local = glm::vec3(lightView * glm::vec4(position, 1.0f));
+    float distance = -local.z;
+    return std::fabs(local.x - bounds.center.x) <= bounds.radius + radius &&
+        std::fabs(local.y - bounds.center.y) <= bounds.radius + radius &&
+        distance + radius >= bounds.nearDistance && distance - radius <= bounds.farDistance;
+}
+
+void CascadedShadowMap::bindLayer(GLuint texture, int layer)
+{
+    glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, layer);
+}
+
+void CascadedShadowMap::render(const ShadowCasterDrawer& drawCasters)
+{
+    staticRedrawsLastFrame = 0;
+    if (!ready)
+        return;
+
+    GLint previousDraw = 0, previousRead = 0, viewport[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDraw);
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+    glViewport(0, 0, resolution, resolution);
+    GlStateCache& state = GlStateCache::getInstance();
+    state.setDepthMask(true);
+    state.setEnabled(GL_POLYGON_OFFSET_FILL, true);
+    glPolygonOffset(SLOPE_BIAS, CONSTANT_BIAS);
+
+    for (int i = 0; i < cascadeCount; i++)
+    {
+        ShadowCascade& cascade = cascades[i];
+        if (!cascade.cached)
+        {
+            bindLayer(liveTexture, i);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            drawCasters(i, cascade, true);
+            drawCasters(i, cascade, false);
+            continue;
+        }
+
+        if (cascade.staticDirty)
+        {
+            bindLayer(cacheTexture, i - 1);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            drawCasters(i, cascade, true);
+            cascade.staticDirty = false;
+            liveStale[i] = true;
+            staticRedrawsLastFrame++;
+        }
+
+        // Start from the static depth again when the live layer has moved on from it
+        bindLayer(liveTexture, i);
+        if (liveStale[i] || liveHasMoving[i])
+        {
+            glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, cacheTexture, 0, i - 1);
+            glBlitFramebuffer(0, 0, resolution, resolution, 0, 0, resolution, resolution,
+                GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            liveStale[i] = false;
+        }
+        liveHasMoving[i] = drawCasters(i, cascade, false) > 0;
+    }
+
+    state.setEnabled(GL_POLYGON_OFFSET_FILL, false);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDraw);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    staticRedrawsTotal += staticRedrawsLastFrame;
+    rendered = true;
+}
+
+void CascadedShadowMap::applyUniforms(GLuint program) const
+{
+    // Always on its own unit: a shadow sampler sharing a unit with a 2D
+    // texture makes draws fail even when the shader never samples it
+    glUniform1i(glGetUniformLocation(program, "shadowMap"), TEXTURE_UNIT);
+
+    int active = ready && rendered ? cascadeCount : 0;
+    glUniform1i(glGetUniformLocation(program, "shadowCascadeCount"), active);
+    if (active == 0)
+        return;
+
+    glm::mat4 matrices[MAX_CASCADES];
+    float texelSizes[MAX_CASCADES];
+    for (int i = 0; i < active; i++)
+    {
+        matrices[i] = cascades[i].viewProjection;
+        texelSizes[i] = cascades[i].texelSize;
+    }
+    glUniformMatrix4fv(glGetUniformLocation(program, "shadowMatrices"), active, GL_FALSE, &matrices[0][0][0]);
+    glUniform1fv(glGetUniformLocation(program, "shadowTexelSizes"), active, texelSizes);
+
+    GlStateCache::getInstance().bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, liveTexture);
+}
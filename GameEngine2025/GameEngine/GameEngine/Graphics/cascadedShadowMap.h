@@ -0,0 +1,113 @@
+#pragma once
+#include <functional>
+#include <glew.h>
+#include <glm.hpp>
+
+// One slice of the view frustum as seen from the light
+struct ShadowCascade
+{
+    glm::mat4 viewProjection;   // world to the cascade's clip space
+    glm::vec3 center;           // light space, snapped to whole texels
+    float radius;               // half width of the covered square
+    float nearDistance;         // depth range along the light
+    float farDistance;
+    float texelSize;            // world units per shadow texel
+    bool cached;                // keeps its static casters between frames
+    bool staticDirty;           // static casters must be drawn again
+};
+
+// Draws the casters of one kind into the bound cascade and returns how many
+// it drew; `staticCasters` picks static geometry or moving objects
+typedef std::function<unsigned int(int cascade, const ShadowCascade& bounds, bool staticCasters)> ShadowCasterDrawer;
+
+// Cascaded shadow maps for a directional light. Cascade 0, nearest to the
+// camera, is drawn from scratch every frame. The farther cascades cover a
+// wider area than their slice needs and keep their static casters in a
+// cache layer: that is drawn again only when the light, the static geometry
+// or the cascade size changes, or when the camera has moved far enough for
+// its slice to leave the cached area. Each frame the cached depth is copied
+// back only if moving casters touched the cascade, and the moving casters
+// are drawn on top. Main thread only.
+class CascadedShadowMap
+{
+public:
+    static const int MAX_CASCADES = 4;
+
+    // Above the units meshes bind their textures to
+    static const int TEXTURE_UNIT = 8;
+
+    CascadedShadowMap();
+    ~CascadedShadowMap();
+
+    // 0 cascades turns shadows off. Both take effect on the next update.
+    void setCascadeCount(int count);
+    void setResolution(int size);
+    int getCascadeCount() const { return cascadeCount; }
+    int getResolution() const { return resolution; }
+
+    // Distance from the camera the last cascade reaches
+    void setMaxDistance(float distance);
+    float getMaxDistance() const { return maxDistance; }
+
+    // Direction the light travels in
+    void setLightDirection(const glm::vec3& direction);
+
+    // Static casters were added, moved, removed or finished loading
+    void invalidateStatic();
+
+    // Only the cached cascades the world box can cast into
+    void invalidateStatic(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    // Fits the cascades to the camera; false when shadows are off or there is
+    // no GL context, in which case render draws nothing
+    bool update(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix);
+
+    // Draws whatever the cascades need this frame through `drawCasters`,
+    // with the caster shader already in use. Restores the framebuffer and
+    // viewport it found.
+    void render(const ShadowCasterDrawer& drawCasters);
+
+    // Whether a bounding sphere can cast a shadow into a cascade
+    bool overlaps(int cascade, const glm::vec3& position, float radius) const;
+
+    // Binds the maps and sets the lookup uniforms of a lit shader
+    void applyUniforms(GLuint program) const;
+
+    // Cached cascades whose static casters were drawn again last frame
+    unsigned int getStaticRedrawsLastFrame() const { return staticRedrawsLastFrame; }
+    unsigned int getStaticRedrawsTotal() const { return staticRedrawsTotal; }
+
+private:
+    CascadedShadowMap(const CascadedShadowMap&) = delete;
+    CascadedShadowMap& operator=(const CascadedShadowMap&) = delete;
+
+    int cascadeCount;
+    int resolution;
+    float maxDistance;
+    glm::vec3 lightDirection;
+    glm::mat4 lightView;
+
+    ShadowCascade cascades[MAX_CASCADES];
+    float sliceRadius[MAX_CASCADES];    // what the cascade size was fitted to
+    bool liveHasMoving[MAX_CASCADES];   // live layer holds moving casters on top of the cache
+    bool liveStale[MAX_CASCADES];       // live layer lacks the latest static depth
+
+    // Live maps sampled by the lit shader, and the static depth of the cached
+    // cascades (cascade i in layer i - 1)
+    GLuint liveTexture;
+    GLuint cacheTexture;
+    GLuint drawFramebuffer;
+    GLuint readFramebuffer;
+    int allocatedCascades;
+    int allocatedResolution;
+    bool ready;         // maps allocated and complete
+    bool rendered;      // render ran since the last update
+
+    unsigned int staticRedrawsLastFrame;
+    unsigned int staticRedrawsTotal;
+
+    void allocate();
+    void release();
+    void fitCascade(int cascade, const glm::vec3& lightSpaceCenter, float radius);
+    void bindLayer(GLuint texture, int layer);
+};
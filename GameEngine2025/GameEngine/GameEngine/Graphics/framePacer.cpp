@@ -0,0 +1,198 @@
+#include "framePacer.h"
+#include <glfw3.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+// Capped mode sleeps until this long before the deadline and spins the rest
+static const int SPIN_MICROSECONDS = 2000;
+// glClientWaitSync slice; the wait repeats until the fence signals
+static const GLuint64 FENCE_WAIT_NANOSECONDS = 100000000;
+
+FramePacer::FramePacer()
+    : mode(PACING_VSYNC), targetFps(60.0f), maxFramesInFlight(2),
+    fencesSupported(false), fenceHead(0), fenceCount(0), timing(false),
+    frameTimes(HISTORY_FRAMES, 0.0f), frameTimeNext(0), fenceWaitSumMs(0.0), fenceWaitFrames(0)
+{
+    fencesSupported = glfwGetCurrentContext() != nullptr && (GLEW_VERSION_3_2 || GLEW_ARB_sync);
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        fences[i] = 0;
+
+#ifdef _WIN32
+    // The default 15.6 ms scheduler tick would make every capped frame oversleep
+    timeBeginPeriod(1);
+#endif
+
+    setMode(mode);
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+    timeEndPeriod(1);
+#endif
+    releaseFences();
+}
+
+void FramePacer::releaseFences()
+{
+    for (int i = 0; i < fenceCount; i++)
+        glDeleteSync(fences[(fenceHead + i) % MAX_FRAMES_IN_FLIGHT]);
+    fenceHead = fenceCount = 0;
+}
+
+void FramePacer::setMode(FramePacingMode newMode)
+{
+    mode = newMode;
+    if (glfwGetCurrentContext())
+        glfwSwapInterval(mode == PACING_VSYNC ? 1 : 0);
+    timing = false;
+}
+
+void FramePacer::setTargetFps(float fps)
+{
+    targetFps = std::max(fps, 1.0f);
+    timing = false;
+}
+
+void FramePacer::setMaxFramesInFlight(int frames)
+{
+    maxFramesInFlight = std::min(std::max(frames, 1), (int)MAX_FRAMES_IN_FLIGHT);
+}
+
+void FramePacer::beginFrame()
+{
+    // This frame will be in flight too, so at most max - 1 may be ahead of it
+    Clock::time_point start = Clock::now();
+    waitForFrames(maxFramesInFlight - 1);
+    fenceWaitSumMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    fenceWaitFrames++;
+}
+
+void FramePacer::waitForFrames(int allowedInFlight)
+{
+    while (fenceCount > allowedInFlight)
+    {
+        GLsync& fence = fences[fenceHead];
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_NANOSECONDS);
+        while (result == GL_TIMEOUT_EXPIRED)
+            result = glClientWaitSync(fence, 0, FENCE_WAIT_NANOSECONDS);
+
+        // GL_WAIT_FAILED (lost context) drops the fence as well
+        glDeleteSync(fence);
+        fence = 0;
+        fenceHead = (fenceHead + 1) % MAX_FRAMES_IN_FLIGHT;
+        fenceCount--;
+    }
+}
+
+void FramePacer::endFrame()
+{
+    if (fencesSupported)
+    {
+        // beginFrame left room for this one
+        waitForFrames(MAX_FRAMES_IN_FLIGHT - 1);
+        fences[(fenceHead + fenceCount) % MAX_FRAMES_IN_FLIGHT] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        fenceCount++;
+    }
+
+    if (mode == PACING_CAPPED)
+        waitUntilDeadline();
+
+    Clock::time_point now = Clock::now();
+    if (timing)
+    {
+        frameTimes[frameTimeNext % HISTORY_FRAMES] =
+            (float)std::chrono::duration<double, std::milli>(now - lastFrameEnd).count();
+        frameTimeNext++;
+    }
+    lastFrameEnd = now;
+    timing = true;
+}
+
+void FramePacer::waitUntilDeadline()
+{
+    Clock::duration period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / targetFps));
+    Clock::time_point now = Clock::now();
+
+    // A frame that ran over, by however little, starts the schedule again
+    // rather than being followed by a burst of short ones catching up
+    if (!timing || now > deadline)
+        deadline = now;
+
+    const Clock::duration spin = std::chrono::microseconds(SPIN_MICROSECONDS);
+    while (now < deadline)
+    {
+        if (deadline - now > spin)
+            std::this_thread::sleep_for(deadline - now - spin);
+        else
+            std::this_thread::yield();
+        now = Clock::now();
+    }
+    deadline += period;
+}
+
+FramePacingStats FramePacer::getStats() const
+{
+    FramePacingStats stats;
+    stats.frames = std::min(frameTimeNext, (int)HISTORY_FRAMES);
+    if (fenceWaitFrames > 0)
+        stats.fenceWaitMs = fenceWaitSumMs / fenceWaitFrames;
+    if (stats.frames == 0)
+        return stats;
+
+    double sum = 0.0;
+    stats.minMs = stats.maxMs = frameTimes[0];
+    for (int i = 0; i < stats.frames; i++)
+    {
+        sum += frameTimes[i];
+        stats.minMs = std::min(stats.minMs, (double)frameTimes[i]);
+        stats.maxMs = std::max(stats.maxMs, (double)frameTimes[i]);
+    }
+    stats.meanMs = sum / stats.frames;
+
+    double variance = 0.0;
+    for (int i = 0; i < stats.frames; i++)
+        variance += (frameTimes[i] - stats.meanMs) * (frameTimes[i] - stats.meanMs);
+    stats.stdDevMs = std::sqrt(variance / stats.frames);
+    return stats;
+}
+
+void FramePacer::resetStats()
+{
+    frameTimeNext = 0;
+    fenceWaitSumMs = 0.0;
+    fenceWaitFrames = 0;
+    timing = false;
+}
+
+const char* FramePacer::getModeName(FramePacingMode mode)
+{
+    switch (mode)
+    {
+    case PACING_VSYNC: return "vsync";
+    case PACING_CAPPED: return "capped";
+    default: return "uncapped";
+    }
+}
+
+bool FramePacer::parseModeName(const char* name, FramePacingMode& mode)
+{
+    for (int i = PACING_VSYNC; i <= PACING_UNCAPPED; i++)
+    {
+        if (strcmp(name, getModeName((FramePacingMode)i)) == 0)
+        {
+            mode = (FramePacingMode)i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <glew.h>
+#include <chrono>
+#include <vector>
+
+enum FramePacingMode
+{
+    PACING_VSYNC,       // swap interval 1, the display sets the rate
+    PACING_CAPPED,      // no vsync, frames held to the target rate by the CPU
+    PACING_UNCAPPED     // no vsync, as fast as possible
+};
+
+// Spread of the frame-to-frame times over the last FramePacer::HISTORY_FRAMES frames
+struct FramePacingStats
+{
+    int frames = 0;
+    double meanMs = 0.0;
+    double stdDevMs = 0.0;
+    double minMs = 0.0;
+    double maxMs = 0.0;
+    double fenceWaitMs = 0.0;   // average time the CPU was held back by the frames-in-flight limit
+};
+
+// Decides when the main loop may start its next frame. The swap interval
+// follows the mode; in capped mode the pacer sleeps to the next frame
+// deadline and spins the last stretch, because sleeps wake up to a
+// scheduler tick late. Independently, a fence after every swap keeps the
+// CPU at most maxFramesInFlight frames ahead of the GPU, so the driver
+// cannot queue frames behind the one being built, adding latency and
+// uneven frame times. Needs the window's context current.
+//
+//   pacer.beginFrame();     // before the frame's first GL command
+//   ...build and draw...
+//   window->update();       // swap
+//   pacer.endFrame();
+class FramePacer
+{
+public:
+    static const int MAX_FRAMES_IN_FLIGHT = 4;
+    static const int HISTORY_FRAMES = 240;
+
+    FramePacer();
+    ~FramePacer();
+
+    void setMode(FramePacingMode mode);
+    FramePacingMode getMode() const { return mode; }
+
+    // Capped mode rate
+    void setTargetFps(float fps);
+    float getTargetFps() const { return targetFps; }
+
+    // 1 waits for the previous frame to finish before starting the next one
+    void setMaxFramesInFlight(int frames);
+    int getMaxFramesInFlight() const { return maxFramesInFlight; }
+
+    void beginFrame();
+    void endFrame();
+
+    FramePacingStats getStats() const;
+    void resetStats();
+
+    static const char* getModeName(FramePacingMode mode);
+    static bool parseModeName(const char* name, FramePacingMode& mode);
+
+private:
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    typedef std::chrono::steady_clock Clock;
+
+    FramePacingMode mode;
+    float targetFps;
+    int maxFramesInFlight;
+    bool fencesSupported;
+
+    GLsync fences[MAX_FRAMES_IN_FLIGHT];    // ring, oldest at fenceHead
+    int fenceHead;
+    int fenceCount;
+
+    Clock::time_point deadline;     // capped mode: when the next frame may start
+    Clock::time_point lastFrameEnd;
+    bool timing;
+
+    std::vector<float> frameTimes;  // ring of HISTORY_FRAMES, in milliseconds
+    int frameTimeNext;
+    double fenceWaitSumMs;
+    int fenceWaitFrames;
+
+    void waitForFrames(int allowedInFlight);
+    void waitUntilDeadline();
+    void releaseFences();
+};
@@ -0,0 +1,304 @@
+#include "glStateCache.h"
+#include <iostream>
+
+// Cached value that matches no real one, so the next call always goes through
+static const GLuint UNKNOWN = 0xFFFFFFFF;
+
+static const GLenum TEXTURE_TARGETS[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY };
+static const GLenum TEXTURE_BINDINGS[] = { GL_TEXTURE_BINDING_2D, GL_TEXTURE_BINDING_2D_ARRAY };
+static const GLenum BUFFER_TARGETS[] = { GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_PIXEL_UNPACK_BUFFER };
+static const GLenum BUFFER_BINDINGS[] = { GL_ARRAY_BUFFER_BINDING, GL_ELEMENT_ARRAY_BUFFER_BINDING, GL_PIXEL_UNPACK_BUFFER_BINDING };
+static const GLenum CAPABILITIES[] = { GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_POLYGON_OFFSET_FILL };
+
+// Slot of a tracked enum, -1 for ones passed straight through
+template<size_t N>
+static int findSlot(const GLenum (&values)[N], GLenum value)
+{
+    for (size_t i = 0; i < N; i++)
+    {
+        if (values[i] == value)
+            return (int)i;
+    }
+    return -1;
+}
+
+unsigned int GlStateStats::getTotalIssued() const
+{
+    unsigned int total = 0;
+    for (int i = 0; i < STATE_CATEGORY_COUNT; i++)
+        total += issued[i];
+    return total;
+}
+
+unsigned int GlStateStats::getTotalSkipped() const
+{
+    unsigned int total = 0;
+    for (int i = 0; i < STATE_CATEGORY_COUNT; i++)
+        total += skipped[i];
+    return total;
+}
+
+void GlStateStats::add(const GlStateStats& other)
+{
+    for (int i = 0; i < STATE_CATEGORY_COUNT; i++)
+    {
+        issued[i] += other.issued[i];
+        skipped[i] += other.skipped[i];
+    }
+}
+
+GlStateCache& GlStateCache::getInstance()
+{
+    static GlStateCache instance;
+    return instance;
+}
+
+GlStateCache::GlStateCache()
+{
+    for (int i = 0; i < STATE_CATEGORY_COUNT; i++)
+        mismatchReported[i] = false;
+    invalidate();
+}
+
+void GlStateCache::invalidate()
+{
+    program = UNKNOWN;
+    vertexArray = UNKNOWN;
+    for (int i = 0; i < BUFFER_TARGET_COUNT; i++)
+        buffers[i] = UNKNOWN;
+    activeUnit = -1;
+    for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+    {
+        for (int i = 0; i < TEXTURE_TARGET_COUNT; i++)
+            textures[unit][i] = UNKNOWN;
+        samplers[unit] = UNKNOWN;
+    }
+    for (int i = 0; i < CAPABILITY_COUNT; i++)
+        capabilities[i] = -1;
+    depthMask = -1;
+    depthFunc = UNKNOWN;
+    blendSource = blendDestination = UNKNOWN;
+}
+
+bool GlStateCache::skip(GlStateCategory category, bool redundant)
+{
+    if (redundant)
+        current.skipped[category]++;
+    else
+        current.issued[category]++;
+    return redundant;
+}
+
+#if GL_STATE_VALIDATION
+bool GlStateCache::matchesDriver(GlStateCategory category, GLenum query, GLint expected, const char* what)
+{
+    GLint actual = 0;
+    glGetIntegerv(query, &actual);
+    if (actual == expected)
+        return true;
+
+    // Something changed the state behind the cache's back; the call goes
+    // through and the cache follows the driver from here on
+    if (!mismatchReported[category])
+    {
+        std::cout << "Warning: GL state cache out of sync: " << what << " is " << actual
+            << ", cached " << expected << std::endl;
+        mismatchReported[category] = true;
+    }
+    return false;
+}
+#define CONFIRM(redundant, category, query, expected, what) \
+    ((redundant) && matchesDriver(category, query, (GLint)(expected), what))
+#else
+#define CONFIRM(redundant, category, query, expected, what) (redundant)
+#endif
+
+void GlStateCache::useProgram(GLuint id)
+{
+    if (skip(STATE_PROGRAM, CONFIRM(id == program, STATE_PROGRAM, GL_CURRENT_PROGRAM, id, "program")))
+        return;
+    glUseProgram(id);
+    program = id;
+}
+
+void GlStateCache::bindVertexArray(GLuint id)
+{
+    if (skip(STATE_VERTEX_ARRAY,
+        CONFIRM(id == vertexArray, STATE_VERTEX_ARRAY, GL_VERTEX_ARRAY_BINDING, id, "vertex array")))
+        return;
+    glBindVertexArray(id);
+    vertexArray = id;
+
+    // The element buffer binding belongs to the vertex array
+    buffers[findSlot(BUFFER_TARGETS, GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+}
+
+void GlStateCache::bindBuffer(GLenum target, GLuint id)
+{
+    int slot = findSlot(BUFFER_TARGETS, target);
+    if (skip(STATE_BUFFER, slot >= 0 &&
+        CONFIRM(buffers[slot] == id, STATE_BUFFER, BUFFER_BINDINGS[slot], id, "buffer")))
+        return;
+    glBindBuffer(target, id);
+    if (slot >= 0)
+        buffers[slot] = id;
+}
+
+void GlStateCache::selectUnit(int unit)
+{
+    if (skip(STATE_TEXTURE, CONFIRM(unit == activeUnit, STATE_TEXTURE, GL_ACTIVE_TEXTURE, GL_TEXTURE0 + unit, "active texture")))
+        return;
+    glActiveTexture(GL_TEXTURE0 + unit);
+    activeUnit = unit;
+}
+
+void GlStateCache::bindTexture(int unit, GLenum target, GLuint id)
+{
+    int slot = findSlot(TEXTURE_TARGETS, target);
+    bool redundant = slot >= 0 && unit < MAX_TEXTURE_UNITS && textures[unit][slot] == id;
+#if GL_STATE_VALIDATION
+    if (redundant && unit != activeUnit)
+    {
+        GLint previous = 0;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &previous);
+        glActiveTexture(GL_TEXTURE0 + unit);
+        redundant = matchesDriver(STATE_TEXTURE, TEXTURE_BINDINGS[slot], id, "texture");
+        glActiveTexture(previous);
+    }
+    else
+    {
+        redundant = CONFIRM(redundant, STATE_TEXTURE, TEXTURE_BINDINGS[slot], id, "texture");
+    }
+#endif
+    if (skip(STATE_TEXTURE, redundant))
+        return;
+
+    selectUnit(unit);
+    glBindTexture(target, id);
+    if (slot >= 0 && unit < MAX_TEXTURE_UNITS)
+        textures[unit][slot] = id;
+}
+
+void GlStateCache::bindTexture(GLenum target, GLuint id)
+{
+    if (activeUnit < 0)
+        selectUnit(0);
+    bindTexture(activeUnit, target, id);
+}
+
+void GlStateCache::bindSampler(int unit, GLuint id)
+{
+    bool redundant = unit < MAX_TEXTURE_UNITS && samplers[unit] == id;
+#if GL_STATE_VALIDATION
+    if (redundant)
+    {
+        GLint previous = 0;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &previous);
+        glActiveTexture(GL_TEXTURE0 + unit);
+        redundant = matchesDriver(STATE_SAMPLER, GL_SAMPLER_BINDING, id, "sampler");
+        glActiveTexture(previous);
+    }
+#endif
+    if (skip(STATE_SAMPLER, redundant))
+        return;
+
+    // Takes the unit as a parameter, the active one stays
+    glBindSampler(unit, id);
+    if (unit < MAX_TEXTURE_UNITS)
+        samplers[unit] = id;
+}
+
+void GlStateCache::setEnabled(GLenum capability, bool enabled)
+{
+    int slot = findSlot(CAPABILITIES, capability);
+    if (skip(STATE_DEPTH_BLEND, slot >= 0 &&
+        CONFIRM(capabilities[slot] == (int)enabled, STATE_DEPTH_BLEND, capability, enabled, "capability")))
+        return;
+
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+    if (slot >= 0)
+        capabilities[slot] = enabled;
+}
+
+void GlStateCache::setDepthMask(bool write)
+{
+    if (skip(STATE_DEPTH_BLEND, CONFIRM(depthMask == (int)write, STATE_DEPTH_BLEND, GL_DEPTH_WRITEMASK, write, "depth mask")))
+        return;
+    glDepthMask(write ? GL_TRUE : GL_FALSE);
+    depthMask = write;
+}
+
+void GlStateCache::setDepthFunc(GLenum func)
+{
+    if (skip(STATE_DEPTH_BLEND, CONFIRM(depthFunc == func, STATE_DEPTH_BLEND, GL_DEPTH_FUNC, func, "depth function")))
+        return;
+    glDepthFunc(func);
+    depthFunc = func;
+}
+
+void GlStateCache::setBlendFunc(GLenum source, GLenum destination)
+{
+    bool redundant = source == blendSource && destination == blendDestination;
+    redundant = CONFIRM(redundant, STATE_DEPTH_BLEND, GL_BLEND_SRC_RGB, source, "blend source");
+    redundant = CONFIRM(redundant, STATE_DEPTH_BLEND, GL_BLEND_DST_RGB, destination, "blend destination");
+    if (skip(STATE_DEPTH_BLEND, redundant))
+        return;
+    glBlendFunc(source, destination);
+    blendSource = source;
+    blendDestination = destination;
+}
+
+// Deleting a bound object reverts the binding to 0 in the current context
+
+void GlStateCache::forgetTexture(GLuint id)
+{
+    for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+    {
+        for (int i = 0; i < TEXTURE_TARGET_COUNT; i++)
+        {
+            if (textures[unit][i] == id)
+                textures[unit][i] = 0;
+        }
+    }
+}
+
+void GlStateCache::forgetBuffer(GLuint id)
+{
+    for (int i = 0; i < BUFFER_TARGET_COUNT; i++)
+    {
+        if (buffers[i] == id)
+            buffers[i] = 0;
+    }
+}
+
+void GlStateCache::forgetVertexArray(GLuint id)
+{
+    if (vertexArray == id)
+    {
+        vertexArray = 0;
+        buffers[findSlot(BUFFER_TARGETS, GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    }
+}
+
+void GlStateCache::beginFrame()
+{
+    lastFrame = current;
+    current = GlStateStats();
+}
+
+const char* GlStateCache::getCategoryName(GlStateCategory category)
+{
+    switch (category)
+    {
+    case STATE_PROGRAM: return "program";
+    case STATE_VERTEX_ARRAY: return "vertex array";
+    case STATE_BUFFER: return "buffer";
+    case STATE_TEXTURE: return "texture";
+    case STATE_SAMPLER: return "sampler";
+    case STATE_DEPTH_BLEND: return "depth/blend";
+    default: return "unknown";
+    }
+}
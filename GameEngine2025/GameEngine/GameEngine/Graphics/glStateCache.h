@@ -0,0 +1,105 @@
+#pragma once
+#include <glew.h>
+
+// Debug builds check every skipped call against the driver's actual state;
+// set GL_STATE_VALIDATION in the preprocessor definitions to override
+#ifndef GL_STATE_VALIDATION
+#ifdef _DEBUG
+#define GL_STATE_VALIDATION 1
+#else
+#define GL_STATE_VALIDATION 0
+#endif
+#endif
+
+enum GlStateCategory
+{
+    STATE_PROGRAM,
+    STATE_VERTEX_ARRAY,
+    STATE_BUFFER,
+    STATE_TEXTURE,      // texture bindings and the active unit
+    STATE_SAMPLER,
+    STATE_DEPTH_BLEND,  // capabilities, depth mask and function, blend function
+    STATE_CATEGORY_COUNT
+};
+
+struct GlStateStats
+{
+    unsigned int issued[STATE_CATEGORY_COUNT] = {};
+    unsigned int skipped[STATE_CATEGORY_COUNT] = {};    // redundant calls never sent to the driver
+
+    unsigned int getTotalIssued() const;
+    unsigned int getTotalSkipped() const;
+    void add(const GlStateStats& other);
+};
+
+// Shadow of the binding and fixed-function state the renderer changes per
+// draw. A call that would set what is already set returns without reaching
+// the driver, so callers can bind what they need before every draw instead
+// of restoring defaults after it. Only correct while all such state goes
+// through here: code that touches it directly, or a new context, must be
+// followed by invalidate(), and deleted objects reported with forget*(),
+// since GL unbinds them. One context, main thread only.
+class GlStateCache
+{
+public:
+    static const int MAX_TEXTURE_UNITS = 16;
+
+    static GlStateCache& getInstance();
+
+    // Forgets everything; the next call of each kind reaches the driver
+    void invalidate();
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+    void bindBuffer(GLenum target, GLuint buffer);
+
+    // Selects the unit only when the binding has to change
+    void bindTexture(int unit, GLenum target, GLuint texture);
+    // On whatever unit is active, for creating and updating textures
+    void bindTexture(GLenum target, GLuint texture);
+    void bindSampler(int unit, GLuint sampler);
+
+    void setEnabled(GLenum capability, bool enabled);
+    void setDepthMask(bool write);
+    void setDepthFunc(GLenum func);
+    void setBlendFunc(GLenum source, GLenum destination);
+
+    void forgetTexture(GLuint texture);
+    void forgetBuffer(GLuint buffer);
+    void forgetVertexArray(GLuint vertexArray);
+
+    // Frame boundary: the counts so far become the last frame's
+    void beginFrame();
+    const GlStateStats& getLastFrameStats() const { return lastFrame; }
+
+    static const char* getCategoryName(GlStateCategory category);
+
+private:
+    GlStateCache();
+    GlStateCache(const GlStateCache&) = delete;
+    GlStateCache& operator=(const GlStateCache&) = delete;
+
+    enum { TEXTURE_TARGET_COUNT = 2, BUFFER_TARGET_COUNT = 3, CAPABILITY_COUNT = 4 };
+
+    GLuint program;
+    GLuint vertexArray;
+    GLuint buffers[BUFFER_TARGET_COUNT];
+    int activeUnit;
+    GLuint textures[MAX_TEXTURE_UNITS][TEXTURE_TARGET_COUNT];
+    GLuint samplers[MAX_TEXTURE_UNITS];
+    int capabilities[CAPABILITY_COUNT];     // 0, 1, or -1 when unknown
+    int depthMask;
+    GLenum depthFunc;
+    GLenum blendSource;
+    GLenum blendDestination;
+
+    GlStateStats current;
+    GlStateStats lastFrame;
+    bool mismatchReported[STATE_CATEGORY_COUNT];
+
+    bool skip(GlStateCategory category, bool redundant);
+    void selectUnit(int unit);
+#if GL_STATE_VALIDATION
+    bool matchesDriver(GlStateCategory category, GLenum query, GLint expected, const char* what);
+#endif
+};
@@ -0,0 +1,54 @@
+#include "gpuFrameTimer.h"
+#include <glfw3.h>
+
+GpuFrameTimer::GpuFrameTimer()
+    : supported(false), issued(0), read(0), frameOpen(false)
+{
+    supported = glfwGetCurrentContext() != nullptr && (GLEW_VERSION_3_3 || GLEW_ARB_timer_query);
+    if (supported)
+        glGenQueries(MAX_FRAMES_IN_FLIGHT * 2, queries);
+}
+
+GpuFrameTimer::~GpuFrameTimer()
+{
+    if (supported)
+        glDeleteQueries(MAX_FRAMES_IN_FLIGHT * 2, queries);
+}
+
+void GpuFrameTimer::beginFrame()
+{
+    // All pairs still waiting for the GPU: skip this frame rather than stall
+    frameOpen = supported && issued - read < MAX_FRAMES_IN_FLIGHT;
+    if (frameOpen)
+        glQueryCounter(queries[(issued % MAX_FRAMES_IN_FLIGHT) * 2], GL_TIMESTAMP);
+}
+
+void GpuFrameTimer::endFrame()
+{
+    if (!frameOpen)
+        return;
+
+    glQueryCounter(queries[(issued % MAX_FRAMES_IN_FLIGHT) * 2 + 1], GL_TIMESTAMP);
+    issued++;
+    frameOpen = false;
+}
+
+bool GpuFrameTimer::readResult(double& gpuMs)
+{
+    if (read == issued)
+        return false;
+
+    // The end timestamp is the later one; once it is available both are
+    GLuint* pair = &queries[(read % MAX_FRAMES_IN_FLIGHT) * 2];
+    GLint available = 0;
+    glGetQueryObjectiv(pair[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return false;
+
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(pair[0], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(pair[1], GL_QUERY_RESULT, &end);
+    read++;
+    gpuMs = (end - begin) / 1.0e6;
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <glew.h>
+
+// GPU time of whole frames, measured with a timestamp query at either end of
+// the frame's commands. Results are read a few frames later, once the driver
+// has them, so the CPU never waits on the GPU; when every query pair is still
+// in flight the frame is simply not measured. Timestamps rather than
+// GL_TIME_ELAPSED so that other elapsed-time queries may run in between.
+class GpuFrameTimer
+{
+public:
+    static const int MAX_FRAMES_IN_FLIGHT = 4;
+
+    GpuFrameTimer();
+    ~GpuFrameTimer();
+
+    // False without a context or timer query support; begin/end then do nothing
+    bool isSupported() const { return supported; }
+
+    void beginFrame();
+    void endFrame();
+
+    // Oldest finished frame not read yet, in milliseconds
+    bool readResult(double& gpuMs);
+
+private:
+    GpuFrameTimer(const GpuFrameTimer&) = delete;
+    GpuFrameTimer& operator=(const GpuFrameTimer&) = delete;
+
+    bool supported;
+    GLuint queries[MAX_FRAMES_IN_FLIGHT * 2];
+    int issued;         // frames begun so far
+    int read;           // frames whose result was read
+    bool frameOpen;
+};
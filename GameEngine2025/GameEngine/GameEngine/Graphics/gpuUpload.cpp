@@ -0,0 +1,13 @@
+#include "gpuUpload.h"
+
+static bool gpuUploadEnabled = true;
+
+void setGpuUploadEnabled(bool enabled)
+{
+    gpuUploadEnabled = enabled;
+}
+
+bool isGpuUploadEnabled()
+{
+    return gpuUploadEnabled;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// Global switch for GPU uploads from the asset loaders. Benchmarks turn it off
+// to measure parsing and decoding on machines without a GL context; meshes then
+// keep their CPU data with no buffers, and textures get placeholder ids.
+void setGpuUploadEnabled(bool enabled);
+bool isGpuUploadEnabled();
@@ -0,0 +1,265 @@
+#include "impostorBaker.h"
+#include "glStateCache.h"
+#include "../Core/mappedFile.h"
+#include <gtc/matrix_transform.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const uint32_t IMPOSTOR_CACHE_MAGIC = 0x504D4943;   // "CIMP"
+static const uint32_t IMPOSTOR_CACHE_VERSION = 1;
+
+// Coarser levels would blend neighbouring frames into each other
+static const int MAX_MIP_LEVEL = 4;
+
+struct ImpostorCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t frames;
+    uint32_t frameSize;
+    float radius;           // of the mesh when baked; a changed mesh bakes again
+};
+
+static std::string impostorCachePath(const std::string& modelPath)
+{
+    return modelPath + ".impostor";
+}
+
+static const size_t ATLAS_BYTES = (size_t)ImpostorBaker::ATLAS_SIZE * ImpostorBaker::ATLAS_SIZE * 4;
+
+bool readImpostorCache(const std::string& modelPath, float radius,
+    std::vector<unsigned char>& albedo, std::vector<unsigned char>& normalDepth)
+{
+    std::string path = impostorCachePath(modelPath);
+    long long cacheTime = getFileModificationTime(path);
+    if (cacheTime < 0 || cacheTime < getFileModificationTime(modelPath))
+        return false;
+
+    MappedFile file;
+    if (!file.open(path) || file.getSize() < sizeof(ImpostorCacheHeader))
+        return false;
+
+    ImpostorCacheHeader header;
+    memcpy(&header, file.getData(), sizeof(header));
+    if (header.magic != IMPOSTOR_CACHE_MAGIC || header.version != IMPOSTOR_CACHE_VERSION ||
+        header.frames != ImpostorBaker::FRAMES || header.frameSize != ImpostorBaker::FRAME_SIZE ||
+        header.radius != radius || file.getSize() != sizeof(header) + 2 * ATLAS_BYTES)
+    {
+        std::cout << "Warning: ignoring outdated impostor cache " << path << std::endl;
+        return false;
+    }
+
+    const unsigned char* data = file.getData() + sizeof(header);
+    albedo.assign(data, data + ATLAS_BYTES);
+    normalDepth.assign(data + ATLAS_BYTES, data + 2 * ATLAS_BYTES);
+    return true;
+}
+
+bool writeImpostorCache(const std::string& modelPath, float radius,
+    const std::vector<unsigned char>& albedo, const std::vector<unsigned char>& normalDepth)
+{
+    if (albedo.size() != ATLAS_BYTES || normalDepth.size() != ATLAS_BYTES)
+        return false;
+
+    std::string path = impostorCachePath(modelPath);
+    std::ofstream out(path.c_str(), std::ios::binary);
+    if (!out)
+        return false;
+
+    ImpostorCacheHeader header = { IMPOSTOR_CACHE_MAGIC, IMPOSTOR_CACHE_VERSION,
+        (uint32_t)ImpostorBaker::FRAMES, (uint32_t)ImpostorBaker::FRAME_SIZE, radius };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(&albedo[0]), albedo.size());
+    out.write(reinterpret_cast<const char*>(&normalDepth[0]), normalDepth.size());
+
+    if (!out)
+    {
+        // A half-written cache would only be rejected later; drop it now
+        out.close();
+        std::remove(path.c_str());
+        return false;
+    }
+    return true;
+}
+
+ImpostorBaker::ImpostorBaker()
+    : framebuffer(0), depthBuffer(0)
+{
+}
+
+ImpostorBaker::~ImpostorBaker()
+{
+    if (framebuffer)
+        glDeleteFramebuffers(1, &framebuffer);
+    if (depthBuffer)
+        glDeleteRenderbuffers(1, &depthBuffer);
+}
+
+glm::vec3 ImpostorBaker::getFrameDirection(int x, int y)
+{
+    // Hemi-octahedral decode of the frame centre; the shaders encode with the
+    // inverse (impostor_vertex_shader.glsl)
+    float u = (x + 0.5f) / FRAMES * 2.0f - 1.0f;
+    float v = (y + 0.5f) / FRAMES * 2.0f - 1.0f;
+    float px = (u + v) * 0.5f;
+    float pz = (u - v) * 0.5f;
+    return glm::normalize(glm::vec3(px, 1.0f - std::fabs(px) - std::fabs(pz), pz));
+}
+
+static GLuint createAtlasTexture(const unsigned char* pixels)
+{
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    GlStateCache::getInstance().bindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, ImpostorBaker::ATLAS_SIZE, ImpostorBaker::ATLAS_SIZE, 0,
+        GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, MAX_MIP_LEVEL);
+    return texture;
+}
+
+void ImpostorBaker::release(ImpostorAtlas& atlas)
+{
+    GlStateCache& state = GlStateCache::getInstance();
+    if (atlas.albedo)
+    {
+        glDeleteTextures(1, &atlas.albedo);
+        state.forgetTexture(atlas.albedo);
+    }
+    if (atlas.normalDepth)
+    {
+        glDeleteTextures(1, &atlas.normalDepth);
+        state.forgetTexture(atlas.normalDepth);
+    }
+    atlas = ImpostorAtlas();
+}
+
+bool ImpostorBaker::build(Mesh& mesh, float radius, const std::string& modelPath, Shader& bakeShader,
+    ImpostorAtlas& atlas)
+{
+    release(atlas);
+    if (radius <= 0.0f)
+        return false;
+
+    std::vector<unsigned char> albedo, normalDepth;
+    bool cached = !modelPath.empty() && readImpostorCache(modelPath, radius, albedo, normalDepth);
+
+    atlas.radius = radius;
+    atlas.albedo = createAtlasTexture(cached ? &albedo[0] : nullptr);
+    atlas.normalDepth = createAtlasTexture(cached ? &normalDepth[0] : nullptr);
+    // Full chain down to MAX_MIP_LEVEL is a third more than the top level
+    atlas.gpuBytes = 2 * ATLAS_BYTES * 4 / 3;
+
+    if (!cached)
+    {
+        if (!render(mesh, radius, bakeShader, atlas))
+        {
+            release(atlas);
+            return false;
+        }
+
+        if (!modelPath.empty())
+        {
+            albedo.resize(ATLAS_BYTES);
+            normalDepth.resize(ATLAS_BYTES);
+            GlStateCache& state = GlStateCache::getInstance();
+            state.bindTexture(GL_TEXTURE_2D, atlas.albedo);
+            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, &albedo[0]);
+            state.bindTexture(GL_TEXTURE_2D, atlas.normalDepth);
+            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, &normalDepth[0]);
+            if (!writeImpostorCache(modelPath, radius, albedo, normalDepth))
+                std::cout << "Warning: could not write impostor cache for " << modelPath << std::endl;
+        }
+    }
+
+    GlStateCache& state = GlStateCache::getInstance();
+    state.bindTexture(GL_TEXTURE_2D, atlas.albedo);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    state.bindTexture(GL_TEXTURE_2D, atlas.normalDepth);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    return true;
+}
+
+bool ImpostorBaker::render(Mesh& mesh, float radius, Shader& bakeShader, ImpostorAtlas& atlas)
+{
+    GLint previousDraw = 0, previousRead = 0, viewport[4];
+    GLfloat clearColor[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDraw);
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+    if (!framebuffer)
+    {
+        glGenFramebuffers(1, &framebuffer);
+        glGenRenderbuffers(1, &depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, ATLAS_SIZE, ATLAS_SIZE);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, atlas.albedo, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, atlas.normalDepth, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (complete)
+    {
+        GlStateCache& state = GlStateCache::getInstance();
+        state.setEnabled(GL_DEPTH_TEST, true);
+        state.setEnabled(GL_BLEND, false);
+        state.setDepthMask(true);
+
+        glViewport(0, 0, ATLAS_SIZE, ATLAS_SIZE);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        bakeShader.use();
+        GLuint program = bakeShader.getId();
+        GLint mvpId = glGetUniformLocation(program, "MVP");
+        GLint directionId = glGetUniformLocation(program, "frameDirection");
+        glm::mat4 identity(1.0f);
+        glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE, &identity[0][0]);
+        glUniform1f(glGetUniformLocation(program, "radius"), radius);
+
+        // Each frame an orthographic view of the bounding sphere, from outside it
+        glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, radius, 3.0f * radius);
+        for (int y = 0; y < FRAMES; y++)
+        {
+            for (int x = 0; x < FRAMES; x++)
+            {
+                glm::vec3 direction = getFrameDirection(x, y);
+                glm::vec3 up = std::fabs(direction.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+                glm::mat4 mvp = projection * glm::lookAt(direction * (2.0f * radius), glm::vec3(0.0f), up);
+
+                glViewport(x * FRAME_SIZE, y * FRAME_SIZE, FRAME_SIZE, FRAME_SIZE);
+                glUniformMatrix4fv(mvpId, 1, GL_FALSE, &mvp[0][0]);
+                glUniform3fv(directionId, 1, &direction.x);
+                mesh.draw(bakeShader);
+            }
+        }
+    }
+    else
+    {
+        std::cout << "Warning: impostor framebuffer is incomplete, nothing baked" << std::endl;
+    }
+
+    // The atlases are sampled later; keep them out of a framebuffer that is not drawn to
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, 0, 0);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDraw);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    return complete;
+}
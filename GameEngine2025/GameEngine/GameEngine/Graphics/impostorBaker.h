@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glew.h>
+#include <glm.hpp>
+#include "../Model Loading/mesh.h"
+#include "../Shaders/shader.h"
+
+// A mesh as seen from a hemisphere of directions: FRAMES x FRAMES orthographic
+// views side by side in one atlas, the view direction of each frame given by
+// the hemi-octahedral mapping of its centre (see getFrameDirection). Each view
+// covers the bounding sphere of the mesh, `radius` around the model origin.
+struct ImpostorAtlas
+{
+    GLuint albedo = 0;          // RGB colour, A coverage
+    GLuint normalDepth = 0;     // RGB object-space normal * 0.5 + 0.5, A height towards the viewer
+    float radius = 0.0f;
+    size_t gpuBytes = 0;
+};
+
+// Renders impostor atlases, or reads them back from a cache dumped next to
+// the source model (<model>.impostor) the way meshes and collision trees are
+// cached. A cache older than its model, or baked with other settings, is
+// ignored. Main thread only.
+class ImpostorBaker
+{
+public:
+    static const int FRAMES = 8;            // per atlas side
+    static const int FRAME_SIZE = 64;       // pixels per frame side
+    static const int ATLAS_SIZE = FRAMES * FRAME_SIZE;
+
+    ImpostorBaker();
+    ~ImpostorBaker();
+
+    // Fills `atlas` for a resident mesh. `bakeShader` draws the mesh into the
+    // two atlas textures (vertex_shader.glsl + impostor_bake_fragment_shader.glsl).
+    // Restores the framebuffer and viewport it found; false when neither the
+    // cache nor the GPU gave a complete atlas.
+    bool build(Mesh& mesh, float radius, const std::string& modelPath, Shader& bakeShader, ImpostorAtlas& atlas);
+    static void release(ImpostorAtlas& atlas);
+
+    // Object-space direction frame (x, y) was seen from; the hemisphere above y = 0
+    static glm::vec3 getFrameDirection(int x, int y);
+
+private:
+    ImpostorBaker(const ImpostorBaker&) = delete;
+    ImpostorBaker& operator=(const ImpostorBaker&) = delete;
+
+    GLuint framebuffer;
+    GLuint depthBuffer;
+
+    bool render(Mesh& mesh, float radius, Shader& bakeShader, ImpostorAtlas& atlas);
+};
+
+bool readImpostorCache(const std::string& modelPath, float radius,
+    std::vector<unsigned char>& albedo, std::vector<unsigned char>& normalDepth);
+bool writeImpostorCache(const std::string& modelPath, float radius,
+    const std::vector<unsigned char>& albedo, const std::vector<unsigned char>& normalDepth);
@@ -0,0 +1,203 @@
+#include "impostorRenderer.h"
+#include "gpuUpload.h"
+#include "glStateCache.h"
+#include "renderStats.h"
+#include "../Core/allocationTracker.h"
+#include "../Core/profiler.h"
+#include "../ResourceManager/resourceManager.h"
+#include <cstring>
+#include <iostream>
+
+ImpostorRenderer::ImpostorRenderer()
+    : vao(0), instanceBuffer(0), instancesLastFrame(0), drawCallsLastFrame(0), atlasCount(0), gpuBytes(0)
+{
+}
+
+ImpostorRenderer::~ImpostorRenderer()
+{
+    clear();
+
+    GlStateCache& state = GlStateCache::getInstance();
+    if (instanceBuffer)
+    {
+        glDeleteBuffers(1, &instanceBuffer);
+        state.forgetBuffer(instanceBuffer);
+    }
+    if (vao)
+    {
+        glDeleteVertexArrays(1, &vao);
+        state.forgetVertexArray(vao);
+    }
+}
+
+void ImpostorRenderer::enable(MeshHandle mesh)
+{
+    if (!mesh.isValid())
+        return;
+
+    uint32_t index = mesh.getIndex();
+    if (index >= meshSlots.size())
+        meshSlots.resize(index + 1, 0);
+    if (meshSlots[index] != 0)
+        return;
+
+    // Room for a typical view, so the first frames do not grow it
+    Slot slot;
+    slot.mesh = mesh;
+    slot.instances.reserve(256);
+    slots.push_back(std::move(slot));
+    meshSlots[index] = (uint32_t)slots.size();
+}
+
+bool ImpostorRenderer::add(MeshHandle mesh, const glm::vec3& position, const glm::quat& rotation, float scale)
+{
+    uint32_t index = mesh.getIndex();
+    if (index >= meshSlots.size() || meshSlots[index] == 0)
+        return false;
+
+    Slot& slot = slots[meshSlots[index] - 1];
+    if (slot.mesh != mesh)
+        return false;
+    if (!slot.atlas.albedo)
+    {
+        slot.requested = !slot.failed;
+        return false;
+    }
+
+    Instance instance;
+    instance.placement = glm::vec4(position, scale);
+    instance.rotation = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+    slot.instances.push_back(instance);
+    return true;
+}
+
+bool ImpostorRenderer::build(Shader& bakeShader)
+{
+    if (!isGpuUploadEnabled())
+        return false;
+
+    ResourceManager& rm = ResourceManager::getInstance();
+    for (Slot& slot : slots)
+    {
+        if (!slot.requested || slot.atlas.albedo || slot.failed)
+            continue;
+        slot.requested = false;
+
+        Mesh* mesh = rm.getMesh(slot.mesh);
+        if (!mesh)
+            continue;
+
+        PROFILE_SCOPE("buildImpostor");
+        // Once per mesh and run, like an asset load
+        ExpectedAllocationScope building;
+        if (!baker.build(*mesh, rm.getMeshRadius(slot.mesh), rm.getMeshPath(slot.mesh), bakeShader, slot.atlas))
+        {
+            std::cout << "Warning: no impostor for " << rm.getMeshPath(slot.mesh) << ", drawing the mesh instead" << std::endl;
+            slot.failed = true;
+            return false;
+        }
+        atlasCount++;
+        gpuBytes += slot.atlas.gpuBytes;
+        return true;
+    }
+    return false;
+}
+
+void ImpostorRenderer::render(const glm::mat4& viewProjection, const glm::vec3& cameraPos, Shader& shader)
+{
+    PROFILE_SCOPE("renderImpostors");
+    PROFILE_GPU_SCOPE("renderImpostors");
+
+    instancesLastFrame = 0;
+    drawCallsLastFrame = 0;
+    size_t total = 0;
+    for (const Slot& slot : slots)
+        total += slot.instances.size();
+    if (total == 0 || !isGpuUploadEnabled())
+    {
+        for (Slot& slot : slots)
+            slot.instances.clear();
+        return;
+    }
+
+    if (!vao)
+    {
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &instanceBuffer);
+    }
+
+    shader.use();
+    GLuint program = shader.getId();
+    glUniformMatrix4fv(glGetUniformLocation(program, "viewProjection"), 1, GL_FALSE, &viewProjection[0][0]);
+    glUniform3fv(glGetUniformLocation(program, "viewPos"), 1, &cameraPos.x);
+    glUniform1f(glGetUniformLocation(program, "framesPerSide"), (float)ImpostorBaker::FRAMES);
+    glUniform1i(glGetUniformLocation(program, "impostorAlbedo"), 0);
+    glUniform1i(glGetUniformLocation(program, "impostorNormalDepth"), 1);
+    GLint radiusId = glGetUniformLocation(program, "impostorRadius");
+
+    GlStateCache& state = GlStateCache::getInstance();
+    RenderStats& stats = RenderStats::getInstance();
+    state.bindVertexArray(vao);
+    state.bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+    // Every mesh's instances in one orphaned upload, drawn from their offsets
+    size_t bytes = total * sizeof(Instance);
+    glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    char* mapped = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!mapped)
+    {
+        for (Slot& slot : slots)
+            slot.instances.clear();
+        return;
+    }
+    size_t offset = 0;
+    for (const Slot& slot : slots)
+    {
+        if (slot.instances.empty())
+            continue;
+        memcpy(mapped + offset, slot.instances.data(), slot.instances.size() * sizeof(Instance));
+        offset += slot.instances.size() * sizeof(Instance);
+    }
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    stats.countUpload(bytes);
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(0, 1);
+    glVertexAttribDivisor(1, 1);
+
+    offset = 0;
+    for (Slot& slot : slots)
+    {
+        if (slot.instances.empty())
+            continue;
+
+        GLsizei count = (GLsizei)slot.instances.size();
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offset);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offset + sizeof(glm::vec4)));
+        state.bindTexture(0, GL_TEXTURE_2D, slot.atlas.albedo);
+        state.bindTexture(1, GL_TEXTURE_2D, slot.atlas.normalDepth);
+        glUniform1f(radiusId, slot.atlas.radius);
+
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+        stats.countDraw(GL_TRIANGLE_STRIP, 4, count);
+        drawCallsLastFrame++;
+        instancesLastFrame += count;
+
+        offset += slot.instances.size() * sizeof(Instance);
+        slot.instances.clear();
+    }
+}
+
+void ImpostorRenderer::clear()
+{
+    for (Slot& slot : slots)
+    {
+        ImpostorBaker::release(slot.atlas);
+        slot.instances.clear();
+        slot.requested = false;
+        slot.failed = false;
+    }
+    atlasCount = 0;
+    gpuBytes = 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glew.h>
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+#include "impostorBaker.h"
+#include "../ResourceManager/assetHandle.h"
+#include "../Shaders/shader.h"
+
+// Stands in for distant static props: every instance of a mesh becomes one
+// card in a single instanced draw, textured from the mesh's impostor atlas.
+// Meshes opt in with enable(); their atlas is built (or read from its cache)
+// the first time an instance is far enough to need it, one mesh per frame,
+// and until then the full mesh keeps drawing.
+//
+//   add(...) per distant entity while drawing the scene, then
+//   build(bakeShader) and render(...) once, after the opaque meshes.
+//
+// Main thread only.
+class ImpostorRenderer
+{
+public:
+    ImpostorRenderer();
+    ~ImpostorRenderer();
+
+    void enable(MeshHandle mesh);
+
+    // Queues an instance; false when the mesh has no atlas (yet), in which
+    // case the caller draws the mesh itself
+    bool add(MeshHandle mesh, const glm::vec3& position, const glm::quat& rotation, float scale);
+
+    // Builds at most one atlas that add() asked for; true when it built one
+    bool build(Shader& bakeShader);
+
+    // Draws and then drops the queued instances. The lighting uniforms of
+    // `shader` (impostor_*_shader.glsl) are the caller's.
+    void render(const glm::mat4& viewProjection, const glm::vec3& cameraPos, Shader& shader);
+
+    // Forgets every atlas, e.g. when the GL context goes away
+    void clear();
+
+    unsigned int getInstancesLastFrame() const { return instancesLastFrame; }
+    unsigned int getDrawCallsLastFrame() const { return drawCallsLastFrame; }
+    unsigned int getAtlasCount() const { return atlasCount; }
+    size_t getGpuBytes() const { return gpuBytes; }
+
+private:
+    ImpostorRenderer(const ImpostorRenderer&) = delete;
+    ImpostorRenderer& operator=(const ImpostorRenderer&) = delete;
+
+    // Per instance: position and scale, then the rotation
+    struct Instance
+    {
+        glm::vec4 placement;
+        glm::vec4 rotation;
+    };
+
+    struct Slot
+    {
+        MeshHandle mesh;
+        ImpostorAtlas atlas;
+        bool requested = false;     // an instance wanted the atlas before it existed
+        bool failed = false;        // not retried
+        std::vector<Instance> instances;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> meshSlots;    // slot + 1 by mesh index, 0 for meshes without impostors
+    ImpostorBaker baker;
+
+    GLuint vao;
+    GLuint instanceBuffer;
+    unsigned int instancesLastFrame;
+    unsigned int drawCallsLastFrame;
+    unsigned int atlasCount;
+    size_t gpuBytes;
+};
@@ -0,0 +1,148 @@
+#include "offscreenContext.h"
+#include "glStateCache.h"
+#include <cstring>
+#include <iostream>
+
+OffscreenContext::OffscreenContext()
+    : window(nullptr),
+    framebuffer(0),
+    colorBuffer(0),
+    depthBuffer(0),
+    width(0),
+    height(0)
+{
+}
+
+OffscreenContext::~OffscreenContext()
+{
+    destroy();
+}
+
+const char* OffscreenContext::getApiName(OffscreenContextApi api)
+{
+    switch (api)
+    {
+    case OFFSCREEN_EGL: return "egl";
+    case OFFSCREEN_OSMESA: return "osmesa";
+    default: return "native";
+    }
+}
+
+bool OffscreenContext::parseApiName(const char* name, OffscreenContextApi& api)
+{
+    if (strcmp(name, "native") == 0) api = OFFSCREEN_NATIVE;
+    else if (strcmp(name, "egl") == 0) api = OFFSCREEN_EGL;
+    else if (strcmp(name, "osmesa") == 0) api = OFFSCREEN_OSMESA;
+    else return false;
+    return true;
+}
+
+bool OffscreenContext::create(int w, int h, OffscreenContextApi api)
+{
+    destroy();
+
+    if (!glfwInit())
+    {
+        std::cout << "Error initializing glfw!" << std::endl;
+        return false;
+    }
+
+    glfwDefaultWindowHints();
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    if (api == OFFSCREEN_EGL)
+    {
+#ifdef GLFW_EGL_CONTEXT_API
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#else
+        std::cout << "Error: this GLFW build cannot create EGL contexts" << std::endl;
+        glfwTerminate();
+        return false;
+#endif
+    }
+    else if (api == OFFSCREEN_OSMESA)
+    {
+#ifdef GLFW_OSMESA_CONTEXT_API
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+#else
+        std::cout << "Error: this GLFW build cannot create OSMesa contexts" << std::endl;
+        glfwTerminate();
+        return false;
+#endif
+    }
+
+    // The window itself is never shown; rendering goes to the framebuffer object
+    window = glfwCreateWindow(w, h, "offscreen", NULL, NULL);
+    glfwDefaultWindowHints();
+    if (window == NULL)
+    {
+        std::cout << "Failed to create an offscreen " << getApiName(api) << " context" << std::endl;
+        glfwTerminate();
+        return false;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    if (glewInit() != GLEW_OK)
+    {
+        std::cout << "Error initializing glew!" << std::endl;
+        destroy();
+        return false;
+    }
+    // A fresh context: whatever the cache remembers belongs to an old one
+    GlStateCache::getInstance().invalidate();
+
+    width = w;
+    height = h;
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "Error: offscreen framebuffer is incomplete" << std::endl;
+        destroy();
+        return false;
+    }
+
+    bind();
+    std::cout << "Offscreen " << getApiName(api) << " context: " << glGetString(GL_RENDERER)
+        << ", Open GL " << glGetString(GL_VERSION) << std::endl;
+    return true;
+}
+
+void OffscreenContext::bind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+}
+
+void OffscreenContext::destroy()
+{
+    if (!window)
+        return;
+
+    glfwMakeContextCurrent(window);
+    if (framebuffer)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(1, &colorBuffer);
+        glDeleteRenderbuffers(1, &depthBuffer);
+        framebuffer = colorBuffer = depthBuffer = 0;
+    }
+
+    glfwDestroyWindow(window);
+    window = nullptr;
+    glfwTerminate();
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <glew.h>
+#include <glfw3.h>
+
+// Which driver interface creates the GL context
+enum OffscreenContextApi
+{
+    OFFSCREEN_NATIVE = 0,   // WGL / GLX, whatever a normal window uses
+    OFFSCREEN_EGL,          // EGL, for headless GPU and Mesa drivers
+    OFFSCREEN_OSMESA        // Mesa's pure software rasterizer, no display or GPU needed
+};
+
+// A GL context without a visible window, rendering into a framebuffer object
+// of a fixed size. Creation goes through GLFW with an invisible window so the
+// same code path serves native drivers, EGL and OSMesa (GLFW 3.3+); on builds
+// with an older GLFW only the native API is available. On Windows without a
+// GPU, Mesa's opengl32.dll placed next to the executable gives llvmpipe
+// through the native path.
+class OffscreenContext
+{
+public:
+    OffscreenContext();
+    ~OffscreenContext();
+
+    bool create(int width, int height, OffscreenContextApi api);
+    void destroy();
+
+    // Binds the offscreen framebuffer and sets the viewport to it
+    void bind();
+
+    GLuint getFramebuffer() const { return framebuffer; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    bool isValid() const { return window != nullptr; }
+
+    static const char* getApiName(OffscreenContextApi api);
+    static bool parseApiName(const char* name, OffscreenContextApi& api);
+
+private:
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    GLFWwindow* window;
+    GLuint framebuffer;
+    GLuint colorBuffer;
+    GLuint depthBuffer;
+    int width, height;
+};
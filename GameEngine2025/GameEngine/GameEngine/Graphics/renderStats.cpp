@@ -0,0 +1,167 @@
+#include "renderStats.h"
+#include "glStateCache.h"
+#include <algorithm>
+#include <iostream>
+
+void RenderCounters::add(const RenderCounters& other)
+{
+    drawCalls += other.drawCalls;
+    triangles += other.triangles;
+    points += other.points;
+    culled += other.culled;
+    stateChanges += other.stateChanges;
+    redundantStateChanges += other.redundantStateChanges;
+    uploads += other.uploads;
+    uploadBytes += other.uploadBytes;
+}
+
+RenderStats& RenderStats::getInstance()
+{
+    static RenderStats instance;
+    return instance;
+}
+
+RenderStats::RenderStats()
+    : head(0), frameOpen(false), dumpPeriod(1), intervalsSinceDump(0)
+{
+    intervalStart = dumpStart = Clock::now();
+}
+
+void RenderStats::countDraw(GLenum mode, GLsizei vertices, GLsizei instances)
+{
+    current.drawCalls++;
+    switch (mode)
+    {
+    case GL_TRIANGLES:
+        current.triangles += (uint64_t)(vertices / 3) * instances;
+        break;
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN:
+        current.triangles += (uint64_t)std::max(vertices - 2, 0) * instances;
+        break;
+    case GL_POINTS:
+        current.points += (uint64_t)vertices * instances;
+        break;
+    default:
+        break;
+    }
+}
+
+void RenderStats::beginFrame()
+{
+    Clock::time_point now = Clock::now();
+    if (frameOpen)
+    {
+        const GlStateStats& state = GlStateCache::getInstance().getLastFrameStats();
+        current.stateChanges = state.getTotalIssued();
+        current.redundantStateChanges = state.getTotalSkipped();
+
+        Interval& interval = intervals[head];
+        interval.counters.add(current);
+        interval.cpuMs.record(std::chrono::duration<double, std::milli>(now - frameStart).count());
+        interval.frames++;
+        lastFrame = current;
+    }
+    current = RenderCounters();
+    frameStart = now;
+    frameOpen = true;
+
+    if (now - intervalStart >= std::chrono::seconds(1))
+        closeInterval(now);
+}
+
+void RenderStats::addGpuFrameTime(double gpuMs)
+{
+    intervals[head].gpuMs.record(gpuMs);
+}
+
+void RenderStats::closeInterval(Clock::time_point now)
+{
+    intervals[head].seconds = std::chrono::duration<double>(now - intervalStart).count();
+    intervalStart = now;
+
+    if (dumpFile.is_open() && ++intervalsSinceDump >= dumpPeriod)
+    {
+        writeDump();
+        intervalsSinceDump = 0;
+    }
+
+    // The oldest second leaves the window
+    head = (head + 1) % WINDOW_SECONDS;
+    Interval& next = intervals[head];
+    next.counters = RenderCounters();
+    next.cpuMs.reset();
+    next.gpuMs.reset();
+    next.frames = 0;
+    next.seconds = 0.0;
+}
+
+RenderStatsSummary RenderStats::getSummary() const
+{
+    RenderStatsSummary summary;
+    windowCpuMs.reset();
+    windowGpuMs.reset();
+    for (int i = 0; i < WINDOW_SECONDS; i++)
+    {
+        const Interval& interval = intervals[i];
+        summary.totals.add(interval.counters);
+        summary.frames += interval.frames;
+        summary.seconds += interval.seconds;
+        windowCpuMs.add(interval.cpuMs);
+        windowGpuMs.add(interval.gpuMs);
+    }
+    summary.seconds += std::chrono::duration<double>(Clock::now() - intervalStart).count();
+    summary.cpuMs = windowCpuMs.getSummary();
+    summary.gpuMs = windowGpuMs.getSummary();
+    return summary;
+}
+
+bool RenderStats::startDump(const std::string& path, int periodSeconds)
+{
+    stopDump();
+    dumpFile.open(path.c_str(), std::ios::out | std::ios::app);
+    if (!dumpFile)
+    {
+        std::cout << "Warning: could not open render stats file " << path << std::endl;
+        return false;
+    }
+    dumpPeriod = std::max(periodSeconds, 1);
+    intervalsSinceDump = 0;
+    dumpStart = Clock::now();
+    return true;
+}
+
+void RenderStats::stopDump()
+{
+    if (dumpFile.is_open())
+        dumpFile.close();
+}
+
+static void writeHistogram(std::ofstream& out, const char* name, const HistogramSummary& summary)
+{
+    out << ",\"" << name << "\":{\"count\":" << summary.count << ",\"p50\":" << summary.p50
+        << ",\"p95\":" << summary.p95 << ",\"p99\":" << summary.p99 << ",\"max\":" << summary.max << "}";
+}
+
+void RenderStats::writeDump()
+{
+    RenderStatsSummary summary = getSummary();
+    double frames = std::max((double)summary.frames, 1.0);
+    const RenderCounters& totals = summary.totals;
+
+    // Counters as per-frame averages over the window
+    dumpFile.setf(std::ios::fixed);
+    dumpFile.precision(3);
+    dumpFile << "{\"time\":" << std::chrono::duration<double>(Clock::now() - dumpStart).count()
+        << ",\"windowSeconds\":" << summary.seconds << ",\"frames\":" << summary.frames
+        << ",\"drawCalls\":" << totals.drawCalls / frames << ",\"triangles\":" << totals.triangles / frames
+        << ",\"points\":" << totals.points / frames << ",\"culled\":" << totals.culled / frames
+        << ",\"stateChanges\":" << totals.stateChanges / frames
+        << ",\"redundantStateChanges\":" << totals.redundantStateChanges / frames
+        << ",\"uploads\":" << totals.uploads / frames << ",\"uploadBytes\":" << totals.uploadBytes / frames;
+    writeHistogram(dumpFile, "cpuMs", summary.cpuMs);
+    writeHistogram(dumpFile, "gpuMs", summary.gpuMs);
+    // No flush: the stream writes out whole buffers, so a dump does not
+    // stall the frame it is measuring; stopDump and exit write the rest
+    dumpFile << "}\n";
+}
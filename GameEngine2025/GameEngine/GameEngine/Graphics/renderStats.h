@@ -0,0 +1,104 @@
+#pragma once
+#include <glew.h>
+#include "../Core/histogram.h"
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// What frames asked of the driver
+struct RenderCounters
+{
+    uint64_t drawCalls = 0;
+    uint64_t triangles = 0;
+    uint64_t points = 0;
+    uint64_t culled = 0;                // entities beyond the draw distance
+    uint64_t stateChanges = 0;          // GL state calls that reached the driver
+    uint64_t redundantStateChanges = 0; // and the ones GlStateCache dropped
+    uint64_t uploads = 0;               // buffer and texture data handed to GL
+    uint64_t uploadBytes = 0;
+
+    void add(const RenderCounters& other);
+};
+
+// The rolling window: counter totals and frame time distributions
+struct RenderStatsSummary
+{
+    double seconds = 0.0;
+    uint64_t frames = 0;
+    RenderCounters totals;
+    HistogramSummary cpuMs;     // frame to frame on the main thread
+    HistogramSummary gpuMs;     // as measured by GpuFrameTimer
+};
+
+// Per-frame render counters and frame time histograms over the last
+// WINDOW_SECONDS, kept as one-second intervals so old frames drop out a
+// second at a time. The draw and upload paths count themselves; the main
+// loop closes each frame and hands in GPU times as they come back. The
+// window can be queried at any time or appended to a file as one JSON
+// object per line every few seconds. Main thread only.
+//
+//   GlStateCache::getInstance().beginFrame();
+//   RenderStats::getInstance().beginFrame();    // once per frame, after the state cache
+//   RenderStats::getInstance().addGpuFrameTime(ms);
+class RenderStats
+{
+public:
+    static const int WINDOW_SECONDS = 10;
+
+    static RenderStats& getInstance();
+
+    void countDraw(GLenum mode, GLsizei vertices, GLsizei instances = 1);
+    void countUpload(size_t bytes)
+    {
+        current.uploads++;
+        current.uploadBytes += bytes;
+    }
+    void countCulled() { current.culled++; }
+
+    void beginFrame();
+    void addGpuFrameTime(double gpuMs);
+
+    const RenderCounters& getLastFrame() const { return lastFrame; }
+    RenderStatsSummary getSummary() const;
+
+    // Appends the window summary to `path` every periodSeconds
+    bool startDump(const std::string& path, int periodSeconds = 1);
+    void stopDump();
+
+private:
+    RenderStats();
+    RenderStats(const RenderStats&) = delete;
+    RenderStats& operator=(const RenderStats&) = delete;
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Interval
+    {
+        RenderCounters counters;
+        Histogram cpuMs;
+        Histogram gpuMs;
+        uint64_t frames = 0;
+        double seconds = 0.0;
+    };
+
+    RenderCounters current;
+    RenderCounters lastFrame;
+
+    Interval intervals[WINDOW_SECONDS];
+    // Merge space for getSummary, so summaries and dumps do not allocate
+    mutable Histogram windowCpuMs;
+    mutable Histogram windowGpuMs;
+    int head;                       // the interval being filled
+    Clock::time_point intervalStart;
+    Clock::time_point frameStart;
+    bool frameOpen;
+
+    std::ofstream dumpFile;
+    int dumpPeriod;
+    int intervalsSinceDump;
+    Clock::time_point dumpStart;
+
+    void closeInterval(Clock::time_point now);
+    void writeDump();
+};
@@ -0,0 +1,80 @@
+#include "scaledRenderTarget.h"
+#include "../Core/profiler.h"
+#include <algorithm>
+#include <iostream>
+
+ScaledRenderTarget::ScaledRenderTarget()
+    : framebuffer(0), colorBuffer(0), depthBuffer(0), width(0), height(0)
+{
+}
+
+ScaledRenderTarget::~ScaledRenderTarget()
+{
+    release();
+}
+
+void ScaledRenderTarget::release()
+{
+    if (framebuffer)
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(1, &colorBuffer);
+        glDeleteRenderbuffers(1, &depthBuffer);
+    }
+    framebuffer = colorBuffer = depthBuffer = 0;
+    width = height = 0;
+}
+
+bool ScaledRenderTarget::bind(int w, int h)
+{
+    w = std::max(w, 1);
+    h = std::max(h, 1);
+
+    if (!framebuffer || w != width || h != height)
+    {
+        release();
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+        glGenRenderbuffers(1, &colorBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+
+        glGenRenderbuffers(1, &depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, w, h);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cout << "Warning: " << w << "x" << h << " render target is incomplete" << std::endl;
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            release();
+            return false;
+        }
+        width = w;
+        height = h;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+    return true;
+}
+
+void ScaledRenderTarget::resolve(GLuint target, int targetWidth, int targetHeight)
+{
+    PROFILE_SCOPE("upscale");
+    PROFILE_GPU_SCOPE("upscale");
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+    if (framebuffer)
+    {
+        glBlitFramebuffer(0, 0, width, height, 0, 0, targetWidth, targetHeight,
+            GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+    glViewport(0, 0, targetWidth, targetHeight);
+}
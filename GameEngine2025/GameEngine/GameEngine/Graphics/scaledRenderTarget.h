@@ -0,0 +1,34 @@
+#pragma once
+#include <glew.h>
+
+// Colour and depth framebuffer the scene is drawn into at a reduced size,
+// then stretched onto the real framebuffer with a filtered blit. Storage is
+// reallocated only when the size changes. Main thread only.
+class ScaledRenderTarget
+{
+public:
+    ScaledRenderTarget();
+    ~ScaledRenderTarget();
+
+    // Binds the target at the given size (at least 1x1) and sets the viewport to it
+    bool bind(int width, int height);
+
+    // Stretches the last bound contents over `framebuffer` (0 for the window)
+    // and leaves that bound with the viewport covering it
+    void resolve(GLuint framebuffer, int width, int height);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+private:
+    ScaledRenderTarget(const ScaledRenderTarget&) = delete;
+    ScaledRenderTarget& operator=(const ScaledRenderTarget&) = delete;
+
+    GLuint framebuffer;
+    GLuint colorBuffer;
+    GLuint depthBuffer;
+    int width;
+    int height;
+
+    void release();
+};
@@ -1,4 +1,6 @@
 #include "window.h"
+#include "../Core/profiler.h"
+#include "glStateCache.h"
 
 Window::Window(char* name, int width, int height)
 {
@@ -60,6 +62,7 @@ void Window::init()
 	{
 		std::cout << "Successfully initializing glew!" << std::endl;
 	}
+	GlStateCache::getInstance().invalidate();
 
 	std::cout << "Open GL " << glGetString(GL_VERSION) << std::endl;
 }
@@ -69,9 +72,29 @@ void Window::update()
 	glfwPollEvents();
 	glfwGetFramebufferSize(window, &width, &height);
 	glViewport(0, 0, width, height);
+
+	PROFILE_SCOPE("swapBuffers");
 	glfwSwapBuffers(window);
 }
 
+void Window::pollEvents()
+{
+	glfwPollEvents();
+}
+
+bool Window::setRawMouseMotion(bool enable)
+{
+#ifdef GLFW_RAW_MOUSE_MOTION
+	if (!glfwRawMouseMotionSupported())
+		return false;
+	glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, enable ? GLFW_TRUE : GLFW_FALSE);
+	return true;
+#else
+	// GLFW before 3.3
+	return false;
+#endif
+}
+
 void Window::clear()
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -82,6 +105,11 @@ GLFWwindow* Window::getWindow()
 	return window;
 }
 
+InputQueue& Window::getInput()
+{
+	return input;
+}
+
 int Window::getWidth()
 {
 	return width;
@@ -135,6 +163,9 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		wind->setKey(key, true);
 	else
 		wind->setKey(key, false);
+
+	InputEvent event = { INPUT_KEY, glfwGetTime(), key, action, 0.0, 0.0 };
+	wind->getInput().push(event);
 }
 
 //Handling mouse actions
@@ -146,6 +177,9 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 		wind->setMouseButton(button, true);
 	else
 		wind->setMouseButton(button, false);
+
+	InputEvent event = { INPUT_MOUSE_BUTTON, glfwGetTime(), button, action, 0.0, 0.0 };
+	wind->getInput().push(event);
 }
 
 //Handling cursor position
@@ -153,4 +187,7 @@ void cursor_position_callback(GLFWwindow* window, double xpos, double ypos)
 {
 	Window* wind = (Window*)glfwGetWindowUserPointer(window);
 	wind->setMousePos(xpos, ypos);
+
+	InputEvent event = { INPUT_CURSOR, glfwGetTime(), 0, 0, xpos, ypos };
+	wind->getInput().push(event);
 }
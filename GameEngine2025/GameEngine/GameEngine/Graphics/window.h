@@ -1,6 +1,7 @@
 #include <iostream>
 #include <glew.h>
 #include <glfw3.h>
+#include "../Input/inputQueue.h"
 
 #pragma once
 
@@ -22,6 +23,9 @@ class Window
 		bool mouseButtons[MAX_MOUSE];
 		double xpos;
 		double ypos;
+
+		// Every callback in delivery order, timestamped; see InputQueue
+		InputQueue input;
 	
 	public:
 		Window(char* name, int width, int height);
@@ -32,6 +36,16 @@ class Window
 		void update();
 		void clear();
 
+		// Polls without swapping, so a frame can pick up input that arrived
+		// while it was being built just before it draws
+		void pollEvents();
+
+		// Unaccelerated mouse motion while the cursor is disabled; false when
+		// the platform has none
+		bool setRawMouseMotion(bool enable);
+
+		InputQueue& getInput();
+
 		void setKey(int key, bool ok);
 		void setMouseButton(int button, bool ok);
 		void setMousePos(double xpos, double ypos);
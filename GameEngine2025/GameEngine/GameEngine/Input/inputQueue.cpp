@@ -0,0 +1,64 @@
+#include "inputQueue.h"
+#include <algorithm>
+
+InputQueue::InputQueue()
+    : latchedSamples(0), oldestSample(0.0), newestSample(0.0),
+    latencySumMs(0.0), latencyFrames(0), maxLatencyMs(0.0)
+{
+}
+
+void InputQueue::push(const InputEvent& event)
+{
+    pending.push_back(event);
+}
+
+const std::vector<InputEvent>& InputQueue::latch()
+{
+    // Swapping keeps both buffers' capacity, so steady state allocates nothing
+    latched.swap(pending);
+    pending.clear();
+
+    // Only cursor samples shape the latched view; keys go through the
+    // simulation ticks, which sample them at their own rate
+    latchedSamples = 0;
+    for (const InputEvent& event : latched)
+    {
+        if (event.type != INPUT_CURSOR)
+            continue;
+        if (latchedSamples == 0)
+            oldestSample = event.time;
+        newestSample = event.time;
+        latchedSamples++;
+    }
+    return latched;
+}
+
+void InputQueue::markSubmitted(double time)
+{
+    lastLatency.samples = latchedSamples;
+    if (latchedSamples == 0)
+    {
+        lastLatency.oldestMs = lastLatency.newestMs = 0.0;
+        return;
+    }
+
+    lastLatency.oldestMs = (time - oldestSample) * 1000.0;
+    lastLatency.newestMs = (time - newestSample) * 1000.0;
+    latchedSamples = 0;
+
+    latencySumMs += lastLatency.oldestMs;
+    latencyFrames++;
+    maxLatencyMs = std::max(maxLatencyMs, lastLatency.oldestMs);
+}
+
+double InputQueue::getAverageLatencyMs() const
+{
+    return latencyFrames ? latencySumMs / latencyFrames : 0.0;
+}
+
+void InputQueue::resetLatencyStats()
+{
+    latencySumMs = 0.0;
+    latencyFrames = 0;
+    maxLatencyMs = 0.0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+
+enum InputEventType
+{
+    INPUT_KEY,
+    INPUT_MOUSE_BUTTON,
+    INPUT_CURSOR
+};
+
+// One GLFW callback, stamped with glfwGetTime() when it was delivered
+struct InputEvent
+{
+    InputEventType type;
+    double time;
+    int code;       // key or mouse button
+    int action;     // GLFW_PRESS, GLFW_REPEAT or GLFW_RELEASE
+    double x;       // cursor position; raw, unaccelerated motion when enabled
+    double y;
+};
+
+// Time from cursor samples to the submission of the frame they were latched into
+struct InputLatency
+{
+    int samples = 0;
+    double oldestMs = 0.0;      // the sample that waited longest
+    double newestMs = 0.0;
+};
+
+// Every input event since the last frame, in delivery order, so motion that
+// arrives several times a frame is applied sample by sample instead of only
+// as the last position. The frame takes the events with latch() as late as
+// it can, just before its view is built, and reports with markSubmitted()
+// once its draws are issued; the time in between is the input latency the
+// renderer adds. Main thread only, like the GLFW callbacks that fill it.
+//
+//   glfwPollEvents();
+//   for (const InputEvent& event : input.latch()) ...
+//   ...draw...
+//   input.markSubmitted(glfwGetTime());
+class InputQueue
+{
+public:
+    InputQueue();
+
+    void push(const InputEvent& event);
+
+    // Hands over everything queued since the previous latch
+    const std::vector<InputEvent>& latch();
+
+    void markSubmitted(double time);
+
+    const InputLatency& getLastLatency() const { return lastLatency; }
+    double getAverageLatencyMs() const;     // of the oldest sample, over frames that had any
+    double getMaxLatencyMs() const { return maxLatencyMs; }
+    void resetLatencyStats();
+
+private:
+    std::vector<InputEvent> pending;
+    std::vector<InputEvent> latched;
+
+    int latchedSamples;
+    double oldestSample;
+    double newestSample;
+
+    InputLatency lastLatency;
+    double latencySumMs;
+    unsigned long long latencyFrames;
+    double maxLatencyMs;
+};
@@ -0,0 +1,308 @@
+#include "transformKernel.h"
+#include "transformKernelInternal.h"
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "positions must be packed floats");
+static_assert(sizeof(glm::quat) == 4 * sizeof(float), "rotations must be packed floats");
+static_assert(sizeof(glm::mat4) == 16 * sizeof(float), "matrices must be packed floats");
+
+// ==================== CPU DETECTION ====================
+
+static bool cpuSupportsAvx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave || !avx || !fma)
+        return false;
+
+    // The OS has to save the YMM registers on context switches
+    if ((_xgetbv(0) & 0x6) != 0x6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+TransformKernelPath getBestTransformKernelPath()
+{
+    static const TransformKernelPath best =
+        (transformKernelAvx2Compiled() && cpuSupportsAvx2()) ? KERNEL_AVX2 : KERNEL_SSE;
+    return best;
+}
+
+static TransformKernelPath activePath = getBestTransformKernelPath();
+
+TransformKernelPath getTransformKernelPath()
+{
+    return activePath;
+}
+
+void setTransformKernelPath(TransformKernelPath path)
+{
+    activePath = path > getBestTransformKernelPath() ? getBestTransformKernelPath() : path;
+}
+
+const char* getTransformKernelName(TransformKernelPath path)
+{
+    switch (path)
+    {
+    case KERNEL_AVX2: return "avx2";
+    case KERNEL_SSE: return "sse";
+    default: return "scalar";
+    }
+}
+
+// ==================== PUBLIC ENTRY POINTS ====================
+
+void batchTransform(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+    const glm::mat4& viewProjection, glm::mat4* models, glm::mat4* mvps, size_t count)
+{
+    const float* p = &positions[0].x;
+    const float* r = &rotations[0].x;
+    const float* s = &scales[0].x;
+    const float* vp = &viewProjection[0][0];
+    float* m = &models[0][0][0];
+    float* mvp = mvps ? &mvps[0][0][0] : nullptr;
+
+    if (count == 0)
+        return;
+
+    switch (activePath)
+    {
+    case KERNEL_AVX2: batchTransformAvx2(p, r, s, vp, m, mvp, count); break;
+    case KERNEL_SSE: batchTransformSse(p, r, s, vp, m, mvp, count); break;
+    default: batchTransformScalar(p, r, s, vp, m, mvp, count); break;
+    }
+}
+
+void batchMultiply(const glm::mat4& viewProjection, const glm::mat4* models, glm::mat4* mvps, size_t count)
+{
+    if (count == 0)
+        return;
+
+    const float* vp = &viewProjection[0][0];
+    const float* m = &models[0][0][0];
+    float* mvp = &mvps[0][0][0];
+
+    switch (activePath)
+    {
+    case KERNEL_AVX2: batchMultiplyAvx2(vp, m, mvp, count); break;
+    case KERNEL_SSE: batchMultiplySse(vp, m, mvp, count); break;
+    default: batchMultiplyScalar(vp, m, mvp, count); break;
+    }
+}
+
+// ==================== SCALAR ====================
+
+void batchTransformScalar(const float* positions, const float* rotations, const float* scales,
+    const float* viewProjection, float* models, float* mvps, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const float* p = positions + i * 3;
+        const float* q = rotations + i * 4;
+        const float* s = scales + i * 3;
+        float* m = models + i * 16;
+
+        float x = q[0], y = q[1], z = q[2], w = q[3];
+        float xx = x * x, yy = y * y, zz = z * z;
+        float xy = x * y, xz = x * z, yz = y * z;
+        float wx = w * x, wy = w * y, wz = w * z;
+
+        m[0] = (1.0f - 2.0f * (yy + zz)) * s[0];
+        m[1] = 2.0f * (xy + wz) * s[0];
+        m[2] = 2.0f * (xz - wy) * s[0];
+        m[3] = 0.0f;
+
+        m[4] = 2.0f * (xy - wz) * s[1];
+        m[5] = (1.0f - 2.0f * (xx + zz)) * s[1];
+        m[6] = 2.0f * (yz + wx) * s[1];
+        m[7] = 0.0f;
+
+        m[8] = 2.0f * (xz + wy) * s[2];
+        m[9] = 2.0f * (yz - wx) * s[2];
+        m[10] = (1.0f - 2.0f * (xx + yy)) * s[2];
+        m[11] = 0.0f;
+
+        m[12] = p[0];
+        m[13] = p[1];
+        m[14] = p[2];
+        m[15] = 1.0f;
+
+        if (mvps)
+            batchMultiplyScalar(viewProjection, m, mvps + i * 16, 1);
+    }
+}
+
+void batchMultiplyScalar(const float* viewProjection, const float* models, float* mvps, size_t count)
+{
+    const float* a = viewProjection;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const float* b = models + i * 16;
+        float* out = mvps + i * 16;
+
+        for (int col = 0; col < 4; col++)
+        {
+            for (int row = 0; row < 4; row++)
+            {
+                out[col * 4 + row] =
+                    a[0 * 4 + row] * b[col * 4 + 0] +
+                    a[1 * 4 + row] * b[col * 4 + 1] +
+                    a[2 * 4 + row] * b[col * 4 + 2] +
+                    a[3 * 4 + row] * b[col * 4 + 3];
+            }
+        }
+    }
+}
+
+// ==================== SSE (4 objects per iteration) ====================
+
+// Splits four packed vec3 (12 floats) into x, y and z lanes
+static inline void loadVec3x4(const float* src, __m128& x, __m128& y, __m128& z)
+{
+    __m128 a = _mm_loadu_ps(src);       // x0 y0 z0 x1
+    __m128 b = _mm_loadu_ps(src + 4);   // y1 z1 x2 y2
+    __m128 c = _mm_loadu_ps(src + 8);   // z2 x3 y3 z3
+
+    __m128 xHi = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));  // x2 x2 x3 x3
+    x = _mm_shuffle_ps(a, xHi, _MM_SHUFFLE(2, 0, 3, 0));
+
+    __m128 yLo = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));  // y0 y0 y1 y1
+    __m128 yHi = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));  // y2 y2 y3 y3
+    y = _mm_shuffle_ps(yLo, yHi, _MM_SHUFFLE(2, 0, 2, 0));
+
+    __m128 zLo = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));  // z0 z0 z1 z1
+    z = _mm_shuffle_ps(zLo, c, _MM_SHUFFLE(3, 0, 2, 0));
+}
+
+void batchTransformSse(const float* positions, const float* rotations, const float* scales,
+    const float* viewProjection, float* models, float* mvps, size_t count)
+{
+    __m128 vp[16];
+    for (int i = 0; i < 16; i++)
+        vp[i] = _mm_set1_ps(viewProjection[i]);
+
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 px, py, pz, sx, sy, sz;
+        loadVec3x4(positions + i * 3, px, py, pz);
+        loadVec3x4(scales + i * 3, sx, sy, sz);
+
+        __m128 qx = _mm_loadu_ps(rotations + i * 4);
+        __m128 qy = _mm_loadu_ps(rotations + i * 4 + 4);
+        __m128 qz = _mm_loadu_ps(rotations + i * 4 + 8);
+        __m128 qw = _mm_loadu_ps(rotations + i * 4 + 12);
+        _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+        __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+        __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+        __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+        // Model matrix, one lane per object: m[column * 4 + row]
+        __m128 m[16];
+        m[0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+        m[1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+        m[2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+        m[3] = zero;
+        m[4] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+        m[5] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+        m[6] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+        m[7] = zero;
+        m[8] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+        m[9] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+        m[10] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+        m[11] = zero;
+        m[12] = px;
+        m[13] = py;
+        m[14] = pz;
+        m[15] = one;
+
+        // Transpose each column back to one vector per object and store
+        for (int col = 0; col < 4; col++)
+        {
+            __m128 r0 = m[col * 4 + 0], r1 = m[col * 4 + 1], r2 = m[col * 4 + 2], r3 = m[col * 4 + 3];
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(models + (i + 0) * 16 + col * 4, r0);
+            _mm_storeu_ps(models + (i + 1) * 16 + col * 4, r1);
+            _mm_storeu_ps(models + (i + 2) * 16 + col * 4, r2);
+            _mm_storeu_ps(models + (i + 3) * 16 + col * 4, r3);
+        }
+
+        if (!mvps)
+            continue;
+
+        // mvp[col][row] = sum_k vp[k][row] * m[col][k]; the model's last row is (0, 0, 0, 1)
+        for (int col = 0; col < 4; col++)
+        {
+            __m128 out[4];
+            for (int row = 0; row < 4; row++)
+            {
+                __m128 acc = _mm_mul_ps(vp[0 * 4 + row], m[col * 4 + 0]);
+                acc = _mm_add_ps(acc, _mm_mul_ps(vp[1 * 4 + row], m[col * 4 + 1]));
+                acc = _mm_add_ps(acc, _mm_mul_ps(vp[2 * 4 + row], m[col * 4 + 2]));
+                if (col == 3)
+                    acc = _mm_add_ps(acc, vp[3 * 4 + row]);
+                out[row] = acc;
+            }
+
+            _MM_TRANSPOSE4_PS(out[0], out[1], out[2], out[3]);
+            _mm_storeu_ps(mvps + (i + 0) * 16 + col * 4, out[0]);
+            _mm_storeu_ps(mvps + (i + 1) * 16 + col * 4, out[1]);
+            _mm_storeu_ps(mvps + (i + 2) * 16 + col * 4, out[2]);
+            _mm_storeu_ps(mvps + (i + 3) * 16 + col * 4, out[3]);
+        }
+    }
+
+    if (i < count)
+    {
+        batchTransformScalar(positions + i * 3, rotations + i * 4, scales + i * 3, viewProjection,
+            models + i * 16, mvps ? mvps + i * 16 : nullptr, count - i);
+    }
+}
+
+void batchMultiplySse(const float* viewProjection, const float* models, float* mvps, size_t count)
+{
+    __m128 a0 = _mm_loadu_ps(viewProjection);
+    __m128 a1 = _mm_loadu_ps(viewProjection + 4);
+    __m128 a2 = _mm_loadu_ps(viewProjection + 8);
+    __m128 a3 = _mm_loadu_ps(viewProjection + 12);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const float* b = models + i * 16;
+        float* out = mvps + i * 16;
+
+        for (int col = 0; col < 4; col++)
+        {
+            __m128 acc = _mm_mul_ps(a0, _mm_set1_ps(b[col * 4 + 0]));
+            acc = _mm_add_ps(acc, _mm_mul_ps(a1, _mm_set1_ps(b[col * 4 + 1])));
+            acc = _mm_add_ps(acc, _mm_mul_ps(a2, _mm_set1_ps(b[col * 4 + 2])));
+            acc = _mm_add_ps(acc, _mm_mul_ps(a3, _mm_set1_ps(b[col * 4 + 3])));
+            _mm_storeu_ps(out + col * 4, acc);
+        }
+    }
+}
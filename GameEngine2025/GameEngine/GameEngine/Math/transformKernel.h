@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+
+enum TransformKernelPath
+{
+    KERNEL_SCALAR = 0,
+    KERNEL_SSE,
+    KERNEL_AVX2
+};
+
+// Batch transform kernel.
+// Writes model = translate(position) * mat4_cast(rotation) * scale(scale) for `count`
+// objects from packed SoA arrays, and in the same pass mvp = viewProjection * model.
+// `mvps` may be null to only build model matrices. Rotations must be unit quaternions.
+void batchTransform(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+    const glm::mat4& viewProjection, glm::mat4* models, glm::mat4* mvps, size_t count);
+
+// mvps[i] = viewProjection * models[i], for objects whose model matrix is cached
+void batchMultiply(const glm::mat4& viewProjection, const glm::mat4* models, glm::mat4* mvps, size_t count);
+
+// Path picked at startup from CPUID; can be forced lower for comparisons
+TransformKernelPath getTransformKernelPath();
+void setTransformKernelPath(TransformKernelPath path);
+TransformKernelPath getBestTransformKernelPath();
+const char* getTransformKernelName(TransformKernelPath path);
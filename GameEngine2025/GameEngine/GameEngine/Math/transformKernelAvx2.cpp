@@ -0,0 +1,192 @@
+// AVX2 + FMA transform kernels (8 objects per iteration).
+// This file is built with AVX2 code generation (see the project settings) and is
+// only called after getBestTransformKernelPath() confirmed CPU support.
+#include "transformKernelInternal.h"
+
+#if defined(_MSC_VER) || defined(__AVX2__)
+
+#include <immintrin.h>
+
+bool transformKernelAvx2Compiled()
+{
+    return true;
+}
+
+static inline __m256 combine(__m128 lo, __m128 hi)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+// Splits four packed vec3 (12 floats) into x, y and z lanes
+static inline void loadVec3x4(const float* src, __m128& x, __m128& y, __m128& z)
+{
+    __m128 a = _mm_loadu_ps(src);
+    __m128 b = _mm_loadu_ps(src + 4);
+    __m128 c = _mm_loadu_ps(src + 8);
+
+    __m128 xHi = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+    x = _mm_shuffle_ps(a, xHi, _MM_SHUFFLE(2, 0, 3, 0));
+
+    __m128 yLo = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+    __m128 yHi = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+    y = _mm_shuffle_ps(yLo, yHi, _MM_SHUFFLE(2, 0, 2, 0));
+
+    __m128 zLo = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+    z = _mm_shuffle_ps(zLo, c, _MM_SHUFFLE(3, 0, 2, 0));
+}
+
+static inline void loadVec3x8(const float* src, __m256& x, __m256& y, __m256& z)
+{
+    __m128 x0, y0, z0, x1, y1, z1;
+    loadVec3x4(src, x0, y0, z0);
+    loadVec3x4(src + 12, x1, y1, z1);
+    x = combine(x0, x1);
+    y = combine(y0, y1);
+    z = combine(z0, z1);
+}
+
+// Writes one matrix column (four lane vectors = rows) for eight objects
+static inline void storeColumnx8(float* matrices, int col, __m256 r0, __m256 r1, __m256 r2, __m256 r3)
+{
+    __m128 lo0 = _mm256_castps256_ps128(r0), lo1 = _mm256_castps256_ps128(r1);
+    __m128 lo2 = _mm256_castps256_ps128(r2), lo3 = _mm256_castps256_ps128(r3);
+    __m128 hi0 = _mm256_extractf128_ps(r0, 1), hi1 = _mm256_extractf128_ps(r1, 1);
+    __m128 hi2 = _mm256_extractf128_ps(r2, 1), hi3 = _mm256_extractf128_ps(r3, 1);
+
+    _MM_TRANSPOSE4_PS(lo0, lo1, lo2, lo3);
+    _MM_TRANSPOSE4_PS(hi0, hi1, hi2, hi3);
+
+    _mm_storeu_ps(matrices + 0 * 16 + col * 4, lo0);
+    _mm_storeu_ps(matrices + 1 * 16 + col * 4, lo1);
+    _mm_storeu_ps(matrices + 2 * 16 + col * 4, lo2);
+    _mm_storeu_ps(matrices + 3 * 16 + col * 4, lo3);
+    _mm_storeu_ps(matrices + 4 * 16 + col * 4, hi0);
+    _mm_storeu_ps(matrices + 5 * 16 + col * 4, hi1);
+    _mm_storeu_ps(matrices + 6 * 16 + col * 4, hi2);
+    _mm_storeu_ps(matrices + 7 * 16 + col * 4, hi3);
+}
+
+void batchTransformAvx2(const float* positions, const float* rotations, const float* scales,
+    const float* viewProjection, float* models, float* mvps, size_t count)
+{
+    __m256 vp[16];
+    for (int i = 0; i < 16; i++)
+        vp[i] = _mm256_set1_ps(viewProjection[i]);
+
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 zero = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 px, py, pz, sx, sy, sz;
+        loadVec3x8(positions + i * 3, px, py, pz);
+        loadVec3x8(scales + i * 3, sx, sy, sz);
+
+        const float* q = rotations + i * 4;
+        __m128 a0 = _mm_loadu_ps(q), a1 = _mm_loadu_ps(q + 4), a2 = _mm_loadu_ps(q + 8), a3 = _mm_loadu_ps(q + 12);
+        __m128 b0 = _mm_loadu_ps(q + 16), b1 = _mm_loadu_ps(q + 20), b2 = _mm_loadu_ps(q + 24), b3 = _mm_loadu_ps(q + 28);
+        _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+        _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+        __m256 qx = combine(a0, b0), qy = combine(a1, b1), qz = combine(a2, b2), qw = combine(a3, b3);
+
+        __m256 xx = _mm256_mul_ps(qx, qx), yy = _mm256_mul_ps(qy, qy), zz = _mm256_mul_ps(qz, qz);
+        __m256 xy = _mm256_mul_ps(qx, qy), xz = _mm256_mul_ps(qx, qz), yz = _mm256_mul_ps(qy, qz);
+        __m256 wx = _mm256_mul_ps(qw, qx), wy = _mm256_mul_ps(qw, qy), wz = _mm256_mul_ps(qw, qz);
+
+        __m256 m[16];
+        m[0] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one), sx);
+        m[1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+        m[2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+        m[3] = zero;
+        m[4] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+        m[5] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one), sy);
+        m[6] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+        m[7] = zero;
+        m[8] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+        m[9] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+        m[10] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one), sz);
+        m[11] = zero;
+        m[12] = px;
+        m[13] = py;
+        m[14] = pz;
+        m[15] = one;
+
+        for (int col = 0; col < 4; col++)
+            storeColumnx8(models + i * 16, col, m[col * 4 + 0], m[col * 4 + 1], m[col * 4 + 2], m[col * 4 + 3]);
+
+        if (!mvps)
+            continue;
+
+        for (int col = 0; col < 4; col++)
+        {
+            __m256 out[4];
+            for (int row = 0; row < 4; row++)
+            {
+                __m256 acc = _mm256_mul_ps(vp[0 * 4 + row], m[col * 4 + 0]);
+                acc = _mm256_fmadd_ps(vp[1 * 4 + row], m[col * 4 + 1], acc);
+                acc = _mm256_fmadd_ps(vp[2 * 4 + row], m[col * 4 + 2], acc);
+                if (col == 3)
+                    acc = _mm256_add_ps(acc, vp[3 * 4 + row]);
+                out[row] = acc;
+            }
+            storeColumnx8(mvps + i * 16, col, out[0], out[1], out[2], out[3]);
+        }
+    }
+
+    // Remaining objects go through the 4-wide path (and its scalar tail)
+    if (i < count)
+    {
+        batchTransformSse(positions + i * 3, rotations + i * 4, scales + i * 3, viewProjection,
+            models + i * 16, mvps ? mvps + i * 16 : nullptr, count - i);
+    }
+}
+
+void batchMultiplyAvx2(const float* viewProjection, const float* models, float* mvps, size_t count)
+{
+    // Each register holds a view-projection column twice, so two output columns
+    // are produced per multiply-add chain
+    __m128 c0 = _mm_loadu_ps(viewProjection), c1 = _mm_loadu_ps(viewProjection + 4);
+    __m128 c2 = _mm_loadu_ps(viewProjection + 8), c3 = _mm_loadu_ps(viewProjection + 12);
+    __m256 a0 = combine(c0, c0), a1 = combine(c1, c1), a2 = combine(c2, c2), a3 = combine(c3, c3);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const float* b = models + i * 16;
+        float* out = mvps + i * 16;
+
+        for (int col = 0; col < 4; col += 2)
+        {
+            const float* lo = b + col * 4;
+            const float* hi = b + (col + 1) * 4;
+
+            __m256 acc = _mm256_mul_ps(a0, combine(_mm_set1_ps(lo[0]), _mm_set1_ps(hi[0])));
+            acc = _mm256_fmadd_ps(a1, combine(_mm_set1_ps(lo[1]), _mm_set1_ps(hi[1])), acc);
+            acc = _mm256_fmadd_ps(a2, combine(_mm_set1_ps(lo[2]), _mm_set1_ps(hi[2])), acc);
+            acc = _mm256_fmadd_ps(a3, combine(_mm_set1_ps(lo[3]), _mm_set1_ps(hi[3])), acc);
+            _mm256_storeu_ps(out + col * 4, acc);
+        }
+    }
+}
+
+#else
+
+// Built without AVX2 support: never selected at runtime
+bool transformKernelAvx2Compiled()
+{
+    return false;
+}
+
+void batchTransformAvx2(const float* positions, const float* rotations, const float* scales,
+    const float* viewProjection, float* models, float* mvps, size_t count)
+{
+    batchTransformSse(positions, rotations, scales, viewProjection, models, mvps, count);
+}
+
+void batchMultiplyAvx2(const float* viewProjection, const float* models, float* mvps, size_t count)
+{
+    batchMultiplySse(viewProjection, models, mvps, count);
+}
+
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+
+// Raw float entry points of the transform kernels. The AVX2 translation unit is
+// compiled with a different instruction set, so it only sees plain float arrays
+// and never instantiates glm inline code that could leak into other objects.
+// Layouts: positions/scales 3 floats, rotations 4 floats (x, y, z, w), matrices 16
+// floats column-major.
+
+void batchTransformScalar(const float* positions, const float* rotations, const float* scales,
+    const float* viewProjection, float* models, float* mvps, size_t count);
+void batchTransformSse(const float* positions, const float* rotations, const float* scales,
+    const float* viewProjection, float* models, float* mvps, size_t count);
+void batchTransformAvx2(const float* positions, const float* rotations, const float* scales,
+    const float* viewProjection, float* models, float* mvps, size_t count);
+
+void batchMultiplyScalar(const float* viewProjection, const float* models, float* mvps, size_t count);
+void batchMultiplySse(const float* viewProjection, const float* models, float* mvps, size_t count);
+void batchMultiplyAvx2(const float* viewProjection, const float* models, float* mvps, size_t count);
+
+// False when the AVX2 unit was built without AVX2 code generation
+bool transformKernelAvx2Compiled();
@@ -1,8 +1,16 @@
 #include "mesh.h"
+#include "../Graphics/gpuUpload.h"
+#include "../Graphics/glStateCache.h"
+#include "../Graphics/renderStats.h"
+#include <cstdio>
 
-Mesh::Mesh() {}
+Mesh::Mesh()
+	: vao(0), vbo(0), ibo(0), samplerProgram(0)
+{
+}
 
 Mesh::Mesh(std::vector<Vertex> vertices, std::vector<int> indices)
+	: samplerProgram(0)
 {
 	this->vertices = vertices;
 	this->indices = indices;
@@ -11,6 +19,7 @@ Mesh::Mesh(std::vector<Vertex> vertices, std::vector<int> indices)
 }
 
 Mesh::Mesh(std::vector<Vertex> vertices, std::vector<int> indices, std::vector<Texture> textures)
+	: samplerProgram(0)
 {
 	this->vertices = vertices;
 	this->indices = indices;
@@ -19,54 +28,88 @@ Mesh::Mesh(std::vector<Vertex> vertices, std::vector<int> indices, std::vector<T
 	setup();
 }
 
-// render the mesh
-void Mesh::draw(Shader shader)
+// Sampler names are texture_diffuse1, texture_diffuse2, ..., numbered per type
+void Mesh::findSamplerLocations(unsigned int program)
 {
 	unsigned int diffuseNr = 1;
 	unsigned int specularNr = 1;
 	unsigned int normalNr = 1;
 	unsigned int heightNr = 1;
 
+	// Names go into a stack buffer: meshes drawn by both the impostor baker
+	// and the scene look them up again on every switch, mid-frame
+	char uniformName[64];
+	samplerLocations.resize(textures.size());
 	for (unsigned int i = 0; i < textures.size(); i++)
 	{
-		glActiveTexture(GL_TEXTURE0 + i);
-
-		std::string number;
-		std::string name = textures[i].type;
+		unsigned int number = 0;
+		const std::string& name = textures[i].type;
 		if (name == "texture_diffuse")
-			number = std::to_string(diffuseNr++);
+			number = diffuseNr++;
 		else if (name == "texture_specular")
-			number = std::to_string(specularNr++);
+			number = specularNr++;
 		else if (name == "texture_normal")
-			number = std::to_string(normalNr++);
+			number = normalNr++;
 		else if (name == "texture_height")
-			number = std::to_string(heightNr++);
+			number = heightNr++;
 
-		glUniform1i(glGetUniformLocation(shader.getId(), (name + number).c_str()), i);
-		glBindTexture(GL_TEXTURE_2D, textures[i].id);
+		if (number > 0)
+			snprintf(uniformName, sizeof(uniformName), "%s%u", name.c_str(), number);
+		else
+			snprintf(uniformName, sizeof(uniformName), "%s", name.c_str());
+		samplerLocations[i] = glGetUniformLocation(program, uniformName);
 	}
+	samplerProgram = program;
+}
 
-	glBindVertexArray(vao);
-	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
+// render the mesh
+void Mesh::draw(Shader& shader)
+{
+	GlStateCache& state = GlStateCache::getInstance();
+
+	// Names are only built when the program or the textures change, not per draw
+	if (samplerProgram != (unsigned int)shader.getId() || samplerLocations.size() != textures.size())
+		findSamplerLocations(shader.getId());
+
+	for (unsigned int i = 0; i < textures.size(); i++)
+	{
+		glUniform1i(samplerLocations[i], i);
+		state.bindTexture(i, GL_TEXTURE_2D, textures[i].id);
+	}
 
-	glActiveTexture(GL_TEXTURE0);
+	// Stays bound, so drawing the same mesh again costs no bind
+	state.bindVertexArray(vao);
+	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+	RenderStats::getInstance().countDraw(GL_TRIANGLES, indices.size());
 }
 
 void Mesh::setup()
 {
+	// CPU-only meshes (loader benchmarks) keep their data without GL buffers
+	if (!isGpuUploadEnabled())
+	{
+		vao = vbo = ibo = 0;
+		return;
+	}
+
+	// Sized while uploading, so the first draw of a streamed-in mesh only fills it in
+	samplerLocations.assign(textures.size(), -1);
+
 	//create buffers
 	glGenVertexArrays(1, &vao);
 	glGenBuffers(1, &vbo);
 	glGenBuffers(1, &ibo);
 
 	//bind buffers
-	glBindVertexArray(vao);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	GlStateCache& state = GlStateCache::getInstance();
+	state.bindVertexArray(vao);
+	state.bindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+	RenderStats::getInstance().countUpload(vertices.size() * sizeof(Vertex));
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+	RenderStats::getInstance().countUpload(indices.size() * sizeof(unsigned int));
 
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
@@ -76,42 +119,86 @@ void Mesh::setup()
 
 	glEnableVertexAttribArray(2);
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, textureCoords));
-
-	glBindVertexArray(0);
 }
 
 //no textures yet
 void Mesh::setup2()
 {
+	if (!isGpuUploadEnabled())
+	{
+		vao = vbo = ibo = 0;
+		return;
+	}
+
 	glGenVertexArrays(1, &vao);
 	glGenBuffers(1, &vbo);
 	glGenBuffers(1, &ibo);
 
-	glBindVertexArray(vao);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	GlStateCache& state = GlStateCache::getInstance();
+	state.bindVertexArray(vao);
+	state.bindBuffer(GL_ARRAY_BUFFER, vbo);
 
 	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+	RenderStats::getInstance().countUpload(vertices.size() * sizeof(Vertex));
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+	RenderStats::getInstance().countUpload(indices.size() * sizeof(unsigned int));
 
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-
-	glBindVertexArray(0);
 }
 
 void Mesh::setTextures(std::vector<Texture> textures)
 {
 	this->textures = textures;
+	samplerProgram = 0;
 	setup();
 }
 
-void Mesh::drawPoints(Shader shader)
+void Mesh::drawPoints(Shader& shader)
 {
-	glBindVertexArray(vao);
+	GlStateCache::getInstance().bindVertexArray(vao);
 	glDrawElements(GL_POINTS, indices.size(), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
+	RenderStats::getInstance().countDraw(GL_POINTS, indices.size());
+}
+
+void Mesh::drawDepth()
+{
+	GlStateCache::getInstance().bindVertexArray(vao);
+	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+	RenderStats::getInstance().countDraw(GL_TRIANGLES, indices.size());
+}
+
+void Mesh::release()
+{
+	if (vao)
+	{
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(1, &vbo);
+		glDeleteBuffers(1, &ibo);
+
+		GlStateCache& state = GlStateCache::getInstance();
+		state.forgetVertexArray(vao);
+		state.forgetBuffer(vbo);
+		state.forgetBuffer(ibo);
+	}
+	vao = vbo = ibo = 0;
+	samplerProgram = 0;
+
+	// swap rather than clear() so the capacity goes too
+	std::vector<Vertex>().swap(vertices);
+	std::vector<int>().swap(indices);
+}
+
+size_t Mesh::getCpuBytes() const
+{
+	return vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(int);
+}
+
+size_t Mesh::getGpuBytes() const
+{
+	return vao ? vertices.size() * sizeof(Vertex) + indices.size() * sizeof(int) : 0;
 }
 
 Mesh::~Mesh() {}
\ No newline at end of file
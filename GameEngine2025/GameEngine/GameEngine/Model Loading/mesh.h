@@ -73,6 +73,10 @@ public:
 
 	unsigned int vao, vbo, ibo;
 
+	// Sampler uniform of each texture, looked up for samplerProgram
+	std::vector<int> samplerLocations;
+	unsigned int samplerProgram;
+
 	Mesh();
 	Mesh(std::vector<Vertex> vertices, std::vector<int> indices, std::vector<Texture> textures);
 	Mesh(std::vector<Vertex> vertices, std::vector<int> indices);
@@ -81,6 +85,17 @@ public:
 	void setTextures(std::vector<Texture> textures);
 	void setup();
 	void setup2();
-	void draw(Shader shader);
-	void drawPoints(Shader shader); // Draw as points for stars
+	void draw(Shader& shader);
+	void drawPoints(Shader& shader); // Draw as points for stars
+	void drawDepth(); // Geometry only, no textures (shadow casters)
+
+	// Frees the vertex data and GL buffers; the mesh draws nothing until it is filled and set up again
+	void release();
+
+	// Memory held by the CPU copy and by the GL buffers
+	size_t getCpuBytes() const;
+	size_t getGpuBytes() const;
+
+private:
+	void findSamplerLocations(unsigned int program);
 };
\ No newline at end of file
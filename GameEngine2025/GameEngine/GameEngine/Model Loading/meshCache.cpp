@@ -0,0 +1,80 @@
+#include "meshCache.h"
+#include "../Core/mappedFile.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const uint32_t MESH_CACHE_MAGIC = 0x48534D43;   // "CMSH"
+static const uint32_t MESH_CACHE_VERSION = 1;
+
+struct MeshCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexSize;    // sizeof(Vertex) when written; guards against layout changes
+    uint32_t vertexCount;
+    uint32_t indexCount;
+};
+
+static std::string cachePath(const std::string& modelPath)
+{
+    return modelPath + ".meshcache";
+}
+
+bool readMeshCache(const std::string& modelPath, std::vector<Vertex>& vertices, std::vector<int>& indices)
+{
+    std::string path = cachePath(modelPath);
+    long long cacheTime = getFileModificationTime(path);
+    if (cacheTime < 0 || cacheTime < getFileModificationTime(modelPath))
+        return false;
+
+    MappedFile file;
+    if (!file.open(path) || file.getSize() < sizeof(MeshCacheHeader))
+        return false;
+
+    MeshCacheHeader header;
+    memcpy(&header, file.getData(), sizeof(header));
+    if (header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_VERSION || header.vertexSize != sizeof(Vertex) ||
+        file.getSize() != sizeof(header) + (unsigned long long)header.vertexCount * sizeof(Vertex) +
+        (unsigned long long)header.indexCount * sizeof(int))
+    {
+        std::cout << "Warning: ignoring outdated mesh cache " << path << std::endl;
+        return false;
+    }
+
+    const unsigned char* data = file.getData() + sizeof(header);
+    vertices.resize(header.vertexCount);
+    indices.resize(header.indexCount);
+    if (header.vertexCount)
+        memcpy(&vertices[0], data, header.vertexCount * sizeof(Vertex));
+    if (header.indexCount)
+        memcpy(&indices[0], data + header.vertexCount * sizeof(Vertex), header.indexCount * sizeof(int));
+    return true;
+}
+
+bool writeMeshCache(const std::string& modelPath, const std::vector<Vertex>& vertices, const std::vector<int>& indices)
+{
+    std::string path = cachePath(modelPath);
+    std::ofstream out(path.c_str(), std::ios::binary);
+    if (!out)
+        return false;
+
+    MeshCacheHeader header = { MESH_CACHE_MAGIC, MESH_CACHE_VERSION, (uint32_t)sizeof(Vertex),
+        (uint32_t)vertices.size(), (uint32_t)indices.size() };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!vertices.empty())
+        out.write(reinterpret_cast<const char*>(&vertices[0]), vertices.size() * sizeof(Vertex));
+    if (!indices.empty())
+        out.write(reinterpret_cast<const char*>(&indices[0]), indices.size() * sizeof(int));
+
+    if (!out)
+    {
+        // A half-written cache would only be rejected later; drop it now
+        out.close();
+        std::remove(path.c_str());
+        return false;
+    }
+    return true;
+}
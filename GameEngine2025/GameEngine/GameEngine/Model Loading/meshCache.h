@@ -0,0 +1,11 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "mesh.h"
+
+// Parsed vertex and index arrays dumped next to their source model
+// (<model>.meshcache), so reloading an evicted mesh is a memcpy instead of
+// an OBJ parse. A cache older than its model is ignored.
+
+bool readMeshCache(const std::string& modelPath, std::vector<Vertex>& vertices, std::vector<int>& indices);
+bool writeMeshCache(const std::string& modelPath, const std::vector<Vertex>& vertices, const std::vector<int>& indices);
@@ -3,17 +3,17 @@
 
 MeshLoaderObj::MeshLoaderObj() {};
 
-Mesh MeshLoaderObj::loadObj(const std::string &filename)
+bool MeshLoaderObj::parseObj(const std::string &filename, std::vector<Vertex> &vertices, std::vector<int> &indices)
 {
-	std::vector<Vertex> vertices;
-	std::vector<int> indices;
+	vertices.clear();
+	indices.clear();
 
 	//Reading Obj file
 	std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
 	if (!file.good())
 	{
 		std::cout << "Obj model not found " << filename << std::endl;
-		std::terminate();
+		return false;
 	}
 
 	std::string line;
@@ -150,6 +150,16 @@ Mesh MeshLoaderObj::loadObj(const std::string &filename)
 
 	std::cout << "Loading:  " << filename << std::endl;
 
+	return true;
+}
+
+Mesh MeshLoaderObj::loadObj(const std::string &filename)
+{
+	std::vector<Vertex> vertices;
+	std::vector<int> indices;
+	if (!parseObj(filename, vertices, indices))
+		std::terminate();
+
 	Mesh mesh(vertices, indices);
 
 	return mesh;
@@ -14,5 +14,8 @@ class MeshLoaderObj
 		MeshLoaderObj();
 		Mesh loadObj(const std::string &filename, std::vector<Texture> textures);
 		Mesh loadObj(const std::string &filename);
+
+		// CPU side only: fills the arrays without creating GL buffers. Returns false when the file is missing
+		bool parseObj(const std::string &filename, std::vector<Vertex> &vertices, std::vector<int> &indices);
 };
 
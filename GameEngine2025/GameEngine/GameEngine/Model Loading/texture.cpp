@@ -1,63 +1,79 @@
 #include "texture.h"
+#include "../Graphics/gpuUpload.h"
+#include "../Graphics/glStateCache.h"
+#include "../Graphics/renderStats.h"
+#include <cstring>
 #include <iostream>
 
-GLuint loadBMP(const char * imagepath) {
-
-	printf("Reading image %s\n", imagepath);
+bool decodeBMP(const char * imagepath, ImageData& image) {
 
 	unsigned char header[54];
 	unsigned int dataPos;
 	unsigned int imageSize;
-	unsigned int width, height;
-
-	unsigned char * data;
 
 	FILE * file;
 	errno_t err = fopen_s(&file, imagepath, "rb");
 	if (err)
 	{
-		printf("%s could not be opened.", imagepath); getchar(); return 0;
+		printf("%s could not be opened.\n", imagepath); return false;
 	}
 
 	if (fread(header, 1, 54, file) != 54) {
 		printf("Not a correct BMP file\n");
-		return 0;
+		fclose(file);
+		return false;
 	}
 
 	// Parsing BMP file
 	if (header[0] != 'B' || header[1] != 'M') {
 		printf("Not a correct BMP file\n");
-		return 0;
+		fclose(file);
+		return false;
 	}
 
-	if (*(int*)&(header[0x1E]) != 0) { printf("Not a correct BMP file\n");    return 0; }
-	if (*(int*)&(header[0x1C]) != 24) { printf("Not a correct BMP file\n");    return 0; }
+	if (*(int*)&(header[0x1E]) != 0) { printf("Not a correct BMP file\n"); fclose(file); return false; }
+	if (*(int*)&(header[0x1C]) != 24) { printf("Not a correct BMP file\n"); fclose(file); return false; }
 
 	dataPos = *(int*)&(header[0x0A]);
 	imageSize = *(int*)&(header[0x22]);
-	width = *(int*)&(header[0x12]);
-	height = *(int*)&(header[0x16]);
+	image.width = *(int*)&(header[0x12]);
+	image.height = *(int*)&(header[0x16]);
 
-	if (imageSize == 0)    imageSize = width*height * 3; 
-	if (dataPos == 0)      dataPos = 54; 
+	if (imageSize == 0)    imageSize = image.width*image.height * 3;
+	if (dataPos == 0)      dataPos = 54;
 
-										
-	data = new unsigned char[imageSize];
+	image.pixels.resize(imageSize);
 
 	// Read data into buffer
-	fread(data, 1, imageSize, file);
+	fseek(file, dataPos, SEEK_SET);
+	size_t bytesRead = fread(image.pixels.data(), 1, imageSize, file);
 
 	fclose(file);
 
+	if (bytesRead != imageSize) {
+		printf("%s is truncated\n", imagepath);
+		return false;
+	}
+	return true;
+}
+
+GLuint uploadTexture(const ImageData& image) {
+
+	// Upload disabled (loader benchmarks): hand out distinct placeholder ids
+	if (!isGpuUploadEnabled())
+	{
+		static GLuint placeholderId = 0;
+		return ++placeholderId;
+	}
+
 	// Create OpenGL texture
 	GLuint textureID;
 	glGenTextures(1, &textureID);
 
-	glBindTexture(GL_TEXTURE_2D, textureID);
+	GlStateCache::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
 
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, data);
-
-	delete[] data;
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.width, image.height, 0, GL_BGR, GL_UNSIGNED_BYTE, image.pixels.data());
+	RenderStats::getInstance().countUpload(image.pixels.size());
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -67,4 +83,161 @@ GLuint loadBMP(const char * imagepath) {
 
 	// Return the ID of the texture
 	return textureID;
-}
\ No newline at end of file
+}
+
+static unsigned int rowStride(unsigned int width)
+{
+	return (width * 3 + 3) & ~3u;
+}
+
+void buildMipChain(ImageData& image, std::vector<ImageData>& levels)
+{
+	levels.clear();
+	levels.push_back(ImageData());
+	levels[0].width = image.width;
+	levels[0].height = image.height;
+	levels[0].pixels.swap(image.pixels);
+
+	// Headers that leave out the size give unpadded rows; those stay single-level
+	if (levels[0].pixels.size() < (size_t)rowStride(image.width) * image.height)
+		return;
+
+	while (levels.back().width > 1 || levels.back().height > 1)
+	{
+		const ImageData& source = levels.back();
+		ImageData next;
+		next.width = source.width > 1 ? source.width / 2 : 1;
+		next.height = source.height > 1 ? source.height / 2 : 1;
+		next.pixels.resize((size_t)rowStride(next.width) * next.height);
+
+		unsigned int sourceStride = rowStride(source.width);
+		unsigned int stride = rowStride(next.width);
+		unsigned int stepX = source.width > 1 ? 2 : 1;
+		unsigned int stepY = source.height > 1 ? 2 : 1;
+
+		// Average of each 2x2 block (1x2 / 2x1 once one side reaches 1)
+		for (unsigned int y = 0; y < next.height; y++)
+		{
+			const unsigned char* row0 = &source.pixels[(size_t)(y * stepY) * sourceStride];
+			const unsigned char* row1 = &source.pixels[(size_t)(y * stepY + stepY - 1) * sourceStride];
+			unsigned char* out = &next.pixels[(size_t)y * stride];
+			for (unsigned int x = 0; x < next.width; x++)
+			{
+				unsigned int a = x * stepX * 3;
+				unsigned int b = (x * stepX + stepX - 1) * 3;
+				for (int c = 0; c < 3; c++)
+					out[x * 3 + c] = (unsigned char)((row0[a + c] + row0[b + c] + row1[a + c] + row1[b + c] + 2) / 4);
+			}
+		}
+		levels.push_back(next);
+	}
+}
+
+GLuint uploadTextureLevels(const std::vector<ImageData>& levels, int firstLevel)
+{
+	// Upload disabled: placeholder ids, kept apart from uploadTexture's
+	if (!isGpuUploadEnabled())
+	{
+		static GLuint placeholderId = 0x10000;
+		return ++placeholderId;
+	}
+
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	GlStateCache::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
+
+	for (int level = firstLevel; level < (int)levels.size(); level++)
+	{
+		const ImageData& image = levels[level];
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGB, image.width, image.height, 0, GL_BGR, GL_UNSIGNED_BYTE, image.pixels.data());
+		RenderStats::getInstance().countUpload(image.pixels.size());
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, firstLevel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levels.size() - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	return textureID;
+}
+
+TextureLevelUpload beginTextureLevelUpload(GLuint texture, int level, const ImageData& image)
+{
+	TextureLevelUpload upload = { 0, nullptr };
+	if (!isGpuUploadEnabled())
+		return upload;
+
+	GLsizeiptr size = (GLsizeiptr)image.pixels.size();
+	GlStateCache& state = GlStateCache::getInstance();
+	glGenBuffers(1, &upload.pbo);
+	state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.pbo);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (mapped)
+	{
+		memcpy(mapped, image.pixels.data(), (size_t)size);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		RenderStats::getInstance().countUpload((size_t)size);
+
+		// Sources from the bound buffer; returns without waiting for the copy
+		state.bindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGB, image.width, image.height, 0, GL_BGR, GL_UNSIGNED_BYTE, (const void*)0);
+	}
+	// Other uploads pass client memory, which a bound unpack buffer would redirect
+	state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	upload.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	return upload;
+}
+
+bool finishTextureLevelUpload(TextureLevelUpload& upload, bool abandon)
+{
+	if (upload.fence && !abandon)
+	{
+		GLenum status = glClientWaitSync(upload.fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			return false;
+	}
+
+	if (upload.fence)
+		glDeleteSync(upload.fence);
+	if (upload.pbo)
+	{
+		glDeleteBuffers(1, &upload.pbo);
+		GlStateCache::getInstance().forgetBuffer(upload.pbo);
+	}
+	upload.fence = nullptr;
+	upload.pbo = 0;
+	return true;
+}
+
+void setTextureBaseLevel(GLuint texture, int level)
+{
+	if (!isGpuUploadEnabled())
+		return;
+
+	GlStateCache::getInstance().bindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+}
+
+void releaseTextureLevel(GLuint texture, int level)
+{
+	if (!isGpuUploadEnabled())
+		return;
+
+	// A zero-size image lets the driver drop the level's storage
+	GlStateCache::getInstance().bindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, level, GL_RGB, 0, 0, 0, GL_BGR, GL_UNSIGNED_BYTE, nullptr);
+}
+
+GLuint loadBMP(const char * imagepath) {
+
+	printf("Reading image %s\n", imagepath);
+
+	ImageData image;
+	if (!decodeBMP(imagepath, image))
+		return 0;
+
+	return uploadTexture(image);
+}
@@ -2,4 +2,44 @@
 #include <glew.h>
 #include <glfw3.h>
 
+#include <vector>
+
+// Decoded 24-bit image, rows bottom-up in BGR order as stored in the file
+struct ImageData
+{
+	unsigned int width;
+	unsigned int height;
+	std::vector<unsigned char> pixels;
+};
+
+bool decodeBMP(const char * imagepath, ImageData& image);
+GLuint uploadTexture(const ImageData& image);
+
+// ---- Mip streaming ----
+
+// Box-filtered mip chain, level 0 (the image itself, moved in) first. Every
+// level keeps the BMP row layout, rows padded to 4 bytes.
+void buildMipChain(ImageData& image, std::vector<ImageData>& levels);
+
+// Texture holding only levels [firstLevel, last], with GL_TEXTURE_BASE_LEVEL
+// clamped to firstLevel so sampling never touches the undefined finer ones
+GLuint uploadTextureLevels(const std::vector<ImageData>& levels, int firstLevel);
+
+// One level uploaded through a pixel buffer object: the driver copies from
+// the buffer in the background and the fence tells when it is done
+struct TextureLevelUpload
+{
+	GLuint pbo;
+	GLsync fence;
+};
+
+TextureLevelUpload beginTextureLevelUpload(GLuint texture, int level, const ImageData& image);
+// True once the GPU has the data; frees the buffer and fence then (or at once when abandon is set)
+bool finishTextureLevelUpload(TextureLevelUpload& upload, bool abandon = false);
+
+void setTextureBaseLevel(GLuint texture, int level);
+// Frees a level that is no longer sampled (base level already above it)
+void releaseTextureLevel(GLuint texture, int level);
+
+// decodeBMP + uploadTexture; returns 0 on failure
 GLuint loadBMP(const char * imagepath);
@@ -0,0 +1,102 @@
+#include "particleRenderer.h"
+#include "../Core/profiler.h"
+#include "../Graphics/gpuUpload.h"
+#include "../Graphics/glStateCache.h"
+#include "../Graphics/renderStats.h"
+
+ParticleRenderer::ParticleRenderer()
+    : vao(0), instanceBuffer(0), drawCallsLastFrame(0)
+{
+}
+
+ParticleRenderer::~ParticleRenderer()
+{
+    GlStateCache& state = GlStateCache::getInstance();
+    if (instanceBuffer)
+    {
+        glDeleteBuffers(1, &instanceBuffer);
+        state.forgetBuffer(instanceBuffer);
+    }
+    if (vao)
+    {
+        glDeleteVertexArrays(1, &vao);
+        state.forgetVertexArray(vao);
+    }
+}
+
+void ParticleRenderer::render(ParticleSystem& particles, const glm::mat4& projectionMatrix,
+    const glm::mat4& viewMatrix, const glm::vec3& cameraPos, Shader& shader)
+{
+    PROFILE_SCOPE("renderParticles");
+    PROFILE_GPU_SCOPE("renderParticles");
+
+    drawCallsLastFrame = 0;
+    if (!isGpuUploadEnabled() || particles.getParticleCount() == 0)
+        return;
+
+    if (!vao)
+    {
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &instanceBuffer);
+    }
+
+    // Rows of the view rotation are the camera axes in world space
+    glm::vec3 right(viewMatrix[0][0], viewMatrix[1][0], viewMatrix[2][0]);
+    glm::vec3 up(viewMatrix[0][1], viewMatrix[1][1], viewMatrix[2][1]);
+    glm::vec3 viewDirection(-viewMatrix[0][2], -viewMatrix[1][2], -viewMatrix[2][2]);
+
+    shader.use();
+    glm::mat4 viewProjection = projectionMatrix * viewMatrix;
+    glUniformMatrix4fv(glGetUniformLocation(shader.getId(), "viewProjection"), 1, GL_FALSE, &viewProjection[0][0]);
+    glUniform3fv(glGetUniformLocation(shader.getId(), "cameraRight"), 1, &right.x);
+    glUniform3fv(glGetUniformLocation(shader.getId(), "cameraUp"), 1, &up.x);
+
+    GlStateCache& state = GlStateCache::getInstance();
+    RenderStats& stats = RenderStats::getInstance();
+    state.setEnabled(GL_BLEND, true);
+    state.setDepthMask(false);
+    state.bindVertexArray(vao);
+    state.bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(0, 1);
+    glVertexAttribDivisor(1, 1);
+
+    for (uint32_t id = 0; id < particles.getEmitterSlots(); id++)
+    {
+        ParticleEmitter* emitter = particles.getEmitter(id);
+        if (!emitter || emitter->getCount() == 0)
+            continue;
+
+        // Centres, then colours; orphaned every draw so the driver never
+        // waits for the GPU to finish with the previous contents
+        size_t capacity = emitter->getInstanceCapacity();
+        size_t colorOffset = capacity * sizeof(glm::vec4);
+        size_t bytes = colorOffset + capacity * sizeof(uint32_t);
+        glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        char* mapped = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (!mapped)
+            continue;
+
+        ParticleInstances instances = { (glm::vec4*)mapped, (uint32_t*)(mapped + colorOffset) };
+        emitter->writeInstances(instances, cameraPos, viewDirection, particles.getPool());
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        stats.countUpload(bytes);
+
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(uint32_t), (void*)colorOffset);
+
+        if (emitter->getDesc().additive)
+            state.setBlendFunc(GL_SRC_ALPHA, GL_ONE);
+        else
+            state.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, emitter->getCount());
+        stats.countDraw(GL_TRIANGLE_STRIP, 4, emitter->getCount());
+        drawCallsLastFrame++;
+    }
+
+    state.setDepthMask(true);
+    state.setEnabled(GL_BLEND, false);
+}
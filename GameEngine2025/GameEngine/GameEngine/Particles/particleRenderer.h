@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <glew.h>
+#include <glm.hpp>
+#include "particleSystem.h"
+#include "../Shaders/shader.h"
+
+// Draws every emitter of a ParticleSystem as camera-facing quads, with one
+// instanced draw call per emitter. Instances are written by the emitter
+// kernels straight into a mapped stream buffer; the quad corners come from
+// the vertex index, so there is no vertex buffer. Main thread only.
+class ParticleRenderer
+{
+public:
+    ParticleRenderer();
+    ~ParticleRenderer();
+
+    // Blends over the opaque scene without writing depth; call it last
+    void render(ParticleSystem& particles, const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix,
+        const glm::vec3& cameraPos, Shader& shader);
+
+    unsigned int getDrawCallsLastFrame() const { return drawCallsLastFrame; }
+
+private:
+    ParticleRenderer(const ParticleRenderer&) = delete;
+    ParticleRenderer& operator=(const ParticleRenderer&) = delete;
+
+    GLuint vao;
+    GLuint instanceBuffer;
+    unsigned int drawCallsLastFrame;
+};
@@ -0,0 +1,308 @@
+#include "particleSystem.h"
+#include "../Core/frameArena.h"
+#include <algorithm>
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+// Particles per block of the parallel kernels; a multiple of the SSE width
+static const uint32_t PARTICLE_GRAIN = 16384;
+
+static uint32_t roundUpToVector(uint32_t value)
+{
+    return (value + 3) & ~3u;
+}
+
+// ==================== SSE HELPERS ====================
+
+// Four independent xorshift32 generators
+static inline __m128i nextRandom(__m128i& state)
+{
+    state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+    state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+    state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+    return state;
+}
+
+// Uniform in [0, 1): the top 23 bits as the mantissa of a float in [1, 2)
+static inline __m128 randomUnit(__m128i& state)
+{
+    __m128i bits = _mm_or_si128(_mm_srli_epi32(nextRandom(state), 9), _mm_set1_epi32(0x3F800000));
+    return _mm_sub_ps(_mm_castsi128_ps(bits), _mm_set1_ps(1.0f));
+}
+
+// Uniform in [center - spread, center + spread)
+static inline __m128 randomAround(__m128i& state, float center, float spread)
+{
+    __m128 signedUnit = _mm_sub_ps(_mm_mul_ps(randomUnit(state), _mm_set1_ps(2.0f)), _mm_set1_ps(1.0f));
+    return _mm_add_ps(_mm_set1_ps(center), _mm_mul_ps(signedUnit, _mm_set1_ps(spread)));
+}
+
+static inline __m128 lerp(float from, float to, __m128 t)
+{
+    return _mm_add_ps(_mm_set1_ps(from), _mm_mul_ps(_mm_set1_ps(to - from), t));
+}
+
+// Colour channel in [0, 1] to an integer in [0, 255] per lane
+static inline __m128i toByte(__m128 value)
+{
+    value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(255.0f)));
+}
+
+static inline uint32_t toByte(float value)
+{
+    return (uint32_t)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+static inline uint32_t packColor(const glm::vec4& color)
+{
+    return toByte(color.x) | (toByte(color.y) << 8) | (toByte(color.z) << 16) | (toByte(color.w) << 24);
+}
+
+// ==================== EMITTER ====================
+
+ParticleEmitter::ParticleEmitter(const ParticleEmitterDesc& emitterDesc)
+    : desc(emitterDesc)
+{
+    desc.minLifetime = std::max(desc.minLifetime, 1.0e-3f);
+    desc.maxLifetime = std::max(desc.maxLifetime, desc.minLifetime);
+
+    // Room for the last vector of a spawn that starts just below the limit
+    uint32_t capacity = roundUpToVector(desc.maxParticles) + 4;
+    std::vector<float>* arrays[] = { &positionsX, &positionsY, &positionsZ, &velocitiesX, &velocitiesY,
+        &velocitiesZ, &ages, &inverseLifetimes };
+    for (std::vector<float>* values : arrays)
+        values->assign(capacity, 0.0f);
+
+    // Distinct non-zero seeds; xorshift never leaves zero
+    const uint32_t SEEDS[4] = { 0x9E3779B9u, 0x7F4A7C15u, 0x85EBCA6Bu, 0xC2B2AE35u };
+    for (int i = 0; i < 4; i++)
+        random[i] = SEEDS[i];
+}
+
+void ParticleEmitter::emit(uint32_t amount)
+{
+    amount = std::min(amount, desc.maxParticles - count);
+    if (amount == 0)
+        return;
+
+    __m128i state = _mm_loadu_si128((const __m128i*)random);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    // Whole vectors from the first free slot; lanes past the new count are
+    // written but stay outside the live range
+    uint32_t end = count + amount;
+    for (uint32_t i = count; i < end; i += 4)
+    {
+        _mm_storeu_ps(&positionsX[i], randomAround(state, desc.position.x, desc.positionSpread.x));
+        _mm_storeu_ps(&positionsY[i], randomAround(state, desc.position.y, desc.positionSpread.y));
+        _mm_storeu_ps(&positionsZ[i], randomAround(state, desc.position.z, desc.positionSpread.z));
+        _mm_storeu_ps(&velocitiesX[i], randomAround(state, desc.velocity.x, desc.velocitySpread.x));
+        _mm_storeu_ps(&velocitiesY[i], randomAround(state, desc.velocity.y, desc.velocitySpread.y));
+        _mm_storeu_ps(&velocitiesZ[i], randomAround(state, desc.velocity.z, desc.velocitySpread.z));
+        _mm_storeu_ps(&ages[i], zero);
+        __m128 lifetime = lerp(desc.minLifetime, desc.maxLifetime, randomUnit(state));
+        _mm_storeu_ps(&inverseLifetimes[i], _mm_div_ps(one, lifetime));
+    }
+
+    _mm_storeu_si128((__m128i*)random, state);
+    count = end;
+}
+
+void ParticleEmitter::update(float dt, ThreadPool& pool)
+{
+    if (count > 0)
+    {
+        uint32_t blockCount = (count + PARTICLE_GRAIN - 1) / PARTICLE_GRAIN;
+        blockDead.resize(blockCount);
+
+        const __m128 step = _mm_set1_ps(dt);
+        const __m128 damping = _mm_set1_ps(std::max(1.0f - desc.drag * dt, 0.0f));
+        const __m128 accelerationX = _mm_set1_ps(desc.acceleration.x * dt);
+        const __m128 accelerationY = _mm_set1_ps(desc.acceleration.y * dt);
+        const __m128 accelerationZ = _mm_set1_ps(desc.acceleration.z * dt);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const uint32_t live = count;
+
+        pool.parallelFor(count, PARTICLE_GRAIN, [&](uint32_t begin, uint32_t end)
+        {
+            std::vector<uint32_t>& dead = blockDead[begin / PARTICLE_GRAIN];
+            dead.clear();
+
+            for (uint32_t i = begin; i < end; i += 4)
+            {
+                __m128 vx = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&velocitiesX[i]), damping), accelerationX);
+                __m128 vy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&velocitiesY[i]), damping), accelerationY);
+                __m128 vz = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&velocitiesZ[i]), damping), accelerationZ);
+                _mm_storeu_ps(&velocitiesX[i], vx);
+                _mm_storeu_ps(&velocitiesY[i], vy);
+                _mm_storeu_ps(&velocitiesZ[i], vz);
+                _mm_storeu_ps(&positionsX[i], _mm_add_ps(_mm_loadu_ps(&positionsX[i]), _mm_mul_ps(vx, step)));
+                _mm_storeu_ps(&positionsY[i], _mm_add_ps(_mm_loadu_ps(&positionsY[i]), _mm_mul_ps(vy, step)));
+                _mm_storeu_ps(&positionsZ[i], _mm_add_ps(_mm_loadu_ps(&positionsZ[i]), _mm_mul_ps(vz, step)));
+
+                __m128 age = _mm_add_ps(_mm_loadu_ps(&ages[i]), step);
+                _mm_storeu_ps(&ages[i], age);
+
+                int expired = _mm_movemask_ps(_mm_cmpge_ps(_mm_mul_ps(age, _mm_loadu_ps(&inverseLifetimes[i])), one));
+                if (!expired)
+                    continue;
+                for (uint32_t lane = 0; lane < 4; lane++)
+                {
+                    if ((expired & (1 << lane)) && i + lane < live)
+                        dead.push_back(i + lane);
+                }
+            }
+        });
+
+        removeDead();
+    }
+
+    emitDebt += desc.rate * dt;
+    uint32_t spawned = (uint32_t)emitDebt;
+    emitDebt -= (float)spawned;
+    emit(spawned);
+}
+
+void ParticleEmitter::removeDead()
+{
+    // Highest index first: everything above it is already live, so the last
+    // particle can always fill the hole
+    std::vector<float>* arrays[] = { &positionsX, &positionsY, &positionsZ, &velocitiesX, &velocitiesY,
+        &velocitiesZ, &ages, &inverseLifetimes };
+    for (auto block = blockDead.rbegin(); block != blockDead.rend(); ++block)
+    {
+        for (auto index = block->rbegin(); index != block->rend(); ++index)
+        {
+            uint32_t last = --count;
+            if (*index == last)
+                continue;
+            for (std::vector<float>* values : arrays)
+                (*values)[*index] = (*values)[last];
+        }
+    }
+}
+
+void ParticleEmitter::writeInstances(const ParticleInstances& out, const glm::vec3& cameraPos,
+    const glm::vec3& viewDirection, ThreadPool& pool)
+{
+    if (count == 0)
+        return;
+
+    if (!desc.sorted)
+    {
+        // Same order as the arrays, four particles per step
+        const __m128 one = _mm_set1_ps(1.0f);
+        pool.parallelFor(count, PARTICLE_GRAIN, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i += 4)
+            {
+                __m128 t = _mm_min_ps(_mm_mul_ps(_mm_loadu_ps(&ages[i]), _mm_loadu_ps(&inverseLifetimes[i])), one);
+
+                __m128 x = _mm_loadu_ps(&positionsX[i]);
+                __m128 y = _mm_loadu_ps(&positionsY[i]);
+                __m128 z = _mm_loadu_ps(&positionsZ[i]);
+                __m128 size = lerp(desc.startSize, desc.endSize, t);
+                _MM_TRANSPOSE4_PS(x, y, z, size);
+                float* centers = &out.centers[i].x;
+                _mm_storeu_ps(centers, x);
+                _mm_storeu_ps(centers + 4, y);
+                _mm_storeu_ps(centers + 8, z);
+                _mm_storeu_ps(centers + 12, size);
+
+                __m128i r = toByte(lerp(desc.startColor.x, desc.endColor.x, t));
+                __m128i g = toByte(lerp(desc.startColor.y, desc.endColor.y, t));
+                __m128i b = toByte(lerp(desc.startColor.z, desc.endColor.z, t));
+                __m128i a = toByte(lerp(desc.startColor.w, desc.endColor.w, t));
+                __m128i rgba = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)),
+                    _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+                _mm_storeu_si128((__m128i*)&out.colors[i], rgba);
+            }
+        });
+        return;
+    }
+
+    // Back to front: the sort itself is sequential, keys and the gather are not.
+    // Depth key and particle index only live for this call, in the frame arena.
+    std::pair<float, uint32_t>* drawOrder = FrameArena::getInstance().allocateArray<std::pair<float, uint32_t>>(count);
+    pool.parallelFor(count, PARTICLE_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            glm::vec3 offset(positionsX[i] - cameraPos.x, positionsY[i] - cameraPos.y, positionsZ[i] - cameraPos.z);
+            drawOrder[i] = std::make_pair(-glm::dot(offset, viewDirection), i);
+        }
+    });
+    std::sort(drawOrder, drawOrder + count);
+
+    pool.parallelFor(count, PARTICLE_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            uint32_t particle = drawOrder[i].second;
+            float t = std::min(ages[particle] * inverseLifetimes[particle], 1.0f);
+            out.centers[i] = glm::vec4(positionsX[particle], positionsY[particle], positionsZ[particle],
+                desc.startSize + (desc.endSize - desc.startSize) * t);
+            out.colors[i] = packColor(desc.startColor + (desc.endColor - desc.startColor) * t);
+        }
+    });
+}
+
+// ==================== SYSTEM ====================
+
+ParticleSystem::ParticleSystem(ThreadPool& threadPool)
+    : pool(threadPool)
+{
+}
+
+uint32_t ParticleSystem::addEmitter(const ParticleEmitterDesc& desc)
+{
+    for (uint32_t i = 0; i < emitters.size(); i++)
+    {
+        if (!emitters[i])
+        {
+            emitters[i].reset(new ParticleEmitter(desc));
+            return i;
+        }
+    }
+
+    emitters.emplace_back(new ParticleEmitter(desc));
+    return (uint32_t)emitters.size() - 1;
+}
+
+void ParticleSystem::removeEmitter(uint32_t id)
+{
+    if (id < emitters.size())
+        emitters[id].reset();
+}
+
+void ParticleSystem::clear()
+{
+    emitters.clear();
+}
+
+ParticleEmitter* ParticleSystem::getEmitter(uint32_t id)
+{
+    return id < emitters.size() ? emitters[id].get() : nullptr;
+}
+
+uint32_t ParticleSystem::getParticleCount() const
+{
+    uint32_t total = 0;
+    for (const std::unique_ptr<ParticleEmitter>& emitter : emitters)
+    {
+        if (emitter)
+            total += emitter->getCount();
+    }
+    return total;
+}
+
+void ParticleSystem::update(float dt)
+{
+    for (const std::unique_ptr<ParticleEmitter>& emitter : emitters)
+    {
+        if (emitter)
+            emitter->update(dt, pool);
+    }
+}
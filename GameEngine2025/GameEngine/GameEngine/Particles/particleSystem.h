@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm.hpp>
+#include "../Core/threadPool.h"
+
+struct ParticleEmitterDesc
+{
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 positionSpread = glm::vec3(0.0f);    // half extents of the spawn box
+    glm::vec3 velocity = glm::vec3(0.0f);
+    glm::vec3 velocitySpread = glm::vec3(0.0f);    // per axis, added uniformly in [-spread, spread]
+    glm::vec3 acceleration = glm::vec3(0.0f);      // gravity, wind, buoyancy
+    float drag = 0.0f;                              // fraction of velocity lost per second
+    float minLifetime = 1.0f;
+    float maxLifetime = 1.0f;
+    float startSize = 1.0f;
+    float endSize = 1.0f;
+    glm::vec4 startColor = glm::vec4(1.0f);
+    glm::vec4 endColor = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+    float rate = 0.0f;                              // particles per second
+    uint32_t maxParticles = 1024;
+    bool additive = true;   // additive blending needs no order
+    bool sorted = false;    // back to front; only worth it for small alpha-blended emitters
+};
+
+// What the renderer reads per particle. Centres and colours are separate
+// runs of one buffer, so the kernel writes both with plain vector stores.
+struct ParticleInstances
+{
+    glm::vec4* centers;     // xyz, size
+    uint32_t* colors;       // RGBA8
+};
+
+// Particles of one effect in SoA form: one float array per attribute, padded
+// to whole SSE vectors so the kernels never need a scalar tail. Updates and
+// instance writes split the arrays into blocks on the thread pool; dead
+// particles are swapped out with the last live one, so live particles stay
+// packed at the front.
+class ParticleEmitter
+{
+public:
+    explicit ParticleEmitter(const ParticleEmitterDesc& desc);
+
+    void setPosition(const glm::vec3& position) { desc.position = position; }
+    const ParticleEmitterDesc& getDesc() const { return desc; }
+    uint32_t getCount() const { return count; }
+
+    // Spawns up to `amount` particles at once (capped by maxParticles)
+    void emit(uint32_t amount);
+
+    // Ages and moves the particles, removes the expired ones, then spawns
+    // rate * dt new ones
+    void update(float dt, ThreadPool& pool);
+
+    // Writes getCount() instances, back to front along viewDirection when the
+    // emitter is sorted. `out` must have room for getInstanceCapacity().
+    uint32_t getInstanceCapacity() const { return (count + 3) & ~3u; }
+    void writeInstances(const ParticleInstances& out, const glm::vec3& cameraPos, const glm::vec3& viewDirection,
+        ThreadPool& pool);
+
+private:
+    ParticleEmitterDesc desc;
+    uint32_t count = 0;
+    float emitDebt = 0.0f;      // fraction of a particle owed from earlier updates
+    uint32_t random[4];         // one xorshift state per SSE lane
+
+    std::vector<float> positionsX;
+    std::vector<float> positionsY;
+    std::vector<float> positionsZ;
+    std::vector<float> velocitiesX;
+    std::vector<float> velocitiesY;
+    std::vector<float> velocitiesZ;
+    std::vector<float> ages;
+    std::vector<float> inverseLifetimes;
+
+    // Expired particles found by each update block, in ascending order
+    std::vector<std::vector<uint32_t>> blockDead;
+
+    void removeDead();
+};
+
+// All emitters of a scene. Ids stay valid until the emitter is removed.
+class ParticleSystem
+{
+public:
+    explicit ParticleSystem(ThreadPool& pool = ThreadPool::getShared());
+
+    uint32_t addEmitter(const ParticleEmitterDesc& desc);
+    void removeEmitter(uint32_t id);
+    void clear();
+
+    // Null for removed ids
+    ParticleEmitter* getEmitter(uint32_t id);
+    uint32_t getEmitterSlots() const { return (uint32_t)emitters.size(); }
+    uint32_t getParticleCount() const;
+
+    void update(float dt);
+
+    ThreadPool& getPool() { return pool; }
+
+private:
+    ThreadPool& pool;
+    std::vector<std::unique_ptr<ParticleEmitter>> emitters;
+};
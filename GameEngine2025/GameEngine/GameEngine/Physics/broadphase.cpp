@@ -0,0 +1,195 @@
+#include "broadphase.h"
+#include "../Core/threadPool.h"
+#include <algorithm>
+#include <cmath>
+
+// Bodies swept per block of the parallel sweep
+static const uint32_t SWEEP_GRAIN = 2048;
+
+// Bands far out are clamped together, which only costs pruning
+static const float BAND_LIMIT = 1.0e9f;
+
+void SweepAndPrune::clear()
+{
+    order.clear();
+    axis = -1;
+    bandAxis = -1;
+    bandWidth = 0.0f;
+}
+
+void SweepAndPrune::chooseAxes(const glm::vec3* boundsMin, const glm::vec3* boundsMax, uint32_t count, bool& reset)
+{
+    glm::vec3 mean(0.0f), meanSquares(0.0f), largest(0.0f);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        glm::vec3 center = (boundsMin[i] + boundsMax[i]) * 0.5f;
+        mean += center;
+        meanSquares += center * center;
+        largest = glm::max(largest, boundsMax[i] - boundsMin[i]);
+    }
+    mean /= (float)count;
+    glm::vec3 variance = meanSquares / (float)count - mean * mean;
+
+    // Switching axes throws the order away; stay unless the new one is clearly better
+    int newAxis = variance.x >= variance.y ? (variance.x >= variance.z ? 0 : 2) : (variance.y >= variance.z ? 1 : 2);
+    if (axis >= 0 && newAxis != axis && variance[newAxis] < variance[axis] * 1.5f)
+        newAxis = axis;
+
+    int other1 = (newAxis + 1) % 3;
+    int other2 = (newAxis + 2) % 3;
+    int newBandAxis = variance[other1] >= variance[other2] ? other1 : other2;
+    if (newBandAxis != bandAxis && bandAxis >= 0 && bandAxis != newAxis &&
+        variance[newBandAxis] < variance[bandAxis] * 1.5f)
+        newBandAxis = bandAxis;
+
+    // Bands must hold the largest box; widened with headroom and narrowed
+    // only when far too wide, so they rarely change under the sort
+    float extent = std::max(largest[newBandAxis], 1.0e-3f);
+    float newWidth = bandWidth;
+    if (extent > bandWidth || extent < bandWidth * 0.25f)
+        newWidth = extent * 1.5f;
+
+    reset = reset || newAxis != axis || newBandAxis != bandAxis || newWidth != bandWidth;
+    axis = newAxis;
+    bandAxis = newBandAxis;
+    bandWidth = newWidth;
+}
+
+void SweepAndPrune::sortBodies(const glm::vec3* boundsMin, uint32_t count, bool reset)
+{
+    auto before = [&](uint32_t left, uint32_t right)
+    {
+        if (bands[left] != bands[right])
+            return bands[left] < bands[right];
+        float leftKey = boundsMin[left][axis];
+        float rightKey = boundsMin[right][axis];
+        return leftKey < rightKey || (leftKey == rightKey && left < right);
+    };
+
+    // New axes or a new body set leave no useful previous order
+    if (reset)
+    {
+        order.resize(count);
+        for (uint32_t i = 0; i < count; i++)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), before);
+        return;
+    }
+
+    for (uint32_t i = 1; i < count; i++)
+    {
+        uint32_t body = order[i];
+        uint32_t j = i;
+        while (j > 0 && before(body, order[j - 1]))
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = body;
+    }
+}
+
+void SweepAndPrune::findPairs(const glm::vec3* boundsMin, const glm::vec3* boundsMax, uint32_t count, ThreadPool& pool,
+    std::vector<BodyPair>& pairs)
+{
+    pairs.clear();
+    if (count < 2)
+    {
+        clear();
+        return;
+    }
+
+    bool reset = order.size() != count;
+    chooseAxes(boundsMin, boundsMax, count, reset);
+
+    bands.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        float band = std::floor(boundsMin[i][bandAxis] / bandWidth);
+        bands[i] = (int32_t)std::max(-BAND_LIMIT, std::min(band, BAND_LIMIT));
+    }
+    sortBodies(boundsMin, count, reset);
+
+    const int otherAxis = 3 - axis - bandAxis;
+    sorted.resize(count);
+    sortedRuns.resize(count);
+    runs.clear();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t body = order[i];
+        SweepBox& box = sorted[i];
+        box.min = boundsMin[body][axis];
+        box.max = boundsMax[body][axis];
+        box.min1 = boundsMin[body][bandAxis];
+        box.max1 = boundsMax[body][bandAxis];
+        box.min2 = boundsMin[body][otherAxis];
+        box.max2 = boundsMax[body][otherAxis];
+        box.body = body;
+
+        if (runs.empty() || runs.back().band != bands[body])
+        {
+            BandRun run = { bands[body], i, i };
+            runs.push_back(run);
+        }
+        runs.back().end = i + 1;
+        sortedRuns[i] = (uint32_t)runs.size() - 1;
+    }
+
+    uint32_t blockCount = (count + SWEEP_GRAIN - 1) / SWEEP_GRAIN;
+    blockPairs.resize(blockCount);
+
+    pool.parallelFor(count, SWEEP_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        std::vector<BodyPair>& found = blockPairs[begin / SWEEP_GRAIN];
+        found.clear();
+        const SweepBox* boxes = sorted.data();
+        auto byMin = [](const SweepBox& box, float value) { return box.min < value; };
+        auto byMinAfter = [](float value, const SweepBox& box) { return value < box.min; };
+
+        for (uint32_t i = begin; i < end; i++)
+        {
+            const SweepBox& first = boxes[i];
+            auto test = [&](uint32_t j)
+            {
+                const SweepBox& second = boxes[j];
+                if (second.min1 > first.max1 || second.max1 < first.min1 ||
+                    second.min2 > first.max2 || second.max2 < first.min2)
+                    return;
+                BodyPair pair = { std::min(first.body, second.body), std::max(first.body, second.body) };
+                found.push_back(pair);
+            };
+
+            // Own band: the boxes after this one in sweep order
+            uint32_t runIndex = sortedRuns[i];
+            const BandRun& run = runs[runIndex];
+            for (uint32_t j = i + 1; j < run.end && boxes[j].min <= first.max; j++)
+                test(j);
+
+            // Neighbouring bands: each cross-band pair is found by the box
+            // that starts first, and by the one in the lower band on a tie
+            if (runIndex + 1 < runs.size() && runs[runIndex + 1].band == run.band + 1)
+            {
+                const BandRun& next = runs[runIndex + 1];
+                uint32_t j = (uint32_t)(std::lower_bound(boxes + next.begin, boxes + next.end, first.min, byMin) - boxes);
+                for (; j < next.end && boxes[j].min <= first.max; j++)
+                    test(j);
+            }
+            if (runIndex > 0 && runs[runIndex - 1].band == run.band - 1)
+            {
+                const BandRun& previous = runs[runIndex - 1];
+                uint32_t j = (uint32_t)(std::upper_bound(boxes + previous.begin, boxes + previous.end, first.min, byMinAfter) - boxes);
+                for (; j < previous.end && boxes[j].min <= first.max; j++)
+                    test(j);
+            }
+        }
+    });
+
+    size_t total = 0;
+    for (const std::vector<BodyPair>& found : blockPairs)
+        total += found.size();
+    // At least doubling, so a slowly rising pair count doesn't reallocate every step
+    if (pairs.capacity() < total)
+        pairs.reserve(std::max(total, pairs.capacity() * 2));
+    for (const std::vector<BodyPair>& found : blockPairs)
+        pairs.insert(pairs.end(), found.begin(), found.end());
+}
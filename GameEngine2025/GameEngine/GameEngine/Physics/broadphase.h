@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm.hpp>
+
+class ThreadPool;
+
+struct BodyPair
+{
+    uint32_t a;     // the lower body index
+    uint32_t b;
+};
+
+// Sweep and prune over body bounds. Boxes are sorted by their lower edge on
+// the axis along which the bodies are most spread out; each one is then only
+// tested against the run of boxes that start before it ends.
+//
+// On a wide field a single sweep axis still tests every box in a thin slice
+// through the whole field, so the sweep is split into bands along the second
+// most spread out axis, at least as wide as the largest box. A box can only
+// overlap boxes of its own band and the two next to it, and is swept against
+// just those three.
+//
+// The order is kept between steps and repaired with an insertion sort, which
+// is close to linear while bodies move a little per step. Ties break on the
+// body index, so the order (and the pair list) depends only on the input.
+class SweepAndPrune
+{
+public:
+    // Replaces pairs with every overlapping pair of boxes, in sweep order
+    void findPairs(const glm::vec3* boundsMin, const glm::vec3* boundsMax, uint32_t count, ThreadPool& pool,
+        std::vector<BodyPair>& pairs);
+
+    void clear();
+
+    int getAxis() const { return axis; }
+    int getBandAxis() const { return bandAxis; }
+
+private:
+    // Bounds gathered into sweep order with the sweep axis first, so the
+    // inner loop walks memory linearly and never indexes by axis
+    struct SweepBox
+    {
+        float min;
+        float max;
+        float min1;
+        float max1;
+        float min2;
+        float max2;
+        uint32_t body;
+    };
+
+    // Consecutive boxes of one band in sweep order
+    struct BandRun
+    {
+        int32_t band;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    std::vector<uint32_t> order;
+    int axis = -1;
+    int bandAxis = -1;
+    float bandWidth = 0.0f;
+    std::vector<int32_t> bands;     // per body
+
+    std::vector<SweepBox> sorted;
+    std::vector<BandRun> runs;
+    std::vector<uint32_t> sortedRuns;   // run of each sorted box
+
+    // Pairs found by each block of the parallel sweep, merged in block order
+    std::vector<std::vector<BodyPair>> blockPairs;
+
+    void chooseAxes(const glm::vec3* boundsMin, const glm::vec3* boundsMax, uint32_t count, bool& reset);
+    void sortBodies(const glm::vec3* boundsMin, uint32_t count, bool reset);
+};
@@ -0,0 +1,49 @@
+#include "convexHull.h"
+#include <algorithm>
+#include <cmath>
+
+void buildConvexHull(const glm::vec3* points, uint32_t count, uint32_t maxPoints, ConvexHull& hull)
+{
+    hull.points.clear();
+    hull.boundingRadius = 0.0f;
+    if (count == 0 || maxPoints == 0)
+        return;
+
+    // Fibonacci sphere: directions spread evenly without clustering at the poles
+    const float GOLDEN_ANGLE = 2.39996323f;
+    std::vector<uint32_t> chosen;
+    chosen.reserve(maxPoints);
+    for (uint32_t d = 0; d < maxPoints; d++)
+    {
+        float y = 1.0f - 2.0f * (d + 0.5f) / maxPoints;
+        float ring = std::sqrt(1.0f - y * y);
+        glm::vec3 direction(ring * std::cos(GOLDEN_ANGLE * d), y, ring * std::sin(GOLDEN_ANGLE * d));
+
+        uint32_t best = 0;
+        float bestDistance = glm::dot(points[0], direction);
+        for (uint32_t i = 1; i < count; i++)
+        {
+            float distance = glm::dot(points[i], direction);
+            if (distance > bestDistance)
+            {
+                bestDistance = distance;
+                best = i;
+            }
+        }
+        chosen.push_back(best);
+    }
+
+    // Neighbouring directions often share an extreme point, and meshes repeat
+    // positions across vertices with different normals
+    std::sort(chosen.begin(), chosen.end());
+    chosen.erase(std::unique(chosen.begin(), chosen.end()), chosen.end());
+
+    hull.points.reserve(chosen.size());
+    for (uint32_t index : chosen)
+    {
+        if (std::find(hull.points.begin(), hull.points.end(), points[index]) != hull.points.end())
+            continue;
+        hull.points.push_back(points[index]);
+        hull.boundingRadius = std::max(hull.boundingRadius, glm::length(points[index]));
+    }
+}
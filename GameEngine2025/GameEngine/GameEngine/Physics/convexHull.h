@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm.hpp>
+
+// Convex shape of a rigid body as the points spanning it, in body space. The
+// narrowphase only needs the support mapping, so no faces are stored.
+struct ConvexHull
+{
+    std::vector<glm::vec3> points;
+    float boundingRadius = 0.0f;    // furthest point from the body origin
+
+    // Point furthest along direction (body space)
+    const glm::vec3& support(const glm::vec3& direction) const
+    {
+        uint32_t best = 0;
+        float bestDistance = glm::dot(points[0], direction);
+        for (uint32_t i = 1; i < (uint32_t)points.size(); i++)
+        {
+            float distance = glm::dot(points[i], direction);
+            if (distance > bestDistance)
+            {
+                bestDistance = distance;
+                best = i;
+            }
+        }
+        return points[best];
+    }
+};
+
+// Hull of a point cloud (e.g. a mesh's vertices) reduced to at most maxPoints
+// vertices: the extreme points along evenly spread directions. Every one of
+// them is a vertex of the exact hull, so the result sits inside it.
+void buildConvexHull(const glm::vec3* points, uint32_t count, uint32_t maxPoints, ConvexHull& hull);
@@ -0,0 +1,280 @@
+#include "narrowphase.h"
+#include <algorithm>
+#include <cmath>
+
+static const int GJK_MAX_ITERATIONS = 32;
+
+// Relative progress below which GJK has found the closest points
+static const float GJK_TOLERANCE = 1.0e-5f;
+
+bool collideSpheres(const glm::vec3& centerA, float radiusA, const glm::vec3& centerB, float radiusB,
+    ContactPoint& contact)
+{
+    glm::vec3 offset = centerB - centerA;
+    float distanceSquared = glm::dot(offset, offset);
+    float reach = radiusA + radiusB;
+    if (distanceSquared >= reach * reach)
+        return false;
+
+    float distance = std::sqrt(distanceSquared);
+    contact.normal = distance > 1.0e-6f ? offset / distance : glm::vec3(0.0f, 1.0f, 0.0f);
+    contact.depth = reach - distance;
+    contact.point = centerA + contact.normal * (radiusA - contact.depth * 0.5f);
+    return true;
+}
+
+// ==================== GJK ====================
+
+// Furthest point of the core (the hull, or the sphere's centre) along a world direction
+static glm::vec3 supportPoint(const ConvexProxy& proxy, const glm::vec3& direction)
+{
+    if (!proxy.hull)
+        return proxy.position;
+
+    glm::vec3 local = glm::conjugate(proxy.orientation) * direction;
+    return proxy.position + proxy.orientation * (proxy.hull->support(local) * proxy.scale);
+}
+
+// Vertex of the Minkowski difference A - B, with the points it came from
+struct SimplexVertex
+{
+    glm::vec3 w;
+    glm::vec3 a;
+    glm::vec3 b;
+};
+
+static SimplexVertex supportVertex(const ConvexProxy& a, const ConvexProxy& b, const glm::vec3& direction)
+{
+    SimplexVertex vertex;
+    vertex.a = supportPoint(a, direction);
+    vertex.b = supportPoint(b, -direction);
+    vertex.w = vertex.a - vertex.b;
+    return vertex;
+}
+
+// Barycentric coordinates of the point of triangle abc closest to the origin
+// (Ericson, Real-Time Collision Detection 5.1.5)
+static void closestToOriginOnTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, float weights[3])
+{
+    glm::vec3 ab = b - a;
+    glm::vec3 ac = c - a;
+    float d1 = -glm::dot(ab, a);
+    float d2 = -glm::dot(ac, a);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+    {
+        weights[0] = 1.0f; weights[1] = 0.0f; weights[2] = 0.0f;
+        return;
+    }
+
+    float d3 = -glm::dot(ab, b);
+    float d4 = -glm::dot(ac, b);
+    if (d3 >= 0.0f && d4 <= d3)
+    {
+        weights[0] = 0.0f; weights[1] = 1.0f; weights[2] = 0.0f;
+        return;
+    }
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    {
+        float v = d1 / (d1 - d3);
+        weights[0] = 1.0f - v; weights[1] = v; weights[2] = 0.0f;
+        return;
+    }
+
+    float d5 = -glm::dot(ab, c);
+    float d6 = -glm::dot(ac, c);
+    if (d6 >= 0.0f && d5 <= d6)
+    {
+        weights[0] = 0.0f; weights[1] = 0.0f; weights[2] = 1.0f;
+        return;
+    }
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    {
+        float w = d2 / (d2 - d6);
+        weights[0] = 1.0f - w; weights[1] = 0.0f; weights[2] = w;
+        return;
+    }
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+    {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        weights[0] = 0.0f; weights[1] = 1.0f - w; weights[2] = w;
+        return;
+    }
+
+    float denominator = 1.0f / (va + vb + vc);
+    weights[1] = vb * denominator;
+    weights[2] = vc * denominator;
+    weights[0] = 1.0f - weights[1] - weights[2];
+}
+
+// Keeps the vertices with a non-zero weight, in order
+static void reduceSimplex(SimplexVertex* simplex, float* weights, int& count)
+{
+    int kept = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (weights[i] > 0.0f)
+        {
+            simplex[kept] = simplex[i];
+            weights[kept] = weights[i];
+            kept++;
+        }
+    }
+    count = kept;
+}
+
+// Replaces the simplex by the smallest sub-simplex holding its point closest
+// to the origin. False when the origin is inside the tetrahedron.
+static bool solveSimplex(SimplexVertex* simplex, float* weights, int& count)
+{
+    if (count == 1)
+    {
+        weights[0] = 1.0f;
+        return true;
+    }
+
+    if (count == 2)
+    {
+        glm::vec3 edge = simplex[1].w - simplex[0].w;
+        float lengthSquared = glm::dot(edge, edge);
+        float t = lengthSquared > 0.0f ? -glm::dot(simplex[0].w, edge) / lengthSquared : 0.0f;
+        t = glm::clamp(t, 0.0f, 1.0f);
+        weights[0] = 1.0f - t;
+        weights[1] = t;
+        reduceSimplex(simplex, weights, count);
+        return true;
+    }
+
+    if (count == 3)
+    {
+        closestToOriginOnTriangle(simplex[0].w, simplex[1].w, simplex[2].w, weights);
+        reduceSimplex(simplex, weights, count);
+        return true;
+    }
+
+    // Tetrahedron: the closest point lies on a face the origin is outside of
+    static const int FACES[4][4] = { { 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 } };
+    float bestDistance = -1.0f;
+    SimplexVertex best[3];
+    float bestWeights[3];
+    for (const int* face : FACES)
+    {
+        const glm::vec3& a = simplex[face[0]].w;
+        const glm::vec3& b = simplex[face[1]].w;
+        const glm::vec3& c = simplex[face[2]].w;
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float originSide = -glm::dot(normal, a);
+        float oppositeSide = glm::dot(normal, simplex[face[3]].w - a);
+        if (originSide * oppositeSide > 0.0f)
+            continue;
+
+        float faceWeights[3];
+        closestToOriginOnTriangle(a, b, c, faceWeights);
+        glm::vec3 point = a * faceWeights[0] + b * faceWeights[1] + c * faceWeights[2];
+        float distance = glm::dot(point, point);
+        if (bestDistance < 0.0f || distance < bestDistance)
+        {
+            bestDistance = distance;
+            for (int i = 0; i < 3; i++)
+            {
+                best[i] = simplex[face[i]];
+                bestWeights[i] = faceWeights[i];
+            }
+        }
+    }
+
+    if (bestDistance < 0.0f)
+        return false;
+
+    count = 3;
+    for (int i = 0; i < 3; i++)
+    {
+        simplex[i] = best[i];
+        weights[i] = bestWeights[i];
+    }
+    reduceSimplex(simplex, weights, count);
+    return true;
+}
+
+bool collideConvex(const ConvexProxy& a, const ConvexProxy& b, ContactPoint& contact)
+{
+    SimplexVertex simplex[4];
+    float weights[4];
+    int count = 1;
+
+    glm::vec3 direction = b.position - a.position;
+    if (glm::dot(direction, direction) <= 0.0f)
+        direction = glm::vec3(1.0f, 0.0f, 0.0f);
+    simplex[0] = supportVertex(a, b, -direction);
+    weights[0] = 1.0f;
+    glm::vec3 closest = simplex[0].w;
+
+    float reach = a.radius + b.radius;
+    bool overlapping = false;
+    for (int iteration = 0; iteration < GJK_MAX_ITERATIONS; iteration++)
+    {
+        float distanceSquared = glm::dot(closest, closest);
+        if (distanceSquared <= 1.0e-12f)
+        {
+            overlapping = true;
+            break;
+        }
+
+        // The support plane bounds the distance from below; once that is out
+        // of reach the exact distance is not needed
+        SimplexVertex vertex = supportVertex(a, b, -closest);
+        float projection = glm::dot(closest, vertex.w);
+        if (projection > 0.0f && projection * projection > reach * reach * distanceSquared)
+            return false;
+
+        // No vertex further towards the origin: the current point is the closest
+        if (distanceSquared - projection <= GJK_TOLERANCE * distanceSquared)
+            break;
+
+        simplex[count++] = vertex;
+        if (!solveSimplex(simplex, weights, count))
+        {
+            overlapping = true;
+            break;
+        }
+
+        closest = glm::vec3(0.0f);
+        for (int i = 0; i < count; i++)
+            closest += simplex[i].w * weights[i];
+    }
+
+    if (!overlapping)
+    {
+        glm::vec3 pointA(0.0f), pointB(0.0f);
+        for (int i = 0; i < count; i++)
+        {
+            pointA += simplex[i].a * weights[i];
+            pointB += simplex[i].b * weights[i];
+        }
+
+        float distance = glm::length(closest);
+        if (distance >= reach)
+            return false;
+
+        contact.normal = (pointB - pointA) / distance;
+        contact.depth = reach - distance;
+        contact.point = (pointA + contact.normal * a.radius + pointB - contact.normal * b.radius) * 0.5f;
+        return true;
+    }
+
+    // Cores overlap: how far the shapes overlap along the line between them
+    glm::vec3 normal = b.position - a.position;
+    float length = glm::length(normal);
+    normal = length > 1.0e-6f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    float extentA = glm::dot(supportPoint(a, normal), normal) + a.radius;
+    float extentB = glm::dot(supportPoint(b, -normal), normal) - b.radius;
+    contact.normal = normal;
+    contact.depth = std::max(extentA - extentB, 0.0f);
+    contact.point = (a.position + b.position) * 0.5f;
+    return true;
+}
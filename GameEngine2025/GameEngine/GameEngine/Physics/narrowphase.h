@@ -0,0 +1,32 @@
+#pragma once
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+#include "convexHull.h"
+
+// Contact between two shapes, seen from the first one
+struct ContactPoint
+{
+    glm::vec3 point;    // world space, halfway between the two surfaces
+    glm::vec3 normal;   // unit length, from the first shape towards the second
+    float depth;        // penetration
+};
+
+// A shape placed in the world. Hulls are rounded by `radius`, which keeps
+// resting contacts in the cheap separated-cores case; a shape without a hull
+// is a sphere of that radius.
+struct ConvexProxy
+{
+    const ConvexHull* hull;
+    glm::vec3 position;
+    glm::quat orientation;
+    float scale;
+    float radius;
+};
+
+bool collideSpheres(const glm::vec3& centerA, float radiusA, const glm::vec3& centerB, float radiusB,
+    ContactPoint& contact);
+
+// GJK distance between the cores, then the rounding decides. Cores that
+// interpenetrate (a body tunnelled in) fall back to the overlap of the two
+// shapes along the line between their origins.
+bool collideConvex(const ConvexProxy& a, const ConvexProxy& b, ContactPoint& contact);
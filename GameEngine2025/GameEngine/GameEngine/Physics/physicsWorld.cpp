@@ -0,0 +1,420 @@
+#include "physicsWorld.h"
+#include "narrowphase.h"
+#include "../Collision/collisionWorld.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+// Items per block of the parallel passes
+static const uint32_t BODY_GRAIN = 1024;
+static const uint32_t CONTACT_GRAIN = 1024;
+
+static const float FRICTION = 0.6f;
+static const float LINEAR_DAMPING = 0.02f;     // per second
+static const float ANGULAR_DAMPING = 0.1f;
+
+// Penetration is removed at this fraction per step, ignoring the first slop
+// so resting contacts do not jitter, and never faster than the speed limit
+static const float BAUMGARTE = 0.2f;
+static const float PENETRATION_SLOP = 0.01f;
+static const float MAX_CORRECTION_SPEED = 5.0f;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static double millisecondsSince(const Clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Any two unit vectors perpendicular to n and each other
+static void tangentBasis(const glm::vec3& n, glm::vec3& t1, glm::vec3& t2)
+{
+    t1 = std::fabs(n.x) > 0.57735f ? glm::vec3(n.y, -n.x, 0.0f) : glm::vec3(0.0f, n.z, -n.y);
+    t1 = glm::normalize(t1);
+    t2 = glm::cross(n, t1);
+}
+
+PhysicsWorld::PhysicsWorld(ThreadPool& pool)
+    : pool(pool)
+{
+}
+
+uint32_t PhysicsWorld::addSphereShape(float radius)
+{
+    Shape shape;
+    shape.radius = radius;
+    shapes.push_back(shape);
+    return (uint32_t)shapes.size() - 1;
+}
+
+uint32_t PhysicsWorld::addHullShape(const ConvexHull& hull, float margin)
+{
+    if (hull.points.empty())
+    {
+        std::cout << "Warning: empty convex hull, using a sphere instead" << std::endl;
+        return addSphereShape(margin);
+    }
+
+    Shape shape;
+    shape.hull = hull;
+    shape.radius = margin;
+    shapes.push_back(shape);
+    return (uint32_t)shapes.size() - 1;
+}
+
+uint32_t PhysicsWorld::addBody(const RigidBodyDesc& desc)
+{
+    const Shape& shape = shapes[desc.shape];
+    float radius = (shape.hull.boundingRadius + shape.radius) * desc.scale;
+
+    positions.push_back(desc.position);
+    orientations.push_back(desc.orientation);
+    linearVelocities.push_back(desc.linearVelocity);
+    angularVelocities.push_back(desc.angularVelocity);
+    inverseMasses.push_back(desc.mass > 0.0f ? 1.0f / desc.mass : 0.0f);
+    inverseInertias.push_back(desc.mass > 0.0f ? 1.0f / (0.4f * desc.mass * radius * radius) : 0.0f);
+    scales.push_back(desc.scale);
+    boundingRadii.push_back(radius);
+    bodyShapes.push_back(desc.shape);
+    return (uint32_t)positions.size() - 1;
+}
+
+void PhysicsWorld::clear(bool clearShapes)
+{
+    positions.clear();
+    orientations.clear();
+    linearVelocities.clear();
+    angularVelocities.clear();
+    inverseMasses.clear();
+    inverseInertias.clear();
+    scales.clear();
+    boundingRadii.clear();
+    bodyShapes.clear();
+    boundsMin.clear();
+    boundsMax.clear();
+    pairs.clear();
+    contacts.clear();
+    broadphase.clear();
+    if (clearShapes)
+        shapes.clear();
+}
+
+// ==================== STEP ====================
+
+void PhysicsWorld::step(float dt)
+{
+    Clock::time_point start = Clock::now();
+    Clock::time_point phase = start;
+
+    integrateVelocities(dt);
+    updateBounds(dt);
+    timings.bounds = millisecondsSince(phase);
+
+    phase = Clock::now();
+    broadphase.findPairs(boundsMin.data(), boundsMax.data(), getBodyCount(), pool, pairs);
+    timings.broadphase = millisecondsSince(phase);
+
+    phase = Clock::now();
+    findContacts(dt);
+    findStaticContacts(dt);
+    timings.narrowphase = millisecondsSince(phase);
+
+    phase = Clock::now();
+    prepareContacts(dt);
+    solveContacts();
+    timings.solve = millisecondsSince(phase);
+
+    phase = Clock::now();
+    integratePositions(dt);
+    timings.integrate = millisecondsSince(phase);
+    timings.total = millisecondsSince(start);
+}
+
+void PhysicsWorld::integrateVelocities(float dt)
+{
+    const glm::vec3 gravityStep = gravity * dt;
+    const float linearDamping = 1.0f / (1.0f + dt * LINEAR_DAMPING);
+    const float angularDamping = 1.0f / (1.0f + dt * ANGULAR_DAMPING);
+
+    pool.parallelFor(getBodyCount(), BODY_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            if (inverseMasses[i] == 0.0f)
+                continue;
+            linearVelocities[i] = (linearVelocities[i] + gravityStep) * linearDamping;
+            angularVelocities[i] *= angularDamping;
+        }
+    });
+}
+
+void PhysicsWorld::updateBounds(float dt)
+{
+    boundsMin.resize(getBodyCount());
+    boundsMax.resize(getBodyCount());
+
+    // Grown by this step's motion, so contacts are found before bodies meet
+    pool.parallelFor(getBodyCount(), BODY_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            glm::vec3 extent(boundingRadii[i] + glm::length(linearVelocities[i]) * dt);
+            boundsMin[i] = positions[i] - extent;
+            boundsMax[i] = positions[i] + extent;
+        }
+    });
+}
+
+bool PhysicsWorld::collideBodies(uint32_t a, uint32_t b, float dt, Contact& contact) const
+{
+    const Shape& shapeA = shapes[bodyShapes[a]];
+    const Shape& shapeB = shapes[bodyShapes[b]];
+
+    // Speculative contacts: pairs within reach of each other this step are
+    // kept with a negative depth, and the solver only lets them close the gap
+    float reach = glm::length(linearVelocities[b] - linearVelocities[a]) * dt;
+
+    // Boxes of tumbling bodies overlap far more often than the bodies do
+    glm::vec3 offset = positions[b] - positions[a];
+    float limit = boundingRadii[a] + boundingRadii[b] + reach;
+    if (glm::dot(offset, offset) > limit * limit)
+        return false;
+
+    ContactPoint point;
+    bool touching;
+    if (shapeA.hull.points.empty() && shapeB.hull.points.empty())
+    {
+        touching = collideSpheres(positions[a], shapeA.radius * scales[a] + reach * 0.5f,
+            positions[b], shapeB.radius * scales[b] + reach * 0.5f, point);
+    }
+    else
+    {
+        ConvexProxy proxyA = { shapeA.hull.points.empty() ? nullptr : &shapeA.hull, positions[a], orientations[a],
+            scales[a], shapeA.radius * scales[a] + reach * 0.5f };
+        ConvexProxy proxyB = { shapeB.hull.points.empty() ? nullptr : &shapeB.hull, positions[b], orientations[b],
+            scales[b], shapeB.radius * scales[b] + reach * 0.5f };
+        touching = collideConvex(proxyA, proxyB, point);
+    }
+
+    if (!touching)
+        return false;
+
+    contact.a = a;
+    contact.b = b;
+    contact.point = point.point;
+    contact.normal = point.normal;
+    contact.depth = point.depth - reach;
+    return true;
+}
+
+void PhysicsWorld::findContacts(float dt)
+{
+    uint32_t pairCount = (uint32_t)pairs.size();
+    pairContacts.resize(pairCount);
+    pairTouching.resize(pairCount);
+
+    pool.parallelFor(pairCount, CONTACT_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+            pairTouching[i] = collideBodies(pairs[i].a, pairs[i].b, dt, pairContacts[i]) ? 1 : 0;
+    });
+
+    contacts.clear();
+    for (uint32_t i = 0; i < pairCount; i++)
+    {
+        if (pairTouching[i])
+            contacts.push_back(pairContacts[i]);
+    }
+}
+
+void PhysicsWorld::findStaticContacts(float dt)
+{
+    uint32_t blockCount = (getBodyCount() + BODY_GRAIN - 1) / BODY_GRAIN;
+    blockContacts.resize(blockCount);
+
+    pool.parallelFor(getBodyCount(), BODY_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        std::vector<Contact>& found = blockContacts[begin / BODY_GRAIN];
+        found.clear();
+        for (uint32_t i = begin; i < end; i++)
+        {
+            if (inverseMasses[i] == 0.0f)
+                continue;
+
+            const Shape& shape = shapes[bodyShapes[i]];
+            float reach = glm::length(linearVelocities[i]) * dt;
+
+            // Ground plane, against the lowest point of the shape
+            if (boundsMin[i].y <= groundHeight)
+            {
+                glm::vec3 lowest = positions[i];
+                if (!shape.hull.points.empty())
+                {
+                    glm::vec3 down = glm::conjugate(orientations[i]) * glm::vec3(0.0f, -1.0f, 0.0f);
+                    lowest += orientations[i] * (shape.hull.support(down) * scales[i]);
+                }
+                lowest.y -= shape.radius * scales[i];
+
+                Contact contact;
+                contact.a = i;
+                contact.b = STATIC_BODY;
+                contact.normal = glm::vec3(0.0f, -1.0f, 0.0f);
+                contact.depth = groundHeight - lowest.y;
+                contact.point = glm::vec3(lowest.x, groundHeight, lowest.z);
+                if (contact.depth > -reach)
+                    found.push_back(contact);
+            }
+
+            // Scene geometry, against the bounding sphere
+            if (staticGeometry)
+            {
+                Capsule sphere = { positions[i], positions[i], boundingRadii[i] + reach };
+                ShapeHit hit;
+                if (staticGeometry->overlapCapsule(sphere, hit))
+                {
+                    Contact contact;
+                    contact.a = i;
+                    contact.b = STATIC_BODY;
+                    contact.normal = -hit.normal;
+                    contact.depth = hit.depth - reach;
+                    contact.point = positions[i] + contact.normal * boundingRadii[i];
+                    found.push_back(contact);
+                }
+            }
+        }
+    });
+
+    for (const std::vector<Contact>& found : blockContacts)
+        contacts.insert(contacts.end(), found.begin(), found.end());
+}
+
+void PhysicsWorld::prepareContacts(float dt)
+{
+    pool.parallelFor((uint32_t)contacts.size(), CONTACT_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            Contact& contact = contacts[i];
+            bool isStatic = contact.b == STATIC_BODY;
+            float inverseMassA = inverseMasses[contact.a];
+            float inverseInertiaA = inverseInertias[contact.a];
+            float inverseMassB = isStatic ? 0.0f : inverseMasses[contact.b];
+            float inverseInertiaB = isStatic ? 0.0f : inverseInertias[contact.b];
+
+            contact.offsetA = contact.point - positions[contact.a];
+            contact.offsetB = isStatic ? glm::vec3(0.0f) : contact.point - positions[contact.b];
+            tangentBasis(contact.normal, contact.tangent1, contact.tangent2);
+
+            // Rotational inertia is a scalar (sphere), so each term is |r x d|^2 / I
+            auto effectiveMass = [&](const glm::vec3& direction)
+            {
+                glm::vec3 armA = glm::cross(contact.offsetA, direction);
+                glm::vec3 armB = glm::cross(contact.offsetB, direction);
+                float k = inverseMassA + inverseMassB + inverseInertiaA * glm::dot(armA, armA) +
+                    inverseInertiaB * glm::dot(armB, armB);
+                return k > 0.0f ? 1.0f / k : 0.0f;
+            };
+            contact.normalMass = effectiveMass(contact.normal);
+            contact.tangentMass1 = effectiveMass(contact.tangent1);
+            contact.tangentMass2 = effectiveMass(contact.tangent2);
+
+            // Separating speed the solver aims for: push out of penetration, or
+            // for a speculative contact allow closing exactly the gap
+            if (contact.depth > 0.0f)
+                contact.bias = std::min(BAUMGARTE * std::max(contact.depth - PENETRATION_SLOP, 0.0f) / dt, MAX_CORRECTION_SPEED);
+            else
+                contact.bias = contact.depth / dt;
+
+            contact.normalImpulse = 0.0f;
+            contact.tangentImpulse1 = 0.0f;
+            contact.tangentImpulse2 = 0.0f;
+        }
+    });
+}
+
+void PhysicsWorld::solveContacts()
+{
+    // Sequential impulses in contact order; the order is fixed, so is the result
+    const glm::vec3 still(0.0f);
+    for (int iteration = 0; iteration < solverIterations; iteration++)
+    {
+        for (Contact& contact : contacts)
+        {
+            bool isStatic = contact.b == STATIC_BODY;
+            glm::vec3& velocityA = linearVelocities[contact.a];
+            glm::vec3& spinA = angularVelocities[contact.a];
+            float inverseMassA = inverseMasses[contact.a];
+            float inverseInertiaA = inverseInertias[contact.a];
+            glm::vec3 velocityB = isStatic ? still : linearVelocities[contact.b];
+            glm::vec3 spinB = isStatic ? still : angularVelocities[contact.b];
+
+            auto relativeVelocity = [&]()
+            {
+                return velocityB + glm::cross(spinB, contact.offsetB) - velocityA - glm::cross(spinA, contact.offsetA);
+            };
+            auto applyImpulse = [&](const glm::vec3& impulse)
+            {
+                velocityA -= impulse * inverseMassA;
+                spinA -= glm::cross(contact.offsetA, impulse) * inverseInertiaA;
+                if (!isStatic)
+                {
+                    velocityB += impulse * inverseMasses[contact.b];
+                    spinB += glm::cross(contact.offsetB, impulse) * inverseInertias[contact.b];
+                }
+            };
+
+            // Normal: accumulated impulse stays pushing
+            float normalSpeed = glm::dot(relativeVelocity(), contact.normal);
+            float impulse = (contact.bias - normalSpeed) * contact.normalMass;
+            float accumulated = std::max(contact.normalImpulse + impulse, 0.0f);
+            impulse = accumulated - contact.normalImpulse;
+            contact.normalImpulse = accumulated;
+            applyImpulse(contact.normal * impulse);
+
+            // Friction, bounded by the normal impulse
+            float limit = FRICTION * contact.normalImpulse;
+            glm::vec3 relative = relativeVelocity();
+            impulse = -glm::dot(relative, contact.tangent1) * contact.tangentMass1;
+            accumulated = glm::clamp(contact.tangentImpulse1 + impulse, -limit, limit);
+            impulse = accumulated - contact.tangentImpulse1;
+            contact.tangentImpulse1 = accumulated;
+            applyImpulse(contact.tangent1 * impulse);
+
+            relative = relativeVelocity();
+            impulse = -glm::dot(relative, contact.tangent2) * contact.tangentMass2;
+            accumulated = glm::clamp(contact.tangentImpulse2 + impulse, -limit, limit);
+            impulse = accumulated - contact.tangentImpulse2;
+            contact.tangentImpulse2 = accumulated;
+            applyImpulse(contact.tangent2 * impulse);
+
+            if (!isStatic)
+            {
+                linearVelocities[contact.b] = velocityB;
+                angularVelocities[contact.b] = spinB;
+            }
+        }
+    }
+}
+
+void PhysicsWorld::integratePositions(float dt)
+{
+    pool.parallelFor(getBodyCount(), BODY_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            if (inverseMasses[i] == 0.0f)
+                continue;
+
+            positions[i] += linearVelocities[i] * dt;
+
+            // dq/dt = 0.5 * w * q
+            const glm::vec3& w = angularVelocities[i];
+            glm::quat spin(0.0f, w.x, w.y, w.z);
+            glm::quat& q = orientations[i];
+            glm::quat derivative = spin * q;
+            q = glm::normalize(glm::quat(q.w + derivative.w * 0.5f * dt, q.x + derivative.x * 0.5f * dt,
+                q.y + derivative.y * 0.5f * dt, q.z + derivative.z * 0.5f * dt));
+        }
+    });
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+#include "broadphase.h"
+#include "convexHull.h"
+#include "../Core/threadPool.h"
+
+class CollisionWorld;
+
+struct RigidBodyDesc
+{
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::quat orientation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 linearVelocity = glm::vec3(0.0f);
+    glm::vec3 angularVelocity = glm::vec3(0.0f);
+    float mass = 1.0f;
+    float scale = 1.0f;     // uniform, applied to the shape
+    uint32_t shape = 0;     // from addSphereShape / addHullShape
+};
+
+// Wall time of the phases of the last step, in milliseconds
+struct PhysicsStepTimings
+{
+    double bounds = 0.0;
+    double broadphase = 0.0;
+    double narrowphase = 0.0;
+    double solve = 0.0;
+    double integrate = 0.0;
+    double total = 0.0;
+};
+
+// Dynamic rigid bodies (asteroid showers and the like) against each other,
+// the ground plane and the scene's static collision geometry.
+//
+// Body state is kept as parallel arrays indexed by body, which the bounds,
+// narrowphase, contact setup and integration passes split into blocks on the
+// thread pool. Contacts are merged in block order and solved sequentially,
+// so a step gives bit-identical results for the same input, whatever the
+// number of threads. Call step() with a fixed dt (the simulation tick).
+//
+// Bodies are approximated by their bounding sphere against static geometry,
+// and by a sphere for rotational inertia.
+class PhysicsWorld
+{
+public:
+    // Index used in contacts for the ground and the scene geometry
+    static const uint32_t STATIC_BODY = 0xFFFFFFFFu;
+
+    explicit PhysicsWorld(ThreadPool& pool = ThreadPool::getShared());
+
+    uint32_t addSphereShape(float radius);
+    // margin rounds the hull off; contacts within it never need the slow path
+    uint32_t addHullShape(const ConvexHull& hull, float margin);
+    uint32_t addBody(const RigidBodyDesc& desc);
+
+    // Removes every body; shapes stay unless clearShapes
+    void clear(bool clearShapes = false);
+
+    void setGravity(const glm::vec3& value) { gravity = value; }
+    // Infinite plane at y = height
+    void setGroundHeight(float height) { groundHeight = height; }
+    void setStaticGeometry(const CollisionWorld* geometry) { staticGeometry = geometry; }
+    void setSolverIterations(int iterations) { solverIterations = iterations; }
+
+    void step(float dt);
+
+    uint32_t getBodyCount() const { return (uint32_t)positions.size(); }
+    uint32_t getShapeCount() const { return (uint32_t)shapes.size(); }
+    const glm::vec3& getPosition(uint32_t body) const { return positions[body]; }
+    const glm::quat& getOrientation(uint32_t body) const { return orientations[body]; }
+    const glm::vec3& getLinearVelocity(uint32_t body) const { return linearVelocities[body]; }
+
+    uint32_t getPairCount() const { return (uint32_t)pairs.size(); }
+    uint32_t getContactCount() const { return (uint32_t)contacts.size(); }
+    const PhysicsStepTimings& getLastTimings() const { return timings; }
+
+private:
+    struct Shape
+    {
+        ConvexHull hull;    // empty for spheres
+        float radius;       // sphere radius, or the hull's rounding
+    };
+
+    struct Contact
+    {
+        uint32_t a;
+        uint32_t b;             // STATIC_BODY for static geometry
+        glm::vec3 point;
+        glm::vec3 normal;       // from a towards b
+        float depth;
+
+        // Filled in by prepareContacts
+        glm::vec3 offsetA;
+        glm::vec3 offsetB;
+        glm::vec3 tangent1;
+        glm::vec3 tangent2;
+        float normalMass;
+        float tangentMass1;
+        float tangentMass2;
+        float bias;
+        float normalImpulse;
+        float tangentImpulse1;
+        float tangentImpulse2;
+    };
+
+    ThreadPool& pool;
+    std::vector<Shape> shapes;
+
+    // Body state, one entry per body
+    std::vector<glm::vec3> positions;
+    std::vector<glm::quat> orientations;
+    std::vector<glm::vec3> linearVelocities;
+    std::vector<glm::vec3> angularVelocities;
+    std::vector<float> inverseMasses;
+    std::vector<float> inverseInertias;
+    std::vector<float> scales;
+    std::vector<float> boundingRadii;   // scaled, including the rounding
+    std::vector<uint32_t> bodyShapes;
+    std::vector<glm::vec3> boundsMin;
+    std::vector<glm::vec3> boundsMax;
+
+    SweepAndPrune broadphase;
+    std::vector<BodyPair> pairs;
+    std::vector<Contact> contacts;
+    std::vector<uint8_t> pairTouching;
+    std::vector<Contact> pairContacts;
+    std::vector<std::vector<Contact>> blockContacts;
+
+    glm::vec3 gravity = glm::vec3(0.0f, -9.81f, 0.0f);
+    float groundHeight = -1.0e30f;
+    const CollisionWorld* staticGeometry = nullptr;
+    int solverIterations = 8;
+    PhysicsStepTimings timings;
+
+    void integrateVelocities(float dt);
+    void updateBounds(float dt);
+    void findContacts(float dt);
+    void findStaticContacts(float dt);
+    void prepareContacts(float dt);
+    void solveContacts();
+    void integratePositions(float dt);
+
+    bool collideBodies(uint32_t a, uint32_t b, float dt, Contact& contact) const;
+};
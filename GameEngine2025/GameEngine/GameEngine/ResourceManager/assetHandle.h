@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+// 32-bit FNV-1a of an asset name. constexpr, so names spelled out in code can
+// be hashed by the compiler (see ASSET_NAME) instead of on every lookup.
+constexpr uint32_t hashAssetName(const char* name)
+{
+    uint32_t hash = 2166136261u;
+    while (*name)
+    {
+        hash ^= (unsigned char)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+inline uint32_t hashAssetName(const std::string& name)
+{
+    return hashAssetName(name.c_str());
+}
+
+// An asset name together with its hash
+struct AssetName
+{
+    uint32_t hash;
+    const char* text;
+};
+
+// Forces the hash of a literal name into a compile-time constant
+#define ASSET_NAME(text) AssetName{ std::integral_constant<uint32_t, hashAssetName(text)>::value, text }
+
+// Generational handle into an AssetTable: the low bits index a slot, the high
+// bits hold the slot's generation when the handle was issued. Generation 0 is
+// never issued, so a zero handle means "no asset".
+template<typename Tag>
+struct AssetHandle
+{
+    static const uint32_t INDEX_BITS = 20;
+    static const uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static const uint32_t MAX_GENERATION = (1u << (32 - INDEX_BITS)) - 1;
+
+    uint32_t value;
+
+    AssetHandle() : value(0) {}
+    AssetHandle(uint32_t index, uint32_t generation) : value((generation << INDEX_BITS) | index) {}
+
+    uint32_t getIndex() const { return value & INDEX_MASK; }
+    uint32_t getGeneration() const { return value >> INDEX_BITS; }
+    bool isValid() const { return value != 0; }
+
+    bool operator==(const AssetHandle& other) const { return value == other.value; }
+    bool operator!=(const AssetHandle& other) const { return value != other.value; }
+};
+
+struct MeshAssetTag;
+struct TextureAssetTag;
+typedef AssetHandle<MeshAssetTag> MeshHandle;
+typedef AssetHandle<TextureAssetTag> TextureHandle;
@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include "assetHandle.h"
+
+// Dense, fixed-capacity array of asset records addressed by generational
+// handles, plus an open-addressing index from name hash to slot. Slots are
+// allocated up front and never move, so resolving a handle is a plain array
+// access that needs no lock; find and insert must be serialized by the owner.
+template<typename Record, typename Tag>
+class AssetTable
+{
+public:
+    typedef AssetHandle<Tag> Handle;
+
+    explicit AssetTable(uint32_t capacity)
+        : slots(new Slot[capacity]),
+        capacity(capacity),
+        count(0),
+        bucketMask(0)
+    {
+        // Power of two at least twice the capacity keeps probe chains short
+        uint32_t bucketCount = 1;
+        while (bucketCount < capacity * 2)
+            bucketCount <<= 1;
+        buckets.reset(new uint32_t[bucketCount]());
+        bucketMask = bucketCount - 1;
+    }
+
+    // Handle of the named record, creating it if needed. Invalid when the
+    // table is full or the name's hash is already taken by another name.
+    Handle insert(uint32_t nameHash, const std::string& name)
+    {
+        uint32_t bucket = findBucket(nameHash);
+        if (buckets[bucket] != 0)
+        {
+            Slot& slot = slots[buckets[bucket] - 1];
+            if (slot.name != name)
+            {
+                std::cout << "Warning: asset names '" << slot.name << "' and '" << name << "' have the same hash" << std::endl;
+                return Handle();
+            }
+            return Handle(buckets[bucket] - 1, slot.generation);
+        }
+
+        if (count == capacity)
+        {
+            std::cout << "Warning: no room for asset '" << name << "' (" << capacity << " slots)" << std::endl;
+            return Handle();
+        }
+
+        uint32_t index = count++;
+        Slot& slot = slots[index];
+        slot.name = name;
+        slot.nameHash = nameHash;
+        buckets[bucket] = index + 1;
+        return Handle(index, slot.generation);
+    }
+
+    Handle find(uint32_t nameHash) const
+    {
+        uint32_t entry = buckets[findBucket(nameHash)];
+        if (entry == 0)
+            return Handle();
+        return Handle(entry - 1, slots[entry - 1].generation);
+    }
+
+    // True while the handle's record has not been cleared since it was issued
+    bool isCurrent(Handle handle) const
+    {
+        return handle.isValid() && handle.getIndex() < count &&
+            slots[handle.getIndex()].generation == handle.getGeneration();
+    }
+
+    // O(1). Debug builds also reject handles that outlived a clear()
+    Record* get(Handle handle)
+    {
+        if (!handle.isValid())
+            return nullptr;
+#ifdef _DEBUG
+        if (!isCurrent(handle))
+        {
+            std::cout << "Warning: stale asset handle " << handle.getIndex() << ":" << handle.getGeneration() << std::endl;
+            return nullptr;
+        }
+#endif
+        return &slots[handle.getIndex()].record;
+    }
+
+    const Record* get(Handle handle) const { return const_cast<AssetTable*>(this)->get(handle); }
+
+    const std::string& getName(Handle handle) const { return slots[handle.getIndex()].name; }
+
+    // Iteration over every record, e.g. for eviction
+    uint32_t getCount() const { return count; }
+    Record& at(uint32_t index) { return slots[index].record; }
+
+    // Drops every record and invalidates every handle issued so far
+    void clear()
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            // Destroy and rebuild rather than assign, so record memory is freed too
+            Slot& slot = slots[i];
+            slot.record.~Record();
+            new (&slot.record) Record();
+            std::string().swap(slot.name);
+            slot.generation = slot.generation == Handle::MAX_GENERATION ? 1 : slot.generation + 1;
+        }
+        for (uint32_t i = 0; i <= bucketMask; i++)
+            buckets[i] = 0;
+        count = 0;
+    }
+
+private:
+    AssetTable(const AssetTable&) = delete;
+    AssetTable& operator=(const AssetTable&) = delete;
+
+    struct Slot
+    {
+        Record record;
+        std::string name;
+        uint32_t nameHash = 0;
+        uint32_t generation = 1;
+    };
+
+    // Bucket holding nameHash, or the empty bucket where it would go
+    uint32_t findBucket(uint32_t nameHash) const
+    {
+        uint32_t bucket = nameHash & bucketMask;
+        while (buckets[bucket] != 0 && slots[buckets[bucket] - 1].nameHash != nameHash)
+            bucket = (bucket + 1) & bucketMask;
+        return bucket;
+    }
+
+    std::unique_ptr<Slot[]> slots;
+    uint32_t capacity;
+    uint32_t count;
+    std::unique_ptr<uint32_t[]> buckets;   // slot index + 1; 0 is empty
+    uint32_t bucketMask;
+};
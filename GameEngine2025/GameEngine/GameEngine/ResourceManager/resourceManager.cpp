@@ -1,5 +1,24 @@
 #include "resourceManager.h"
+#include "../Graphics/gpuUpload.h"
+#include "../Graphics/glStateCache.h"
+#include "../Model Loading/meshCache.h"
+#include "../Core/allocationTracker.h"
+#include "../Core/profiler.h"
+#include "../Core/threadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <thread>
+
+// Generous defaults; --memory-budget lowers them
+static const size_t DEFAULT_CPU_BUDGET = 512 * 1024 * 1024;
+static const size_t DEFAULT_GPU_BUDGET = 512 * 1024 * 1024;
+
+// Textures load with their levels up to this size; finer ones are streamed
+static const unsigned int STREAMING_START_SIZE = 64;
+// Updates (frames) a level may go unneeded before it is dropped again
+static const unsigned long long MIP_DROP_DELAY = 120;
 
 ResourceManager& ResourceManager::getInstance()
 {
@@ -7,127 +26,819 @@ ResourceManager& ResourceManager::getInstance()
     return instance;
 }
 
+ResourceManager::ResourceManager()
+    : textures(MAX_TEXTURES),
+    meshes(MAX_MESHES),
+    uploads(MAX_LOADS_IN_FLIGHT),
+    loadsInFlight(0),
+    placeholderTexture(0),
+    cpuBudget(DEFAULT_CPU_BUDGET),
+    gpuBudget(DEFAULT_GPU_BUDGET),
+    stats(),
+    releaseClock(0),
+    streamingUpdates(0)
+{
+}
+
 ResourceManager::~ResourceManager()
 {
     cleanup();
 }
 
+// ==================== TEXTURES ====================
+
+TextureHandle ResourceManager::registerTexture(const std::string& name, const std::string& path)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    TextureHandle handle = textures.insert(hashAssetName(name), name);
+    TextureRecord* record = textures.get(handle);
+    if (record && record->path.empty())
+        record->path = path;
+    return handle;
+}
+
 GLuint ResourceManager::loadTexture(const std::string& name, const std::string& path)
 {
-    // Check if already loaded
-    auto it = textures.find(name);
-    if (it != textures.end())
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    TextureHandle handle = registerTexture(name, path);
+
+    // Load it now without taking a reference
+    GLuint textureId = acquireTexture(handle);
+    releaseTexture(handle, ++releaseClock);
+    return textureId;
+}
+
+TextureHandle ResourceManager::findTexture(const std::string& name) const
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    TextureHandle handle = textures.find(hashAssetName(name));
+    if (!handle.isValid())
+        std::cout << "Warning: Texture '" << name << "' not found!" << std::endl;
+    return handle;
+}
+
+TextureHandle ResourceManager::findTexture(const AssetName& name) const
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    TextureHandle handle = textures.find(name.hash);
+    if (!handle.isValid())
+        std::cout << "Warning: Texture '" << name.text << "' not found!" << std::endl;
+    return handle;
+}
+
+GLuint ResourceManager::getTexture(TextureHandle texture)
+{
+    TextureRecord* record = textures.get(texture);
+    return record ? record->id : 0;
+}
+
+GLuint ResourceManager::acquireTexture(TextureHandle texture, bool async)
+{
+    TextureRecord* found = textures.get(texture);
+    if (!found)
+        return 0;
+
+    TextureRecord& record = *found;
+    record.refCount++;
+    if (record.id != 0 || record.missing)
+        return record.id;
+
+    // The placeholder is swapped for the real id when the upload lands
+    if (async || record.loading)
     {
-        return it->second;
+        requestLoad(texture, record);
+        return getPlaceholderTexture();
     }
 
-    // Load new texture
-    GLuint textureId = loadBMP(path.c_str());
-    textures[name] = textureId;
-    std::cout << "Loaded texture: " << name << " from " << path << std::endl;
-    return textureId;
+    ImageData image;
+    if (!decodeBMP(record.path.c_str(), image))
+    {
+        record.missing = true;
+        return 0;
+    }
+
+    buildMipChain(image, record.mips);
+    makeTextureResident(record, textures.getName(texture));
+    return record.id;
+}
+
+void ResourceManager::makeTextureResident(TextureRecord& record, const std::string& name)
+{
+    record.startLevel = 0;
+    while (record.startLevel + 1 < (int)record.mips.size() &&
+        std::max(record.mips[record.startLevel].width, record.mips[record.startLevel].height) > STREAMING_START_SIZE)
+        record.startLevel++;
+
+    record.id = uploadTextureLevels(record.mips, record.startLevel);
+    record.baseLevel = record.startLevel;
+    record.wantedLevel = (int)record.mips.size() - 1;
+    record.lastNeeded = streamingUpdates;
+
+    record.cpuBytes = 0;
+    for (const ImageData& level : record.mips)
+        record.cpuBytes += level.pixels.size();
+    record.gpuBytes = getTextureGpuBytes(record);
+    stats.cpuBytes += record.cpuBytes;
+    stats.gpuBytes += record.gpuBytes;
+    stats.residentTextures++;
+    std::cout << "Loaded texture: " << name << " from " << record.path << std::endl;
+}
+
+size_t ResourceManager::getTextureGpuBytes(const TextureRecord& record) const
+{
+    if (!isGpuUploadEnabled())
+        return 0;
+
+    // Drivers store RGB as RGBA
+    size_t bytes = 0;
+    for (size_t level = (size_t)record.baseLevel; level < record.mips.size(); level++)
+        bytes += (size_t)record.mips[level].width * record.mips[level].height * 4;
+    return bytes;
+}
+
+void ResourceManager::releaseTexture(TextureHandle texture, unsigned long long lastUsed)
+{
+    TextureRecord* record = textures.get(texture);
+    if (record && --record->refCount == 0)
+        record->lastUsed = lastUsed;
 }
 
-GLuint ResourceManager::getTexture(const std::string& name)
+void ResourceManager::evict(TextureRecord& record)
 {
-    auto it = textures.find(name);
-    if (it != textures.end())
+    if (record.pendingLevel >= 0)
+        finishTextureLevelUpload(record.pendingUpload, true);
+    record.pendingLevel = -1;
+
+    if (isGpuUploadEnabled())
     {
-        return it->second;
+        glDeleteTextures(1, &record.id);
+        GlStateCache::getInstance().forgetTexture(record.id);
     }
-    std::cout << "Warning: Texture '" << name << "' not found!" << std::endl;
-    return 0;
+    record.id = 0;
+    std::vector<ImageData>().swap(record.mips);
+
+    stats.cpuBytes -= record.cpuBytes;
+    stats.gpuBytes -= record.gpuBytes;
+    stats.residentTextures--;
+    stats.evictions++;
+    record.cpuBytes = record.gpuBytes = 0;
 }
 
-Mesh* ResourceManager::loadMesh(const std::string& name, const std::string& path)
+// ==================== MESHES ====================
+
+MeshHandle ResourceManager::addMeshRecord(const std::string& name, const std::string& path,
+    const std::vector<TextureBinding>& textureBindings)
 {
-    // Check if already loaded
-    auto it = meshes.find(name);
-    if (it != meshes.end())
+    MeshHandle handle = meshes.insert(hashAssetName(name), name);
+    MeshRecord* record = meshes.get(handle);
+    if (record && record->path.empty() && !record->pinned)
     {
-        return it->second.get();
+        record->path = path;
+        record->textures = textureBindings;
     }
+    return handle;
+}
 
-    // Load new mesh
-    Mesh loadedMesh = meshLoader.loadObj(path);
-    meshes[name] = std::make_unique<Mesh>(loadedMesh);
-    std::cout << "Loaded mesh: " << name << " from " << path << std::endl;
-    return meshes[name].get();
+MeshHandle ResourceManager::registerMesh(const std::string& name, const std::string& path,
+    const std::vector<TextureBinding>& textureBindings)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return addMeshRecord(name, path, textureBindings);
 }
 
-Mesh* ResourceManager::loadMesh(const std::string& name, const std::string& path,
+MeshHandle ResourceManager::loadMesh(const std::string& name, const std::string& path)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    MeshHandle handle = addMeshRecord(name, path, std::vector<TextureBinding>());
+    makeResident(handle);
+    return handle;
+}
+
+MeshHandle ResourceManager::loadMesh(const std::string& name, const std::string& path,
     const std::vector<std::string>& textureNames)
 {
-    // Check if already loaded
-    auto it = meshes.find(name);
-    if (it != meshes.end())
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    std::vector<TextureBinding> textureBindings;
+    for (const auto& texName : textureNames)
     {
-        return it->second.get();
+        TextureBinding binding;
+        binding.name = texName;
+        binding.type = "texture_diffuse"; // Default, can be customized
+        textureBindings.push_back(binding);
     }
 
-    // Build texture vector
-    std::vector<Texture> textureList;
-    for (const auto& texName : textureNames)
+    MeshHandle handle = addMeshRecord(name, path, textureBindings);
+    makeResident(handle);
+    return handle;
+}
+
+MeshHandle ResourceManager::findMesh(const std::string& name) const
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    MeshHandle handle = meshes.find(hashAssetName(name));
+    if (!handle.isValid())
+        std::cout << "Warning: Mesh '" << name << "' not found!" << std::endl;
+    return handle;
+}
+
+MeshHandle ResourceManager::findMesh(const AssetName& name) const
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    MeshHandle handle = meshes.find(name.hash);
+    if (!handle.isValid())
+        std::cout << "Warning: Mesh '" << name.text << "' not found!" << std::endl;
+    return handle;
+}
+
+MeshHandle ResourceManager::findMesh(uint32_t nameHash) const
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return meshes.find(nameHash);
+}
+
+void ResourceManager::acquireMesh(MeshHandle mesh)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    MeshRecord* record = meshes.get(mesh);
+    if (record)
+        record->refCount++;
+}
+
+void ResourceManager::releaseMesh(MeshHandle mesh)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    MeshRecord* record = meshes.get(mesh);
+    if (record && --record->refCount == 0)
+        record->lastUsed = ++releaseClock;
+}
+
+void ResourceManager::makeResident(MeshHandle mesh)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    MeshRecord* record = meshes.get(mesh);
+    if (record)
+        makeResident(*record);
+}
+
+// Collision hierarchy of a model, from its cache or built from the triangles.
+// Runs wherever the mesh is loaded, so async loads build it on the workers.
+static void loadCollisionMesh(const std::string& path, const std::vector<Vertex>& vertices,
+    const std::vector<int>& indices, TriangleBvh& bvh)
+{
+    if (readTriangleBvhCache(path, bvh))
+        return;
+    bvh.build(vertices, indices);
+    writeTriangleBvhCache(path, bvh);
+}
+
+void ResourceManager::makeResident(MeshRecord& record)
+{
+    if (record.resident || record.missing || record.loading)
+        return;
+
+    Mesh& mesh = record.mesh;
+    if (!readMeshCache(record.path, mesh.vertices, mesh.indices))
+    {
+        if (!meshLoader.parseObj(record.path, mesh.vertices, mesh.indices))
+        {
+            record.missing = true;
+            return;
+        }
+        writeMeshCache(record.path, mesh.vertices, mesh.indices);
+    }
+    loadCollisionMesh(record.path, mesh.vertices, mesh.indices, record.collision);
+
+    bindTextures(record, false);
+    finishResident(record);
+}
+
+void ResourceManager::bindTextures(MeshRecord& record, bool async)
+{
+    // Bindings name textures that may be registered after the mesh, so they
+    // are resolved here rather than at registration
+    Mesh& mesh = record.mesh;
+    mesh.textures.clear();
+    record.boundTextures.clear();
+    for (const TextureBinding& binding : record.textures)
+    {
+        TextureHandle handle = findTexture(binding.name);
+        Texture texture;
+        texture.id = acquireTexture(handle, async);
+        texture.type = binding.type;
+        mesh.textures.push_back(texture);
+        record.boundTextures.push_back(handle);
+    }
+}
+
+// Bounding radius around the origin and the UV range the vertices cover,
+// which the texture streaming needs to turn screen size into texel density
+static void measureMesh(const Mesh& mesh, float& radius, float& uvExtent)
+{
+    float radiusSquared = 0.0f;
+    glm::vec2 uvMin(0.0f), uvMax(0.0f);
+    if (!mesh.vertices.empty())
+        uvMin = uvMax = mesh.vertices[0].textureCoords;
+
+    for (const Vertex& vertex : mesh.vertices)
+    {
+        radiusSquared = std::max(radiusSquared, glm::dot(vertex.pos, vertex.pos));
+        uvMin.x = std::min(uvMin.x, vertex.textureCoords.x);
+        uvMin.y = std::min(uvMin.y, vertex.textureCoords.y);
+        uvMax.x = std::max(uvMax.x, vertex.textureCoords.x);
+        uvMax.y = std::max(uvMax.y, vertex.textureCoords.y);
+    }
+
+    radius = std::sqrt(radiusSquared);
+    uvExtent = std::max(std::max(uvMax.x - uvMin.x, uvMax.y - uvMin.y), 0.01f);
+}
+
+void ResourceManager::finishResident(MeshRecord& record)
+{
+    Mesh& mesh = record.mesh;
+    measureMesh(mesh, record.boundingRadius, record.uvExtent);
+    mesh.setup();
+
+    record.resident = true;
+    record.cpuBytes = mesh.getCpuBytes() + record.collision.getMemoryBytes();
+    record.gpuBytes = mesh.getGpuBytes();
+    stats.cpuBytes += record.cpuBytes;
+    stats.gpuBytes += record.gpuBytes;
+    stats.residentMeshes++;
+    if (record.loadCount++ > 0)
+        stats.reloads++;
+}
+
+void ResourceManager::evict(MeshRecord& record)
+{
+    record.mesh.release();
+    record.mesh.textures.clear();
+    record.collision.clear();
+    for (TextureHandle texture : record.boundTextures)
+        releaseTexture(texture, record.lastUsed);
+    record.boundTextures.clear();
+
+    record.resident = false;
+    stats.cpuBytes -= record.cpuBytes;
+    stats.gpuBytes -= record.gpuBytes;
+    stats.residentMeshes--;
+    stats.evictions++;
+    record.cpuBytes = record.gpuBytes = 0;
+}
+
+// ==================== ASYNC LOADING ====================
+
+TextureHandle ResourceManager::loadTextureAsync(const std::string& name, const std::string& path)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    TextureHandle handle = registerTexture(name, path);
+    TextureRecord* record = textures.get(handle);
+    if (record)
+        requestLoad(handle, *record);
+    return handle;
+}
+
+MeshHandle ResourceManager::loadMeshAsync(const std::string& name, const std::string& path,
+    const std::vector<TextureBinding>& textureBindings)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    MeshHandle handle = addMeshRecord(name, path, textureBindings);
+    makeResidentAsync(handle);
+    return handle;
+}
+
+void ResourceManager::makeResidentAsync(MeshHandle mesh)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    MeshRecord* record = meshes.get(mesh);
+    if (record)
+        requestLoad(mesh, *record);
+}
+
+const std::string& ResourceManager::getMeshPath(MeshHandle mesh) const
+{
+    // Set at registration and never changed, so no lock
+    static const std::string none;
+    const MeshRecord* record = meshes.get(mesh);
+    return record ? record->path : none;
+}
+
+bool ResourceManager::isResident(MeshHandle mesh) const
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    const MeshRecord* record = meshes.get(mesh);
+    return record && record->resident;
+}
+
+bool ResourceManager::isLoading(MeshHandle mesh) const
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    const MeshRecord* record = meshes.get(mesh);
+    return record && record->loading;
+}
+
+unsigned int ResourceManager::getPendingLoadCount() const
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return loadsInFlight + (unsigned int)waitingLoads.size();
+}
+
+void ResourceManager::requestLoad(MeshHandle mesh, MeshRecord& record)
+{
+    if (record.resident || record.missing || record.loading || record.path.empty())
+        return;
+
+    record.loading = true;
+    LoadRequest request = { true, mesh.value, record.path };
+    waitingLoads.push_back(request);
+
+    // Decode the textures alongside the mesh; references are only taken when it uploads
+    for (const TextureBinding& binding : record.textures)
+    {
+        TextureHandle texture = textures.find(hashAssetName(binding.name));
+        TextureRecord* textureRecord = textures.get(texture);
+        if (textureRecord)
+            requestLoad(texture, *textureRecord);
+    }
+    startWaitingLoads();
+}
+
+void ResourceManager::requestLoad(TextureHandle texture, TextureRecord& record)
+{
+    if (record.id != 0 || record.missing || record.loading)
+        return;
+
+    record.loading = true;
+    LoadRequest request = { false, texture.value, record.path };
+    waitingLoads.push_back(request);
+    startWaitingLoads();
+}
+
+void ResourceManager::startWaitingLoads()
+{
+    while (loadsInFlight < MAX_LOADS_IN_FLIGHT && !waitingLoads.empty())
+    {
+        LoadRequest request = waitingLoads.front();
+        waitingLoads.pop_front();
+        loadsInFlight++;
+        ThreadPool::getShared().submit([this, request]() { runLoad(request); });
+    }
+}
+
+void ResourceManager::runLoad(const LoadRequest& request)
+{
+    // Worker thread: only files and the queue, never the tables or GL
+    PendingUpload* upload = new PendingUpload();
+    upload->isMesh = request.isMesh;
+    upload->handle = request.handle;
+
+    if (request.isMesh)
+    {
+        upload->loaded = readMeshCache(request.path, upload->vertices, upload->indices);
+        if (!upload->loaded)
+        {
+            MeshLoaderObj loader;
+            upload->loaded = loader.parseObj(request.path, upload->vertices, upload->indices);
+            if (upload->loaded)
+                writeMeshCache(request.path, upload->vertices, upload->indices);
+        }
+        if (upload->loaded)
+            loadCollisionMesh(request.path, upload->vertices, upload->indices, upload->collision);
+    }
+    else
+    {
+        ImageData image;
+        upload->loaded = decodeBMP(request.path.c_str(), image);
+        if (upload->loaded)
+            buildMipChain(image, upload->mips);
+    }
+
+    // Cannot fail: there are never more uploads than queue slots
+    uploads.push(upload);
+}
+
+unsigned int ResourceManager::processUploads(double budgetMs)
+{
+    PROFILE_SCOPE("processUploads");
+    ExpectedAllocationScope expected;   // uploads hand over loaded data and create GL objects
+
+    auto start = std::chrono::high_resolution_clock::now();
+    unsigned int uploaded = 0;
+    PendingUpload* upload = nullptr;
+    while (uploads.pop(upload))
+    {
+        std::unique_ptr<PendingUpload> owned(upload);
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            loadsInFlight--;
+            finishUpload(*owned);
+        }
+        uploaded++;
+
+        if (std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() >= budgetMs)
+            break;
+    }
+
+    if (uploaded > 0)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        startWaitingLoads();
+        enforceBudget();
+    }
+    return uploaded;
+}
+
+void ResourceManager::finishUpload(PendingUpload& upload)
+{
+    if (upload.isMesh)
+    {
+        MeshHandle handle;
+        handle.value = upload.handle;
+        MeshRecord* record = meshes.isCurrent(handle) ? meshes.get(handle) : nullptr;
+        if (!record || !record->loading)
+            return;
+
+        record->loading = false;
+        if (!upload.loaded)
+        {
+            record->missing = true;
+            return;
+        }
+
+        record->mesh.vertices.swap(upload.vertices);
+        record->mesh.indices.swap(upload.indices);
+        record->collision.swap(upload.collision);
+        bindTextures(*record, true);
+        finishResident(*record);
+        if (record->refCount == 0)
+            record->lastUsed = ++releaseClock;
+        return;
+    }
+
+    TextureHandle handle;
+    handle.value = upload.handle;
+    TextureRecord* record = textures.isCurrent(handle) ? textures.get(handle) : nullptr;
+    if (!record || !record->loading)
+        return;
+
+    record->loading = false;
+    if (!upload.loaded)
+        record->missing = true;
+    else
+    {
+        record->mips.swap(upload.mips);
+        makeTextureResident(*record, textures.getName(handle));
+        if (record->refCount == 0)
+            record->lastUsed = ++releaseClock;
+    }
+
+    // Meshes that went resident first are still sampling the placeholder
+    for (uint32_t i = 0; i < meshes.getCount(); i++)
+    {
+        MeshRecord& mesh = meshes.at(i);
+        for (size_t j = 0; j < mesh.boundTextures.size(); j++)
+        {
+            if (mesh.boundTextures[j] == handle && j < mesh.mesh.textures.size())
+                mesh.mesh.textures[j].id = record->id;
+        }
+    }
+}
+
+void ResourceManager::waitForLoads()
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        waitingLoads.clear();
+    }
+
+    // Without the lock: a worker may be queued behind a task that needs it
+    for (;;)
     {
-        GLuint texId = getTexture(texName);
-        if (texId != 0)
+        PendingUpload* upload = nullptr;
+        if (uploads.pop(upload))
+        {
+            delete upload;
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            loadsInFlight--;
+            continue;
+        }
+
         {
-            Texture tex;
-            tex.id = texId;
-            tex.type = "texture_diffuse"; // Default, can be customized
-            textureList.push_back(tex);
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            if (loadsInFlight == 0)
+                return;
         }
+        std::this_thread::yield();
     }
+}
 
-    // Load mesh with textures
-    Mesh loadedMesh = meshLoader.loadObj(path, textureList);
-    meshes[name] = std::make_unique<Mesh>(loadedMesh);
-    std::cout << "Loaded mesh with textures: " << name << " from " << path << std::endl;
-    return meshes[name].get();
+GLuint ResourceManager::getPlaceholderTexture()
+{
+    if (placeholderTexture == 0)
+    {
+        // One mid-grey texel
+        ImageData image;
+        image.width = 1;
+        image.height = 1;
+        image.pixels.assign(3, 128);
+        placeholderTexture = uploadTexture(image);
+    }
+    return placeholderTexture;
 }
 
-Mesh* ResourceManager::getMesh(const std::string& name)
+// ==================== TEXTURE STREAMING ====================
+
+void ResourceManager::requestTextureDetail(MeshHandle mesh, float pixelsPerUnit)
 {
-    auto it = meshes.find(name);
-    if (it != meshes.end())
+    // Hot path, once per drawn object; the fields it touches are main-thread only
+    MeshRecord* record = meshes.get(mesh);
+    if (!record || !record->resident || pixelsPerUnit <= 0.0f)
+        return;
+
+    float pixels = std::max(2.0f * record->boundingRadius * pixelsPerUnit, 1.0f);
+    for (TextureHandle handle : record->boundTextures)
     {
-        return it->second.get();
+        TextureRecord* texture = textures.get(handle);
+        if (!texture || texture->mips.empty())
+            continue;
+
+        // Each level halves the texels spread over the object's pixels
+        float texelsPerPixel = texture->mips[0].width * record->uvExtent / pixels;
+        int level = texelsPerPixel > 1.0f ? (int)std::log2(texelsPerPixel) : 0;
+        texture->wantedLevel = std::min(texture->wantedLevel, level);
     }
-    std::cout << "Warning: Mesh '" << name << "' not found!" << std::endl;
-    return nullptr;
 }
 
-Mesh* ResourceManager::createStarField(const std::string& name, int numStars, float spaceSize)
+void ResourceManager::updateTextureStreaming(size_t budgetBytes)
 {
-    auto it = meshes.find(name);
-    if (it != meshes.end())
+    PROFILE_SCOPE("updateTextureStreaming");
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    streamingUpdates++;
+    size_t uploadedBytes = 0;
+    for (uint32_t i = 0; i < textures.getCount(); i++)
     {
-        return it->second.get();
+        TextureRecord& record = textures.at(i);
+        int lastLevel = (int)record.mips.size() - 1;
+        int wanted = record.wantedLevel;
+        record.wantedLevel = lastLevel;
+        if (record.id == 0 || lastLevel < 0)
+            continue;
+
+        // The finer level only becomes visible once the GPU has it
+        if (record.pendingLevel >= 0)
+        {
+            if (!finishTextureLevelUpload(record.pendingUpload))
+                continue;
+
+            setTextureBaseLevel(record.id, record.pendingLevel);
+            record.baseLevel = record.pendingLevel;
+            record.pendingLevel = -1;
+            stats.gpuBytes -= record.gpuBytes;
+            record.gpuBytes = getTextureGpuBytes(record);
+            stats.gpuBytes += record.gpuBytes;
+            stats.streamedMips++;
+        }
+
+        if (wanted <= record.baseLevel)
+            record.lastNeeded = streamingUpdates;
+
+        if (wanted < record.baseLevel)
+        {
+            int level = record.baseLevel - 1;
+            size_t bytes = record.mips[level].pixels.size();
+            if (uploadedBytes > 0 && uploadedBytes + bytes > budgetBytes)
+                continue;
+
+            record.pendingUpload = beginTextureLevelUpload(record.id, level, record.mips[level]);
+            record.pendingLevel = level;
+            uploadedBytes += bytes;
+        }
+        else if (record.baseLevel < record.startLevel && streamingUpdates - record.lastNeeded > MIP_DROP_DELAY)
+        {
+            // One level per delay, so a brief look away costs little
+            setTextureBaseLevel(record.id, record.baseLevel + 1);
+            releaseTextureLevel(record.id, record.baseLevel);
+            record.baseLevel++;
+            record.lastNeeded = streamingUpdates;
+            stats.gpuBytes -= record.gpuBytes;
+            record.gpuBytes = getTextureGpuBytes(record);
+            stats.gpuBytes += record.gpuBytes;
+            stats.droppedMips++;
+        }
     }
+}
 
-    Mesh* stars = createStarsInternal(numStars, spaceSize);
-    meshes[name] = std::unique_ptr<Mesh>(stars);
-    return meshes[name].get();
+// ==================== BUDGET ====================
+
+void ResourceManager::setMemoryBudget(size_t cpuBytes, size_t gpuBytes)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    cpuBudget = cpuBytes;
+    gpuBudget = gpuBytes;
 }
 
-Mesh* ResourceManager::createGround(const std::string& name, float size, const std::string& textureName)
+void ResourceManager::enforceBudget()
 {
-    auto it = meshes.find(name);
-    if (it != meshes.end())
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    while (stats.cpuBytes > cpuBudget || stats.gpuBytes > gpuBudget)
     {
-        return it->second.get();
+        // Least recently released of everything nobody holds. Evicting a mesh
+        // drops its texture references, so those become candidates next round.
+        MeshRecord* oldestMesh = nullptr;
+        for (uint32_t i = 0; i < meshes.getCount(); i++)
+        {
+            MeshRecord& record = meshes.at(i);
+            if (record.resident && !record.pinned && record.refCount == 0 &&
+                (!oldestMesh || record.lastUsed < oldestMesh->lastUsed))
+                oldestMesh = &record;
+        }
+
+        TextureRecord* oldestTexture = nullptr;
+        for (uint32_t i = 0; i < textures.getCount(); i++)
+        {
+            TextureRecord& record = textures.at(i);
+            if (record.id != 0 && record.refCount == 0 &&
+                (!oldestTexture || record.lastUsed < oldestTexture->lastUsed))
+                oldestTexture = &record;
+        }
+
+        if (oldestTexture && (!oldestMesh || oldestTexture->lastUsed <= oldestMesh->lastUsed))
+        {
+            evict(*oldestTexture);
+        }
+        else if (oldestMesh)
+        {
+            evict(*oldestMesh);
+        }
+        else
+        {
+            std::cout << "Warning: referenced assets exceed the memory budget ("
+                << stats.cpuBytes / (1024 * 1024) << " MB CPU, " << stats.gpuBytes / (1024 * 1024) << " MB GPU)" << std::endl;
+            break;
+        }
     }
+}
+
+ResourceMemoryStats ResourceManager::getMemoryStats() const
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return stats;
+}
 
-    GLuint texId = getTexture(textureName);
-    Mesh* ground = createGroundInternal(size, texId);
-    meshes[name] = std::unique_ptr<Mesh>(ground);
-    return meshes[name].get();
+// ==================== PROCEDURAL MESHES ====================
+
+MeshHandle ResourceManager::createStarField(const std::string& name, int numStars, float spaceSize)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    MeshHandle handle = meshes.insert(hashAssetName(name), name);
+    MeshRecord* record = meshes.get(handle);
+    if (!record || record->resident)
+        return handle;
+
+    createStarsInternal(record->mesh, numStars, spaceSize);
+    pinProceduralMesh(*record);
+    return handle;
 }
 
-Mesh* ResourceManager::createStarsInternal(int numStars, float spaceSize)
+MeshHandle ResourceManager::createGround(const std::string& name, float size, const std::string& textureName)
 {
-    std::vector<Vertex> vertices;
-    std::vector<int> indices;
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    MeshHandle handle = meshes.insert(hashAssetName(name), name);
+    MeshRecord* record = meshes.get(handle);
+    if (!record || record->resident)
+        return handle;
+
+    // The reference is the mesh's, like for a resident loaded mesh
+    TextureHandle texture = findTexture(textureName);
+    GLuint texId = acquireTexture(texture);
+    TextureBinding binding = { textureName, "texture_diffuse" };
+    record->textures.assign(1, binding);
+    record->boundTextures.assign(1, texture);
+
+    createGroundInternal(record->mesh, size, texId);
+    pinProceduralMesh(*record);
+    return handle;
+}
+
+void ResourceManager::pinProceduralMesh(MeshRecord& record)
+{
+    measureMesh(record.mesh, record.boundingRadius, record.uvExtent);
+    record.pinned = true;
+    record.resident = true;
+    record.loadCount = 1;
+    record.cpuBytes = record.mesh.getCpuBytes();
+    record.gpuBytes = record.mesh.getGpuBytes();
+    stats.cpuBytes += record.cpuBytes;
+    stats.gpuBytes += record.gpuBytes;
+    stats.residentMeshes++;
+}
+
+void ResourceManager::createStarsInternal(Mesh& mesh, int numStars, float spaceSize)
+{
+    std::vector<Vertex>& vertices = mesh.vertices;
+    std::vector<int>& indices = mesh.indices;
 
     srand(42);
     for (int i = 0; i < numStars; i++)
@@ -144,13 +855,13 @@ Mesh* ResourceManager::createStarsInternal(int numStars, float spaceSize)
         vertices.push_back(star);
         indices.push_back(i);
     }
-    return new Mesh(vertices, indices);
+    mesh.setup2();
 }
 
-Mesh* ResourceManager::createGroundInternal(float size, GLuint textureId)
+void ResourceManager::createGroundInternal(Mesh& mesh, float size, GLuint textureId)
 {
-    std::vector<Vertex> vertices;
-    std::vector<int> indices;
+    std::vector<Vertex>& vertices = mesh.vertices;
+    std::vector<int>& indices = mesh.indices;
 
     int gridSize = 20;
     float step = (size * 2.0f) / gridSize;
@@ -193,17 +904,44 @@ Mesh* ResourceManager::createGroundInternal(float size, GLuint textureId)
         }
     }
 
-    std::vector<Texture> textures;
     Texture tex;
     tex.id = textureId;
     tex.type = "texture_diffuse";
-    textures.push_back(tex);
+    mesh.textures.assign(1, tex);
 
-    return new Mesh(vertices, indices, textures);
+    mesh.setup();
 }
 
 void ResourceManager::cleanup()
 {
+    // Results of abandoned loads are dropped; their records are about to go
+    waitForLoads();
+
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    // At exit the context may already be gone; the driver frees everything then anyway
+    if (isGpuUploadEnabled() && glfwGetCurrentContext())
+    {
+        for (uint32_t i = 0; i < meshes.getCount(); i++)
+            meshes.at(i).mesh.release();
+        for (uint32_t i = 0; i < textures.getCount(); i++)
+        {
+            TextureRecord& record = textures.at(i);
+            if (record.pendingLevel >= 0)
+                finishTextureLevelUpload(record.pendingUpload, true);
+            if (record.id != 0)
+                glDeleteTextures(1, &record.id);
+        }
+        if (placeholderTexture != 0)
+            glDeleteTextures(1, &placeholderTexture);
+
+        // Names freed in bulk; none of the cached bindings can be trusted
+        GlStateCache::getInstance().invalidate();
+    }
+    placeholderTexture = 0;
+
+    // Bumps every generation, so handles held past this point are caught in debug builds
     meshes.clear();
     textures.clear();
+    stats = ResourceMemoryStats();
 }
\ No newline at end of file
@@ -1,41 +1,258 @@
 #pragma once
-#include <map>
+#include <deque>
 #include <string>
-#include <memory>
+#include <mutex>
+#include "assetHandle.h"
+#include "assetTable.h"
+#include "../Core/boundedQueue.h"
+#include "../Collision/triangleBvh.h"
 #include "../Model Loading/mesh.h"
 #include "../Model Loading/texture.h"
 #include "../Model Loading/meshLoaderObj.h"
 
+// A texture a mesh samples, by resource name
+struct TextureBinding
+{
+    std::string name;
+    std::string type;   // sampler prefix in the shader, e.g. "texture_diffuse"
+};
+
+// Memory held by resident assets, and how often the budget forced a reload
+struct ResourceMemoryStats
+{
+    size_t cpuBytes;
+    size_t gpuBytes;
+    unsigned int residentMeshes;
+    unsigned int residentTextures;
+    unsigned int evictions;     // since startup
+    unsigned int reloads;
+    unsigned int streamedMips;  // texture levels streamed in / dropped again
+    unsigned int droppedMips;
+};
+
+// Owns every mesh and texture. Assets are registered by name and path, loaded
+// when first made resident, and evicted again (least recently released first)
+// once nothing references them and the memory budget is exceeded.
+//
+// Callers hold MeshHandle / TextureHandle values and look names up only when
+// they register or first bind an asset; resolving a handle is an array index.
+// Handles stay valid until cleanup(); an evicted mesh simply has no data until
+// it is made resident again.
+//
+// The *Async calls only queue work: files are read and decoded on the shared
+// thread pool, and the results wait in a lock-free queue until the main
+// thread's processUploads hands them to GL within a per-frame time budget.
+//
+// Textures start with only their coarse mips on the GPU. Renderers report
+// how large each mesh appears on screen (requestTextureDetail), and
+// updateTextureStreaming uploads finer levels through pixel buffer objects
+// or drops levels nothing has needed for a while.
 class ResourceManager
 {
 public:
+    static const uint32_t MAX_MESHES = 4096;
+    static const uint32_t MAX_TEXTURES = 4096;
+
     static ResourceManager& getInstance();
 
-    // Load and cache textures
+    // Registration only records where an asset comes from
+    TextureHandle registerTexture(const std::string& name, const std::string& path);
+    MeshHandle registerMesh(const std::string& name, const std::string& path, const std::vector<TextureBinding>& textures);
+
+    // Load and cache textures. The id of an unreferenced texture is only valid
+    // until the next enforceBudget; meshes get theirs through TextureBinding
     GLuint loadTexture(const std::string& name, const std::string& path);
-    GLuint getTexture(const std::string& name);
+    TextureHandle findTexture(const std::string& name) const;
+    TextureHandle findTexture(const AssetName& name) const;
+    GLuint getTexture(TextureHandle texture);
+
+    // Load and cache meshes (register and make resident at once)
+    MeshHandle loadMesh(const std::string& name, const std::string& path);
+    MeshHandle loadMesh(const std::string& name, const std::string& path, const std::vector<std::string>& textureNames);
+
+    // Name lookups; the hash form takes precomputed hashes (ASSET_NAME, compiled scenes)
+    MeshHandle findMesh(const std::string& name) const;
+    MeshHandle findMesh(const AssetName& name) const;
+    MeshHandle findMesh(uint32_t nameHash) const;
+
+    // Hot path: no lock, no hashing. Null for an invalid handle (and, in debug
+    // builds, for one issued before the last cleanup) and while the mesh is
+    // not resident, so renderers skip meshes that are still loading
+    Mesh* getMesh(MeshHandle mesh)
+    {
+        MeshRecord* record = meshes.get(mesh);
+        return record && record->resident ? &record->mesh : nullptr;
+    }
+
+    // Triangle BVH of a resident model, for collision queries; same rules as
+    // getMesh, and null for procedural meshes
+    const TriangleBvh* getCollisionMesh(MeshHandle mesh) const
+    {
+        const MeshRecord* record = meshes.get(mesh);
+        return record && record->resident && !record->collision.isEmpty() ? &record->collision : nullptr;
+    }
+
+    // Bounding radius around the model origin, for culling; same rules as getMesh, 0 when not resident
+    float getMeshRadius(MeshHandle mesh) const
+    {
+        const MeshRecord* record = meshes.get(mesh);
+        return record && record->resident ? record->boundingRadius : 0.0f;
+    }
+
+    // Model file a mesh was registered with; empty for procedural meshes and invalid handles
+    const std::string& getMeshPath(MeshHandle mesh) const;
+
+    // Procedural meshes; they cannot be reloaded, so they are never evicted
+    MeshHandle createStarField(const std::string& name, int numStars, float spaceSize);
+    MeshHandle createGround(const std::string& name, float size, const std::string& textureName);
+
+    // Reference counts, held by GameObjects and scenes for the meshes they draw.
+    // Safe from any thread; invalid handles are ignored.
+    void acquireMesh(MeshHandle mesh);
+    void releaseMesh(MeshHandle mesh);
 
-    // Load and cache meshes
-    Mesh* loadMesh(const std::string& name, const std::string& path);
-    Mesh* loadMesh(const std::string& name, const std::string& path, const std::vector<std::string>& textureNames);
-    Mesh* getMesh(const std::string& name);
+    // Reloads an evicted mesh and its textures, from the mesh cache when possible
+    // (main thread). A mesh already loading asynchronously is left to finish there.
+    void makeResident(MeshHandle mesh);
 
-    // Procedural meshes
-    Mesh* createStarField(const std::string& name, int numStars, float spaceSize);
-    Mesh* createGround(const std::string& name, float size, const std::string& textureName);
+    // Non-blocking loads; the handle is usable at once and the asset appears
+    // once processUploads has uploaded it. Meshes sample a placeholder texture
+    // until their own textures arrive. Safe from any thread.
+    TextureHandle loadTextureAsync(const std::string& name, const std::string& path);
+    MeshHandle loadMeshAsync(const std::string& name, const std::string& path, const std::vector<TextureBinding>& textures);
+    void makeResidentAsync(MeshHandle mesh);
+    bool isResident(MeshHandle mesh) const;
+    bool isLoading(MeshHandle mesh) const;     // requested and neither uploaded nor failed yet
+    unsigned int getPendingLoadCount() const;
+
+    // Uploads finished loads until budgetMs has passed, at least one per call.
+    // Main thread, once per frame; returns the number uploaded.
+    unsigned int processUploads(double budgetMs);
+
+    // Texture streaming (main thread). pixelsPerUnit is the on-screen size of
+    // one world unit at the mesh's distance; each call may only ask for more
+    // detail than the frame's earlier requests. The update then moves every
+    // texture one level towards what was asked, uploading at most budgetBytes
+    // (but at least one level) per call.
+    void requestTextureDetail(MeshHandle mesh, float pixelsPerUnit);
+    void updateTextureStreaming(size_t budgetBytes);
+
+    // Evicts unreferenced assets until both totals fit the budget (main thread)
+    void setMemoryBudget(size_t cpuBytes, size_t gpuBytes);
+    void enforceBudget();
+    ResourceMemoryStats getMemoryStats() const;
 
     void cleanup();
 
 private:
-    ResourceManager() {}
+    ResourceManager();
     ~ResourceManager();
     ResourceManager(const ResourceManager&) = delete;
     ResourceManager& operator=(const ResourceManager&) = delete;
 
-    std::map<std::string, GLuint> textures;
-    std::map<std::string, std::unique_ptr<Mesh>> meshes;
+    struct TextureRecord
+    {
+        std::string path;
+        GLuint id = 0;              // 0 while evicted
+        int refCount = 0;           // resident meshes sampling it
+        unsigned long long lastUsed = 0;
+        size_t gpuBytes = 0;
+        bool missing = false;       // failed to load once; not retried
+        bool loading = false;       // decode queued or running on a worker
+
+        // Streaming: the full chain stays on the CPU, levels >= baseLevel on the GPU
+        std::vector<ImageData> mips;
+        size_t cpuBytes = 0;
+        int startLevel = 0;         // coarse levels uploaded at load; never dropped
+        int baseLevel = 0;
+        int wantedLevel = 0;        // finest level requested since the last update
+        unsigned long long lastNeeded = 0;  // update in which baseLevel was last needed
+        int pendingLevel = -1;      // level in flight through a PBO
+        TextureLevelUpload pendingUpload = { 0, nullptr };
+    };
+
+    struct MeshRecord
+    {
+        std::string path;           // empty for procedural meshes
+        Mesh mesh;
+        TriangleBvh collision;      // built with the mesh, or read from its .bvhcache
+        std::vector<TextureBinding> textures;
+        std::vector<TextureHandle> boundTextures;   // references taken while resident
+        int refCount = 0;
+        unsigned long long lastUsed = 0;
+        bool resident = false;
+        bool pinned = false;
+        bool missing = false;
+        bool loading = false;
+        unsigned int loadCount = 0;
+        size_t cpuBytes = 0;
+        size_t gpuBytes = 0;
+        float boundingRadius = 0.0f;    // around the model origin
+        float uvExtent = 1.0f;          // texture repeats across the mesh
+    };
+
+    // Lookups and reference counts may come from worker threads (scene
+    // prefetch); loading, eviction and cleanup stay on the main thread
+    // because they touch GL. Resolving a handle does not need the lock.
+    mutable std::recursive_mutex mutex;
+
+    AssetTable<TextureRecord, TextureAssetTag> textures;
+    AssetTable<MeshRecord, MeshAssetTag> meshes;
     MeshLoaderObj meshLoader;
 
-    Mesh* createStarsInternal(int numStars, float spaceSize);
-    Mesh* createGroundInternal(float size, GLuint textureId);
-};
\ No newline at end of file
+    struct LoadRequest
+    {
+        bool isMesh;
+        uint32_t handle;            // MeshHandle or TextureHandle value
+        std::string path;
+    };
+
+    // A file read and decoded on a worker, waiting for its GL upload
+    struct PendingUpload
+    {
+        bool isMesh;
+        uint32_t handle;
+        bool loaded;                // false when the file is missing or unreadable
+        std::vector<ImageData> mips;
+        std::vector<Vertex> vertices;
+        std::vector<int> indices;
+        TriangleBvh collision;
+    };
+
+    // No more loads run than the queue holds, so a worker never waits to push
+    // its result; the rest wait in waitingLoads until uploads free a slot
+    static const unsigned int MAX_LOADS_IN_FLIGHT = 32;
+    BoundedQueue<PendingUpload*> uploads;
+    std::deque<LoadRequest> waitingLoads;
+    unsigned int loadsInFlight;
+    GLuint placeholderTexture;
+
+    size_t cpuBudget;
+    size_t gpuBudget;
+    ResourceMemoryStats stats;
+    unsigned long long releaseClock;    // orders releases for LRU eviction
+    unsigned long long streamingUpdates;
+
+    MeshHandle addMeshRecord(const std::string& name, const std::string& path, const std::vector<TextureBinding>& textures);
+    void makeResident(MeshRecord& record);
+    void bindTextures(MeshRecord& record, bool async);
+    void finishResident(MeshRecord& record);
+    void evict(MeshRecord& record);
+    GLuint acquireTexture(TextureHandle texture, bool async = false);
+    void releaseTexture(TextureHandle texture, unsigned long long lastUsed);
+    void evict(TextureRecord& record);
+    void makeTextureResident(TextureRecord& record, const std::string& name);
+    size_t getTextureGpuBytes(const TextureRecord& record) const;
+    void pinProceduralMesh(MeshRecord& record);
+
+    void requestLoad(MeshHandle mesh, MeshRecord& record);
+    void requestLoad(TextureHandle texture, TextureRecord& record);
+    void startWaitingLoads();
+    void runLoad(const LoadRequest& request);
+    void finishUpload(PendingUpload& upload);
+    void waitForLoads();
+    GLuint getPlaceholderTexture();
+
+    void createStarsInternal(Mesh& mesh, int numStars, float spaceSize);
+    void createGroundInternal(Mesh& mesh, float size, GLuint textureId);
+};
@@ -0,0 +1,558 @@
+#include "sceneFile.h"
+#include "../ECS/components.h"
+#include "../GameObject/gameObject.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+// ==================== LOADING ====================
+
+SceneFile::SceneFile()
+    : header(nullptr),
+    meshes(nullptr),
+    placements(nullptr),
+    triggers(nullptr),
+    volumes(nullptr),
+    cells(nullptr),
+    cellMeshes(nullptr),
+    strings(nullptr)
+{
+}
+
+bool SceneFile::open(const std::string& path)
+{
+    buffer.clear();
+    if (!mapping.open(path))
+        return false;
+    return validate(mapping.getData(), mapping.getSize(), path);
+}
+
+bool SceneFile::openBuffer(std::vector<unsigned char>& bytes, const std::string& source)
+{
+    mapping.close();
+    buffer.swap(bytes);
+    return validate(buffer.data(), buffer.size(), source);
+}
+
+bool SceneFile::validate(const unsigned char* data, size_t size, const std::string& source)
+{
+    header = nullptr;
+
+    const SceneFileHeader* candidate = reinterpret_cast<const SceneFileHeader*>(data);
+    if (size < sizeof(SceneFileHeader) || candidate->magic != SCENE_FILE_MAGIC)
+    {
+        std::cout << "Warning: '" << source << "' is not a compiled scene" << std::endl;
+        return false;
+    }
+    if (candidate->version != SCENE_FILE_VERSION)
+    {
+        std::cout << "Warning: '" << source << "' has scene format version " << candidate->version
+            << ", expected " << SCENE_FILE_VERSION << "; recompile it" << std::endl;
+        return false;
+    }
+
+    // 64-bit sums, so huge counts in a corrupt file cannot wrap around
+    unsigned long long expected = sizeof(SceneFileHeader) +
+        (unsigned long long)sizeof(SceneMeshRecord) * candidate->meshCount +
+        (unsigned long long)sizeof(ScenePlacement) * candidate->placementCount +
+        (unsigned long long)sizeof(SceneTriggerRecord) * candidate->triggerCount +
+        (unsigned long long)sizeof(SceneVolumeRecord) * candidate->volumeCount +
+        (unsigned long long)sizeof(SceneCellRecord) * candidate->cellCount +
+        (unsigned long long)sizeof(uint32_t) * candidate->cellMeshCount +
+        candidate->stringBytes;
+    if (expected != size || candidate->stringBytes == 0 || data[size - 1] != '\0')
+    {
+        std::cout << "Warning: '" << source << "' is truncated or corrupt" << std::endl;
+        return false;
+    }
+
+    const unsigned char* cursor = data + sizeof(SceneFileHeader);
+    meshes = reinterpret_cast<const SceneMeshRecord*>(cursor);
+    cursor += sizeof(SceneMeshRecord) * candidate->meshCount;
+    placements = reinterpret_cast<const ScenePlacement*>(cursor);
+    cursor += sizeof(ScenePlacement) * candidate->placementCount;
+    triggers = reinterpret_cast<const SceneTriggerRecord*>(cursor);
+    cursor += sizeof(SceneTriggerRecord) * candidate->triggerCount;
+    volumes = reinterpret_cast<const SceneVolumeRecord*>(cursor);
+    cursor += sizeof(SceneVolumeRecord) * candidate->volumeCount;
+    cells = reinterpret_cast<const SceneCellRecord*>(cursor);
+    cursor += sizeof(SceneCellRecord) * candidate->cellCount;
+    cellMeshes = reinterpret_cast<const uint32_t*>(cursor);
+    cursor += sizeof(uint32_t) * candidate->cellMeshCount;
+    strings = reinterpret_cast<const char*>(cursor);
+
+    // Every index and offset is checked once here, so instantiation can trust them
+    bool valid = candidate->name < candidate->stringBytes;
+    for (uint32_t i = 0; i < candidate->meshCount; i++)
+        valid = valid && meshes[i].name < candidate->stringBytes;
+    for (uint32_t i = 0; i < candidate->placementCount; i++)
+        valid = valid && placements[i].mesh < candidate->meshCount;
+    for (uint32_t i = 0; i < candidate->triggerCount; i++)
+        valid = valid && triggers[i].message < candidate->stringBytes;
+    if (candidate->hasBag)
+        valid = valid && candidate->bag.mesh < candidate->meshCount;
+
+    // Cells cover their placement ranges and are sorted, so lookups can bisect
+    valid = valid && (candidate->cellCount == 0 || candidate->cellSize > 0.0f);
+    for (uint32_t i = 0; i < candidate->cellCount; i++)
+    {
+        const SceneCellRecord& cell = cells[i];
+        valid = valid && (unsigned long long)cell.firstPlacement + cell.placementCount <= candidate->placementCount &&
+            (unsigned long long)cell.firstMesh + cell.meshCount <= candidate->cellMeshCount;
+        if (i > 0)
+            valid = valid && (cells[i - 1].z < cell.z || (cells[i - 1].z == cell.z && cells[i - 1].x < cell.x));
+    }
+    for (uint32_t i = 0; i < candidate->cellMeshCount; i++)
+        valid = valid && cellMeshes[i] < candidate->meshCount;
+
+    if (!valid)
+    {
+        std::cout << "Warning: '" << source << "' references data outside the file" << std::endl;
+        return false;
+    }
+
+    // A hash function change would otherwise resolve meshes silently wrong
+    for (uint32_t i = 0; i < candidate->meshCount; i++)
+    {
+        if (meshes[i].nameHash != hashAssetName(strings + meshes[i].name))
+        {
+            std::cout << "Warning: '" << source << "' has stale mesh name hashes; recompile it" << std::endl;
+            return false;
+        }
+    }
+
+    header = candidate;
+    return true;
+}
+
+// ==================== TEXT COMPILER ====================
+
+namespace
+{
+    struct TagName
+    {
+        const char* name;
+        ComponentType tag;
+    };
+
+    const TagName TAG_NAMES[] =
+    {
+        { "spaceship", TAG_SPACESHIP },
+        { "alien", TAG_ALIEN },
+        { "cave_wall", TAG_CAVE_WALL },
+        { "rock", TAG_ROCK },
+        { "asteroid", TAG_ASTEROID },
+        { "portal_marker", TAG_PORTAL_MARKER }
+    };
+
+    const TagName* findTag(const std::string& name)
+    {
+        for (const TagName& candidate : TAG_NAMES)
+        {
+            if (name == candidate.name)
+                return &candidate;
+        }
+        return nullptr;
+    }
+
+    struct SceneBuilder
+    {
+        std::vector<SceneMeshRecord> meshes;
+        std::vector<ScenePlacement> placements;
+        std::vector<SceneTriggerRecord> triggers;
+        std::vector<SceneVolumeRecord> volumes;
+        std::vector<SceneCellRecord> cells;
+        std::vector<uint32_t> cellMeshes;
+        std::string strings;
+        std::map<std::string, uint32_t> stringOffsets;
+        std::map<std::string, uint32_t> meshIndices;
+
+        uint32_t addString(const std::string& text)
+        {
+            auto it = stringOffsets.find(text);
+            if (it != stringOffsets.end())
+                return it->second;
+
+            uint32_t offset = (uint32_t)strings.size();
+            strings.append(text);
+            strings.push_back('\0');
+            stringOffsets[text] = offset;
+            return offset;
+        }
+
+        uint32_t addMesh(const std::string& name)
+        {
+            auto it = meshIndices.find(name);
+            if (it != meshIndices.end())
+                return it->second;
+
+            SceneMeshRecord record;
+            record.name = addString(name);
+            record.nameHash = hashAssetName(name);
+
+            uint32_t index = (uint32_t)meshes.size();
+            meshes.push_back(record);
+            meshIndices[name] = index;
+            return index;
+        }
+    };
+
+    void setPlacementRotation(ScenePlacement& placement, const glm::vec3& euler)
+    {
+        glm::quat rotation = eulerToQuat(euler);
+        placement.rotation[0] = rotation.x;
+        placement.rotation[1] = rotation.y;
+        placement.rotation[2] = rotation.z;
+        placement.rotation[3] = rotation.w;
+    }
+
+    // Reads "x y z  rx ry rz  scale|sx sy sz" and leaves the stream at the first word after it
+    bool readTransform(std::istringstream& fields, ScenePlacement& placement)
+    {
+        glm::vec3 euler;
+        if (!(fields >> placement.position[0] >> placement.position[1] >> placement.position[2]
+            >> euler.x >> euler.y >> euler.z))
+            return false;
+
+        setPlacementRotation(placement, euler);
+
+        if (!(fields >> placement.scale[0]))
+            return false;
+
+        // A uniform scale is followed by flags (or nothing), a per-axis one by two more numbers
+        std::streampos afterScale = fields.tellg();
+        float sy, sz;
+        if (fields >> sy >> sz)
+        {
+            placement.scale[1] = sy;
+            placement.scale[2] = sz;
+        }
+        else
+        {
+            fields.clear();
+            fields.seekg(afterScale);
+            placement.scale[1] = placement.scale[2] = placement.scale[0];
+        }
+        return true;
+    }
+
+    // Reproducible on every platform, unlike rand()
+    float nextScatterRandom(uint32_t& seed, float lo, float hi)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * ((seed >> 8) / 16777216.0f);
+    }
+
+    void cellOf(const ScenePlacement& placement, float cellSize, int32_t& x, int32_t& z)
+    {
+        x = (int32_t)std::floor(placement.position[0] / cellSize);
+        z = (int32_t)std::floor(placement.position[2] / cellSize);
+    }
+
+    // Sorts the placements by cell and records each cell's range and meshes
+    void buildCells(SceneBuilder& builder, float cellSize)
+    {
+        std::stable_sort(builder.placements.begin(), builder.placements.end(),
+            [cellSize](const ScenePlacement& a, const ScenePlacement& b)
+            {
+                int32_t ax, az, bx, bz;
+                cellOf(a, cellSize, ax, az);
+                cellOf(b, cellSize, bx, bz);
+                if (az != bz)
+                    return az < bz;
+                if (ax != bx)
+                    return ax < bx;
+                return a.components < b.components;
+            });
+
+        for (uint32_t i = 0; i < builder.placements.size(); i++)
+        {
+            int32_t x, z;
+            cellOf(builder.placements[i], cellSize, x, z);
+            if (builder.cells.empty() || builder.cells.back().x != x || builder.cells.back().z != z)
+            {
+                SceneCellRecord cell = { x, z, i, 0, 0, 0 };
+                builder.cells.push_back(cell);
+            }
+            builder.cells.back().placementCount++;
+        }
+
+        for (SceneCellRecord& cell : builder.cells)
+        {
+            std::vector<uint32_t> used;
+            for (uint32_t i = cell.firstPlacement; i < cell.firstPlacement + cell.placementCount; i++)
+                used.push_back(builder.placements[i].mesh);
+            std::sort(used.begin(), used.end());
+            used.erase(std::unique(used.begin(), used.end()), used.end());
+
+            cell.firstMesh = (uint32_t)builder.cellMeshes.size();
+            cell.meshCount = (uint32_t)used.size();
+            builder.cellMeshes.insert(builder.cellMeshes.end(), used.begin(), used.end());
+        }
+    }
+
+    std::string readRestOfLine(std::istringstream& fields)
+    {
+        std::string rest;
+        std::getline(fields >> std::ws, rest);
+        while (!rest.empty() && (rest.back() == ' ' || rest.back() == '\t' || rest.back() == '\r'))
+            rest.pop_back();
+        return rest;
+    }
+
+    template<typename T>
+    void appendRecords(std::vector<unsigned char>& output, const std::vector<T>& records)
+    {
+        if (records.empty())
+            return;
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(records.data());
+        output.insert(output.end(), bytes, bytes + records.size() * sizeof(T));
+    }
+}
+
+bool compileSceneText(const std::string& textPath, std::vector<unsigned char>& output)
+{
+    std::ifstream file(textPath.c_str());
+    if (!file)
+    {
+        std::cout << "Warning: scene '" << textPath << "' not found" << std::endl;
+        return false;
+    }
+
+    SceneBuilder builder;
+    SceneFileHeader header = {};
+    header.magic = SCENE_FILE_MAGIC;
+    header.version = SCENE_FILE_VERSION;
+    header.name = builder.addString("");
+
+    bool ok = true;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream fields(line);
+        std::string keyword;
+        if (!(fields >> keyword))
+            continue;   // blank line
+
+        bool valid = true;
+        if (keyword == "name")
+        {
+            header.name = builder.addString(readRestOfLine(fields));
+        }
+        else if (keyword == "object" || keyword == "bag")
+        {
+            std::string meshName, tagName;
+            ScenePlacement placement = {};
+            valid = !!(fields >> meshName);
+            if (valid && keyword == "object")
+                valid = !!(fields >> tagName);
+            valid = valid && readTransform(fields, placement);
+
+            if (valid && keyword == "object")
+            {
+                const TagName* tag = findTag(tagName);
+                if (!tag)
+                {
+                    std::cout << "Warning: unknown tag '" << tagName << "' at " << textPath << ":" << lineNumber << std::endl;
+                    ok = false;
+                    continue;
+                }
+
+                placement.components = componentBit(tag->tag);
+                placement.renderFlags = 0;
+
+                std::string flag;
+                while (fields >> flag)
+                {
+                    if (flag == "enhanced")
+                        placement.renderFlags |= RENDER_ENHANCED_LIGHTING;
+                    else if (flag == "animated")
+                        placement.components |= INTERPOLATED_COMPONENTS;
+                    else
+                        valid = false;
+                }
+            }
+
+            if (valid)
+            {
+                placement.mesh = builder.addMesh(meshName);
+                if (keyword == "bag")
+                {
+                    header.hasBag = 1;
+                    header.bag = placement;
+                }
+                else
+                {
+                    builder.placements.push_back(placement);
+                }
+            }
+        }
+        else if (keyword == "scatter")
+        {
+            std::string meshName, tagName;
+            uint32_t count = 0, seed = 0;
+            float x0, z0, x1, z1, y, minScale, maxScale;
+            valid = !!(fields >> meshName >> tagName >> count >> seed >> x0 >> z0 >> x1 >> z1 >> y >> minScale >> maxScale);
+
+            const TagName* tag = valid ? findTag(tagName) : nullptr;
+            if (valid && !tag)
+            {
+                std::cout << "Warning: unknown tag '" << tagName << "' at " << textPath << ":" << lineNumber << std::endl;
+                ok = false;
+                continue;
+            }
+
+            uint32_t renderFlags = 0;
+            std::string flag;
+            while (valid && fields >> flag)
+            {
+                if (flag == "enhanced")
+                    renderFlags |= RENDER_ENHANCED_LIGHTING;
+                else
+                    valid = false;
+            }
+
+            if (valid)
+            {
+                uint32_t mesh = builder.addMesh(meshName);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    ScenePlacement placement = {};
+                    placement.position[0] = nextScatterRandom(seed, x0, x1);
+                    placement.position[1] = y;
+                    placement.position[2] = nextScatterRandom(seed, z0, z1);
+                    setPlacementRotation(placement, glm::vec3(0.0f, nextScatterRandom(seed, 0.0f, 360.0f), 0.0f));
+                    placement.scale[0] = placement.scale[1] = placement.scale[2] = nextScatterRandom(seed, minScale, maxScale);
+                    placement.mesh = mesh;
+                    placement.components = componentBit(tag->tag);
+                    placement.renderFlags = renderFlags;
+                    builder.placements.push_back(placement);
+                }
+            }
+        }
+        else if (keyword == "partition")
+        {
+            valid = (fields >> header.cellSize) && header.cellSize > 0.0f;
+        }
+        else if (keyword == "trigger")
+        {
+            SceneTriggerRecord trigger = {};
+            valid = !!(fields >> trigger.position[0] >> trigger.position[1] >> trigger.position[2]
+                >> trigger.radius >> trigger.targetScene);
+            if (valid)
+            {
+                trigger.message = builder.addString(readRestOfLine(fields));
+                builder.triggers.push_back(trigger);
+            }
+        }
+        else if (keyword == "interact")
+        {
+            std::string kind;
+            SceneVolumeRecord volume = {};
+            valid = (fields >> kind >> volume.position[0] >> volume.position[1] >> volume.position[2] >> volume.radius) &&
+                kind == "alien";
+            if (valid)
+            {
+                volume.kind = INTERACTION_ALIEN;
+                builder.volumes.push_back(volume);
+            }
+        }
+        else
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            std::cout << "Warning: malformed scene record at " << textPath << ":" << lineNumber << std::endl;
+            ok = false;
+        }
+    }
+
+    if (!ok)
+        return false;
+
+    // Same-archetype placements next to each other; stable keeps the authored order within one
+    if (header.cellSize > 0.0f)
+    {
+        buildCells(builder, header.cellSize);
+    }
+    else
+    {
+        std::stable_sort(builder.placements.begin(), builder.placements.end(),
+            [](const ScenePlacement& a, const ScenePlacement& b) { return a.components < b.components; });
+    }
+
+    header.meshCount = (uint32_t)builder.meshes.size();
+    header.placementCount = (uint32_t)builder.placements.size();
+    header.triggerCount = (uint32_t)builder.triggers.size();
+    header.volumeCount = (uint32_t)builder.volumes.size();
+    header.cellCount = (uint32_t)builder.cells.size();
+    header.cellMeshCount = (uint32_t)builder.cellMeshes.size();
+    header.stringBytes = (uint32_t)builder.strings.size();
+
+    output.clear();
+    const unsigned char* headerBytes = reinterpret_cast<const unsigned char*>(&header);
+    output.insert(output.end(), headerBytes, headerBytes + sizeof(header));
+    appendRecords(output, builder.meshes);
+    appendRecords(output, builder.placements);
+    appendRecords(output, builder.triggers);
+    appendRecords(output, builder.volumes);
+    appendRecords(output, builder.cells);
+    appendRecords(output, builder.cellMeshes);
+    output.insert(output.end(), builder.strings.begin(), builder.strings.end());
+    return true;
+}
+
+bool compileSceneFile(const std::string& textPath, const std::string& binaryPath)
+{
+    std::vector<unsigned char> bytes;
+    if (!compileSceneText(textPath, bytes))
+        return false;
+
+    std::ofstream out(binaryPath.c_str(), std::ios::binary);
+    if (!out || !out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size()))
+    {
+        std::cout << "Warning: could not write '" << binaryPath << "'" << std::endl;
+        return false;
+    }
+
+    const SceneFileHeader& header = *reinterpret_cast<const SceneFileHeader*>(bytes.data());
+    std::cout << "Compiled " << textPath << " -> " << binaryPath << " (" << header.placementCount << " placements, "
+        << header.triggerCount << " triggers, " << header.cellCount << " cells, " << bytes.size() << " bytes)" << std::endl;
+    return true;
+}
+
+// ==================== SCENE LOOKUP ====================
+
+bool openSceneFile(const std::string& basePath, SceneFile& file)
+{
+    std::string textPath = basePath + ".scene";
+    std::string binaryPath = basePath + ".scenebin";
+
+    long long textTime = getFileModificationTime(textPath);
+    long long binaryTime = getFileModificationTime(binaryPath);
+
+    if (binaryTime >= 0 && binaryTime >= textTime && file.open(binaryPath))
+        return true;
+    if (textTime < 0)
+        return false;
+
+    // Development path: still correct, just not the fast one
+    if (binaryTime >= 0)
+        std::cout << "Warning: " << binaryPath << " is stale, compiling " << textPath << " in memory" << std::endl;
+
+    std::vector<unsigned char> bytes;
+    return compileSceneText(textPath, bytes) && file.openBuffer(bytes, textPath);
+}
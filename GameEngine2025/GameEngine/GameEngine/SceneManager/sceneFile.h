@@ -0,0 +1,149 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../Core/mappedFile.h"
+#include "../ResourceManager/assetHandle.h"
+
+// Compiled scene description (.scenebin), produced from the text format below
+// by compileSceneFile / `GameEngine.exe --compile-scene in.scene out.scenebin`.
+//
+// Text format, one record per line, '#' starts a comment:
+//   name <scene title...>
+//   object <mesh> <tag> <x y z> <rx ry rz degrees> <scale | sx sy sz> [enhanced] [animated]
+//   bag <mesh> <x y z> <rx ry rz> <scale | sx sy sz>
+//   trigger <x y z> <radius> <targetScene> <message...>
+//   interact <kind> <x y z> <radius>
+//   scatter <mesh> <tag> <count> <seed> <x0 z0 x1 z1> <y> <minScale maxScale> [enhanced]
+//   partition <cellSize>
+// Tags: spaceship alien cave_wall rock asteroid portal_marker. Kinds: alien.
+// scatter places `count` objects at random (but reproducible per seed) spots
+// and headings in the rectangle. partition splits the placements into square
+// cells on the ground plane that WorldPartition streams in around the camera.
+//
+// Binary layout: SceneFileHeader, mesh table (SceneMeshRecord x meshCount),
+// placements, triggers, interaction volumes, cells, cell mesh lists, then a
+// blob of null-terminated strings that every name and message points into.
+// Placements are sorted by component mask, so instantiation walks them
+// archetype by archetype; in a partitioned scene by cell first.
+
+const uint32_t SCENE_FILE_MAGIC = 0x424E4353;   // "SCNB"
+const uint32_t SCENE_FILE_VERSION = 3;
+
+// Mesh table entry; the hash lets the loader resolve it without hashing strings
+struct SceneMeshRecord
+{
+    uint32_t name;          // string offset
+    uint32_t nameHash;      // hashAssetName(name)
+};
+
+// Renderable entity; its material is the mesh's textures plus renderFlags
+struct ScenePlacement
+{
+    float position[3];
+    float rotation[4];      // quaternion x y z w
+    float scale[3];
+    uint32_t mesh;          // index into the mesh table
+    uint32_t components;    // tags and extra components (ComponentMask)
+    uint32_t renderFlags;
+};
+
+struct SceneTriggerRecord
+{
+    float position[3];
+    float radius;
+    int32_t targetScene;
+    uint32_t message;       // string offset
+};
+
+enum InteractionKind
+{
+    INTERACTION_ALIEN = 0
+};
+
+struct SceneVolumeRecord
+{
+    float position[3];
+    float radius;
+    uint32_t kind;          // InteractionKind
+};
+
+// Square of the ground plane from (x, z) * cellSize to (x + 1, z + 1) * cellSize.
+// Cells are sorted by z, then x; empty ones are not stored.
+struct SceneCellRecord
+{
+    int32_t x;
+    int32_t z;
+    uint32_t firstPlacement;
+    uint32_t placementCount;
+    uint32_t firstMesh;     // into the cell mesh lists: the distinct meshes the cell uses
+    uint32_t meshCount;
+};
+
+struct SceneFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t name;          // string offset
+    uint32_t meshCount;
+    uint32_t placementCount;
+    uint32_t triggerCount;
+    uint32_t volumeCount;
+    uint32_t stringBytes;
+    uint32_t hasBag;
+    ScenePlacement bag;     // held object; a GameObject, not an ECS entity
+    float cellSize;         // 0 for scenes that load all at once
+    uint32_t cellCount;
+    uint32_t cellMeshCount;
+};
+
+// A validated compiled scene, either memory mapped or held in a buffer
+// straight from the compiler. Record arrays point directly into the data.
+class SceneFile
+{
+public:
+    SceneFile();
+
+    bool open(const std::string& path);
+    bool openBuffer(std::vector<unsigned char>& bytes, const std::string& source);   // takes the bytes
+
+    const SceneFileHeader& getHeader() const { return *header; }
+    const char* getName() const { return getString(header->name); }
+    const char* getMeshName(uint32_t index) const { return getString(meshes[index].name); }
+    uint32_t getMeshHash(uint32_t index) const { return meshes[index].nameHash; }
+    const char* getString(uint32_t offset) const { return strings + offset; }
+
+    const ScenePlacement* getPlacements() const { return placements; }
+    const SceneTriggerRecord* getTriggers() const { return triggers; }
+    const SceneVolumeRecord* getVolumes() const { return volumes; }
+
+    bool isPartitioned() const { return header->cellCount > 0; }
+    const SceneCellRecord* getCells() const { return cells; }
+    const uint32_t* getCellMeshes() const { return cellMeshes; }    // mesh table indices
+
+private:
+    SceneFile(const SceneFile&) = delete;
+    SceneFile& operator=(const SceneFile&) = delete;
+
+    bool validate(const unsigned char* data, size_t size, const std::string& source);
+
+    MappedFile mapping;
+    std::vector<unsigned char> buffer;
+
+    const SceneFileHeader* header;
+    const SceneMeshRecord* meshes;
+    const ScenePlacement* placements;
+    const SceneTriggerRecord* triggers;
+    const SceneVolumeRecord* volumes;
+    const SceneCellRecord* cells;
+    const uint32_t* cellMeshes;
+    const char* strings;
+};
+
+// Parses a text scene into the binary layout
+bool compileSceneText(const std::string& textPath, std::vector<unsigned char>& output);
+bool compileSceneFile(const std::string& textPath, const std::string& binaryPath);
+
+// Opens <basePath>.scenebin, or compiles <basePath>.scene in memory when the
+// binary is missing or older than the text
+bool openSceneFile(const std::string& basePath, SceneFile& file);
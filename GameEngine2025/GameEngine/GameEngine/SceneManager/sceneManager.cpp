@@ -1,114 +1,150 @@
 #include "sceneManager.h"
 #include "../Camera/camera.h"
+#include "../ECS/transformSystem.h"
+#include "../Math/transformKernel.h"
+#include "../Core/allocationTracker.h"
+#include "../Core/frameArena.h"
+#include "../Core/profiler.h"
+#include "../Core/threadPool.h"
+#include "../Graphics/renderStats.h"
 #include <glew.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
+// Where a held object sits relative to the camera (right, up, back)
+static const glm::vec3 HELD_OBJECT_OFFSET(0.6f, -0.6f, -2.0f);
+
+// Walk-through portals and anything that moves between ticks are not solid
+static const ComponentMask NON_SOLID_COMPONENTS =
+    componentBit(TAG_PORTAL_MARKER) | componentBit(COMPONENT_PREVIOUS_POSITION);
+
+// How far away something can be picked with the view ray
+static const float INTERACTION_REACH = 20.0f;
+
+// Height of the ground plane, which the camera walks on and bodies land on
+static const float GROUND_HEIGHT = -10.0f;
+
+// Asteroid showers: spacing between bodies as they start, and their size
+static const float SHOWER_SPACING = 4.0f;
+static const float SHOWER_MIN_RADIUS = 0.6f;
+static const float SHOWER_MAX_RADIUS = 1.5f;
+
 SceneManager::SceneManager()
-    : starsMesh(nullptr),
-    groundMesh(nullptr),
+    : matrixUpdatesLastFrame(0),
+    pendingMatrixUpdates(0),
     currentSceneId(0),
     nearbyTrigger(-1),
     lightColor(1.0f, 1.0f, 1.0f),
     lightPos(0.0f, 500.0f, 0.0f)
 {
+    cameraRig = std::make_unique<GameObject>(MeshHandle());
+
+    physics.setGroundHeight(GROUND_HEIGHT);
+    physics.setStaticGeometry(&collision);
+
+    // The sun shines from lightPos towards the origin
+    shadows.setLightDirection(-lightPos);
 }
 
 SceneManager::~SceneManager()
 {
+    // A running build still reads shared resources; let it stop first
+    if (prefetch)
+    {
+        prefetch->cancelled = true;
+        prefetch->done.wait();
+    }
+
+    ResourceManager& rm = ResourceManager::getInstance();
+    for (MeshHandle mesh : sceneMeshes)
+        rm.releaseMesh(mesh);
 }
 
-void SceneManager::initializeResources()
+SceneContents::~SceneContents()
 {
-    ResourceManager& rm = ResourceManager::getInstance();
+    releaseMeshes();
+}
 
-    std::cout << "Loading resources..." << std::endl;
+void SceneContents::releaseMeshes()
+{
+    ResourceManager& rm = ResourceManager::getInstance();
+    for (MeshHandle mesh : meshes)
+        rm.releaseMesh(mesh);
+    meshes.clear();
+}
 
-    // Load all textures
-    rm.loadTexture("mars", "Resources/Textures/mars.bmp");
-    rm.loadTexture("base_color", "Resources/Textures/Texture_1K/Base_BaseColor.bmp");
-    rm.loadTexture("base_normal", "Resources/Textures/Texture_1K/Base_Normal.bmp");
-    rm.loadTexture("cave_wall_diffuse", "Resources/Textures/CaveWalls2_Base_Diffuse.bmp");
-    rm.loadTexture("asteroid_diffuse", "Resources/Textures/Asteroid_1_Diffuse_1K.bmp");
-    rm.loadTexture("cave_wall4_diffuse", "Resources/Textures/CaveWalls4_Base_Diffuse.bmp");
-    rm.loadTexture("alien_body", "Resources/Textures/body_Base_Color.bmp");
-    rm.loadTexture("alien_eye", "Resources/Textures/eye_Base_Color.bmp");
-    rm.loadTexture("bag_diffuse", "Resources/Textures/tex_bakery_paper_bag.bmp");
+void SceneManager::initializeResources()
+{
+    PROFILE_SCOPE("initializeResources");
+    ResourceManager& rm = ResourceManager::getInstance();
 
-    // Create procedural meshes
+    std::cout << "Registering resources..." << std::endl;
+
+    // Textures and models are only registered here; each scene loads what it
+    // uses, and unused ones are evicted when the memory budget runs short
+    rm.registerTexture("mars", "Resources/Textures/mars.bmp");
+    rm.registerTexture("base_color", "Resources/Textures/Texture_1K/Base_BaseColor.bmp");
+    rm.registerTexture("base_normal", "Resources/Textures/Texture_1K/Base_Normal.bmp");
+    rm.registerTexture("cave_wall_diffuse", "Resources/Textures/CaveWalls2_Base_Diffuse.bmp");
+    rm.registerTexture("asteroid_diffuse", "Resources/Textures/Asteroid_1_Diffuse_1K.bmp");
+    rm.registerTexture("cave_wall4_diffuse", "Resources/Textures/CaveWalls4_Base_Diffuse.bmp");
+    rm.registerTexture("alien_body", "Resources/Textures/body_Base_Color.bmp");
+    rm.registerTexture("alien_eye", "Resources/Textures/eye_Base_Color.bmp");
+    rm.registerTexture("bag_diffuse", "Resources/Textures/tex_bakery_paper_bag.bmp");
+
+    // Create procedural meshes (always resident)
     starsMesh = rm.createStarField("stars", 500, 2000.0f);
     groundMesh = rm.createGround("ground", 200.0f, "mars");
 
-    // Load spaceship mesh with textures
-    Mesh* shipMesh = rm.loadMesh("spaceship", "Resources/Models/Imperial_Steniel_obj.obj");
-    std::vector<Texture> shipTextures;
-    shipTextures.push_back({ rm.getTexture("base_color"), "texture_diffuse" });
-    shipTextures.push_back({ rm.getTexture("base_normal"), "texture_normal" });
-    shipMesh->setTextures(shipTextures);
-
-    // Load cave wall meshes
-    rm.loadMesh("cave_wall_a", "Resources/Models/CaveWalls2_A.obj");
-    rm.getMesh("cave_wall_a")->setTextures({ { rm.getTexture("cave_wall_diffuse"), "texture_diffuse" } });
-
-    rm.loadMesh("cave_wall_b", "Resources/Models/CaveWalls2_B.obj");
-    rm.getMesh("cave_wall_b")->setTextures({ { rm.getTexture("cave_wall_diffuse"), "texture_diffuse" } });
-
-    rm.loadMesh("cave_wall_c", "Resources/Models/CaveWalls2_C.obj");
-    rm.getMesh("cave_wall_c")->setTextures({ { rm.getTexture("cave_wall_diffuse"), "texture_diffuse" } });
-
-    rm.loadMesh("cave_wall_set", "Resources/Models/CaveWalls2_Set.obj");
-    rm.getMesh("cave_wall_set")->setTextures({ { rm.getTexture("cave_wall_diffuse"), "texture_diffuse" } });
-
-    // Load asteroid
-    rm.loadMesh("asteroid", "Resources/Models/Asteroid_1.obj");
-    rm.getMesh("asteroid")->setTextures({ { rm.getTexture("asteroid_diffuse"), "texture_diffuse" } });
-
-    // Load cave wall 4 set
-    rm.loadMesh("cave_wall4_set", "Resources/Models/CaveWalls4_Set.obj");
-    rm.getMesh("cave_wall4_set")->setTextures({ { rm.getTexture("cave_wall4_diffuse"), "texture_diffuse" } });
+    // Spaceship
+    rm.registerMesh("spaceship", "Resources/Models/Imperial_Steniel_obj.obj",
+        { { "base_color", "texture_diffuse" }, { "base_normal", "texture_normal" } });
 
-    // Load rock models
-    rm.loadMesh("rock04_a", "Resources/Models/Rock04_A.obj");
-    rm.getMesh("rock04_a")->setTextures({ { rm.getTexture("cave_wall_diffuse"), "texture_diffuse" } });
+    // Cave walls and rocks never move, so far away they can be impostors
+    impostors.enable(rm.registerMesh("cave_wall_a", "Resources/Models/CaveWalls2_A.obj", { { "cave_wall_diffuse", "texture_diffuse" } }));
+    impostors.enable(rm.registerMesh("cave_wall_b", "Resources/Models/CaveWalls2_B.obj", { { "cave_wall_diffuse", "texture_diffuse" } }));
+    impostors.enable(rm.registerMesh("cave_wall_c", "Resources/Models/CaveWalls2_C.obj", { { "cave_wall_diffuse", "texture_diffuse" } }));
+    impostors.enable(rm.registerMesh("cave_wall_set", "Resources/Models/CaveWalls2_Set.obj", { { "cave_wall_diffuse", "texture_diffuse" } }));
+    impostors.enable(rm.registerMesh("cave_wall4_set", "Resources/Models/CaveWalls4_Set.obj", { { "cave_wall4_diffuse", "texture_diffuse" } }));
 
-    rm.loadMesh("rock04_b", "Resources/Models/Rock04_B.obj");
-    rm.getMesh("rock04_b")->setTextures({ { rm.getTexture("cave_wall_diffuse"), "texture_diffuse" } });
+    // Asteroid
+    rm.registerMesh("asteroid", "Resources/Models/Asteroid_1.obj", { { "asteroid_diffuse", "texture_diffuse" } });
 
-    rm.loadMesh("rock04_c", "Resources/Models/Rock04_C.obj");
-    rm.getMesh("rock04_c")->setTextures({ { rm.getTexture("cave_wall_diffuse"), "texture_diffuse" } });
+    // Rocks
+    impostors.enable(rm.registerMesh("rock04_a", "Resources/Models/Rock04_A.obj", { { "cave_wall_diffuse", "texture_diffuse" } }));
+    impostors.enable(rm.registerMesh("rock04_b", "Resources/Models/Rock04_B.obj", { { "cave_wall_diffuse", "texture_diffuse" } }));
+    impostors.enable(rm.registerMesh("rock04_c", "Resources/Models/Rock04_C.obj", { { "cave_wall_diffuse", "texture_diffuse" } }));
+    impostors.enable(rm.registerMesh("rock04_d", "Resources/Models/Rock04_D.obj", { { "cave_wall4_diffuse", "texture_diffuse" } }));
+    impostors.enable(rm.registerMesh("rock04_e", "Resources/Models/Rock04_E.obj", { { "cave_wall4_diffuse", "texture_diffuse" } }));
+    impostors.enable(rm.registerMesh("rock04_set", "Resources/Models/Rock04_Set.obj", { { "cave_wall_diffuse", "texture_diffuse" } }));
 
-    rm.loadMesh("rock04_d", "Resources/Models/Rock04_D.obj");
-    rm.getMesh("rock04_d")->setTextures({ { rm.getTexture("cave_wall4_diffuse"), "texture_diffuse" } });
+    // Alien
+    rm.registerMesh("alien", "Resources/Models/body.obj", { { "alien_body", "texture_diffuse" } });
 
-    rm.loadMesh("rock04_e", "Resources/Models/Rock04_E.obj");
-    rm.getMesh("rock04_e")->setTextures({ { rm.getTexture("cave_wall4_diffuse"), "texture_diffuse" } });
+    // Paper bag
+    rm.registerMesh("bag", "Resources/Models/bakery paper bag.obj", { { "bag_diffuse", "texture_diffuse" } });
 
-    rm.loadMesh("rock04_set", "Resources/Models/Rock04_Set.obj");
-    rm.getMesh("rock04_set")->setTextures({ { rm.getTexture("cave_wall_diffuse"), "texture_diffuse" } });
-
-    // Load alien
-    rm.loadMesh("alien", "Resources/Models/body.obj");
-    rm.getMesh("alien")->setTextures({ { rm.getTexture("alien_body"), "texture_diffuse" } });
-
-	// Load paper bag
-    rm.loadMesh("bag", "Resources/Models/bakery paper bag.obj");
-    rm.getMesh("bag")->setTextures({
-        { rm.getTexture("bag_diffuse"), "texture_diffuse" }
-        });
-
-    std::cout << "Resources loaded successfully!" << std::endl;
+    std::cout << "Resources registered successfully!" << std::endl;
 }
 
 void SceneManager::clearScene()
 {
     std::cout << "Clearing current scene..." << std::endl;
 
-    spaceships.clear();
-    aliens.clear();
-    caveWalls.clear();
-    rocks.clear();
-    asteroids.clear();
-    portalMarkers.clear();
+    ResourceManager& rm = ResourceManager::getInstance();
+    for (MeshHandle mesh : sceneMeshes)
+        rm.releaseMesh(mesh);
+    sceneMeshes.clear();
+    partition.close();
+
+    world.clear();
+    collision.clear();
+    physics.clear();
+    particles.clear();
+    shadows.invalidateStatic();
     triggerZones.clear();
+    interactionVolumes.clear();
     nearbyTrigger = -1;
 
     currentSceneId = 0;
@@ -116,95 +152,292 @@ void SceneManager::clearScene()
 
 void SceneManager::loadScene(int sceneId)
 {
-    clearScene();
+    PROFILE_SCOPE("loadScene");
+
+    if (prefetch && prefetch->sceneId == sceneId)
+    {
+        // Usually finished long ago; otherwise the remaining part is still
+        // shorter than starting over
+        {
+            PROFILE_SCOPE("waitForPrefetch");
+            prefetch->done.wait();
+        }
+
+        std::shared_ptr<ScenePrefetch> ready = prefetch;
+        prefetch.reset();
+        commitScene(ready->contents);
+        std::cout << "Scene " << currentSceneId << " swapped in from prefetch" << std::endl;
+        return;
+    }
+
+    cancelPrefetch();
 
     std::cout << "Loading scene " << sceneId << "..." << std::endl;
 
-    currentSceneId = sceneId;
+    SceneContents scene;
+    buildScene(sceneId, scene);
+    commitScene(scene);
 
-    switch (sceneId)
+    std::cout << "Scene " << currentSceneId << " loaded successfully!" << std::endl;
+}
+
+static std::string scenePath(int sceneId)
+{
+    return "Resources/Scenes/scene" + std::to_string(sceneId);
+}
+
+bool SceneManager::buildScene(int sceneId, SceneContents& scene)
+{
+    scene.sceneId = sceneId;
+
+    std::unique_ptr<SceneFile> file = std::make_unique<SceneFile>();
+    if (!openSceneFile(scenePath(sceneId), *file))
     {
-    case 1:
-        createScene1();
-        break;
-    case 2:
-        createScene2();
-        break;
-    default:
         std::cout << "Warning: Unknown scene ID " << sceneId << ", loading scene 1" << std::endl;
-        createScene1();
-        currentSceneId = 1;
-        break;
+        scene.sceneId = 1;
+        if (!openSceneFile(scenePath(1), *file))
+            return false;
     }
 
-    std::cout << "Scene " << currentSceneId << " loaded successfully!" << std::endl;
+    std::cout << "Creating Scene " << scene.sceneId << ": " << file->getName() << "..." << std::endl;
+    if (!instantiateScene(*file, scene))
+        return false;
+    if (file->isPartitioned())
+        scene.partitionFile = std::move(file);
+    return true;
 }
 
-// ==================== HELPER METHODS FOR ADDING OBJECTS ====================
-
-void SceneManager::addSpaceship(const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& scale)
+bool SceneManager::instantiateScene(const SceneFile& file, SceneContents& scene)
 {
+    const SceneFileHeader& header = file.getHeader();
     ResourceManager& rm = ResourceManager::getInstance();
-    Mesh* shipMesh = rm.getMesh("spaceship");
 
-    spaceships.push_back(std::make_unique<GameObject>(shipMesh, pos, rot, scale));
+    // One hash probe per distinct mesh (the file stores the name hashes),
+    // each holding a reference for as long as the scene exists. Partitioned
+    // scenes only hold the bag's; cells reference their own as they load.
+    bool partitioned = file.isPartitioned();
+    std::vector<MeshHandle> meshes(header.meshCount);
+    for (uint32_t i = 0; i < header.meshCount; i++)
+    {
+        if (partitioned && !(header.hasBag && header.bag.mesh == i))
+            continue;
+        meshes[i] = rm.findMesh(file.getMeshHash(i));
+        if (!meshes[i].isValid())
+        {
+            std::cout << "Warning: Mesh '" << file.getMeshName(i) << "' not found!" << std::endl;
+        }
+        else
+        {
+            rm.acquireMesh(meshes[i]);
+            scene.meshes.push_back(meshes[i]);
+        }
+    }
+
+    // Checking every placement would cost more than a late cancel saves
+    const uint32_t CANCEL_CHECK_INTERVAL = 1024;
+
+    const ScenePlacement* placements = file.getPlacements();
+    uint32_t placementCount = partitioned ? 0 : header.placementCount;
+    for (uint32_t i = 0; i < placementCount; i++)
+    {
+        if (i % CANCEL_CHECK_INTERVAL == 0 && scene.isCancelled())
+            return false;
+
+        const ScenePlacement& placement = placements[i];
+        addObject(scene.world, meshes[placement.mesh],
+            glm::vec3(placement.position[0], placement.position[1], placement.position[2]),
+            glm::quat(placement.rotation[3], placement.rotation[0], placement.rotation[1], placement.rotation[2]),
+            glm::vec3(placement.scale[0], placement.scale[1], placement.scale[2]),
+            placement.components, placement.renderFlags);
+    }
+
+    const SceneTriggerRecord* triggers = file.getTriggers();
+    for (uint32_t i = 0; i < header.triggerCount; i++)
+    {
+        const SceneTriggerRecord& trigger = triggers[i];
+        addTriggerZone(scene, glm::vec3(trigger.position[0], trigger.position[1], trigger.position[2]),
+            trigger.radius, trigger.targetScene, file.getString(trigger.message));
+    }
+
+    const SceneVolumeRecord* volumes = file.getVolumes();
+    scene.interactionVolumes.reserve(header.volumeCount);
+    for (uint32_t i = 0; i < header.volumeCount; i++)
+    {
+        InteractionVolume volume;
+        volume.position = glm::vec3(volumes[i].position[0], volumes[i].position[1], volumes[i].position[2]);
+        volume.radius = volumes[i].radius;
+        volume.kind = (InteractionKind)volumes[i].kind;
+        scene.interactionVolumes.push_back(volume);
+    }
+
+    if (header.hasBag)
+    {
+        const ScenePlacement& bag = header.bag;
+        scene.bag = std::make_unique<GameObject>(meshes[bag.mesh],
+            glm::vec3(bag.position[0], bag.position[1], bag.position[2]),
+            glm::vec3(0.0f),
+            glm::vec3(bag.scale[0], bag.scale[1], bag.scale[2]));
+        scene.bag->setRotation(glm::quat(bag.rotation[3], bag.rotation[0], bag.rotation[1], bag.rotation[2]));
+    }
+
+    return !scene.isCancelled();
 }
 
-void SceneManager::addAlien(const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& scale)
+void SceneManager::commitScene(SceneContents& scene)
 {
-    ResourceManager& rm = ResourceManager::getInstance();
-    Mesh* alienMesh = rm.getMesh("alien");
+    // The previous scene ends up in `scene` and is released with it; so do
+    // the entities of its cells
+    partition.close();
+    world.swap(scene.world);
+    collision.clear();
+    physics.clear();
+    triggerZones.swap(scene.triggerZones);
+    interactionVolumes.swap(scene.interactionVolumes);
+    sceneMeshes.swap(scene.meshes);
+    nearbyTrigger = -1;
+    currentSceneId = scene.sceneId;
 
-    aliens.push_back(std::make_unique<GameObject>(alienMesh, pos, rot, scale));
+    // Scenes without a bag keep the current one (it may be held)
+    if (scene.bag)
+    {
+        bag.swap(scene.bag);
+        scene.bag.reset();
+        if (bagGrabbed)
+            grabBag();
+    }
+
+    // Meshes only the old scene used become evictable; the new scene's ones
+    // were referenced while it was built, so they cannot go. Meshes a
+    // prefetch is still loading are skipped here and appear once uploaded.
+    ResourceManager& rm = ResourceManager::getInstance();
+    scene.releaseMeshes();
+    for (MeshHandle mesh : sceneMeshes)
+        rm.makeResident(mesh);
+    if (bag)
+        rm.makeResident(bag->getMesh());
+    partition.open(std::move(scene.partitionFile));
+    rm.enforceBudget();
+    rebuildCollision();
+    createSceneEmitters();
+    shadows.invalidateStatic();
+
+    ResourceMemoryStats memory = rm.getMemoryStats();
+    std::cout << "Resident assets: " << memory.residentMeshes << " meshes, " << memory.residentTextures << " textures, "
+        << memory.cpuBytes / (1024 * 1024) << " MB CPU, " << memory.gpuBytes / (1024 * 1024) << " MB GPU" << std::endl;
 }
 
-void SceneManager::addCaveWall(const std::string& meshName, const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& scale)
+// ==================== SCENE PREFETCH ====================
+
+// Prefetch starts within this multiple of a trigger's radius...
+static const float PREFETCH_RADIUS_SCALE = 4.0f;
+// ...and is only cancelled once the player is this much further out again
+static const float PREFETCH_CANCEL_SCALE = 1.25f;
+
+void SceneManager::startPrefetch(int sceneId)
 {
-    ResourceManager& rm = ResourceManager::getInstance();
-    Mesh* wallMesh = rm.getMesh(meshName);
+    if (prefetch && prefetch->sceneId == sceneId)
+        return;
+    cancelPrefetch();
+
+    std::cout << "Prefetching scene " << sceneId << " in the background..." << std::endl;
+
+    std::shared_ptr<ScenePrefetch> job = std::make_shared<ScenePrefetch>();
+    job->sceneId = sceneId;
+    job->cancelled = false;
+    job->contents.cancelled = &job->cancelled;
+
+    // The task holds its own reference, so a cancelled job can outlive us
+    job->done = ThreadPool::getShared().submit([job]()
+    {
+        if (!buildScene(job->sceneId, job->contents))
+            return;
 
-    caveWalls.push_back(std::make_unique<GameObject>(wallMesh, pos, rot, scale));
+        // Start reading the meshes as well, so the swap does not stall on
+        // them; any still in flight then stream in after it
+        ResourceManager& rm = ResourceManager::getInstance();
+        for (MeshHandle mesh : job->contents.meshes)
+            rm.makeResidentAsync(mesh);
+        if (job->contents.bag)
+            rm.makeResidentAsync(job->contents.bag->getMesh());
+    });
+    prefetch = job;
 }
 
-void SceneManager::addRock(const std::string& meshName, const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& scale)
+void SceneManager::cancelPrefetch()
 {
-    ResourceManager& rm = ResourceManager::getInstance();
-    Mesh* rockMesh = rm.getMesh(meshName);
+    if (!prefetch)
+        return;
 
-    rocks.push_back(std::make_unique<GameObject>(rockMesh, pos, rot, scale));
+    std::cout << "Prefetch of scene " << prefetch->sceneId << " cancelled" << std::endl;
+    prefetch->cancelled = true;
+    prefetch.reset();
 }
 
-void SceneManager::addAsteroid(const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& scale)
+bool SceneManager::isPrefetchReady(int sceneId) const
 {
-    ResourceManager& rm = ResourceManager::getInstance();
-    Mesh* asteroidMesh = rm.getMesh("asteroid");
+    return prefetch && prefetch->sceneId == sceneId &&
+        prefetch->done.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
 
-    asteroids.push_back(std::make_unique<GameObject>(asteroidMesh, pos, rot, scale));
+void SceneManager::updatePrefetch(const glm::vec3& playerPos)
+{
+    int wanted = -1;
+    bool keepCurrent = false;
+
+    for (const TriggerZone& zone : triggerZones)
+    {
+        float distance = glm::distance(playerPos, zone.position);
+        if (wanted < 0 && distance < zone.prefetchRadius)
+            wanted = zone.targetScene;
+        if (prefetch && zone.targetScene == prefetch->sceneId && distance < zone.prefetchRadius * PREFETCH_CANCEL_SCALE)
+            keepCurrent = true;
+    }
+
+    if (prefetch && !keepCurrent)
+        cancelPrefetch();
+
+    if (wanted >= 0 && !prefetch)
+        startPrefetch(wanted);
+}
+
+// ==================== HELPER METHODS FOR ADDING OBJECTS ====================
+
+Entity SceneManager::addObject(EntityWorld& world, MeshHandle mesh, const glm::vec3& pos,
+    const glm::quat& rot, const glm::vec3& scale, ComponentMask components, uint32_t renderFlags)
+{
+    Entity entity = world.createEntity(RENDERABLE_COMPONENTS | components);
+    world.get<COMPONENT_POSITION>(entity) = pos;
+    world.get<COMPONENT_ROTATION>(entity) = rot;
+    world.get<COMPONENT_SCALE>(entity) = scale;
+    world.get<COMPONENT_MESH>(entity) = mesh;
+    world.get<COMPONENT_RENDER_FLAGS>(entity) = RENDER_VISIBLE | renderFlags;
+
+    // Start at rest so the first rendered frame does not blend from the origin
+    if (components & componentBit(COMPONENT_PREVIOUS_POSITION))
+    {
+        world.get<COMPONENT_PREVIOUS_POSITION>(entity) = pos;
+        world.get<COMPONENT_PREVIOUS_ROTATION>(entity) = rot;
+        world.get<COMPONENT_PREVIOUS_SCALE>(entity) = scale;
+    }
+    return entity;
 }
 
-void SceneManager::addTriggerZone(const glm::vec3& pos, float radius, int targetScene, const std::string& message)
+void SceneManager::addTriggerZone(SceneContents& scene, const glm::vec3& pos, float radius, int targetScene,
+    const std::string& message)
 {
     TriggerZone trigger;
     trigger.position = pos;
     trigger.radius = radius;
+    trigger.prefetchRadius = radius * PREFETCH_RADIUS_SCALE;
     trigger.targetScene = targetScene;
     trigger.message = message;
-    triggerZones.push_back(trigger);
-}
-
-void SceneManager::addPortalMarker(const glm::vec3& pos)
-{
-    ResourceManager& rm = ResourceManager::getInstance();
-    Mesh* asteroidMesh = rm.getMesh("asteroid");
-
-    // Create a glowing asteroid as visual marker
-    portalMarkers.push_back(std::make_unique<GameObject>(asteroidMesh, pos,
-        glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(3.0f)));
+    scene.triggerZones.push_back(trigger);
 }
 
 void SceneManager::checkProximityTriggers(const glm::vec3& playerPos)
 {
     nearbyTrigger = -1;
+    updatePrefetch(playerPos);
 
     for (int i = 0; i < triggerZones.size(); i++)
     {
@@ -217,133 +450,339 @@ void SceneManager::checkProximityTriggers(const glm::vec3& playerPos)
     }
 }
 
-std::string SceneManager::getTriggerMessage() const
+const std::string& SceneManager::getTriggerMessage() const
 {
+    static const std::string none;
     if (nearbyTrigger >= 0 && nearbyTrigger < triggerZones.size())
         return triggerZones[nearbyTrigger].message;
-    return "";
+    return none;
 }
 
 void SceneManager::grabBag()
 {
     bagGrabbed = true;
+
+    if (bag)
+    {
+        // Attach to the camera rig; from here on the hierarchy carries it along
+        bag->setParent(cameraRig.get());
+        bag->setPosition(HELD_OBJECT_OFFSET);
+        bag->setRotation(glm::vec3(0.0f, 0.0f, 0.0f));
+    }
 }
 
-void SceneManager::updateBagFollowCamera(Camera& camera)
+void SceneManager::updateBagFollowCamera(Camera& camera, float alpha)
 {
-    if (!bagGrabbed || !bag)
-        return;
-
-    glm::vec3 camPos = camera.getCameraPosition();
+    // Follow the rendered (interpolated) camera, not the last simulation tick
+    glm::vec3 camPos = camera.getInterpolatedPosition(alpha);
     glm::vec3 forward = camera.getCameraViewDirection();
     glm::vec3 up = camera.getCameraUp();
     glm::vec3 right = glm::normalize(glm::cross(forward, up));
 
-    glm::vec3 bagPos =
-        camPos +
-        forward * 2.0f +   // in front
-        right * 0.6f +     // slightly right
-        up * -0.6f;        // slightly down
-
-    bag->setPosition(bagPos);
-    bag->setRotation(glm::vec3(0.0f, 0.0f, 0.0f));
+    // Only touch the rig when the camera actually moved, so a still camera
+    // leaves the attached subtree clean
+    glm::quat rigOrientation = glm::quat_cast(glm::mat3(right, up, -forward));
+    if (camPos != cameraRig->getPosition())
+        cameraRig->setPosition(camPos);
+    if (fabs(glm::dot(rigOrientation, cameraRig->getOrientation())) < 0.999999f)
+        cameraRig->setRotation(rigOrientation);
 }
 
-void SceneManager::updatePortalAnimation(float time)
+void SceneManager::beginSimulationTick()
 {
-    // ===== PULSE SCALE =====
-    float baseScale = 3.0f;          
-    float scaleAmplitude = 0.5f;    
-    float scaleSpeed = 2.0f;         
-    float scale = baseScale + sin(time * scaleSpeed) * scaleAmplitude;
+    storePreviousTransforms(world);
+    updateCollision();
+}
 
-    // ===== ROTATION =====
-    float rotationSpeed = 25.0f;    
+void SceneManager::rebuildCollision()
+{
+    PROFILE_SCOPE("rebuildCollision");
+    collision.build(world, NON_SOLID_COMPONENTS | componentBit(TAG_STREAMED));
+    collisionResidentMeshes = ResourceManager::getInstance().getMemoryStats().residentMeshes;
+}
 
-    for (auto& portal : portalMarkers)
+void SceneManager::updateWorldStreaming(const glm::vec3& cameraPos, float dt)
+{
+    // The partition marks its own cell work as expected; the distance pass
+    // that runs every frame is held to the allocation check
+    if (partition.update(cameraPos, dt, world))
     {
-        portal->setScale(glm::vec3(scale));
-
-        glm::vec3 rot = portal->getRotation();
-        rot.y += rotationSpeed * 0.016f;
-        portal->setRotation(rot);
+        // Each cell has a collision tree of its own and touches only the
+        // cascades it can cast into. Building the trees is streaming, not
+        // per-frame churn.
+        PROFILE_SCOPE("updateStreamedCells");
+        ExpectedAllocationScope streaming;
+        for (const WorldCellChange& change : partition.getChanges())
+        {
+            if (change.loaded)
+                collision.addGroup(change.cell, world, change.entities, change.entityCount, NON_SOLID_COMPONENTS);
+            else
+                collision.removeGroup(change.cell);
+            shadows.invalidateStatic(change.boundsMin, change.boundsMax);
+        }
     }
 }
 
+void SceneManager::updateCollision()
+{
+    // Meshes a prefetch was still loading join once they are resident
+    if (collision.getPendingCount() > 0 &&
+        ResourceManager::getInstance().getMemoryStats().residentMeshes != collisionResidentMeshes)
+        rebuildCollision();
+}
+
+void SceneManager::interpolateTransforms(float alpha)
+{
+    pendingMatrixUpdates += interpolateModelMatrices(world, alpha);
+}
+
+// ==================== PHYSICS ====================
+
+bool SceneManager::ensureAsteroidShape(MeshHandle mesh)
+{
+    if (asteroidShape < physics.getShapeCount())
+        return true;
 
+    ResourceManager& rm = ResourceManager::getInstance();
+    if (!rm.getCollisionMesh(mesh))
+        rm.makeResident(mesh);
+    const TriangleBvh* bvh = rm.getCollisionMesh(mesh);
+    if (!bvh)
+    {
+        std::cout << "Warning: Asteroid model is not loaded, no asteroid shower" << std::endl;
+        return false;
+    }
 
-// ==================== SCENE CREATION METHODS ====================
+    std::vector<glm::vec3> points;
+    points.reserve(bvh->getTriangleCount() * 3);
+    bvh->forEachTriangle(bvh->getBoundsMin(), bvh->getBoundsMax(),
+        [&](const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+    {
+        points.push_back(a);
+        points.push_back(b);
+        points.push_back(c);
+    });
+
+    ConvexHull hull;
+    buildConvexHull(points.data(), (uint32_t)points.size(), 32, hull);
+    asteroidModelRadius = std::max(hull.boundingRadius, 1.0e-3f);
+    asteroidShape = physics.addHullShape(hull, asteroidModelRadius * 0.02f);
+    return true;
+}
 
-void SceneManager::createScene1()
+// Uniform in [lo, hi); its own sequence so showers do not disturb rand() users
+static float nextShowerRandom(uint32_t& seed, float lo, float hi)
 {
-    std::cout << "Creating Scene 1: Cave Entrance..." << std::endl;
+    seed = seed * 1664525u + 1013904223u;
+    return lo + (hi - lo) * ((seed >> 8) * (1.0f / 16777216.0f));
+}
 
-    // Add spaceship
-    addSpaceship(glm::vec3(-20.0f, -2.5f, -50.0f), glm::vec3(0.0f, 180.0f, 0.0f), glm::vec3(2.5f));
+void SceneManager::spawnAsteroidShower(const glm::vec3& center, int count)
+{
+    ResourceManager& rm = ResourceManager::getInstance();
+    MeshHandle mesh = rm.findMesh("asteroid");
+    if (!mesh.isValid())
+    {
+        std::cout << "Warning: Mesh 'asteroid' not found!" << std::endl;
+        return;
+    }
+    if (!ensureAsteroidShape(mesh))
+        return;
 
-    // Add alien
-    addAlien(glm::vec3(15.0f, -8.0f, -50.0f), glm::vec3(0.0f, 180.0f, 0.0f), glm::vec3(1.5f));
+    // The scene keeps the mesh for as long as the bodies exist
+    if (std::find(sceneMeshes.begin(), sceneMeshes.end(), mesh) == sceneMeshes.end())
+    {
+        rm.acquireMesh(mesh);
+        sceneMeshes.push_back(mesh);
+    }
 
-    // Add bag near the alien
+    const ComponentMask components = RENDERABLE_COMPONENTS | INTERPOLATED_COMPONENTS |
+        componentBit(COMPONENT_RIGID_BODY) | componentBit(TAG_ASTEROID);
+    int perSide = std::max((int)std::ceil(std::cbrt((float)count)), 1);
+    float half = (perSide - 1) * SHOWER_SPACING * 0.5f;
+
+    for (int i = 0; i < count; i++)
     {
-        ResourceManager& rm = ResourceManager::getInstance();
-        Mesh* bagMesh = rm.getMesh("bag");
-
-        bag = std::make_unique<GameObject>(
-            bagMesh,
-            glm::vec3(17.0f, -9.0f, -48.0f),
-            glm::vec3(0.0f, 0.0f, 0.0f),
-            glm::vec3(0.008f)
-        );
+        glm::vec3 cell((float)(i % perSide), (float)(i / (perSide * perSide)), (float)((i / perSide) % perSide));
+        glm::vec3 jitter(nextShowerRandom(asteroidSeed, -0.5f, 0.5f), nextShowerRandom(asteroidSeed, -0.5f, 0.5f),
+            nextShowerRandom(asteroidSeed, -0.5f, 0.5f));
+        float radius = nextShowerRandom(asteroidSeed, SHOWER_MIN_RADIUS, SHOWER_MAX_RADIUS);
+
+        RigidBodyDesc body;
+        body.position = center + glm::vec3(cell.x * SHOWER_SPACING - half, cell.y * SHOWER_SPACING,
+            cell.z * SHOWER_SPACING - half) + jitter;
+        body.orientation = glm::normalize(glm::quat(nextShowerRandom(asteroidSeed, -1.0f, 1.0f),
+            nextShowerRandom(asteroidSeed, -1.0f, 1.0f), nextShowerRandom(asteroidSeed, -1.0f, 1.0f),
+            nextShowerRandom(asteroidSeed, -1.0f, 1.0f)));
+        body.linearVelocity = glm::vec3(jitter.x, -5.0f, jitter.z);
+        body.angularVelocity = jitter * 4.0f;
+        body.mass = radius * radius * radius;
+        body.scale = radius / asteroidModelRadius;
+        body.shape = asteroidShape;
+
+        Entity entity = world.createEntity(components);
+        world.get<COMPONENT_POSITION>(entity) = body.position;
+        world.get<COMPONENT_ROTATION>(entity) = body.orientation;
+        world.get<COMPONENT_SCALE>(entity) = glm::vec3(body.scale);
+        world.get<COMPONENT_MESH>(entity) = mesh;
+        world.get<COMPONENT_RENDER_FLAGS>(entity) = RENDER_VISIBLE | RENDER_ENHANCED_LIGHTING;
+        world.get<COMPONENT_PREVIOUS_POSITION>(entity) = body.position;
+        world.get<COMPONENT_PREVIOUS_ROTATION>(entity) = body.orientation;
+        world.get<COMPONENT_PREVIOUS_SCALE>(entity) = glm::vec3(body.scale);
+        world.get<COMPONENT_RIGID_BODY>(entity) = physics.addBody(body);
     }
 
+    std::cout << "Asteroid shower: " << count << " bodies, " << physics.getBodyCount() << " in total" << std::endl;
+}
+
+void SceneManager::updatePhysics(float dt)
+{
+    if (physics.getBodyCount() == 0)
+        return;
+
+    PROFILE_SCOPE("updatePhysics");
+    physics.step(dt);
+
+    const ComponentMask bodies = componentBit(COMPONENT_RIGID_BODY) |
+        componentBit(COMPONENT_POSITION) | componentBit(COMPONENT_ROTATION);
+
+    world.forEachChunk(bodies, [&](ArchetypeChunk& chunk)
+    {
+        const uint32_t* indices = chunk.column<COMPONENT_RIGID_BODY>();
+        glm::vec3* positions = chunk.column<COMPONENT_POSITION>();
+        glm::quat* rotations = chunk.column<COMPONENT_ROTATION>();
+
+        for (uint32_t i = 0; i < chunk.count; i++)
+        {
+            positions[i] = physics.getPosition(indices[i]);
+            rotations[i] = physics.getOrientation(indices[i]);
+        }
+        chunk.transformsDirty = true;
+    });
+}
+
+// ==================== PARTICLES ====================
+
+// Longest frame the particles are advanced by, so a stall does not fling them
+static const float MAX_PARTICLE_STEP = 0.1f;
+
+void SceneManager::createSceneEmitters()
+{
+    particles.clear();
+
+    // Glow rising around each portal marker
+    ParticleEmitterDesc glow;
+    glow.positionSpread = glm::vec3(3.0f);
+    glow.velocity = glm::vec3(0.0f, 1.5f, 0.0f);
+    glow.velocitySpread = glm::vec3(0.8f, 0.5f, 0.8f);
+    glow.drag = 0.5f;
+    glow.minLifetime = 1.5f;
+    glow.maxLifetime = 3.0f;
+    glow.startSize = 0.4f;
+    glow.endSize = 0.05f;
+    glow.startColor = glm::vec4(0.4f, 0.6f, 1.0f, 0.8f);
+    glow.endColor = glm::vec4(0.8f, 0.3f, 1.0f, 0.0f);
+    glow.rate = 300.0f;
+    glow.maxParticles = 1000;
+
+    const ComponentMask portals = componentBit(TAG_PORTAL_MARKER) | componentBit(COMPONENT_POSITION);
+    world.forEachChunk(portals, [&](ArchetypeChunk& chunk)
+    {
+        const glm::vec3* positions = chunk.column<COMPONENT_POSITION>();
+        for (uint32_t i = 0; i < chunk.count; i++)
+        {
+            glow.position = positions[i];
+            particles.addEmitter(glow);
+        }
+    });
+
+    // Martian dust drifting over the ground near the player, moved along in updateParticles
+    ParticleEmitterDesc dust;
+    dust.positionSpread = glm::vec3(40.0f, 1.0f, 40.0f);
+    dust.velocity = glm::vec3(1.5f, 0.1f, 0.5f);
+    dust.velocitySpread = glm::vec3(0.5f, 0.2f, 0.5f);
+    dust.acceleration = glm::vec3(0.0f, -0.05f, 0.0f);
+    dust.minLifetime = 4.0f;
+    dust.maxLifetime = 8.0f;
+    dust.startSize = 0.15f;
+    dust.endSize = 0.4f;
+    dust.startColor = glm::vec4(0.75f, 0.5f, 0.35f, 0.35f);
+    dust.endColor = glm::vec4(0.7f, 0.45f, 0.3f, 0.0f);
+    dust.rate = 800.0f;
+    dust.maxParticles = 6000;
+    dust.additive = false;
+    dust.sorted = true;
+    dustEmitter = particles.addEmitter(dust);
+}
+
+void SceneManager::updateParticles(float dt, const glm::vec3& cameraPos)
+{
+    PROFILE_SCOPE("updateParticles");
 
-    // Add cave walls
-    addCaveWall("cave_wall_set", glm::vec3(-80.0f, -9.0f, -120.0f), glm::vec3(0.0f, 45.0f, 0.0f), glm::vec3(3.0f));
-    addCaveWall("cave_wall_a", glm::vec3(40.0f, -8.0f, -260.0f), glm::vec3(0.0f, -30.0f, 0.0f), glm::vec3(2.5f));
-    addCaveWall("cave_wall_a", glm::vec3(-30.0f, -8.5f, 400.0f), glm::vec3(0.0f, 60.0f, 0.0f), glm::vec3(2.0f));
-    addCaveWall("cave_wall_b", glm::vec3(-70.0f, -7.0f, -350.0f), glm::vec3(0.0f, 90.0f, 0.0f), glm::vec3(4.0f, 3.0f, 4.0f));
-    addCaveWall("cave_wall_c", glm::vec3(-100.0f, -6.0f, -480.0f), glm::vec3(0.0f, 120.0f, 0.0f), glm::vec3(3.5f));
-    addCaveWall("cave_wall4_set", glm::vec3(100.0f, 10.0f, 350.0f), glm::vec3(0.0f, 90.0f, 0.0f), glm::vec3(2.0f));
+    ParticleEmitter* dust = particles.getEmitter(dustEmitter);
+    if (dust)
+        dust->setPosition(glm::vec3(cameraPos.x, GROUND_HEIGHT + 1.0f, cameraPos.z));
 
-    // Add rocks
-    addRock("rock04_a", glm::vec3(-150.0f, -8.0f, 200.0f), glm::vec3(0.0f, 45.0f, 0.0f), glm::vec3(3.0f));
-    addRock("rock04_b", glm::vec3(-180.0f, -7.0f, -50.0f), glm::vec3(0.0f, -30.0f, 0.0f), glm::vec3(2.5f));
-    addRock("rock04_c", glm::vec3(150.0f, -8.0f, -80.0f), glm::vec3(0.0f, 135.0f, 0.0f), glm::vec3(3.0f));
-    addRock("rock04_d", glm::vec3(170.0f, -7.5f, 20.0f), glm::vec3(0.0f, 200.0f, 0.0f), glm::vec3(2.8f));
-    addRock("rock04_e", glm::vec3(-160.0f, -8.5f, 80.0f), glm::vec3(0.0f, 75.0f, 0.0f), glm::vec3(2.5f));
-    addRock("rock04_set", glm::vec3(140.0f, -8.0f, 50.0f), glm::vec3(0.0f, 160.0f, 0.0f), glm::vec3(2.0f));
-    addRock("rock04_c", glm::vec3(-140.0f, -8.0f, 30.0f), glm::vec3(0.0f, -45.0f, 0.0f), glm::vec3(2.8f));
-    addRock("rock04_d", glm::vec3(-175.0f, -7.8f, 150.0f), glm::vec3(0.0f, 60.0f, 0.0f), glm::vec3(3.2f));
-    addRock("rock04_a", glm::vec3(-130.0f, -8.2f, -30.0f), glm::vec3(0.0f, 110.0f, 0.0f), glm::vec3(2.6f));
-    addRock("rock04_set", glm::vec3(-155.0f, -7.5f, -120.0f), glm::vec3(0.0f, -80.0f, 0.0f), glm::vec3(2.2f));
-    addRock("rock04_b", glm::vec3(-165.0f, -8.3f, 250.0f), glm::vec3(0.0f, 25.0f, 0.0f), glm::vec3(2.9f));
+    particles.update(std::min(dt, MAX_PARTICLE_STEP));
+}
 
-    // Add asteroid
-    addAsteroid(glm::vec3(15.0f, 40.0f, -50.0f), glm::vec3(35.0f * 1.0f, 35.0f * 0.5f, 35.0f * 0.3f), glm::vec3(7.0f));
+void SceneManager::renderParticles(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix,
+    const glm::vec3& cameraPos, Shader& particleShader)
+{
+    particleRenderer.render(particles, projectionMatrix, viewMatrix, cameraPos, particleShader);
+}
 
-    // Add trigger zone at cave_wall_a position to go to scene 2
-    glm::vec3 triggerPos = glm::vec3(-30.0f, -8.5f, 400.0f);
-    addTriggerZone(triggerPos, 25.0f, 2, "Press 'N' to enter the Deep Cave");
+void SceneManager::renderImpostors(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix,
+    const glm::vec3& cameraPos, Shader& impostorShader, Shader& bakeShader)
+{
+    // Atlases asked for this frame are used from the next one on
+    impostors.build(bakeShader);
 
-    // Add visual portal marker (glowing asteroid)
-    addPortalMarker(glm::vec3(-30.0f, -5.0f, 400.0f)); // Slightly above ground
+    impostorShader.use();
+    setupLighting(impostorShader, cameraPos);
+    setNormalLighting(impostorShader);
+    impostors.render(projectionMatrix * viewMatrix, cameraPos, impostorShader);
 }
 
-void SceneManager::createScene2()
+void SceneManager::updatePortalAnimation(float time, float dt)
 {
-    std::cout << "Creating Scene 2" << std::endl;
+    // ===== PULSE SCALE =====
+    float baseScale = 3.0f;          
+    float scaleAmplitude = 0.5f;    
+    float scaleSpeed = 2.0f;         
+    float scale = baseScale + sin(time * scaleSpeed) * scaleAmplitude;
+
+    // ===== ROTATION =====
+    float rotationSpeed = 25.0f;    
+    glm::quat spin = glm::angleAxis(glm::radians(rotationSpeed * dt), glm::vec3(0.0f, 1.0f, 0.0f));
 
-    addCaveWall("cave_wall_a", glm::vec3(-30.0f, -8.5f, 400.0f), glm::vec3(0.0f, 60.0f, 0.0f), glm::vec3(2.0f));
-    
+    const ComponentMask portals = componentBit(TAG_PORTAL_MARKER) |
+        componentBit(COMPONENT_ROTATION) | componentBit(COMPONENT_SCALE);
+
+    world.forEachChunk(portals, [&](ArchetypeChunk& chunk)
+    {
+        glm::vec3* scales = chunk.column<COMPONENT_SCALE>();
+        glm::quat* rotations = chunk.column<COMPONENT_ROTATION>();
+
+        for (uint32_t i = 0; i < chunk.count; i++)
+        {
+            scales[i] = glm::vec3(scale);
+            rotations[i] = glm::normalize(spin * rotations[i]);
+        }
+        chunk.transformsDirty = true;
+    });
 }
 
-bool SceneManager::isPlayerNearAlien(const glm::vec3& playerPos) const
+bool SceneManager::isPlayerLookingAtAlien(const glm::vec3& eyePos, const glm::vec3& viewDirection) const
 {
-    for (const auto& alien : aliens)
+    RaycastHit hit;
+    if (!collision.raycast(eyePos, viewDirection, INTERACTION_REACH, hit) ||
+        !(world.getSignature(hit.entity) & componentBit(TAG_ALIEN)))
+        return false;
+
+    for (const InteractionVolume& volume : interactionVolumes)
     {
-        float dist = glm::distance(playerPos, alien->getPosition());
-        if (dist < 10.0f)
+        if (volume.kind == INTERACTION_ALIEN && glm::distance(eyePos, volume.position) < volume.radius)
             return true;
     }
     return false;
@@ -355,6 +794,7 @@ void SceneManager::setupLighting(Shader& shader, const glm::vec3& cameraPos)
     glUniform3fv(glGetUniformLocation(shader.getId(), "lightColor"), 1, &lightColor[0]);
     glUniform3fv(glGetUniformLocation(shader.getId(), "lightPos"), 1, &lightPos[0]);
     glUniform3fv(glGetUniformLocation(shader.getId(), "viewPos"), 1, &cameraPos[0]);
+    shadows.applyUniforms(shader.getId());
 }
 
 void SceneManager::setEnhancedLighting(Shader& shader)
@@ -380,20 +820,41 @@ void SceneManager::setNormalLighting(Shader& shader)
 
 void SceneManager::renderStars(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix, Shader& sunShader)
 {
+    PROFILE_SCOPE("renderStars");
+    PROFILE_GPU_SCOPE("renderStars");
+
     sunShader.use();
     glm::mat4 MVP = projectionMatrix * viewMatrix;
     glUniformMatrix4fv(glGetUniformLocation(sunShader.getId(), "MVP"), 1, GL_FALSE, &MVP[0][0]);
 
     glPointSize(2.0f);
-    if (starsMesh)
+    Mesh* stars = ResourceManager::getInstance().getMesh(starsMesh);
+    if (stars)
     {
-        starsMesh->drawPoints(sunShader);
+        stars->drawPoints(sunShader);
     }
 }
 
+// Screen pixels covered by one world unit at distance 1; divided by an
+// object's distance it gives the detail texture streaming should provide
+static float getPixelScale(const glm::mat4& projectionMatrix)
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    return projectionMatrix[1][1] * viewport[3] * 0.5f;
+}
+
+void SceneManager::setTextureLodBias(float bias)
+{
+    textureDetailScale = std::pow(2.0f, -std::max(bias, 0.0f));
+}
+
 void SceneManager::renderGround(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix,
     const glm::vec3& cameraPos, Shader& shader)
 {
+    PROFILE_SCOPE("renderGround");
+    PROFILE_GPU_SCOPE("renderGround");
+
     shader.use();
     GLuint MatrixID = glGetUniformLocation(shader.getId(), "MVP");
     GLuint ModelID = glGetUniformLocation(shader.getId(), "model");
@@ -408,107 +869,237 @@ void SceneManager::renderGround(const glm::mat4& projectionMatrix, const glm::ma
     int tileX = (int)floor(camX / tileSize);
     int tileZ = (int)floor(camZ / tileSize);
 
+    // The 3x3 tiles around the camera, transformed in one batch
+    const int TILE_COUNT = 9;
+    glm::vec3 tilePositions[TILE_COUNT];
+    glm::quat tileRotations[TILE_COUNT];
+    glm::vec3 tileScales[TILE_COUNT];
+    glm::mat4 tileModels[TILE_COUNT];
+    glm::mat4 tileMvps[TILE_COUNT];
+
+    int tile = 0;
     for (int x = -1; x <= 1; x++)
     {
         for (int z = -1; z <= 1; z++)
         {
-            glm::mat4 ModelMatrix = glm::translate(glm::mat4(1.0f),
-                glm::vec3((tileX + x) * tileSize, -10.0f, (tileZ + z) * tileSize));
+            tilePositions[tile] = glm::vec3((tileX + x) * tileSize, GROUND_HEIGHT, (tileZ + z) * tileSize);
+            tileRotations[tile] = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+            tileScales[tile] = glm::vec3(1.0f);
+            tile++;
+        }
+    }
 
-            glm::mat4 MVP = projectionMatrix * viewMatrix * ModelMatrix;
-            glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
-            glUniformMatrix4fv(ModelID, 1, GL_FALSE, &ModelMatrix[0][0]);
+    batchTransform(tilePositions, tileRotations, tileScales, projectionMatrix * viewMatrix,
+        tileModels, tileMvps, TILE_COUNT);
 
-            if (groundMesh)
-            {
-                groundMesh->draw(shader);
-            }
+    ResourceManager& rm = ResourceManager::getInstance();
+    Mesh* ground = rm.getMesh(groundMesh);
+    if (ground)
+    {
+        // The nearest ground is right below the camera
+        rm.requestTextureDetail(groundMesh,
+            getPixelScale(projectionMatrix) * textureDetailScale / std::max(cameraPos.y - GROUND_HEIGHT, 1.0f));
+
+        for (int i = 0; i < TILE_COUNT; i++)
+        {
+            glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &tileMvps[i][0][0]);
+            glUniformMatrix4fv(ModelID, 1, GL_FALSE, &tileModels[i][0][0]);
+            ground->draw(shader);
         }
     }
 }
 
-void SceneManager::render(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix,
-    const glm::vec3& cameraPos, Shader& shader)
+// Moving casters: drawn into every cascade each frame
+static const ComponentMask MOVING_CASTER_COMPONENTS = INTERPOLATED_COMPONENTS | componentBit(TAG_ALIEN);
+
+unsigned int SceneManager::drawShadowCasters(int cascade, const ShadowCascade& bounds, bool staticCasters, GLuint mvpId)
 {
-    shader.use();
-    GLuint MatrixID = glGetUniformLocation(shader.getId(), "MVP");
-    GLuint ModelID = glGetUniformLocation(shader.getId(), "model");
+    ResourceManager& rm = ResourceManager::getInstance();
+    unsigned int drawn = 0;
+    auto drawChunk = [&](ArchetypeChunk& chunk)
+    {
+        const glm::mat4* models = chunk.column<COMPONENT_MODEL_MATRIX>();
+        const MeshHandle* meshes = chunk.column<COMPONENT_MESH>();
+        const glm::vec3* scales = chunk.column<COMPONENT_SCALE>();
+        const uint32_t* flags = chunk.column<COMPONENT_RENDER_FLAGS>();
 
-    setupLighting(shader, cameraPos);
+        for (uint32_t i = 0; i < chunk.count; i++)
+        {
+            if (!(flags[i] & RENDER_VISIBLE))
+                continue;
+            Mesh* mesh = rm.getMesh(meshes[i]);
+            float scale = std::max(scales[i].x, std::max(scales[i].y, scales[i].z));
+            if (!mesh || !shadows.overlaps(cascade, glm::vec3(models[i][3]), rm.getMeshRadius(meshes[i]) * scale))
+                continue;
+
+            glm::mat4 MVP = bounds.viewProjection * models[i];
+            glUniformMatrix4fv(mvpId, 1, GL_FALSE, &MVP[0][0]);
+            mesh->drawDepth();
+            drawn++;
+        }
+    };
 
-    // Render spaceships
-    setEnhancedLighting(shader);
-    for (auto& ship : spaceships)
+    if (staticCasters)
     {
-        glm::mat4 modelMatrix = ship->getModelMatrix();
-        glm::mat4 MVP = projectionMatrix * viewMatrix * modelMatrix;
-        glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
-        glUniformMatrix4fv(ModelID, 1, GL_FALSE, &modelMatrix[0][0]);
-        ship->draw(shader);
+        world.forEachChunk(RENDERABLE_COMPONENTS, MOVING_CASTER_COMPONENTS, drawChunk);
+        return drawn;
     }
 
-    // Render cave walls
-    setNormalLighting(shader);
-    for (auto& wall : caveWalls)
-    {
-        glm::mat4 modelMatrix = wall->getModelMatrix();
-        glm::mat4 MVP = projectionMatrix * viewMatrix * modelMatrix;
-        glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
-        glUniformMatrix4fv(ModelID, 1, GL_FALSE, &modelMatrix[0][0]);
-        wall->draw(shader);
-    }
+    world.forEachChunk(RENDERABLE_COMPONENTS | INTERPOLATED_COMPONENTS, drawChunk);
+    world.forEachChunk(RENDERABLE_COMPONENTS | componentBit(TAG_ALIEN), INTERPOLATED_COMPONENTS, drawChunk);
 
-    // Render rocks
-    for (auto& rock : rocks)
+    Mesh* bagMesh = bag ? rm.getMesh(bag->getMesh()) : nullptr;
+    if (bagMesh)
     {
-        glm::mat4 modelMatrix = rock->getModelMatrix();
-        glm::mat4 MVP = projectionMatrix * viewMatrix * modelMatrix;
-        glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
-        glUniformMatrix4fv(ModelID, 1, GL_FALSE, &modelMatrix[0][0]);
-        rock->draw(shader);
+        glm::mat4 modelMatrix = bag->getModelMatrix();
+        glm::vec3 scale = bag->getScale();
+        float radius = rm.getMeshRadius(bag->getMesh()) * std::max(scale.x, std::max(scale.y, scale.z));
+        if (shadows.overlaps(cascade, glm::vec3(modelMatrix[3]), radius))
+        {
+            glm::mat4 MVP = bounds.viewProjection * modelMatrix;
+            glUniformMatrix4fv(mvpId, 1, GL_FALSE, &MVP[0][0]);
+            bagMesh->drawDepth();
+            drawn++;
+        }
     }
+    return drawn;
+}
 
-    // Render aliens
-    setEnhancedLighting(shader);
-    for (auto& alien : aliens)
+void SceneManager::renderShadows(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix, Shader& shadowShader)
+{
+    PROFILE_SCOPE("renderShadows");
+    PROFILE_GPU_SCOPE("renderShadows");
+
+    // A static caster moved, or meshes finished loading: the cached cascades
+    // no longer match the scene
+    bool staticMoved = false;
+    world.forEachChunk(RENDERABLE_COMPONENTS, MOVING_CASTER_COMPONENTS, [&](ArchetypeChunk& chunk)
     {
-        glm::mat4 modelMatrix = alien->getModelMatrix();
-        glm::mat4 MVP = projectionMatrix * viewMatrix * modelMatrix;
-        glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
-        glUniformMatrix4fv(ModelID, 1, GL_FALSE, &modelMatrix[0][0]);
-        alien->draw(shader);
+        staticMoved = staticMoved || chunk.transformsDirty;
+    });
+    unsigned int residentMeshes = ResourceManager::getInstance().getMemoryStats().residentMeshes;
+    if (staticMoved || residentMeshes != shadowResidentMeshes)
+    {
+        shadows.invalidateStatic();
+        shadowResidentMeshes = residentMeshes;
     }
 
-    // Render asteroids
-    for (auto& asteroid : asteroids)
+    pendingMatrixUpdates += updateModelMatrices(world);
+    if (!shadows.update(projectionMatrix, viewMatrix))
+        return;
+
+    shadowShader.use();
+    GLuint mvpId = glGetUniformLocation(shadowShader.getId(), "MVP");
+    shadows.render([&](int cascade, const ShadowCascade& bounds, bool staticCasters)
     {
-        glm::mat4 modelMatrix = asteroid->getModelMatrix();
-        glm::mat4 MVP = projectionMatrix * viewMatrix * modelMatrix;
-        glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
-        glUniformMatrix4fv(ModelID, 1, GL_FALSE, &modelMatrix[0][0]);
-        asteroid->draw(shader);
-    }
+        return drawShadowCasters(cascade, bounds, staticCasters, mvpId);
+    });
+}
+
+void SceneManager::renderEntities(const glm::mat4& viewProjection, GLuint matrixId, GLuint modelId,
+    Shader& shader, float pixelScale)
+{
+    // Ships, aliens, asteroids and portal markers are lit brighter than cave
+    // walls and rocks; the lighting uniforms only change when the group does
+    static const uint32_t LIGHTING_GROUPS[2] = { RENDER_ENHANCED_LIGHTING, 0 };
+    uint32_t currentLighting = ~0u;
 
-    // Render portal markers
-    for (auto& portal : portalMarkers)
+    ResourceManager& rm = ResourceManager::getInstance();
+    world.forEachChunk(RENDERABLE_COMPONENTS, [&](ArchetypeChunk& chunk)
     {
-        glm::mat4 modelMatrix = portal->getModelMatrix();
-        glm::mat4 MVP = projectionMatrix * viewMatrix * modelMatrix;
-        glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
-        glUniformMatrix4fv(ModelID, 1, GL_FALSE, &modelMatrix[0][0]);
-        portal->draw(shader);
-    }
+        const glm::mat4* models = chunk.column<COMPONENT_MODEL_MATRIX>();
+        const MeshHandle* meshes = chunk.column<COMPONENT_MESH>();
+        const glm::quat* rotations = chunk.column<COMPONENT_ROTATION>();
+        const glm::vec3* scales = chunk.column<COMPONENT_SCALE>();
+        const uint32_t* flags = chunk.column<COMPONENT_RENDER_FLAGS>();
+
+        // All MVPs of the chunk in one SIMD pass over the cached model matrices,
+        // shared by both lighting groups
+        glm::mat4* mvps = FrameArena::getInstance().allocateArray<glm::mat4>(chunk.count);
+        batchMultiply(viewProjection, models, mvps, chunk.count);
+
+        for (uint32_t lightingFlag : LIGHTING_GROUPS)
+        {
+            for (uint32_t i = 0; i < chunk.count; i++)
+            {
+                if (!(flags[i] & RENDER_VISIBLE) || (flags[i] & RENDER_ENHANCED_LIGHTING) != lightingFlag)
+                    continue;
+                Mesh* mesh = rm.getMesh(meshes[i]);
+                if (!mesh)
+                    continue;
+
+                // Clip-space w of the object's origin is its view depth
+                float depth = mvps[i][3][3];
+                float scale = std::max(scales[i].x, std::max(scales[i].y, scales[i].z));
+                float nearest = depth - rm.getMeshRadius(meshes[i]) * scale;
+                if (nearest > drawDistance)
+                {
+                    RenderStats::getInstance().countCulled();
+                    continue;
+                }
+
+                // Impostors are lit like the normal group, so only its entities qualify
+                if (lightingFlag == 0 && nearest > impostorDistance &&
+                    impostors.add(meshes[i], glm::vec3(models[i][3]), rotations[i], scale))
+                    continue;
+                if (depth > 0.0f)
+                    rm.requestTextureDetail(meshes[i], pixelScale * scale / depth);
+
+                if (lightingFlag != currentLighting)
+                {
+                    if (lightingFlag == RENDER_ENHANCED_LIGHTING)
+                        setEnhancedLighting(shader);
+                    else
+                        setNormalLighting(shader);
+                    currentLighting = lightingFlag;
+                }
+                glUniformMatrix4fv(matrixId, 1, GL_FALSE, &mvps[i][0][0]);
+                glUniformMatrix4fv(modelId, 1, GL_FALSE, &models[i][0][0]);
+                mesh->draw(shader);
+            }
+        }
+    });
 
-    setNormalLighting(shader);
+    // The bag after the sweep uses the normal lighting
+    if (currentLighting != 0)
+        setNormalLighting(shader);
+}
+
+void SceneManager::render(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix,
+    const glm::vec3& cameraPos, Shader& shader)
+{
+    PROFILE_SCOPE("render");
+    PROFILE_GPU_SCOPE("render");
+
+    shader.use();
+    GLuint MatrixID = glGetUniformLocation(shader.getId(), "MVP");
+    GLuint ModelID = glGetUniformLocation(shader.getId(), "model");
+
+    unsigned int entityMatrixUpdates = updateModelMatrices(world);
+    glm::mat4 viewProjection = projectionMatrix * viewMatrix;
+
+    setupLighting(shader, cameraPos);
+    float pixelScale = getPixelScale(projectionMatrix) * textureDetailScale;
+
+    renderEntities(viewProjection, MatrixID, ModelID, shader, pixelScale);
 
     // Render bag
     if (bag)
     {
         glm::mat4 modelMatrix = bag->getModelMatrix();
-        glm::mat4 MVP = projectionMatrix * viewMatrix * modelMatrix;
+        glm::mat4 MVP = viewProjection * modelMatrix;
+        if (MVP[3][3] > 0.0f)
+        {
+            glm::vec3 scale = bag->getScale();
+            ResourceManager::getInstance().requestTextureDetail(bag->getMesh(),
+                pixelScale * std::max(scale.x, std::max(scale.y, scale.z)) / MVP[3][3]);
+        }
         glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
         glUniformMatrix4fv(ModelID, 1, GL_FALSE, &modelMatrix[0][0]);
         bag->draw(shader);
     }
 
-}
\ No newline at end of file
+    matrixUpdatesLastFrame = GameObject::getMatrixUpdateCount() + entityMatrixUpdates + pendingMatrixUpdates;
+    pendingMatrixUpdates = 0;
+    GameObject::resetMatrixUpdateCount();
+}
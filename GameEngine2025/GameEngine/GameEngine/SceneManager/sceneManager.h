@@ -2,20 +2,66 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <atomic>
+#include <future>
 #include "../GameObject/gameObject.h"
 #include "../Shaders/shader.h"
 #include "../ResourceManager/resourceManager.h"
 #include "../Camera/camera.h"
+#include "../ECS/entityWorld.h"
+#include "../Collision/collisionWorld.h"
+#include "../Physics/physicsWorld.h"
+#include "../Particles/particleSystem.h"
+#include "../Particles/particleRenderer.h"
+#include "../Graphics/cascadedShadowMap.h"
+#include "../Graphics/impostorRenderer.h"
+#include "sceneFile.h"
+#include "worldPartition.h"
 #include <glm.hpp>
 #include <gtc/matrix_transform.hpp>
 
 struct TriggerZone {
     glm::vec3 position;
     float radius;
+    float prefetchRadius; // entering this wider radius starts building targetScene
     int targetScene;
     std::string message;
 };
 
+// Area in which the player can interact with something (e.g. talk to the alien)
+struct InteractionVolume {
+    glm::vec3 position;
+    float radius;
+    InteractionKind kind;
+};
+
+// Everything a scene owns. Instantiated from a scene file, either directly
+// in loadScene or ahead of time on a worker thread; building one only reads
+// shared resources, so it needs no GL context.
+struct SceneContents
+{
+    int sceneId = 0;
+    EntityWorld world;
+    std::vector<TriggerZone> triggerZones;
+    std::vector<InteractionVolume> interactionVolumes;
+    std::unique_ptr<GameObject> bag;
+
+    // Distinct meshes the entities draw; one ResourceManager reference each
+    std::vector<MeshHandle> meshes;
+
+    // Partitioned scenes keep their file open; its cells are streamed in
+    // around the camera once the scene is current
+    std::unique_ptr<SceneFile> partitionFile;
+
+    // Set by the owner to abandon a background build early
+    const std::atomic<bool>* cancelled = nullptr;
+    bool isCancelled() const { return cancelled && cancelled->load(std::memory_order_relaxed); }
+
+    SceneContents() = default;
+    ~SceneContents();
+    void releaseMeshes();
+};
+
 class SceneManager
 {
 public:
@@ -25,18 +71,41 @@ public:
     // Initialize resources (called once at startup)
     void initializeResources();
 
-    // Scene management
+    // Scene management. loadScene swaps in a prefetched scene when one is
+    // ready (or waits for it to finish), otherwise builds it synchronously.
     void loadScene(int sceneId);
     void clearScene();
     int getCurrentScene() const { return currentSceneId; }
 
+    // Background scene building, driven by checkProximityTriggers
+    void startPrefetch(int sceneId);
+    void cancelPrefetch();
+    bool isPrefetchReady(int sceneId) const;
+
+    // Creates the contents of a compiled scene; false when cancelled. Meshes are
+    // looked up once per distinct name, not per placement. The placements of
+    // a partitioned scene are left to its WorldPartition.
+    static bool instantiateScene(const SceneFile& file, SceneContents& scene);
+
+    // Loads and unloads the cells of a partitioned scene around the camera;
+    // once per frame, before processUploads
+    void updateWorldStreaming(const glm::vec3& cameraPos, float dt);
+    WorldPartition& getWorldPartition() { return partition; }
+
+    // Spawns a renderable entity. `components` adds tags (and optional extra components
+    // such as INTERPOLATED_COMPONENTS) and picks the archetype; `renderFlags` its lighting
+    static Entity addObject(EntityWorld& world, MeshHandle mesh, const glm::vec3& pos,
+        const glm::quat& rot, const glm::vec3& scale, ComponentMask components, uint32_t renderFlags);
+
     // Trigger system
     void checkProximityTriggers(const glm::vec3& playerPos);
     int getNearbyTrigger() const { return nearbyTrigger; }
-    std::string getTriggerMessage() const;
+    const std::string& getTriggerMessage() const;    // empty when no trigger is near
     const std::vector<TriggerZone>& getTriggerZones() const { return triggerZones; }
 
-    // Rendering
+    // Rendering. renderShadows draws the sun's shadow maps that render and
+    // renderGround then sample; call it first.
+    void renderShadows(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix, Shader& shadowShader);
     void render(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix,
         const glm::vec3& cameraPos, Shader& shader);
 
@@ -44,27 +113,107 @@ public:
     void renderGround(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix,
         const glm::vec3& cameraPos, Shader& shader);
 
-    bool isPlayerNearAlien(const glm::vec3& playerPos) const;
+    // "Look at and press E": the view ray hits the alien while the player
+    // stands in its interaction volume
+    bool isPlayerLookingAtAlien(const glm::vec3& eyePos, const glm::vec3& viewDirection) const;
     bool isBagGrabbed() const { return bagGrabbed; }
 
     void grabBag();
-    void updateBagFollowCamera(Camera& camera);
+    void updateBagFollowCamera(Camera& camera, float alpha);
+
+    // Fixed-timestep simulation: time is the simulation clock, dt one tick
+    void beginSimulationTick();
+    void updatePortalAnimation(float time, float dt);
+
+    // Rigid-body asteroids falling onto the ground and the scene geometry.
+    // The shower drops `count` of them in a block above `center`; updatePhysics
+    // steps them once per tick and copies the result into their transforms.
+    void spawnAsteroidShower(const glm::vec3& center, int count);
+    void updatePhysics(float dt);
+    const PhysicsWorld& getPhysics() const { return physics; }
+
+    // Distant rocks and cave walls drawn by render() were queued as impostor
+    // cards instead; this draws them, after render and before anything
+    // transparent. Also builds one missing atlas per call with `bakeShader`.
+    void renderImpostors(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix,
+        const glm::vec3& cameraPos, Shader& impostorShader, Shader& bakeShader);
+    const ImpostorRenderer& getImpostors() const { return impostors; }
 
-    void updatePortalAnimation(float time);
+    // Entities whose bounds lie entirely beyond this distance become impostors
+    void setImpostorDistance(float distance) { impostorDistance = distance; }
+    float getImpostorDistance() const { return impostorDistance; }
+
+    // Visual effects (portal glow, dust around the player). Advanced once per
+    // rendered frame rather than per tick, since nothing gameplay reads them;
+    // rendered after everything opaque.
+    void updateParticles(float dt, const glm::vec3& cameraPos);
+    void renderParticles(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix,
+        const glm::vec3& cameraPos, Shader& particleShader);
+    const ParticleSystem& getParticles() const { return particles; }
+
+    // Blends moving entities between the last two ticks before rendering
+    void interpolateTransforms(float alpha);
+
+    // Quality knobs for frame-time governing: entities whose bounds lie
+    // entirely beyond the draw distance are skipped, and texture streaming
+    // asks for `bias` mip levels less detail than the screen needs
+    void setDrawDistance(float distance) { drawDistance = distance; }
+    void setTextureLodBias(float bias);
+
+    // Cascade count, resolution and reach can be changed between frames
+    CascadedShadowMap& getShadows() { return shadows; }
+
+    // Transform statistics: world matrices rebuilt during the last rendered frame
+    unsigned int getMatrixUpdatesLastFrame() const { return matrixUpdatesLastFrame; }
+
+    EntityWorld& getWorld() { return world; }
+
+    // Solid geometry of the current scene, for the camera and picking
+    const CollisionWorld& getCollisionWorld() const { return collision; }
 
 private:
-    // Scene objects
-    std::vector<std::unique_ptr<GameObject>> spaceships;
-    std::vector<std::unique_ptr<GameObject>> aliens;
-    std::vector<std::unique_ptr<GameObject>> caveWalls;
-    std::vector<std::unique_ptr<GameObject>> rocks;
-    std::vector<std::unique_ptr<GameObject>> asteroids;
-    std::vector<std::unique_ptr<GameObject>> portalMarkers;
+    // Scene objects, stored per archetype in contiguous chunks
+    EntityWorld world;
+
+    // Cells of the current scene, when it is partitioned
+    WorldPartition partition;
+
+    // Static entities as collision geometry; rebuilt when the scene changes
+    // and again once meshes that were still loading have arrived
+    CollisionWorld collision;
+    unsigned int collisionResidentMeshes = 0;
+    void rebuildCollision();
+    void updateCollision();
+
+    // Dynamic bodies of the current scene; entities refer to theirs by index
+    PhysicsWorld physics;
+    uint32_t asteroidShape = 0xFFFFFFFFu;  // built from the asteroid model on first use
+    float asteroidModelRadius = 1.0f;
+    uint32_t asteroidSeed = 1;
+    bool ensureAsteroidShape(MeshHandle mesh);
+
+    // Emitters of the current scene, recreated with it
+    ParticleSystem particles;
+    ParticleRenderer particleRenderer;
+    uint32_t dustEmitter = 0xFFFFFFFFu;
+    void createSceneEmitters();
+
+    float drawDistance = 1.0e30f;
+    float impostorDistance = 300.0f;
+    ImpostorRenderer impostors;
+    float textureDetailScale = 1.0f;    // 2^-bias
+
+    // Hierarchical objects that need parenting stay GameObjects
+    // Invisible node that tracks the camera; held objects are parented to it
+    std::unique_ptr<GameObject> cameraRig;
     std::unique_ptr<GameObject> bag;
     bool bagGrabbed = false;
 
-    Mesh* starsMesh;
-    Mesh* groundMesh;
+    unsigned int matrixUpdatesLastFrame;
+    unsigned int pendingMatrixUpdates;  // rebuilt this frame before render
+
+    MeshHandle starsMesh;
+    MeshHandle groundMesh;
 
     int currentSceneId;
 
@@ -72,28 +221,49 @@ private:
     std::vector<TriggerZone> triggerZones;
     int nearbyTrigger; // -1 if none, else index of trigger
 
+    std::vector<InteractionVolume> interactionVolumes;
+
+    // References held for the current scene's entities
+    std::vector<MeshHandle> sceneMeshes;
+
+    // Scene being built on a worker thread; shared with the task so a
+    // cancelled build can finish on its own after we let go of it
+    struct ScenePrefetch
+    {
+        int sceneId;
+        std::atomic<bool> cancelled;
+        std::future<void> done;
+        SceneContents contents;
+    };
+    std::shared_ptr<ScenePrefetch> prefetch;
+
+    void updatePrefetch(const glm::vec3& playerPos);
+    void commitScene(SceneContents& scene);
+
     // Lighting parameters
     glm::vec3 lightColor;
     glm::vec3 lightPos;
 
+    // Sun shadows. Static casters are everything that neither moves with the
+    // simulation nor is an alien; their cascades are redrawn when one of them
+    // moves or when meshes finish loading.
+    CascadedShadowMap shadows;
+    unsigned int shadowResidentMeshes = 0;
+    unsigned int drawShadowCasters(int cascade, const ShadowCascade& bounds, bool staticCasters, GLuint mvpId);
+
     // Lighting setup
     void setupLighting(Shader& shader, const glm::vec3& cameraPos);
     void setEnhancedLighting(Shader& shader);
     void setDimLighting(Shader& shader);
     void setNormalLighting(Shader& shader);
+    void renderEntities(const glm::mat4& viewProjection, GLuint matrixId, GLuint modelId,
+        Shader& shader, float pixelScale);
 
-    // Scene creation methods
-    void createScene1();
-    void createScene2();
-
-    // Helper methods for creating object groups (used by scenes)
-    void addSpaceship(const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& scale);
-    void addAlien(const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& scale);
-    void addCaveWall(const std::string& meshName, const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& scale);
-    void addRock(const std::string& meshName, const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& scale);
-    void addAsteroid(const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& scale);
+    // Scene creation. Static and limited to `scene` so it can run on any
+    // thread; loads Resources/Scenes/scene<N>, returns false when cancelled
+    static bool buildScene(int sceneId, SceneContents& scene);
 
     // Trigger system helpers
-    void addTriggerZone(const glm::vec3& pos, float radius, int targetScene, const std::string& message);
-    void addPortalMarker(const glm::vec3& pos); // Visual indicator
+    static void addTriggerZone(SceneContents& scene, const glm::vec3& pos, float radius, int targetScene,
+        const std::string& message);
 };
\ No newline at end of file
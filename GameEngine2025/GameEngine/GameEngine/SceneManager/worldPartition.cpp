@@ -0,0 +1,417 @@
+#include "worldPartition.h"
+#include "sceneManager.h"
+#include "../Core/allocationTracker.h"
+#include "../Core/profiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+
+// A single frame that moves further than this is a teleport (respawn, scene
+// swap), not movement to extrapolate
+static const float MAX_TRACKED_STEP = 50.0f;
+
+WorldPartition::WorldPartition()
+    : lastPosition(0.0f), velocity(0.0f), hasPosition(false)
+{
+}
+
+WorldPartition::~WorldPartition()
+{
+    close();
+}
+
+void WorldPartition::open(std::unique_ptr<SceneFile> newFile)
+{
+    close();
+    if (!newFile || !newFile->isPartitioned())
+        return;
+
+    file = std::move(newFile);
+    const SceneFileHeader& header = file->getHeader();
+    ResourceManager& rm = ResourceManager::getInstance();
+
+    meshes.resize(header.meshCount);
+    for (uint32_t i = 0; i < header.meshCount; i++)
+    {
+        meshes[i] = rm.findMesh(file->getMeshHash(i));
+        if (!meshes[i].isValid())
+            std::cout << "Warning: Mesh '" << file->getMeshName(i) << "' not found!" << std::endl;
+    }
+
+    cells.reserve(settings.maxActiveCells);
+    changes.reserve(settings.maxActiveCells);
+    reserveCandidates();
+    stats = WorldPartitionStats();
+    hasPosition = false;
+    velocity = glm::vec3(0.0f);
+
+    std::cout << "World partition: " << header.cellCount << " cells of " << header.cellSize
+        << " units, " << header.placementCount << " placements" << std::endl;
+}
+
+void WorldPartition::close()
+{
+    for (const ActiveCell& cell : cells)
+        releaseCellMeshes(cell);
+    cells.clear();
+    candidates.clear();
+    changes.clear();
+    meshes.clear();
+    file.reset();
+    stats = WorldPartitionStats();
+}
+
+void WorldPartition::setSettings(const WorldPartitionSettings& newSettings)
+{
+    settings = newSettings;
+    settings.maxActiveCells = std::max(settings.maxActiveCells, 1);
+    settings.maxCellStartsPerUpdate = std::max(settings.maxCellStartsPerUpdate, 1);
+    settings.maxEntityWorkPerUpdate = std::max(settings.maxEntityWorkPerUpdate, 1u);
+    settings.unloadRadius = std::max(settings.unloadRadius, settings.loadRadius);
+    if (file)
+    {
+        cells.reserve(settings.maxActiveCells);
+        changes.reserve(settings.maxActiveCells);
+        reserveCandidates();
+    }
+}
+
+void WorldPartition::reserveCandidates()
+{
+    // Every cell of the box collectCandidates scans: the camera and its
+    // lookahead point, at most loadRadius apart, each with loadRadius around
+    // it. Per-frame updates then never grow the list.
+    int span = (int)std::ceil(3.0f * settings.loadRadius / file->getHeader().cellSize) + 2;
+    candidates.reserve((size_t)span * span);
+}
+
+int WorldPartition::findCell(int32_t x, int32_t z) const
+{
+    const SceneFileHeader& header = file->getHeader();
+    const SceneCellRecord* records = file->getCells();
+
+    // Same order as the table: z, then x
+    int low = 0;
+    int high = (int)header.cellCount - 1;
+    while (low <= high)
+    {
+        int middle = (low + high) / 2;
+        const SceneCellRecord& cell = records[middle];
+        if (cell.z == z && cell.x == x)
+            return middle;
+        if (cell.z < z || (cell.z == z && cell.x < x))
+            low = middle + 1;
+        else
+            high = middle - 1;
+    }
+    return -1;
+}
+
+bool WorldPartition::isActive(uint32_t record) const
+{
+    for (const ActiveCell& cell : cells)
+    {
+        if (cell.record == record)
+            return true;
+    }
+    return false;
+}
+
+float WorldPartition::distanceTo(const SceneCellRecord& cell, const glm::vec3& point) const
+{
+    // To the nearest point of the cell's square, on the ground plane
+    float size = file->getHeader().cellSize;
+    float minX = cell.x * size;
+    float minZ = cell.z * size;
+    float dx = std::max(std::max(minX - point.x, point.x - (minX + size)), 0.0f);
+    float dz = std::max(std::max(minZ - point.z, point.z - (minZ + size)), 0.0f);
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+void WorldPartition::collectCandidates(const glm::vec3& point, const glm::vec3& ahead)
+{
+    float size = file->getHeader().cellSize;
+    const SceneCellRecord* records = file->getCells();
+
+    // Both circles, as one box of grid coordinates
+    float radius = settings.loadRadius;
+    int32_t x0 = (int32_t)std::floor((std::min(point.x, ahead.x) - radius) / size);
+    int32_t x1 = (int32_t)std::floor((std::max(point.x, ahead.x) + radius) / size);
+    int32_t z0 = (int32_t)std::floor((std::min(point.z, ahead.z) - radius) / size);
+    int32_t z1 = (int32_t)std::floor((std::max(point.z, ahead.z) + radius) / size);
+
+    for (int32_t z = z0; z <= z1; z++)
+    {
+        for (int32_t x = x0; x <= x1; x++)
+        {
+            int index = findCell(x, z);
+            if (index < 0 || isActive((uint32_t)index))
+                continue;
+
+            const SceneCellRecord& cell = records[index];
+            if (std::min(distanceTo(cell, point), distanceTo(cell, ahead)) <= radius)
+                candidates.push_back((uint32_t)index);
+        }
+    }
+}
+
+void WorldPartition::startCell(uint32_t record, float distance)
+{
+    ExpectedAllocationScope streaming;  // the cell's entity list and mesh load requests
+    const SceneCellRecord& cellRecord = file->getCells()[record];
+    const uint32_t* cellMeshes = file->getCellMeshes() + cellRecord.firstMesh;
+    ResourceManager& rm = ResourceManager::getInstance();
+
+    for (uint32_t i = 0; i < cellRecord.meshCount; i++)
+    {
+        MeshHandle mesh = meshes[cellMeshes[i]];
+        if (!mesh.isValid())
+            continue;
+        rm.acquireMesh(mesh);
+        rm.makeResidentAsync(mesh);
+    }
+
+    ActiveCell cell;
+    cell.record = record;
+    cell.state = CELL_LOADING;
+    cell.distance = distance;
+    cell.entities.reserve(cellRecord.placementCount);
+    cells.push_back(std::move(cell));
+}
+
+void WorldPartition::releaseCellMeshes(const ActiveCell& cell)
+{
+    const SceneCellRecord& cellRecord = file->getCells()[cell.record];
+    const uint32_t* cellMeshes = file->getCellMeshes() + cellRecord.firstMesh;
+    ResourceManager& rm = ResourceManager::getInstance();
+
+    for (uint32_t i = 0; i < cellRecord.meshCount; i++)
+    {
+        MeshHandle mesh = meshes[cellMeshes[i]];
+        if (mesh.isValid())
+            rm.releaseMesh(mesh);
+    }
+}
+
+bool WorldPartition::areCellMeshesSettled(const ActiveCell& cell) const
+{
+    const SceneCellRecord& cellRecord = file->getCells()[cell.record];
+    const uint32_t* cellMeshes = file->getCellMeshes() + cellRecord.firstMesh;
+    ResourceManager& rm = ResourceManager::getInstance();
+
+    // Failed loads count as settled; their entities draw nothing, as in a fully loaded scene
+    for (uint32_t i = 0; i < cellRecord.meshCount; i++)
+    {
+        MeshHandle mesh = meshes[cellMeshes[i]];
+        if (mesh.isValid() && rm.isLoading(mesh))
+            return false;
+    }
+    return true;
+}
+
+void WorldPartition::addChange(const ActiveCell& cell, bool loaded)
+{
+    const SceneCellRecord& cellRecord = file->getCells()[cell.record];
+    const ScenePlacement* placements = file->getPlacements() + cellRecord.firstPlacement;
+    ResourceManager& rm = ResourceManager::getInstance();
+
+    // Placements may reach over the cell's edges; their meshes are still
+    // resident while the change is recorded
+    WorldCellChange change;
+    change.cell = cell.record;
+    change.loaded = loaded;
+    change.boundsMin = glm::vec3(FLT_MAX);
+    change.boundsMax = glm::vec3(-FLT_MAX);
+    for (uint32_t i = 0; i < cellRecord.placementCount; i++)
+    {
+        const ScenePlacement& placement = placements[i];
+        glm::vec3 position(placement.position[0], placement.position[1], placement.position[2]);
+        float scale = std::max(placement.scale[0], std::max(placement.scale[1], placement.scale[2]));
+        glm::vec3 reach(rm.getMeshRadius(meshes[placement.mesh]) * scale);
+        change.boundsMin = glm::min(change.boundsMin, position - reach);
+        change.boundsMax = glm::max(change.boundsMax, position + reach);
+    }
+    change.entities = loaded ? cell.entities.data() : nullptr;
+    change.entityCount = loaded ? (uint32_t)cell.entities.size() : 0;
+    changes.push_back(change);
+}
+
+uint32_t WorldPartition::instantiate(ActiveCell& cell, EntityWorld& world, uint32_t budget)
+{
+    ExpectedAllocationScope streaming;  // new entities may open archetype chunks
+    const SceneCellRecord& cellRecord = file->getCells()[cell.record];
+    const ScenePlacement* placements = file->getPlacements() + cellRecord.firstPlacement;
+
+    uint32_t first = (uint32_t)cell.entities.size();
+    uint32_t last = std::min(first + budget, cellRecord.placementCount);
+    for (uint32_t i = first; i < last; i++)
+    {
+        const ScenePlacement& placement = placements[i];
+        cell.entities.push_back(SceneManager::addObject(world, meshes[placement.mesh],
+            glm::vec3(placement.position[0], placement.position[1], placement.position[2]),
+            glm::quat(placement.rotation[3], placement.rotation[0], placement.rotation[1], placement.rotation[2]),
+            glm::vec3(placement.scale[0], placement.scale[1], placement.scale[2]),
+            placement.components | componentBit(TAG_STREAMED), placement.renderFlags));
+    }
+    return last - first;
+}
+
+bool WorldPartition::update(const glm::vec3& position, float dt, EntityWorld& world)
+{
+    if (!file)
+        return false;
+    PROFILE_SCOPE("WorldPartition::update");
+
+    // Ground velocity from the positions we are given, smoothed so one uneven
+    // frame does not swing the lookahead around
+    if (hasPosition && dt > 0.0f)
+    {
+        glm::vec3 step = position - lastPosition;
+        step.y = 0.0f;
+        if (glm::length(step) > MAX_TRACKED_STEP)
+        {
+            velocity = glm::vec3(0.0f);
+        }
+        else
+        {
+            float blend = std::min(dt * 4.0f, 1.0f);
+            velocity += (step / dt - velocity) * blend;
+        }
+    }
+    lastPosition = position;
+    hasPosition = true;
+
+    // Never look further ahead than the load radius, so a fast flyer does not
+    // skip the ground between here and there
+    glm::vec3 lookahead = velocity * settings.lookaheadSeconds;
+    float lookaheadLength = glm::length(lookahead);
+    if (lookaheadLength > settings.loadRadius)
+        lookahead *= settings.loadRadius / lookaheadLength;
+    glm::vec3 ahead = position + lookahead;
+
+    const SceneCellRecord* records = file->getCells();
+    changes.clear();
+
+    // Cells left behind start unloading
+    for (ActiveCell& cell : cells)
+    {
+        const SceneCellRecord& record = records[cell.record];
+        cell.distance = std::min(distanceTo(record, position), distanceTo(record, ahead));
+        if (cell.distance > settings.unloadRadius)
+            cell.state = CELL_UNLOADING;
+    }
+
+    // New cells, nearest first. A full cell list gives up its furthest cell
+    // when something wanted is clearly closer; the freed slot is used once
+    // that cell is gone.
+    candidates.clear();
+    collectCandidates(position, ahead);
+    std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b)
+    {
+        return std::min(distanceTo(records[a], position), distanceTo(records[a], ahead)) <
+            std::min(distanceTo(records[b], position), distanceTo(records[b], ahead));
+    });
+
+    stats.deferredCells = 0;
+    int started = 0;
+    for (uint32_t candidate : candidates)
+    {
+        float distance = std::min(distanceTo(records[candidate], position), distanceTo(records[candidate], ahead));
+        if ((int)cells.size() >= settings.maxActiveCells)
+        {
+            stats.deferredCells++;
+
+            ActiveCell* furthest = nullptr;
+            for (ActiveCell& cell : cells)
+            {
+                if (cell.state != CELL_UNLOADING && (!furthest || cell.distance > furthest->distance))
+                    furthest = &cell;
+            }
+            if (furthest && furthest->distance > distance + file->getHeader().cellSize)
+                furthest->state = CELL_UNLOADING;
+            continue;
+        }
+        // The rest are picked up again next update
+        if (started >= settings.maxCellStartsPerUpdate)
+            break;
+        startCell(candidate, distance);
+        started++;
+    }
+
+    // Entity work, nearest cells first; unloading goes before loading
+    std::sort(cells.begin(), cells.end(), [](const ActiveCell& a, const ActiveCell& b)
+    {
+        if ((a.state == CELL_UNLOADING) != (b.state == CELL_UNLOADING))
+            return a.state == CELL_UNLOADING;
+        return a.distance < b.distance;
+    });
+
+    uint32_t budget = settings.maxEntityWorkPerUpdate;
+    bool released = false;
+    for (ActiveCell& cell : cells)
+    {
+        if (cell.state == CELL_UNLOADING)
+        {
+            ExpectedAllocationScope streaming;
+            while (budget > 0 && !cell.entities.empty())
+            {
+                world.destroyEntity(cell.entities.back());
+                cell.entities.pop_back();
+                budget--;
+            }
+            continue;
+        }
+
+        if (cell.state == CELL_LOADING && areCellMeshesSettled(cell))
+            cell.state = CELL_INSTANTIATING;
+
+        if (cell.state == CELL_INSTANTIATING && budget > 0)
+        {
+            budget -= instantiate(cell, world, budget);
+            if (cell.entities.size() == records[cell.record].placementCount)
+            {
+                cell.state = CELL_LOADED;
+                stats.cellLoads++;
+                addChange(cell, true);
+            }
+        }
+    }
+
+    // Drop the cells whose entities are all gone
+    for (size_t i = 0; i < cells.size();)
+    {
+        if (cells[i].state == CELL_UNLOADING && cells[i].entities.empty())
+        {
+            ExpectedAllocationScope streaming;
+            addChange(cells[i], false);
+            releaseCellMeshes(cells[i]);
+            cells[i] = std::move(cells.back());
+            cells.pop_back();
+            stats.cellUnloads++;
+            released = true;
+        }
+        else
+        {
+            i++;
+        }
+    }
+    // Unreferenced meshes are only evicted over the budget, so turning back
+    // to a cell just left is usually free
+    if (released)
+    {
+        ExpectedAllocationScope streaming;
+        ResourceManager::getInstance().enforceBudget();
+    }
+
+    stats.activeCells = (uint32_t)cells.size();
+    stats.loadedCells = 0;
+    stats.entities = 0;
+    for (const ActiveCell& cell : cells)
+    {
+        if (cell.state == CELL_LOADED)
+            stats.loadedCells++;
+        stats.entities += (uint32_t)cell.entities.size();
+    }
+    return !changes.empty();
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm.hpp>
+#include "sceneFile.h"
+#include "../ECS/entityWorld.h"
+#include "../ResourceManager/assetHandle.h"
+
+struct WorldPartitionSettings
+{
+    // Cells load when their square comes within loadRadius of the camera or
+    // of where it is heading, and unload once they are further than
+    // unloadRadius from both; the gap keeps a cell on the edge from flickering
+    float loadRadius = 600.0f;
+    float unloadRadius = 800.0f;
+    float lookaheadSeconds = 3.0f;      // of the camera's current ground speed
+
+    // Bounds that hold whatever the size of the map
+    int maxActiveCells = 128;           // loaded, loading or unloading
+    int maxCellStartsPerUpdate = 4;
+    uint32_t maxEntityWorkPerUpdate = 2048;     // entities created or destroyed per update
+};
+
+struct WorldPartitionStats
+{
+    uint32_t activeCells = 0;
+    uint32_t loadedCells = 0;
+    uint32_t entities = 0;              // alive and owned by cells
+    uint32_t deferredCells = 0;         // wanted in the last update, but over maxActiveCells
+    unsigned long long cellLoads = 0;   // since open
+    unsigned long long cellUnloads = 0;
+};
+
+// A cell that finished loading or was removed in the last update
+struct WorldCellChange
+{
+    uint32_t cell;              // index into the scene's cell table
+    bool loaded;                // false: removed, its entities are gone
+    glm::vec3 boundsMin;        // world box around the cell's placements
+    glm::vec3 boundsMax;
+    const Entity* entities;     // of a loaded cell, valid until the next update
+    uint32_t entityCount;
+};
+
+// Streams a partitioned scene (see "partition" in sceneFile.h) around the
+// camera, so only the cells near it cost memory. Starting a cell takes
+// references on its meshes and queues their loads on the worker threads; once
+// none is loading any more, its placements become entities, a budgeted
+// number per update. Leaving cells lose their entities the same way and
+// release their meshes, which the resource budget may then evict.
+//
+// The compiled scene stays mapped while open; placements are read from it
+// as cells load, never copied as a whole.
+class WorldPartition
+{
+public:
+    WorldPartition();
+    ~WorldPartition();
+
+    void open(std::unique_ptr<SceneFile> file);
+
+    // Drops every cell and its mesh references. Entities stay in their world,
+    // which the caller clears or has already swapped out.
+    void close();
+    bool isOpen() const { return file != nullptr; }
+
+    void setSettings(const WorldPartitionSettings& settings);
+    const WorldPartitionSettings& getSettings() const { return settings; }
+
+    // Main thread, once per frame. The movement direction comes from the
+    // positions passed in. True when a cell was completed or removed, i.e.
+    // when the static geometry changed; getChanges then lists them.
+    bool update(const glm::vec3& position, float dt, EntityWorld& world);
+    const std::vector<WorldCellChange>& getChanges() const { return changes; }
+
+    const WorldPartitionStats& getStats() const { return stats; }
+    float getCellSize() const { return file ? file->getHeader().cellSize : 0.0f; }
+
+private:
+    enum CellState
+    {
+        CELL_LOADING,           // meshes requested
+        CELL_INSTANTIATING,     // meshes settled, entities being created
+        CELL_LOADED,
+        CELL_UNLOADING          // entities being destroyed
+    };
+
+    struct ActiveCell
+    {
+        uint32_t record;        // index into the cell table
+        CellState state;
+        float distance;         // to the nearer of the camera and its lookahead point
+        std::vector<Entity> entities;
+    };
+
+    WorldPartitionSettings settings;
+    WorldPartitionStats stats;
+
+    std::unique_ptr<SceneFile> file;
+    std::vector<MeshHandle> meshes;         // the scene's mesh table, resolved
+    std::vector<ActiveCell> cells;
+    std::vector<uint32_t> candidates;       // wanted and not active; reused every update
+    std::vector<WorldCellChange> changes;   // of the last update; a cell changes at most once per update
+
+    glm::vec3 lastPosition;
+    glm::vec3 velocity;
+    bool hasPosition;
+
+    int findCell(int32_t x, int32_t z) const;
+    bool isActive(uint32_t record) const;
+    float distanceTo(const SceneCellRecord& cell, const glm::vec3& point) const;
+    void reserveCandidates();
+    void collectCandidates(const glm::vec3& point, const glm::vec3& ahead);
+    void startCell(uint32_t record, float distance);
+    void releaseCellMeshes(const ActiveCell& cell);
+    bool areCellMeshesSettled(const ActiveCell& cell) const;
+    void addChange(const ActiveCell& cell, bool loaded);
+    uint32_t instantiate(ActiveCell& cell, EntityWorld& world, uint32_t budget);
+};
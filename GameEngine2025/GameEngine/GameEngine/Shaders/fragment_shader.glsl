@@ -13,6 +13,33 @@ uniform vec3 viewPos;
 uniform float ambientStrength;
 uniform float specularStrength;
 
+// Sun shadows, see CascadedShadowMap; no cascades means unshadowed
+uniform sampler2DArrayShadow shadowMap;
+uniform int shadowCascadeCount;
+uniform mat4 shadowMatrices[4];
+uniform float shadowTexelSizes[4];
+
+// 1 lit, 0 shadowed; 3x3 filtered in the first cascade that covers the fragment
+float shadowFactor(vec3 normal)
+{
+	for (int i = 0; i < shadowCascadeCount; i++)
+	{
+		// About a texel off the surface, against acne on slopes
+		vec4 shadowPos = shadowMatrices[i] * vec4(fragPos + normal * shadowTexelSizes[i] * 1.5, 1.0);
+		vec3 coords = shadowPos.xyz * 0.5 + 0.5;
+		if (any(lessThan(coords, vec3(0.0))) || any(greaterThan(coords, vec3(1.0))))
+			continue;
+
+		vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+		float lit = 0.0;
+		for (int x = -1; x <= 1; x++)
+			for (int y = -1; y <= 1; y++)
+				lit += texture(shadowMap, vec4(coords.xy + vec2(x, y) * texel, float(i), coords.z));
+		return lit / 9.0;
+	}
+	return 1.0;
+}
+
 void main()
 {
 	// Ambient lighting
@@ -32,7 +59,8 @@ void main()
 	float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
 	vec3 specular = specularStrength * spec * lightColor;
 	
-	// Combine lighting with texture
-	vec3 result = (ambient + diffuse + specular) * texture(texture1, textureCoord).rgb;
+	// Combine lighting with texture; shadows keep only the ambient part
+	float shadow = shadowFactor(norm_normalized);
+	vec3 result = (ambient + shadow * (diffuse + specular)) * texture(texture1, textureCoord).rgb;
 	fragColor = vec4(result, 1.0);
 }
\ No newline at end of file
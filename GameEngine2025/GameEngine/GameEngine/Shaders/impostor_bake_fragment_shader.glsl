@@ -0,0 +1,23 @@
+#version 400
+
+// Impostor baking, after vertex_shader.glsl with an identity model matrix:
+// fragPos and norm are in object space
+in vec2 textureCoord;
+in vec3 norm;
+in vec3 fragPos;
+
+layout (location = 0) out vec4 albedo;
+layout (location = 1) out vec4 normalDepth;
+
+uniform sampler2D texture1;
+uniform vec3 frameDirection;    // towards the viewer of this frame
+uniform float radius;           // of the baked bounding sphere
+
+void main()
+{
+    albedo = vec4(texture(texture1, textureCoord).rgb, 1.0f);
+
+    // Height above the plane through the origin facing the viewer, -radius..radius
+    float height = dot(fragPos, frameDirection) / radius;
+    normalDepth = vec4(normalize(norm) * 0.5f + 0.5f, clamp(height * 0.5f + 0.5f, 0.0f, 1.0f));
+}
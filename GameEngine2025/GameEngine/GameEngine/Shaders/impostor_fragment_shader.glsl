@@ -0,0 +1,70 @@
+#version 400
+
+in vec2 atlasCoord;
+in vec3 cardPos;
+flat in vec4 objectRotation;
+flat in vec3 frameDirection;
+flat in float cardRadius;
+
+out vec4 fragColor;
+
+uniform mat4 viewProjection;
+uniform sampler2D impostorAlbedo;
+uniform sampler2D impostorNormalDepth;
+uniform vec3 lightColor;
+uniform vec3 lightPos;
+uniform vec3 viewPos;
+uniform float ambientStrength;
+uniform float specularStrength;
+
+// Sun shadows, as in fragment_shader.glsl
+uniform sampler2DArrayShadow shadowMap;
+uniform int shadowCascadeCount;
+uniform mat4 shadowMatrices[4];
+uniform float shadowTexelSizes[4];
+
+float shadowFactor(vec3 position, vec3 normal)
+{
+    for (int i = 0; i < shadowCascadeCount; i++)
+    {
+        vec4 shadowPos = shadowMatrices[i] * vec4(position + normal * shadowTexelSizes[i] * 1.5, 1.0);
+        vec3 coords = shadowPos.xyz * 0.5 + 0.5;
+        if (any(lessThan(coords, vec3(0.0))) || any(greaterThan(coords, vec3(1.0))))
+            continue;
+
+        // Distant props are a few pixels tall; one filtered tap is enough
+        return texture(shadowMap, vec4(coords.xy, float(i), coords.z));
+    }
+    return 1.0;
+}
+
+vec3 rotate(vec4 q, vec3 v)
+{
+    return v + 2.0f * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main()
+{
+    vec4 albedo = texture(impostorAlbedo, atlasCoord);
+    if (albedo.a < 0.5f)
+        discard;
+    vec4 normalDepth = texture(impostorNormalDepth, atlasCoord);
+
+    // Back from the card onto the baked surface, so impostors meet the ground
+    // and each other where the meshes would
+    vec3 position = cardPos + frameDirection * ((normalDepth.a * 2.0f - 1.0f) * cardRadius);
+    vec4 clip = viewProjection * vec4(position, 1.0f);
+    gl_FragDepth = clip.z / clip.w * 0.5f + 0.5f;
+
+    // Same lighting as the meshes they stand in for
+    vec3 normal = normalize(rotate(objectRotation, normalDepth.xyz * 2.0f - 1.0f));
+    vec3 ambient = ambientStrength * lightColor;
+    vec3 lightDir = normalize(lightPos - position);
+    vec3 diffuse = max(dot(normal, lightDir), 0.0f) * lightColor;
+    vec3 viewDir = normalize(viewPos - position);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    vec3 specular = specularStrength * pow(max(dot(viewDir, reflectDir), 0.0f), 32) * lightColor;
+
+    float shadow = shadowFactor(position, normal);
+    fragColor = vec4((ambient + shadow * (diffuse + specular)) * albedo.rgb, 1.0f);
+}
@@ -0,0 +1,60 @@
+#version 400
+
+layout (location = 0) in vec4 placement;    // position, uniform scale
+layout (location = 1) in vec4 rotation;     // quaternion xyzw
+
+uniform mat4 viewProjection;
+uniform vec3 viewPos;
+uniform float impostorRadius;   // of the baked bounding sphere, unscaled
+uniform float framesPerSide;
+
+out vec2 atlasCoord;
+out vec3 cardPos;
+flat out vec4 objectRotation;
+flat out vec3 frameDirection;   // world space, towards the viewer of the frame
+flat out float cardRadius;
+
+vec3 rotate(vec4 q, vec3 v)
+{
+    return v + 2.0f * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+// Upper hemisphere onto the unit square and back; ImpostorBaker::getFrameDirection
+// decodes the same way. Views from below the horizon use the horizon.
+vec2 encodeHemiOctahedron(vec3 direction)
+{
+    direction.y = max(direction.y, 1.0e-4f);
+    vec2 p = direction.xz / (abs(direction.x) + direction.y + abs(direction.z));
+    return vec2(p.x + p.y, p.x - p.y);
+}
+
+vec3 decodeHemiOctahedron(vec2 e)
+{
+    vec2 p = vec2(e.x + e.y, e.x - e.y) * 0.5f;
+    return normalize(vec3(p.x, 1.0f - abs(p.x) - abs(p.y), p.y));
+}
+
+void main()
+{
+    // The frame baked nearest to where the camera sees the object from
+    vec3 toViewer = rotate(vec4(-rotation.xyz, rotation.w), viewPos - placement.xyz);
+    vec2 grid = (encodeHemiOctahedron(toViewer) * 0.5f + 0.5f) * framesPerSide;
+    vec2 frame = clamp(floor(grid), vec2(0.0f), vec2(framesPerSide - 1.0f));
+    vec3 direction = decodeHemiOctahedron((frame + 0.5f) / framesPerSide * 2.0f - 1.0f);
+
+    // The card lies in that frame's image plane, through the object's origin;
+    // same basis as the bake's lookAt
+    vec3 up = abs(direction.y) > 0.999f ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+    vec3 right = normalize(cross(up, direction));
+    up = cross(direction, right);
+
+    // Triangle strip (-1,-1) (1,-1) (-1,1) (1,1) from the vertex index
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0f - 1.0f;
+    cardRadius = impostorRadius * placement.w;
+    cardPos = placement.xyz + rotate(rotation, (right * corner.x + up * corner.y) * cardRadius);
+
+    atlasCoord = (frame + corner * 0.5f + 0.5f) / framesPerSide;
+    objectRotation = rotation;
+    frameDirection = rotate(rotation, direction);
+    gl_Position = viewProjection * vec4(cardPos, 1.0f);
+}
@@ -0,0 +1,13 @@
+#version 400
+
+in vec2 corner;
+in vec4 particleColor;
+
+out vec4 fragColor;
+
+void main()
+{
+    // Soft round sprite
+    float falloff = clamp(1.0f - dot(corner, corner), 0.0f, 1.0f);
+    fragColor = vec4(particleColor.rgb, particleColor.a * falloff * falloff);
+}
@@ -0,0 +1,21 @@
+#version 400
+
+layout (location = 0) in vec4 center;   // xyz, size
+layout (location = 1) in vec4 color;
+
+uniform mat4 viewProjection;
+uniform vec3 cameraRight;
+uniform vec3 cameraUp;
+
+out vec2 corner;
+out vec4 particleColor;
+
+void main()
+{
+    // Triangle strip (-1,-1) (1,-1) (-1,1) (1,1) from the vertex index
+    corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0f - 1.0f;
+    vec3 position = center.xyz + (cameraRight * corner.x + cameraUp * corner.y) * center.w;
+
+    particleColor = color;
+    gl_Position = viewProjection * vec4(position, 1.0f);
+}
@@ -1,4 +1,5 @@
 #include "shader.h"
+#include "../Graphics/glStateCache.h"
 #include <iostream>
 #include <vector>
 
@@ -101,7 +102,7 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
 
 void Shader::use()
 {
-	glUseProgram(id);
+	GlStateCache::getInstance().useProgram(id);
 }
 
 int Shader::getId()
@@ -0,0 +1,6 @@
+#version 400
+
+// Nothing to shade: the caster passes only write depth
+void main()
+{
+}
@@ -0,0 +1,11 @@
+#version 400
+
+layout (location = 0) in vec3 pos;
+
+uniform mat4 MVP;
+
+// Depth only, for the shadow map caster passes
+void main()
+{
+    gl_Position = MVP * vec4(pos, 1.0f);
+}
@@ -3,7 +3,22 @@
 #include "Shaders/shader.h"
 #include "ResourceManager/resourceManager.h"
 #include "SceneManager/sceneManager.h"
+#include "Benchmark/benchmark.h"
+#include "Core/fixedTimestep.h"
+#include "Core/profiler.h"
+#include "Core/frameGovernor.h"
+#include "Core/frameArena.h"
+#include "Core/frameAllocationCheck.h"
+#include "Graphics/gpuFrameTimer.h"
+#include "Graphics/scaledRenderTarget.h"
+#include "Graphics/framePacer.h"
+#include "Graphics/glStateCache.h"
+#include "Graphics/renderStats.h"
+#include "Camera/cameraPath.h"
+#include "Input/inputQueue.h"
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
 
 // ================= GLOBALS =================
 bool firstMouse = true;
@@ -13,88 +28,395 @@ float lastY = 600.0f;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// Gameplay runs at a fixed rate; override with --tick-rate <hz>
+const float DEFAULT_TICK_RATE = 60.0f;
+
+// Main-thread time per frame for GL uploads of asynchronously loaded assets
+const double ASSET_UPLOAD_BUDGET_MS = 2.0;
+// Texture mip data streamed to the GPU per frame
+const size_t TEXTURE_STREAMING_BYTES = 8 * 1024 * 1024;
+// GPU time per frame the governor holds by lowering the render resolution;
+// override with --frame-budget <ms>, 0 renders at full resolution always
+const float DEFAULT_FRAME_BUDGET_MS = 1000.0f / 60.0f;
+// Asteroids dropped per press of M
+const int ASTEROID_SHOWER_COUNT = 500;
+
 bool messagePrinted = false;
 
-Window window("VARKON", 2000, 1200);
+Window* window = nullptr; // created in main so benchmark runs never open one
 Camera camera;
 
+// Steady frames make no heap allocations; debug builds warn about any that do
+FrameAllocationCheck allocationCheck;
+
 // Scene management
 int currentScene = 1;
 bool key1Pressed = false;
 bool key2Pressed = false;
 bool key3Pressed = false;
 bool keyNPressed = false;
+bool keyF9Pressed = false;
+bool keyF10Pressed = false;
+bool keyF8Pressed = false;
+bool keyF6Pressed = false;
+bool keyF7Pressed = false;
+bool keyF5Pressed = false;
+bool keyF4Pressed = false;
+bool keyF3Pressed = false;
+bool keyF2Pressed = false;
+bool keyF1Pressed = false;
+
+// Camera path recording (F8), played back by the scene benchmark
+const float PATH_SAMPLE_INTERVAL = 0.5f;
+CameraPath recordedPath;
+bool recordingPath = false;
+double recordingStart = 0.0;
+double nextPathSample = 0.0;
 
 // Message display control
 bool triggerMessagePrinted = false;
 bool alienMessagePrinted = false;
 
 // ================= FUNCTION DECLARATIONS =================
-void processKeyboardInput(SceneManager& sceneManager);
-void mouse_callback(GLFWwindow* window, double xpos, double ypos);
-
-// ================= MOUSE CALLBACK =================
-void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+void processKeyboardInput(SceneManager& sceneManager, float stepSeconds);
+void latchMouseLook(InputQueue& input);
+void printGovernorState(const FrameGovernor& governor);
+void printInputLatency(const InputQueue& input);
+void printPacingStats(const FramePacer& pacer);
+void printWorldStreaming(const WorldPartition& partition);
+void printStateCacheStats();
+void printRenderStats();
+
+// ================= MOUSE LOOK =================
+// Applies every cursor sample since the previous frame, in order
+void latchMouseLook(InputQueue& input)
 {
-    if (firstMouse)
+    for (const InputEvent& event : input.latch())
     {
-        lastX = xpos;
-        lastY = ypos;
-        firstMouse = false;
-    }
+        if (event.type != INPUT_CURSOR)
+            continue;
+
+        if (firstMouse)
+        {
+            lastX = (float)event.x;
+            lastY = (float)event.y;
+            firstMouse = false;
+        }
 
-    float xoffset = xpos - lastX;
-    float yoffset = lastY - ypos;
+        float xoffset = (float)event.x - lastX;
+        float yoffset = lastY - (float)event.y;
 
-    lastX = xpos;
-    lastY = ypos;
+        lastX = (float)event.x;
+        lastY = (float)event.y;
 
-    camera.processMouseMovement(xoffset, yoffset);
+        camera.processMouseMovement(xoffset, yoffset);
+    }
 }
 
 // =============================== MAIN ===============================
-int main()
+int main(int argc, char** argv)
 {
+    int benchmarkExitCode = 0;
+    if (runBenchmarkFromCommandLine(argc, argv, benchmarkExitCode))
+        return benchmarkExitCode;
+
+    // Offline scene conversion: --compile-scene <in.scene> <out.scenebin>
+    if (argc >= 4 && strcmp(argv[1], "--compile-scene") == 0)
+        return compileSceneFile(argv[2], argv[3]) ? 0 : 1;
+
+    float tickRate = DEFAULT_TICK_RATE;
+    int profileFrames = 0;  // --profile <frames> captures startup plus that many frames
+    int shadowCascades = -1;    // --shadow-cascades / --shadow-resolution; -1 keeps the default
+    int shadowResolution = -1;
+    float frameBudgetMs = DEFAULT_FRAME_BUDGET_MS;
+    FramePacingMode pacingMode = PACING_VSYNC;  // --pacing vsync|capped|uncapped
+    float fpsCap = 0.0f;                        // --fps-cap <fps>, implies capped pacing
+    int framesInFlight = 0;                     // --max-frames-in-flight <n>; 0 keeps the default
+    const char* renderStatsPath = nullptr;      // --render-stats <file> appends a summary every second
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--tick-rate") == 0)
+            tickRate = (float)atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--profile") == 0)
+            profileFrames = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--memory-budget") == 0)
+        {
+            // Same limit for CPU copies and GPU resources, in megabytes
+            size_t budget = (size_t)atoi(argv[i + 1]) * 1024 * 1024;
+            ResourceManager::getInstance().setMemoryBudget(budget, budget);
+        }
+        else if (strcmp(argv[i], "--shadow-cascades") == 0)
+            shadowCascades = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--shadow-resolution") == 0)
+            shadowResolution = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--frame-budget") == 0)
+            frameBudgetMs = (float)atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--pacing") == 0)
+        {
+            if (!FramePacer::parseModeName(argv[i + 1], pacingMode))
+                std::cout << "Warning: unknown pacing mode " << argv[i + 1] << ", using vsync" << std::endl;
+        }
+        else if (strcmp(argv[i], "--fps-cap") == 0)
+        {
+            fpsCap = (float)atof(argv[i + 1]);
+            pacingMode = PACING_CAPPED;
+        }
+        else if (strcmp(argv[i], "--max-frames-in-flight") == 0)
+            framesInFlight = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--render-stats") == 0)
+            renderStatsPath = argv[i + 1];
+    }
+    FixedTimestep simulation(tickRate);
+
+    Window gameWindow("VARKON", 2000, 1200);
+    window = &gameWindow;
+
+    if (profileFrames > 0)
+        Profiler::getInstance().beginCapture(profileFrames);
+
     glClearColor(0.02f, 0.05f, 0.15f, 1.0f);
 
-    // Setup mouse control
-    glfwSetCursorPosCallback(window.getWindow(), mouse_callback);
-    glfwSetInputMode(window.getWindow(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    // Setup mouse control; the window queues cursor samples for latchMouseLook
+    glfwSetInputMode(window->getWindow(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    window->setRawMouseMotion(true);
 
     // SHADERS
     Shader shader("Shaders/vertex_shader.glsl", "Shaders/fragment_shader.glsl");
     Shader sunShader("Shaders/sun_vertex_shader.glsl", "Shaders/sun_fragment_shader.glsl");
+    Shader particleShader("Shaders/particle_vertex_shader.glsl", "Shaders/particle_fragment_shader.glsl");
+    Shader shadowShader("Shaders/shadow_vertex_shader.glsl", "Shaders/shadow_fragment_shader.glsl");
+    Shader impostorShader("Shaders/impostor_vertex_shader.glsl", "Shaders/impostor_fragment_shader.glsl");
+    Shader impostorBakeShader("Shaders/vertex_shader.glsl", "Shaders/impostor_bake_fragment_shader.glsl");
 
-    glEnable(GL_DEPTH_TEST);
+    GlStateCache::getInstance().setEnabled(GL_DEPTH_TEST, true);
 
     // INITIALIZE SCENE MANAGER
     SceneManager sceneManager;
     sceneManager.initializeResources();  // Load all resources once
     sceneManager.loadScene(1);            // Start with scene 1
+    camera.setCollisionWorld(&sceneManager.getCollisionWorld());
+
+    CascadedShadowMap& shadows = sceneManager.getShadows();
+    if (shadowCascades >= 0)
+        shadows.setCascadeCount(shadowCascades);
+    if (shadowResolution > 0)
+        shadows.setResolution(shadowResolution);
+
+    // Dynamic resolution: the scene goes through sceneTarget whenever the
+    // governor renders below full size
+    FrameGovernorSettings governorSettings;
+    governorSettings.targetMs = frameBudgetMs;
+    FrameGovernor governor(governorSettings);
+    GpuFrameTimer gpuTimer;
+    ScaledRenderTarget sceneTarget;
+    governor.setEnabled(frameBudgetMs > 0.0f);
+    if (governor.isEnabled() && !gpuTimer.isSupported())
+    {
+        std::cout << "Warning: no GPU timer queries, frame budget ignored" << std::endl;
+        governor.setEnabled(false);
+    }
+
+    if (renderStatsPath)
+        RenderStats::getInstance().startDump(renderStatsPath);
+
+    FramePacer pacer;
+    if (fpsCap > 0.0f)
+        pacer.setTargetFps(fpsCap);
+    if (framesInFlight > 0)
+        pacer.setMaxFramesInFlight(framesInFlight);
+    pacer.setMode(pacingMode);
 
     std::cout << "\n========================================" << std::endl;
     std::cout << "Game Controls:" << std::endl;
     std::cout << "  WASD - Move" << std::endl;
     std::cout << "  R/F - Move up/down" << std::endl;
     std::cout << "  Mouse - Look around" << std::endl;
+    std::cout << "  M - Drop an asteroid shower ahead" << std::endl;
+    std::cout << "  F1 - Show render statistics of the last " << RenderStats::WINDOW_SECONDS << " seconds" << std::endl;
+    std::cout << "  F2 - Show GL state changes of the last frame" << std::endl;
+    std::cout << "  F3 - Cycle frame pacing (vsync, capped, uncapped)" << std::endl;
+    std::cout << "  F4 - Show input latency" << std::endl;
+    std::cout << "  F5 - Show frame governor state" << std::endl;
+    std::cout << "  F6 - Cycle shadow cascade count (0 = off)" << std::endl;
+    std::cout << "  F7 - Cycle shadow map resolution" << std::endl;
+    std::cout << "  F8 - Start/stop recording a camera path" << std::endl;
+    std::cout << "  F9 - Start/stop profiler capture" << std::endl;
+    std::cout << "  F10 - Show world streaming state" << std::endl;
     std::cout << "  ESC - Quit" << std::endl;
     std::cout << "========================================\n" << std::endl;
+    std::cout << "Simulation rate: " << simulation.getTickRate() << " Hz" << std::endl;
+    if (governor.isEnabled())
+        std::cout << "Frame budget: " << frameBudgetMs << " ms GPU" << std::endl;
+    std::cout << "Frame pacing: " << FramePacer::getModeName(pacer.getMode());
+    if (pacer.getMode() == PACING_CAPPED)
+        std::cout << " at " << pacer.getTargetFps() << " fps";
+    std::cout << ", at most " << pacer.getMaxFramesInFlight() << " frames in flight" << std::endl;
+
+    lastFrame = glfwGetTime();
 
     // =============================== MAIN LOOP ===============================
-    while (!window.isPressed(GLFW_KEY_ESCAPE) &&
-        glfwWindowShouldClose(window.getWindow()) == 0)
+    while (!window->isPressed(GLFW_KEY_ESCAPE) &&
+        glfwWindowShouldClose(window->getWindow()) == 0)
     {
-        window.clear();
+        Profiler::getInstance().beginFrame();
+        pacer.beginFrame();
+        GlStateCache::getInstance().beginFrame();
+        RenderStats::getInstance().beginFrame();
+        window->clear();
+
+        // F9 toggles a capture; the trace is written once GPU timings are back
+        if (window->isPressed(GLFW_KEY_F9) && !keyF9Pressed)
+        {
+            keyF9Pressed = true;
+            if (Profiler::isCapturing())
+                Profiler::getInstance().endCapture();
+            else
+                Profiler::getInstance().beginCapture();
+        }
+        else if (!window->isPressed(GLFW_KEY_F9))
+        {
+            keyF9Pressed = false;
+        }
+
+        if (window->isPressed(GLFW_KEY_F1) && !keyF1Pressed)
+        {
+            keyF1Pressed = true;
+            printRenderStats();
+        }
+        else if (!window->isPressed(GLFW_KEY_F1))
+        {
+            keyF1Pressed = false;
+        }
+
+        if (window->isPressed(GLFW_KEY_F2) && !keyF2Pressed)
+        {
+            keyF2Pressed = true;
+            printStateCacheStats();
+        }
+        else if (!window->isPressed(GLFW_KEY_F2))
+        {
+            keyF2Pressed = false;
+        }
+
+        // F3 reports how evenly the current mode paced frames, then moves on
+        if (window->isPressed(GLFW_KEY_F3) && !keyF3Pressed)
+        {
+            keyF3Pressed = true;
+            printPacingStats(pacer);
+            pacer.setMode((FramePacingMode)((pacer.getMode() + 1) % (PACING_UNCAPPED + 1)));
+            pacer.resetStats();
+            std::cout << "Frame pacing: " << FramePacer::getModeName(pacer.getMode()) << std::endl;
+        }
+        else if (!window->isPressed(GLFW_KEY_F3))
+        {
+            keyF3Pressed = false;
+        }
+
+        if (window->isPressed(GLFW_KEY_F4) && !keyF4Pressed)
+        {
+            keyF4Pressed = true;
+            printInputLatency(window->getInput());
+        }
+        else if (!window->isPressed(GLFW_KEY_F4))
+        {
+            keyF4Pressed = false;
+        }
+
+        if (window->isPressed(GLFW_KEY_F5) && !keyF5Pressed)
+        {
+            keyF5Pressed = true;
+            printGovernorState(governor);
+        }
+        else if (!window->isPressed(GLFW_KEY_F5))
+        {
+            keyF5Pressed = false;
+        }
+
+        // F6/F7 change the shadow settings; the maps are rebuilt on the next frame
+        if (window->isPressed(GLFW_KEY_F6) && !keyF6Pressed)
+        {
+            keyF6Pressed = true;
+            shadows.setCascadeCount((shadows.getCascadeCount() + 1) % (CascadedShadowMap::MAX_CASCADES + 1));
+            std::cout << "Shadow cascades: " << shadows.getCascadeCount() << std::endl;
+        }
+        else if (!window->isPressed(GLFW_KEY_F6))
+        {
+            keyF6Pressed = false;
+        }
+
+        if (window->isPressed(GLFW_KEY_F7) && !keyF7Pressed)
+        {
+            keyF7Pressed = true;
+            shadows.setResolution(shadows.getResolution() >= 4096 ? 1024 : shadows.getResolution() * 2);
+            std::cout << "Shadow map resolution: " << shadows.getResolution() << std::endl;
+        }
+        else if (!window->isPressed(GLFW_KEY_F7))
+        {
+            keyF7Pressed = false;
+        }
+
+        if (window->isPressed(GLFW_KEY_F10) && !keyF10Pressed)
+        {
+            keyF10Pressed = true;
+            printWorldStreaming(sceneManager.getWorldPartition());
+        }
+        else if (!window->isPressed(GLFW_KEY_F10))
+        {
+            keyF10Pressed = false;
+        }
 
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
-        // Check proximity triggers EVERY frame
-        sceneManager.checkProximityTriggers(camera.getCameraPosition());
+        // ===== SIMULATION (fixed ticks) =====
+        simulation.addFrameTime(deltaTime);
+        while (simulation.step())
+        {
+            PROFILE_SCOPE("simulationTick");
+            camera.storePreviousState();
+            sceneManager.beginSimulationTick();
+
+            processKeyboardInput(sceneManager, simulation.getTickSeconds());
+            sceneManager.checkProximityTriggers(camera.getCameraPosition());
+            sceneManager.updatePortalAnimation((float)simulation.getSimulationTime(), simulation.getTickSeconds());
+            sceneManager.updatePhysics(simulation.getTickSeconds());
+        }
+
+        // Render between the last two ticks
+        float alpha = simulation.getAlpha();
+
+        // F8 records the flight as keyframes for the headless scene benchmark
+        if (window->isPressed(GLFW_KEY_F8) && !keyF8Pressed)
+        {
+            keyF8Pressed = true;
+            if (!recordingPath)
+            {
+                recordedPath.clear();
+                recordingStart = nextPathSample = simulation.getSimulationTime();
+                recordingPath = true;
+                std::cout << "Recording camera path..." << std::endl;
+            }
+            else
+            {
+                recordingPath = false;
+                recordedPath.save("camera_path_recorded.path");
+            }
+        }
+        else if (!window->isPressed(GLFW_KEY_F8))
+        {
+            keyF8Pressed = false;
+        }
+
+        if (recordingPath && simulation.getSimulationTime() >= nextPathSample)
+        {
+            recordedPath.addKeyframe((float)(simulation.getSimulationTime() - recordingStart),
+                camera.getCameraPosition(), camera.getYaw(), camera.getPitch());
+            nextPathSample = simulation.getSimulationTime() + PATH_SAMPLE_INTERVAL;
+        }
 
         // Display message if near trigger
-        std::string triggerMsg = sceneManager.getTriggerMessage();
+        const std::string& triggerMsg = sceneManager.getTriggerMessage();
         if (!triggerMsg.empty())
         {
             if (!messagePrinted)
@@ -109,7 +431,8 @@ int main()
         }
 
         // Alien interaction message
-        if (sceneManager.isPlayerNearAlien(camera.getCameraPosition()) && !sceneManager.isBagGrabbed())
+        if (sceneManager.isPlayerLookingAtAlien(camera.getCameraPosition(), camera.getCameraViewDirection()) &&
+            !sceneManager.isBagGrabbed())
         {
             if (!messagePrinted)
             {
@@ -122,44 +445,170 @@ int main()
             messagePrinted = false;
         }
 
-        processKeyboardInput(sceneManager);
-        sceneManager.updateBagFollowCamera(camera);
+        // Cells around the camera, and where it is heading, request their
+        // meshes before this frame's uploads are processed
+        sceneManager.updateWorldStreaming(camera.getCameraPosition(), deltaTime);
+
+        // Asset uploads don't depend on the view, so they go before the latch
+        ResourceManager::getInstance().processUploads(ASSET_UPLOAD_BUDGET_MS);
+
+        // Late latch: mouse motion that arrived while this frame was simulated
+        // still turns its view, instead of waiting for the next frame
+        window->pollEvents();
+        latchMouseLook(window->getInput());
 
-        sceneManager.updatePortalAnimation(currentFrame);
+        sceneManager.updateBagFollowCamera(camera, alpha);
+        sceneManager.interpolateTransforms(alpha);
 
         // ===== PROJECTION & VIEW MATRICES =====
         glm::mat4 ProjectionMatrix = glm::perspective(90.0f,
-            window.getWidth() * 1.0f / window.getHeight(),
+            window->getWidth() * 1.0f / window->getHeight(),
             0.1f, 10000.0f);
 
-        glm::mat4 ViewMatrix = camera.getViewMatrix();
+        glm::mat4 ViewMatrix = camera.getViewMatrix(alpha);
+        glm::vec3 renderCameraPos = camera.getInterpolatedPosition(alpha);
+        sceneManager.updateParticles(deltaTime, renderCameraPos);
 
         // ===== RENDER SCENE =====
+        gpuTimer.beginFrame();
+        float renderScale = governor.getState().renderScale;
+        bool scaled = renderScale < 1.0f;
+        if (scaled)
+        {
+            sceneTarget.bind((int)(window->getWidth() * renderScale + 0.5f), (int)(window->getHeight() * renderScale + 0.5f));
+            window->clear();
+        }
+
+        sceneManager.renderShadows(ProjectionMatrix, ViewMatrix, shadowShader);
         sceneManager.renderStars(ProjectionMatrix, ViewMatrix, sunShader);
-        sceneManager.renderGround(ProjectionMatrix, ViewMatrix, camera.getCameraPosition(), shader);
-        sceneManager.render(ProjectionMatrix, ViewMatrix, camera.getCameraPosition(), shader);
+        sceneManager.renderGround(ProjectionMatrix, ViewMatrix, renderCameraPos, shader);
+        sceneManager.render(ProjectionMatrix, ViewMatrix, renderCameraPos, shader);
+        sceneManager.renderImpostors(ProjectionMatrix, ViewMatrix, renderCameraPos, impostorShader, impostorBakeShader);
+        sceneManager.renderParticles(ProjectionMatrix, ViewMatrix, renderCameraPos, particleShader);
+        ResourceManager::getInstance().updateTextureStreaming(TEXTURE_STREAMING_BYTES);
+
+        if (scaled)
+            sceneTarget.resolve(0, window->getWidth(), window->getHeight());
+        gpuTimer.endFrame();
+
+        window->getInput().markSubmitted(glfwGetTime());
+        if (window->getInput().getLastLatency().samples > 0)
+            PROFILE_COUNTER("inputLatencyMs", window->getInput().getLastLatency().oldestMs);
+
+        // Frames finished by the GPU feed the governor; its decisions apply from the next frame
+        double gpuMs;
+        while (gpuTimer.readResult(gpuMs))
+        {
+            governor.addGpuFrameTime(gpuMs);
+            RenderStats::getInstance().addGpuFrameTime(gpuMs);
+        }
+        if (governor.update())
+        {
+            const FrameGovernorState& quality = governor.getState();
+            sceneManager.setDrawDistance(quality.drawDistance);
+            sceneManager.setTextureLodBias(quality.lodBias);
+            printGovernorState(governor);
+        }
 
-        window.update();
+        window->update();
+        pacer.endFrame();
+
+        FrameArena::getInstance().reset();
+        // A profiler capture records into growing buffers; judge the frames after it
+        if (Profiler::isCapturing())
+            allocationCheck.restartWarmup();
+        allocationCheck.endFrame();
     }
 
     return 0;
 }
 
+void printGovernorState(const FrameGovernor& governor)
+{
+    const FrameGovernorState& state = governor.getState();
+    if (!governor.isEnabled())
+    {
+        std::cout << "Frame governor: off, full resolution" << std::endl;
+        return;
+    }
+    std::cout << "Frame governor: " << FrameGovernor::getActionName(state.lastAction) << " at "
+        << state.averageGpuMs << " ms GPU (target " << governor.getSettings().targetMs << " ms): render scale "
+        << state.renderScale << ", texture LOD bias " << state.lodBias << ", draw distance " << state.drawDistance
+        << ", " << state.changes << " changes" << std::endl;
+}
+
+void printInputLatency(const InputQueue& input)
+{
+    const InputLatency& last = input.getLastLatency();
+    std::cout << "Input to submit: last frame " << last.oldestMs << " ms (" << last.samples
+        << " mouse samples, newest " << last.newestMs << " ms), average " << input.getAverageLatencyMs()
+        << " ms, worst " << input.getMaxLatencyMs() << " ms" << std::endl;
+}
+
+void printPacingStats(const FramePacer& pacer)
+{
+    FramePacingStats stats = pacer.getStats();
+    std::cout << "Frame pacing (" << FramePacer::getModeName(pacer.getMode()) << ", last " << stats.frames
+        << " frames): " << stats.meanMs << " ms mean, " << stats.stdDevMs << " ms std dev, "
+        << stats.minMs << "-" << stats.maxMs << " ms, " << stats.fenceWaitMs << " ms waiting on the GPU per frame"
+        << std::endl;
+}
+
+void printWorldStreaming(const WorldPartition& partition)
+{
+    if (!partition.isOpen())
+    {
+        std::cout << "World streaming: this scene is not partitioned" << std::endl;
+        return;
+    }
+    const WorldPartitionStats& stats = partition.getStats();
+    std::cout << "World streaming: " << stats.loadedCells << " of " << stats.activeCells << " active cells loaded, "
+        << stats.entities << " entities, " << stats.cellLoads << " loads and " << stats.cellUnloads
+        << " unloads so far, " << stats.deferredCells << " cells waiting for a free slot" << std::endl;
+}
+
+void printStateCacheStats()
+{
+    const GlStateStats& stats = GlStateCache::getInstance().getLastFrameStats();
+    std::cout << "GL state calls last frame: " << stats.getTotalIssued() << " issued, "
+        << stats.getTotalSkipped() << " redundant skipped" << std::endl;
+    for (int i = 0; i < STATE_CATEGORY_COUNT; i++)
+    {
+        std::cout << "  " << GlStateCache::getCategoryName((GlStateCategory)i) << ": " << stats.issued[i]
+            << " issued, " << stats.skipped[i] << " skipped" << std::endl;
+    }
+}
+
+void printRenderStats()
+{
+    RenderStatsSummary summary = RenderStats::getInstance().getSummary();
+    double frames = summary.frames > 0 ? (double)summary.frames : 1.0;
+    std::cout << "Render stats, " << summary.frames << " frames in " << summary.seconds << " s, per frame: "
+        << summary.totals.drawCalls / frames << " draws, " << summary.totals.triangles / frames << " triangles, "
+        << summary.totals.stateChanges / frames << " state changes (" << summary.totals.redundantStateChanges / frames
+        << " skipped), " << summary.totals.uploads / frames << " uploads of "
+        << summary.totals.uploadBytes / frames / 1024.0 << " KB, " << summary.totals.culled / frames << " culled" << std::endl;
+    std::cout << "  cpu ms p50 " << summary.cpuMs.p50 << ", p95 " << summary.cpuMs.p95 << ", p99 " << summary.cpuMs.p99
+        << ", max " << summary.cpuMs.max << std::endl;
+    std::cout << "  gpu ms p50 " << summary.gpuMs.p50 << ", p95 " << summary.gpuMs.p95 << ", p99 " << summary.gpuMs.p99
+        << ", max " << summary.gpuMs.max << std::endl;
+}
+
 // ================= KEYBOARD INPUT =================
-void processKeyboardInput(SceneManager& sceneManager)
+void processKeyboardInput(SceneManager& sceneManager, float stepSeconds)
 {
-    float speed = 30 * deltaTime;
+    float speed = 30 * stepSeconds;
 
     // Movement
-    if (window.isPressed(GLFW_KEY_W)) camera.keyboardMoveFront(speed);
-    if (window.isPressed(GLFW_KEY_S)) camera.keyboardMoveBack(speed);
-    if (window.isPressed(GLFW_KEY_A)) camera.keyboardMoveLeft(speed);
-    if (window.isPressed(GLFW_KEY_D)) camera.keyboardMoveRight(speed);
-    if (window.isPressed(GLFW_KEY_R)) camera.keyboardMoveUp(speed);
-    if (window.isPressed(GLFW_KEY_F)) camera.keyboardMoveDown(speed);
+    if (window->isPressed(GLFW_KEY_W)) camera.keyboardMoveFront(speed);
+    if (window->isPressed(GLFW_KEY_S)) camera.keyboardMoveBack(speed);
+    if (window->isPressed(GLFW_KEY_A)) camera.keyboardMoveLeft(speed);
+    if (window->isPressed(GLFW_KEY_D)) camera.keyboardMoveRight(speed);
+    if (window->isPressed(GLFW_KEY_R)) camera.keyboardMoveUp(speed);
+    if (window->isPressed(GLFW_KEY_F)) camera.keyboardMoveDown(speed);
 
     // Check for 'N' key to trigger scene transition
-    if (window.isPressed(GLFW_KEY_N) && !keyNPressed)
+    if (window->isPressed(GLFW_KEY_N) && !keyNPressed)
     {
         keyNPressed = true;
 
@@ -172,25 +621,46 @@ void processKeyboardInput(SceneManager& sceneManager)
             int targetScene = zones[trigger].targetScene;
             std::cout << "\n=== Entering Portal - Transitioning to Scene " << targetScene << " ===\n";
             sceneManager.loadScene(targetScene);
+            allocationCheck.restartWarmup();
         }
     }
-    else if (!window.isPressed(GLFW_KEY_N))
+    else if (!window->isPressed(GLFW_KEY_N))
     {
         keyNPressed = false;
     }
+    // 'M' drops asteroids in front of and above the player
+    static bool mPressed = false;
+
+    if (window->isPressed(GLFW_KEY_M) && !mPressed)
+    {
+        mPressed = true;
+        glm::vec3 ahead = camera.getCameraViewDirection();
+        ahead.y = 0.0f;
+        if (glm::dot(ahead, ahead) > 0.0f)
+            ahead = glm::normalize(ahead);
+        sceneManager.spawnAsteroidShower(camera.getCameraPosition() + ahead * 40.0f + glm::vec3(0.0f, 20.0f, 0.0f),
+            ASTEROID_SHOWER_COUNT);
+        // Physics buffers grow while the new bodies find their contacts
+        allocationCheck.restartWarmup();
+    }
+    else if (!window->isPressed(GLFW_KEY_M))
+    {
+        mPressed = false;
+    }
+
     static bool ePressed = false;
 
-    if (window.isPressed(GLFW_KEY_E) && !ePressed)
+    if (window->isPressed(GLFW_KEY_E) && !ePressed)
     {
         ePressed = true;
 
-        if (sceneManager.isPlayerNearAlien(camera.getCameraPosition()))
+        if (sceneManager.isPlayerLookingAtAlien(camera.getCameraPosition(), camera.getCameraViewDirection()))
         {
             sceneManager.grabBag();
             std::cout << ">>> Bag grabbed!\n >>>Find a portal to see zizo..." << std::endl;
         }
     }
-    else if (!window.isPressed(GLFW_KEY_E))
+    else if (!window->isPressed(GLFW_KEY_E))
     {
         ePressed = false;
     }